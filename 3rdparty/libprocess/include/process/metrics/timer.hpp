@@ -87,6 +87,20 @@ public:
     return t;
   }
 
+  // Record an externally measured duration, e.g., the accumulated
+  // time of several non-contiguous sections of code.
+  void record(const Duration& duration)
+  {
+    double value;
+
+    synchronized (data->lock) {
+      data->lastValue = T(duration).value();
+      value = data->lastValue.get();
+    }
+
+    push(value);
+  }
+
   // Time an asynchronous event.
   template <typename U>
   Future<U> time(const Future<U>& future)
@@ -474,6 +474,26 @@ TEST_F(MetricsTest, Timer)
 }
 
 
+TEST_F(MetricsTest, TimerRecord)
+{
+  metrics::Timer<Milliseconds> timer("test/timer");
+  EXPECT_EQ("test/timer_ms", timer.name());
+
+  AWAIT_READY(metrics::add(timer));
+
+  // No value is available until a duration has been recorded.
+  AWAIT_FAILED(timer.value());
+
+  timer.record(Microseconds(1500));
+
+  Future<double> value = timer.value();
+  AWAIT_READY(value);
+  EXPECT_FLOAT_EQ(1.5, value.get());
+
+  AWAIT_READY(metrics::remove(timer));
+}
+
+
 static Future<int> advanceAndReturn()
 {
   Clock::advance(Seconds(1));
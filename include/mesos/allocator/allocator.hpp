@@ -17,6 +17,7 @@
 #ifndef __MESOS_ALLOCATOR_ALLOCATOR_HPP__
 #define __MESOS_ALLOCATOR_ALLOCATOR_HPP__
 
+#include <set>
 #include <string>
 #include <vector>
 
@@ -41,6 +42,99 @@
 namespace mesos {
 namespace allocator {
 
+/**
+ * The options the master passes to the allocator on initialization, see
+ * `Allocator::initialize()`. Allocators may ignore options they do not
+ * support.
+ */
+struct Options
+{
+  /**
+   * The order in which the allocator considers agents when making offers.
+   */
+  enum class OfferPackingPolicy
+  {
+    // Agents are shuffled randomly in every allocation cycle.
+    RANDOM,
+
+    // The most utilized agents are offered first.
+    BINPACK,
+
+    // The least utilized agents are offered first.
+    SPREAD,
+
+    // Agents with the highest sum of attribute weights are offered
+    // first, see `offerPackingAttributeWeights`.
+    ATTRIBUTE_WEIGHTED
+  };
+
+  /**
+   * A weight of the agents with an attribute of the given name or, if a
+   * value is given, only of those where the attribute has that value.
+   */
+  struct AttributeWeight
+  {
+    std::string name;
+    Option<std::string> value;
+    double weight;
+  };
+
+  /**
+   * Parses an offer packing policy: `random`, `binpack`, `spread` or
+   * `attribute_weighted`.
+   */
+  static Try<OfferPackingPolicy> parseOfferPackingPolicy(
+      const std::string& value);
+
+  /**
+   * Parses a comma-separated list of attribute weights of the form
+   * `name=weight` or `name:value=weight`.
+   */
+  static Try<std::vector<AttributeWeight>> parseAttributeWeights(
+      const std::string& value);
+
+  /**
+   * How often the allocator performs the batch allocation. An allocator
+   * may also perform allocation based on events (a framework is added
+   * and so on), this depends on the implementation.
+   */
+  Duration allocationInterval = Seconds(1);
+
+  /**
+   * The resources that are not considered for fair sharing, if any.
+   */
+  Option<std::set<std::string>> fairnessExcludeResourceNames = None();
+
+  /**
+   * Whether GPU resources are only offered to frameworks which have the
+   * `GPU_RESOURCES` capability.
+   */
+  bool filterGpuResources = true;
+
+  /**
+   * The fault domain of the master, if any.
+   */
+  Option<DomainInfo> domain = None();
+
+  /**
+   * The order in which the allocator considers agents when making offers.
+   */
+  OfferPackingPolicy offerPackingPolicy = OfferPackingPolicy::RANDOM;
+
+  /**
+   * The maximum number of agents a framework is offered resources on in
+   * a single allocation cycle, if any.
+   */
+  Option<size_t> maxOffersPerFramework = None();
+
+  /**
+   * The attribute weights of `OfferPackingPolicy::ATTRIBUTE_WEIGHTED`.
+   * The weights of all matching attributes of an agent are summed up.
+   */
+  std::vector<AttributeWeight> offerPackingAttributeWeights;
+};
+
+
 /**
  * Basic model of an allocator: resources are allocated to a framework
  * in the form of offers. A framework can refuse some resources in
@@ -73,6 +167,44 @@ public:
    * initialization should fail fast and result in an ABORT. The master expects
    * the allocator to be successfully initialized if this call returns.
    *
+   * The master initializes the allocator through this overload. By default
+   * it forwards to the overload below and drops the options that the latter
+   * does not take, so that allocator modules which only implement the latter
+   * keep working.
+   *
+   * @param options The options of the allocator, see `Options`.
+   * @param offerCallback A callback the allocator uses to send allocations
+   *     to the frameworks.
+   * @param inverseOfferCallback A callback the allocator uses to send reclaim
+   *     allocations from the frameworks.
+   */
+  virtual void initialize(
+      const Options& options,
+      const lambda::function<
+          void(const FrameworkID&,
+               const hashmap<std::string, hashmap<SlaveID, Resources>>&)>&
+                   offerCallback,
+      const lambda::function<
+          void(const FrameworkID&,
+               const hashmap<SlaveID, UnavailableResources>&)>&
+        inverseOfferCallback)
+  {
+    initialize(
+        options.allocationInterval,
+        offerCallback,
+        inverseOfferCallback,
+        options.fairnessExcludeResourceNames,
+        options.filterGpuResources,
+        options.domain);
+  }
+
+  /**
+   * Initializes the allocator when the master starts up. Any errors in
+   * initialization should fail fast and result in an ABORT. The master expects
+   * the allocator to be successfully initialized if this call returns.
+   *
+   * NOTE: New options are only added to `Options`, see the overload above.
+   *
    * @param allocationInterval The allocate interval for the allocator, it
    *     determines how often the allocator should perform the batch
    *     allocation. An allocator may also perform allocation based on events
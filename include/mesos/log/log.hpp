@@ -159,8 +159,18 @@ public:
     // one writer (local or remote) can be valid at any point in
     // time. A writer becomes invalid if either Writer::append or
     // Writer::truncate return None, in which case, the writer (or
-    // another writer) must be restarted.
-    explicit Writer(Log* log);
+    // another writer) must be restarted. Up to 'pipelineDepth'
+    // rounds of writes are in progress at the same time, and several
+    // writes are written in a single round only if 'batchWrites' is
+    // set (see the note on Writer::truncate).
+    //
+    // NOTE: Replicas of versions before 1.5 drop the messages of a
+    // batch, thus 'batchWrites' must only be set once all replicas
+    // have been upgraded.
+    explicit Writer(
+        Log* log,
+        size_t pipelineDepth = 1,
+        bool batchWrites = false);
     ~Writer();
 
     // Attempts to get a promise (from the log's replicas) for
@@ -180,6 +190,14 @@ public:
     // specificed position. Returns the new ending position of the log
     // or 'none' if this writer has lost its promise to exclusively
     // write (which can be reacquired by invoking Writer::start).
+    //
+    // NOTE: Appends and truncates may be issued without waiting for
+    // the previous ones to complete. They are performed in the order
+    // in which they are issued. A write is sent to the replicas right
+    // away as long as fewer than 'pipelineDepth' rounds of writes are
+    // in progress, otherwise it waits for a round to finish. If
+    // 'batchWrites' is set, the writes issued meanwhile are written
+    // together in the next round (i.e., group commit).
     process::Future<Option<Position>> truncate(const Position& to);
 
   private:
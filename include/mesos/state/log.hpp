@@ -39,7 +39,20 @@ class LogStorageProcess;
 class LogStorage : public mesos::state::Storage
 {
 public:
-  LogStorage(mesos::log::Log* log, size_t diffsBetweenSnapshots = 0);
+  // The format of the diffs that are written between snapshots. A
+  // DELTA is much cheaper to compute than an SVN diff for large
+  // entries, but it can not be read by versions that only support
+  // SVN diffs.
+  enum DiffFormat
+  {
+    SVN,
+    DELTA
+  };
+
+  LogStorage(
+      mesos::log::Log* log,
+      size_t diffsBetweenSnapshots = 0,
+      DiffFormat diffFormat = SVN);
 
   virtual ~LogStorage();
 
@@ -19,10 +19,14 @@
 
 #include <map>
 #include <iosfwd>
+#include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include <boost/iterator/iterator_adaptor.hpp>
+
 #include <google/protobuf/repeated_field.h>
 
 #include <mesos/v1/mesos.hpp>
@@ -35,6 +39,7 @@
 #include <stout/hashmap.hpp>
 #include <stout/json.hpp>
 #include <stout/lambda.hpp>
+#include <stout/nothing.hpp>
 #include <stout/option.hpp>
 #include <stout/try.hpp>
 
@@ -68,6 +73,19 @@ private:
   // together into a single 'Resource_' object and tracked by its internal
   // counter. Non-shared resource objects are not grouped.
   //
+  // 'Resource_' objects are immutable once they are referenced by more
+  // than one 'Resources' object, which allows copies of 'Resources'
+  // (e.g., the results of 'filter()') to share them. A 'Resources'
+  // object copies a 'Resource_' object before mutating it, unless it
+  // is the only owner. The same holds for the index below.
+  //
+  // Ownership rule: only the sole owner of a shared object may mutate
+  // it, and it must observe (with acquire semantics) that it is the
+  // sole owner before doing so, since other owners may have dropped
+  // their references from other threads. A 'Resources' object itself
+  // is not thread-safe, but its copies may be used and destroyed by
+  // different threads.
+  //
   // The rest of the private section is below the public section. We
   // need to define Resource_ first because the public typedefs below
   // depend on it.
@@ -344,12 +362,17 @@ public:
   /*implicit*/
   Resources(const google::protobuf::RepeatedPtrField<Resource>& _resources);
 
-  Resources(const Resources& that) : resources(that.resources) {}
+  Resources(const Resources& that)
+    : resources(that.resources),
+      index(that.index),
+      quantities(that.quantities) {}
 
   Resources& operator=(const Resources& that)
   {
     if (this != &that) {
       resources = that.resources;
+      index = that.index;
+      quantities = that.quantities;
     }
     return *this;
   }
@@ -469,17 +492,22 @@ public:
     Resources result = *this;
 
     foreach (const Offer::Operation& operation, operations) {
-      Try<Resources> transformed = result.apply(operation);
+      Try<Nothing> transformed = result.transform(operation);
       if (transformed.isError()) {
         return Error(transformed.error());
       }
-
-      result = transformed.get();
     }
 
     return result;
   }
 
+  // Applies the given offer operation to these Resources in place.
+  // Unlike `apply()`, this does not copy these Resources, so applying
+  // a sequence of operations only costs as much as the operations
+  // themselves. Returns the same errors as `apply()`, in which case
+  // these Resources are left unchanged.
+  Try<Nothing> transform(const Offer::Operation& operation);
+
   // Helpers to get resource values. We consider all roles here.
   template <typename T>
   Option<T> get(const std::string& name) const;
@@ -498,6 +526,11 @@ public:
   // enforced by Resources::parse().
   std::map<std::string, Value_Type> types() const;
 
+  // Get the total quantity of each scalar resource by name, across
+  // all roles. The totals are kept up to date as these Resources are
+  // modified, so this does not iterate over the resources.
+  std::map<std::string, Value::Scalar> scalarQuantities() const;
+
   // Helpers to get known resource types.
   // TODO(vinod): Fix this when we make these types as first class
   // protobufs.
@@ -513,24 +546,36 @@ public:
   // which holds the ephemeral ports allocation logic.
   Option<Value::Ranges> ephemeral_ports() const;
 
+  // Iterates over the (possibly shared) `Resource_` objects.
+  class const_iterator
+    : public boost::iterator_adaptor<
+          const_iterator,
+          std::vector<std::shared_ptr<Resource_>>::const_iterator,
+          const Resource_>
+  {
+  public:
+    const_iterator() {}
+
+    explicit const_iterator(
+        const std::vector<std::shared_ptr<Resource_>>::const_iterator& it)
+      : const_iterator::iterator_adaptor_(it) {}
+
+  private:
+    friend class boost::iterator_core_access;
+
+    const Resource_& dereference() const { return **base(); }
+  };
+
   // NOTE: Non-`const` `iterator`, `begin()` and `end()` are __intentionally__
   // defined with `const` semantics in order to prevent mutable access to the
   // `Resource` objects within `resources`.
-  typedef std::vector<Resource_>::const_iterator iterator;
-  typedef std::vector<Resource_>::const_iterator const_iterator;
-
-  const_iterator begin()
-  {
-    return static_cast<const std::vector<Resource_>&>(resources).begin();
-  }
+  typedef const_iterator iterator;
 
-  const_iterator end()
-  {
-    return static_cast<const std::vector<Resource_>&>(resources).end();
-  }
+  const_iterator begin() { return const_iterator(resources.cbegin()); }
+  const_iterator end() { return const_iterator(resources.cend()); }
 
-  const_iterator begin() const { return resources.begin(); }
-  const_iterator end() const { return resources.end(); }
+  const_iterator begin() const { return const_iterator(resources.cbegin()); }
+  const_iterator end() const { return const_iterator(resources.cend()); }
 
   // Using this operator makes it easy to copy a resources object into
   // a protocol buffer field.
@@ -574,6 +619,14 @@ private:
   // returns Resources.
   Option<Resources> find(const Resource& target) const;
 
+  // Applies the given offer operation in place and accumulates the
+  // removed and added resources in `consumed` and `converted`. If an
+  // error is returned, the operation may have been partially applied.
+  Option<Error> _transform(
+      const Offer::Operation& operation,
+      Resources* consumed,
+      Resources* converted);
+
   // Validation-free versions of += and -= `Resource_` operators.
   // These can be used when `r` is already validated.
   //
@@ -582,13 +635,76 @@ private:
   void add(const Resource_& r);
   void subtract(const Resource_& r);
 
+  // Adds a `Resource_` object of another `Resources` object, which is
+  // shared rather than copied if it cannot be combined.
+  void add(const std::shared_ptr<Resource_>& r);
+
+  // Appends a `Resource_` object that cannot be combined.
+  void append(const std::shared_ptr<Resource_>& r);
+
+  // Returns the `Resource_` object at the given position for mutation,
+  // copying it first if it is shared with other `Resources` objects.
+  Resource_& exclusive(size_t position);
+
+  // Updates the total quantity of the scalar resource with the given
+  // name. These must be called whenever the scalar value of a
+  // `Resource_` object is added to or removed from `resources`.
+  void addQuantity(const std::string& name, const Value::Scalar& quantity);
+  void subtractQuantity(
+      const std::string& name,
+      const Value::Scalar& quantity);
+
   Resources operator+(const Resource_& that) const;
   Resources& operator+=(const Resource_& that);
 
   Resources operator-(const Resource_& that) const;
   Resources& operator-=(const Resource_& that);
 
-  std::vector<Resource_> resources;
+  // Returns the position of a `Resource_` object that satisfies the
+  // predicate. Only `Resource_` objects with the same identity as
+  // `that` (see `Index`) are considered if the index is built, so
+  // the predicate must not hold for any others.
+  Option<size_t> lookup(
+      const Resource& that,
+      const lambda::function<bool(const Resource_&)>& predicate) const;
+
+  // (Re)builds the index over all `Resource_` objects, e.g., after
+  // they have been modified in place.
+  void reindex();
+
+  std::vector<std::shared_ptr<Resource_>> resources;
+
+  // Once a `Resources` object holds more than a few `Resource_`
+  // objects (e.g., the resources of an agent with many reservations
+  // or persistent volumes), we index them by their identity, i.e., a
+  // hash of the fields that need to be equal for two `Resource`
+  // objects to be addable or subtractable. This avoids comparing
+  // against every `Resource_` object when adding, subtracting or
+  // checking containment.
+  struct Index
+  {
+    // Appends the identity of a `Resource_` object added at the end.
+    void insert(const Resource& resource);
+
+    // Mirrors swapping the `Resource_` object at the given position
+    // with the last one and removing it.
+    void erase(size_t position);
+
+    // The identity of the `Resource_` object at each position.
+    std::vector<size_t> identities;
+
+    // The positions of the `Resource_` objects by identity.
+    std::unordered_multimap<size_t, size_t> positions;
+  };
+
+  // Like `Resource_` objects, the index is shared between copies and
+  // copied before being mutated by one that does not exclusively own it.
+  std::shared_ptr<Index> index;
+
+  // The total quantity of each scalar resource by name, which is
+  // updated along with `resources` and shared between copies like
+  // the index. This is null until a scalar resource is added.
+  std::shared_ptr<std::map<std::string, Value::Scalar>> quantities;
 };
 
 
@@ -16,11 +16,14 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <ostream>
 #include <set>
 #include <string>
 #include <vector>
 
+#include <boost/functional/hash.hpp>
+
 #include <glog/logging.h>
 
 #include <google/protobuf/repeated_field.h>
@@ -41,8 +44,10 @@
 #include "common/resources_utils.hpp"
 
 using std::map;
+using std::make_shared;
 using std::ostream;
 using std::set;
+using std::shared_ptr;
 using std::string;
 using std::vector;
 
@@ -564,6 +569,77 @@ static bool contains(const Resource& left, const Resource& right)
 }
 
 
+// The number of `Resource_` objects beyond which `Resources` indexes
+// them by identity, see `Resources::Index`.
+constexpr size_t RESOURCES_INDEX_THRESHOLD = 16;
+
+
+// Returns true if the given object, which is shared between copies of
+// a `Resources` object, is only referenced by the caller, who may then
+// mutate it in place. Otherwise the caller must copy it first.
+//
+// NOTE: Copies of a `Resources` object are routinely handed to other
+// actors, which may drop them concurrently. `use_count()` is a relaxed
+// load, so the acquire fence is needed to synchronize with the release
+// decrement of the last other owner. Without it our writes could race
+// with the reads that owner made before dropping its reference.
+template <typename T>
+static bool unique(const std::shared_ptr<T>& t)
+{
+  if (t.use_count() > 1) {
+    return false;
+  }
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return true;
+}
+
+
+// Returns the identity of a Resource object, i.e., a hash of some of
+// the fields which 'addable' and 'subtractable' require to be equal.
+// Resource objects with different identities are never addable or
+// subtractable, while those with the same identity may not be either.
+static size_t identity(const Resource& resource)
+{
+  size_t seed = 0;
+
+  boost::hash_combine(seed, resource.name());
+  boost::hash_combine(seed, static_cast<int>(resource.type()));
+  boost::hash_combine(seed, resource.has_shared());
+  boost::hash_combine(seed, resource.has_revocable());
+
+  if (resource.has_allocation_info()) {
+    boost::hash_combine(seed, resource.allocation_info().role());
+  }
+
+  boost::hash_combine(seed, resource.reservations_size());
+
+  foreach (const Resource::ReservationInfo& reservation,
+           resource.reservations()) {
+    boost::hash_combine(seed, reservation.role());
+  }
+
+  if (resource.has_disk()) {
+    const Resource::DiskInfo& disk = resource.disk();
+
+    if (disk.has_persistence()) {
+      boost::hash_combine(seed, disk.persistence().id());
+    }
+
+    if (disk.has_source()) {
+      boost::hash_combine(seed, static_cast<int>(disk.source().type()));
+      boost::hash_combine(seed, disk.source().id());
+    }
+  }
+
+  if (resource.has_provider_id()) {
+    boost::hash_combine(seed, resource.provider_id().value());
+  }
+
+  return seed;
+}
+
+
 /**
  * Checks that a Resources object is valid for command line specification.
  *
@@ -1356,18 +1432,26 @@ Resources::Resources(const RepeatedPtrField<Resource>& _resources)
 
 bool Resources::contains(const Resources& that) const
 {
-  Resources remaining = *this;
+  // We only need to copy the resources if we have to subtract
+  // persistent volumes, as copying large port ranges is expensive.
+  Option<Resources> remaining;
+
+  foreach (const Resource_& resource_, that) {
+    const Resources& current = remaining.isSome() ? remaining.get() : *this;
 
-  foreach (const Resource_& resource_, that.resources) {
     // NOTE: We use _contains because Resources only contain valid
     // Resource objects, and we don't want the performance hit of the
     // validity check.
-    if (!remaining._contains(resource_)) {
+    if (!current._contains(resource_)) {
       return false;
     }
 
     if (isPersistentVolume(resource_.resource)) {
-      remaining.subtract(resource_);
+      if (remaining.isNone()) {
+        remaining = *this;
+      }
+
+      remaining->subtract(resource_);
     }
   }
 
@@ -1386,33 +1470,52 @@ bool Resources::contains(const Resource& that) const
 
 size_t Resources::count(const Resource& that) const
 {
-  foreach (const Resource_& resource_, resources) {
-    if (resource_.resource == that) {
-      // Return 1 for non-shared resources because non-shared
-      // Resource objects in Resources are unique.
-      return resource_.isShared() ? resource_.sharedCount.get() : 1;
-    }
+  Option<size_t> position = lookup(
+      that,
+      [&that](const Resource_& resource_) {
+        return resource_.resource == that;
+      });
+
+  if (position.isNone()) {
+    return 0;
   }
 
-  return 0;
+  const Resource_& resource_ = *resources[position.get()];
+
+  // Return 1 for non-shared resources because non-shared
+  // Resource objects in Resources are unique.
+  return resource_.isShared() ? resource_.sharedCount.get() : 1;
 }
 
 
 void Resources::allocate(const string& role)
 {
-  foreach (Resource_& resource_, resources) {
-    resource_.resource.mutable_allocation_info()->set_role(role);
+  for (size_t i = 0; i < resources.size(); i++) {
+    const Resource& resource = resources[i]->resource;
+
+    if (!resource.has_allocation_info() ||
+        resource.allocation_info().role() != role) {
+      exclusive(i).resource.mutable_allocation_info()->set_role(role);
+    }
+  }
+
+  if (index != nullptr) {
+    reindex();
   }
 }
 
 
 void Resources::unallocate()
 {
-  foreach (Resource_& resource_, resources) {
-    if (resource_.resource.has_allocation_info()) {
-      resource_.resource.clear_allocation_info();
+  for (size_t i = 0; i < resources.size(); i++) {
+    if (resources[i]->resource.has_allocation_info()) {
+      exclusive(i).resource.clear_allocation_info();
     }
   }
+
+  if (index != nullptr) {
+    reindex();
+  }
 }
 
 
@@ -1420,8 +1523,8 @@ Resources Resources::filter(
     const lambda::function<bool(const Resource&)>& predicate) const
 {
   Resources result;
-  foreach (const Resource_& resource_, resources) {
-    if (predicate(resource_.resource)) {
+  foreach (const shared_ptr<Resource_>& resource_, resources) {
+    if (predicate(resource_->resource)) {
       result.add(resource_);
     }
   }
@@ -1433,9 +1536,9 @@ hashmap<string, Resources> Resources::reservations() const
 {
   hashmap<string, Resources> result;
 
-  foreach (const Resource_& resource_, resources) {
-    if (isReserved(resource_.resource)) {
-      result[reservationRole(resource_.resource)].add(resource_);
+  foreach (const shared_ptr<Resource_>& resource_, resources) {
+    if (isReserved(resource_->resource)) {
+      result[reservationRole(resource_->resource)].add(resource_);
     }
   }
 
@@ -1497,12 +1600,12 @@ hashmap<string, Resources> Resources::allocations() const
 {
   hashmap<string, Resources> result;
 
-  foreach (const Resource_& resource_, resources) {
+  foreach (const shared_ptr<Resource_>& resource_, resources) {
     // We require that this is called only when
     // the resources are allocated.
-    CHECK(resource_.resource.has_allocation_info());
-    CHECK(resource_.resource.allocation_info().has_role());
-    result[resource_.resource.allocation_info().role()].add(resource_);
+    CHECK(resource_->resource.has_allocation_info());
+    CHECK(resource_->resource.allocation_info().has_role());
+    result[resource_->resource.allocation_info().role()].add(resource_);
   }
 
   return result;
@@ -1528,7 +1631,7 @@ Resources Resources::popReservation() const
 {
   Resources result;
 
-  foreach (Resource_ resource_, resources) {
+  foreach (Resource_ resource_, *this) {
     CHECK_GT(resource_.resource.reservations_size(), 0);
     resource_.resource.mutable_reservations()->RemoveLast();
     result.add(resource_);
@@ -1555,7 +1658,7 @@ Resources Resources::createStrippedScalarQuantity() const
 {
   Resources stripped;
 
-  foreach (const Resource& resource, resources) {
+  foreach (const Resource& resource, *this) {
     if (resource.type() == Value::SCALAR) {
       Resource scalar = resource;
       scalar.clear_provider_id();
@@ -1605,6 +1708,56 @@ Try<Resources> Resources::apply(const Offer::Operation& operation) const
 {
   Resources result = *this;
 
+  Try<Nothing> transformed = result.transform(operation);
+  if (transformed.isError()) {
+    return Error(transformed.error());
+  }
+
+  return result;
+}
+
+
+Try<Nothing> Resources::transform(const Offer::Operation& operation)
+{
+  // The resources removed from and added to these resources.
+  Resources consumed;
+  Resources converted;
+
+  Option<Error> error = _transform(operation, &consumed, &converted);
+
+  if (error.isSome()) {
+    // Revert the operation, which may have been partially applied.
+    foreach (const Resource_& resource_, converted) {
+      subtract(resource_);
+    }
+
+    foreach (const shared_ptr<Resource_>& resource_, consumed.resources) {
+      add(resource_);
+    }
+
+    return Error(error->message);
+  }
+
+  // The following are sanity checks to ensure the amount of each type of
+  // resource does not change.
+  // TODO(jieyu): Currently, we only check known resource types like
+  // cpus, gpus, mem, disk, ports, etc. We should generalize this.
+
+  CHECK(converted.cpus() == consumed.cpus());
+  CHECK(converted.gpus() == consumed.gpus());
+  CHECK(converted.mem() == consumed.mem());
+  CHECK(converted.disk() == consumed.disk());
+  CHECK(converted.ports() == consumed.ports());
+
+  return Nothing();
+}
+
+
+Option<Error> Resources::_transform(
+    const Offer::Operation& operation,
+    Resources* consumed,
+    Resources* converted)
+{
   switch (operation.type()) {
     case Offer::Operation::LAUNCH:
       // Launch operation does not alter the offered resources.
@@ -1632,13 +1785,16 @@ Try<Resources> Resources::apply(const Offer::Operation& operation) const
         // Note that we only allow "pushing" a single reservation at time.
         Resources resources = Resources(reserved).popReservation();
 
-        if (!result.contains(resources)) {
-          return Error("Invalid RESERVE Operation: " + stringify(result) +
+        if (!contains(resources)) {
+          return Error("Invalid RESERVE Operation: " + stringify(*this) +
                        " does not contain " + stringify(resources));
         }
 
-        result -= resources;
-        result.add(reserved);
+        *this -= resources;
+        *consumed += resources;
+
+        add(reserved);
+        converted->add(reserved);
       }
       break;
     }
@@ -1658,16 +1814,19 @@ Try<Resources> Resources::apply(const Offer::Operation& operation) const
               " dynamically reserved");
         }
 
-        if (!result.contains(reserved)) {
-          return Error("Invalid UNRESERVE Operation: " + stringify(result) +
+        if (!contains(reserved)) {
+          return Error("Invalid UNRESERVE Operation: " + stringify(*this) +
                        " does not contain " + stringify(reserved));
         }
 
         // Note that we only allow "popping" a single reservation at time.
         Resources resources = Resources(reserved).popReservation();
 
-        result.subtract(reserved);
-        result += resources;
+        subtract(reserved);
+        consumed->add(reserved);
+
+        *this += resources;
+        *converted += resources;
       }
       break;
     }
@@ -1704,13 +1863,16 @@ Try<Resources> Resources::apply(const Offer::Operation& operation) const
         // original resource must be non-shared.
         stripped.clear_shared();
 
-        if (!result.contains(stripped)) {
+        if (!contains(stripped)) {
           return Error("Invalid CREATE Operation: Insufficient disk resources"
                        " for persistent volume " + stringify(volume));
         }
 
-        result.subtract(stripped);
-        result.add(volume);
+        subtract(stripped);
+        consumed->add(stripped);
+
+        add(volume);
+        converted->add(volume);
       }
       break;
     }
@@ -1728,14 +1890,15 @@ Try<Resources> Resources::apply(const Offer::Operation& operation) const
           return Error("Invalid DESTROY Operation: Missing 'persistence'");
         }
 
-        if (!result.contains(volume)) {
+        if (!contains(volume)) {
           return Error(
               "Invalid DESTROY Operation: Persistent volume does not exist");
         }
 
-        result.subtract(volume);
+        subtract(volume);
+        consumed->add(volume);
 
-        if (result.contains(volume)) {
+        if (contains(volume)) {
           return Error(
               "Invalid DESTROY Operation: Persistent volume " +
               stringify(volume) + " cannot be removed due to additional " +
@@ -1757,7 +1920,8 @@ Try<Resources> Resources::apply(const Offer::Operation& operation) const
         // return the resource to non-shared state after destroy.
         stripped.clear_shared();
 
-        result.add(stripped);
+        add(stripped);
+        converted->add(stripped);
       }
       break;
     }
@@ -1782,39 +1946,20 @@ Try<Resources> Resources::apply(const Offer::Operation& operation) const
       return Error("Unknown offer operation");
   }
 
-  // The following are sanity checks to ensure the amount of each type of
-  // resource does not change.
-  // TODO(jieyu): Currently, we only check known resource types like
-  // cpus, gpus, mem, disk, ports, etc. We should generalize this.
-
-  CHECK(result.cpus() == cpus());
-  CHECK(result.gpus() == gpus());
-  CHECK(result.mem() == mem());
-  CHECK(result.disk() == disk());
-  CHECK(result.ports() == ports());
-
-  return result;
+  return None();
 }
 
 
 template <>
 Option<Value::Scalar> Resources::get(const string& name) const
 {
-  Value::Scalar total;
-  bool found = false;
-
-  foreach (const Resource& resource, resources) {
-    if (resource.name() == name &&
-        resource.type() == Value::SCALAR) {
-      total += resource.scalar();
-      found = true;
+  if (quantities != nullptr) {
+    auto it = quantities->find(name);
+    if (it != quantities->end()) {
+      return it->second;
     }
   }
 
-  if (found) {
-    return total;
-  }
-
   return None();
 }
 
@@ -1825,7 +1970,7 @@ Option<Value::Set> Resources::get(const string& name) const
   Value::Set total;
   bool found = false;
 
-  foreach (const Resource& resource, resources) {
+  foreach (const Resource& resource, *this) {
     if (resource.name() == name &&
         resource.type() == Value::SET) {
       total += resource.set();
@@ -1847,7 +1992,7 @@ Option<Value::Ranges> Resources::get(const string& name) const
   Value::Ranges total;
   bool found = false;
 
-  foreach (const Resource& resource, resources) {
+  foreach (const Resource& resource, *this) {
     if (resource.name() == name &&
         resource.type() == Value::RANGES) {
       total += resource.ranges();
@@ -1882,7 +2027,7 @@ Resources Resources::scalars() const
 set<string> Resources::names() const
 {
   set<string> result;
-  foreach (const Resource& resource, resources) {
+  foreach (const Resource& resource, *this) {
     result.insert(resource.name());
   }
 
@@ -1893,7 +2038,7 @@ set<string> Resources::names() const
 map<string, Value_Type> Resources::types() const
 {
   map<string, Value_Type> result;
-  foreach (const Resource& resource, resources) {
+  foreach (const Resource& resource, *this) {
     result[resource.name()] = resource.type();
   }
 
@@ -1901,6 +2046,16 @@ map<string, Value_Type> Resources::types() const
 }
 
 
+map<string, Value::Scalar> Resources::scalarQuantities() const
+{
+  if (quantities == nullptr) {
+    return map<string, Value::Scalar>();
+  }
+
+  return *quantities;
+}
+
+
 Option<double> Resources::cpus() const
 {
   Option<Value::Scalar> value = get<Value::Scalar>("cpus");
@@ -1973,13 +2128,11 @@ Option<Value::Ranges> Resources::ephemeral_ports() const
 
 bool Resources::_contains(const Resource_& that) const
 {
-  foreach (const Resource_& resource_, resources) {
-    if (resource_.contains(that)) {
-      return true;
-    }
-  }
-
-  return false;
+  return lookup(
+      that,
+      [&that](const Resource_& resource_) {
+        return resource_.contains(that);
+      }).isSome();
 }
 
 
@@ -2035,7 +2188,7 @@ Option<Resources> Resources::find(const Resource& target) const
 Resources::operator RepeatedPtrField<Resource>() const
 {
   RepeatedPtrField<Resource> all;
-  foreach (const Resource& resource, resources) {
+  foreach (const Resource& resource, *this) {
     all.Add()->CopyFrom(resource);
   }
 
@@ -2085,18 +2238,121 @@ void Resources::add(const Resource_& that)
     return;
   }
 
-  bool found = false;
-  foreach (Resource_& resource_, resources) {
-    if (internal::addable(resource_.resource, that)) {
-      resource_ += that;
-      found = true;
-      break;
+  Option<size_t> position = lookup(
+      that,
+      [&that](const Resource_& resource_) {
+        return internal::addable(resource_.resource, that);
+      });
+
+  if (position.isSome()) {
+    exclusive(position.get()) += that;
+
+    // Adding a shared resource only increments its count.
+    if (that.resource.type() == Value::SCALAR && !that.isShared()) {
+      addQuantity(that.resource.name(), that.resource.scalar());
+    }
+
+    return;
+  }
+
+  // Cannot be combined with any existing Resource object.
+  append(make_shared<Resource_>(that));
+}
+
+
+void Resources::add(const shared_ptr<Resource_>& that)
+{
+  if (that->isEmpty()) {
+    return;
+  }
+
+  Option<size_t> position = lookup(
+      *that,
+      [&that](const Resource_& resource_) {
+        return internal::addable(resource_.resource, *that);
+      });
+
+  if (position.isSome()) {
+    exclusive(position.get()) += *that;
+
+    // Adding a shared resource only increments its count.
+    if (that->resource.type() == Value::SCALAR && !that->isShared()) {
+      addQuantity(that->resource.name(), that->resource.scalar());
     }
+
+    return;
   }
 
   // Cannot be combined with any existing Resource object.
-  if (!found) {
-    resources.push_back(that);
+  append(that);
+}
+
+
+void Resources::append(const shared_ptr<Resource_>& that)
+{
+  resources.push_back(that);
+
+  if (that->resource.type() == Value::SCALAR) {
+    addQuantity(that->resource.name(), that->resource.scalar());
+  }
+
+  if (index != nullptr) {
+    if (!internal::unique(index)) {
+      index = make_shared<Index>(*index);
+    }
+
+    index->insert(*that);
+  } else if (resources.size() > internal::RESOURCES_INDEX_THRESHOLD) {
+    reindex();
+  }
+}
+
+
+Resources::Resource_& Resources::exclusive(size_t position)
+{
+  CHECK_LT(position, resources.size());
+
+  shared_ptr<Resource_>& resource_ = resources[position];
+
+  if (!internal::unique(resource_)) {
+    resource_ = make_shared<Resource_>(*resource_);
+  }
+
+  return *resource_;
+}
+
+
+void Resources::addQuantity(const string& name, const Value::Scalar& quantity)
+{
+  if (quantities == nullptr) {
+    quantities = make_shared<map<string, Value::Scalar>>();
+  } else if (!internal::unique(quantities)) {
+    quantities = make_shared<map<string, Value::Scalar>>(*quantities);
+  }
+
+  (*quantities)[name] += quantity;
+}
+
+
+void Resources::subtractQuantity(
+    const string& name,
+    const Value::Scalar& quantity)
+{
+  CHECK(quantities != nullptr);
+
+  if (!internal::unique(quantities)) {
+    quantities = make_shared<map<string, Value::Scalar>>(*quantities);
+  }
+
+  auto it = quantities->find(name);
+  CHECK(it != quantities->end());
+
+  it->second -= quantity;
+
+  // Scalar `Resource_` objects are positive, so the total drops to
+  // zero once the last one with this name has been removed.
+  if (it->second.value() <= 0) {
+    quantities->erase(it);
   }
 }
 
@@ -2121,7 +2377,7 @@ Resources& Resources::operator+=(const Resource& that)
 
 Resources& Resources::operator+=(const Resources& that)
 {
-  foreach (const Resource_& resource_, that) {
+  foreach (const shared_ptr<Resource_>& resource_, that.resources) {
     add(resource_);
   }
 
@@ -2159,37 +2415,143 @@ void Resources::subtract(const Resource_& that)
     return;
   }
 
-  for (size_t i = 0; i < resources.size(); i++) {
-    Resource_& resource_ = resources[i];
-
-    if (internal::subtractable(resource_.resource, that)) {
-      resource_ -= that;
-
-      // Remove the resource if it has become negative or empty.
-      // Note that a negative resource means the caller is
-      // subtracting more than they should!
-      //
-      // TODO(gyliu513): Provide a stronger interface to avoid
-      // silently allowing this to occur.
-
-      // A "negative" Resource_ either has a negative sharedCount or
-      // a negative scalar value.
-      bool negative =
-        (resource_.isShared() && resource_.sharedCount.get() < 0) ||
-        (resource_.resource.type() == Value::SCALAR &&
-         resource_.resource.scalar().value() < 0);
-
-      if (negative || resource_.isEmpty()) {
-        // As `resources` is not ordered, and erasing an element
-        // from the middle is expensive, we swap with the last element
-        // and then shrink the vector by one.
-        resources[i] = resources.back();
-        resources.pop_back();
+  Option<size_t> position = lookup(
+      that,
+      [&that](const Resource_& resource_) {
+        return internal::subtractable(resource_.resource, that);
+      });
+
+  if (position.isNone()) {
+    return;
+  }
+
+  const size_t i = position.get();
+  Resource_& resource_ = exclusive(i);
+
+  const bool scalar = resource_.resource.type() == Value::SCALAR;
+
+  Value::Scalar before;
+  if (scalar) {
+    before = resource_.resource.scalar();
+  }
+
+  resource_ -= that;
+
+  // Remove the resource if it has become negative or empty.
+  // Note that a negative resource means the caller is
+  // subtracting more than they should!
+  //
+  // TODO(gyliu513): Provide a stronger interface to avoid
+  // silently allowing this to occur.
+
+  // A "negative" Resource_ either has a negative sharedCount or
+  // a negative scalar value.
+  bool negative =
+    (resource_.isShared() && resource_.sharedCount.get() < 0) ||
+    (resource_.resource.type() == Value::SCALAR &&
+     resource_.resource.scalar().value() < 0);
+
+  if (negative || resource_.isEmpty()) {
+    if (scalar) {
+      subtractQuantity(resource_.resource.name(), before);
+    }
+
+    // As `resources` is not ordered, and erasing an element
+    // from the middle is expensive, we swap with the last element
+    // and then shrink the vector by one.
+    resources[i] = resources.back();
+    resources.pop_back();
+
+    if (index != nullptr) {
+      if (!internal::unique(index)) {
+        index = make_shared<Index>(*index);
       }
 
-      break;
+      index->erase(i);
+    }
+  } else if (scalar && !resource_.isShared()) {
+    // Subtracting a shared resource only decrements its count.
+    subtractQuantity(
+        resource_.resource.name(),
+        before - resource_.resource.scalar());
+  }
+}
+
+
+Option<size_t> Resources::lookup(
+    const Resource& that,
+    const lambda::function<bool(const Resource_&)>& predicate) const
+{
+  if (index == nullptr) {
+    for (size_t i = 0; i < resources.size(); i++) {
+      if (predicate(*resources[i])) {
+        return i;
+      }
+    }
+
+    return None();
+  }
+
+  auto range = index->positions.equal_range(internal::identity(that));
+
+  for (auto it = range.first; it != range.second; ++it) {
+    if (predicate(*resources[it->second])) {
+      return it->second;
+    }
+  }
+
+  return None();
+}
+
+
+void Resources::reindex()
+{
+  index = make_shared<Index>();
+
+  foreach (const Resource_& resource_, *this) {
+    index->insert(resource_);
+  }
+}
+
+
+void Resources::Index::insert(const Resource& resource)
+{
+  const size_t identity = internal::identity(resource);
+
+  positions.emplace(identity, identities.size());
+  identities.push_back(identity);
+}
+
+
+void Resources::Index::erase(size_t position)
+{
+  CHECK_LT(position, identities.size());
+
+  const size_t last = identities.size() - 1;
+
+  // Removes the entry for the given identity and position.
+  auto remove = [this](size_t identity, size_t position) {
+    auto range = positions.equal_range(identity);
+
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == position) {
+        positions.erase(it);
+        return;
+      }
     }
+
+    UNREACHABLE();
+  };
+
+  remove(identities[position], position);
+
+  if (position != last) {
+    remove(identities[last], last);
+    positions.emplace(identities[last], position);
+    identities[position] = identities[last];
   }
+
+  identities.pop_back();
 }
 
 
@@ -40,9 +40,6 @@ using std::ostream;
 using std::string;
 using std::vector;
 
-using mesos::internal::values::intervalSetToRanges;
-using mesos::internal::values::rangesToIntervalSet;
-
 namespace mesos {
 
 // We manipulate scalar values by converting them from floating point to a
@@ -145,39 +142,59 @@ struct Range
 };
 
 
-// Coalesces the vector of ranges provided and modifies `result` to contain the
-// solution.
+// Returns whether the ranges are sorted, disjoint and non-adjacent,
+// i.e., whether coalescing them would not change them. This holds for
+// the ranges of resources that are the result of arithmetic.
+static bool coalesced(const Value::Ranges& ranges)
+{
+  for (int i = 0; i < ranges.range_size(); i++) {
+    const Value::Range& range = ranges.range(i);
+
+    if (range.begin() > range.end()) {
+      return false;
+    }
+
+    if (i > 0) {
+      const uint64_t previousEnd = ranges.range(i - 1).end();
+
+      if (range.begin() <= previousEnd || range.begin() - previousEnd == 1) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+
+// Coalesces the vector of ranges provided in place.
 // The algorithm first sorts all the individual intervals so that we can iterate
 // over them sequentially.
 // The algorithm does a single pass, after the sort, and builds up the solution
-// in place. It then modifies the `result` with as few steps as possible. The
-// expensive part of this operation is modification of the protobuf, which is
-// why we prefer to build up the solution in a temporary vector.
-void coalesce(Value::Ranges* result, vector<Range> ranges)
+// in place.
+static void coalesce(vector<Range>* ranges)
 {
   // Exit early if empty.
-  if (ranges.empty()) {
-    result->clear_range();
+  if (ranges->empty()) {
     return;
   }
 
   std::sort(
-      ranges.begin(),
-      ranges.end(),
+      ranges->begin(),
+      ranges->end(),
       [](const Range& left, const Range& right) {
         return std::tie(left.start, left.end) <
                std::tie(right.start, right.end);
       });
 
   // We build up initial state of the current range.
-  CHECK(!ranges.empty());
   int count = 1;
-  Range current = ranges.front();
+  Range current = ranges->front();
 
   // In a single pass, we compute the size of the end result, as well as modify
   // in place the intermediate data structure to build up result as we
   // solve it.
-  foreach (const Range& range, ranges) {
+  foreach (const Range& range, *ranges) {
     // Skip if this range is equivalent to the current range.
     if (range.start == current.start && range.end == current.end) {
       continue;
@@ -193,7 +210,7 @@ void coalesce(Value::Ranges* result, vector<Range> ranges)
         current.end = max(current.end, range.end);
       } else {
         // 2. No overlap and we are adding a new range.
-        ranges[count - 1] = current;
+        (*ranges)[count - 1] = current;
         ++count;
         current = range;
       }
@@ -201,9 +218,43 @@ void coalesce(Value::Ranges* result, vector<Range> ranges)
   }
 
   // Record the state of the last range into of ranges vector.
-  ranges[count - 1] = current;
+  (*ranges)[count - 1] = current;
+
+  CHECK(count <= static_cast<int>(ranges->size()));
+
+  ranges->resize(count);
+}
+
+
+// Returns the given ranges as a sorted vector of disjoint and
+// non-adjacent ranges. This is the representation that the arithmetic
+// and comparison operators below work on, which allows them to merge
+// their operands in a single pass. Sorting is skipped if the ranges
+// are coalesced already.
+static vector<Range> intervals(const Value::Ranges& ranges)
+{
+  vector<Range> result;
+  result.reserve(ranges.range_size());
+
+  foreach (const Value::Range& range, ranges.range()) {
+    result.push_back({range.begin(), range.end()});
+  }
 
-  CHECK(count <= static_cast<int>(ranges.size()));
+  if (!coalesced(ranges)) {
+    coalesce(&result);
+  }
+
+  return result;
+}
+
+
+// Modifies `result` to contain the given sorted ranges with as few steps
+// as possible. The expensive part of the arithmetic is modification of
+// the protobuf, which is why we prefer to build up the solution in a
+// temporary vector.
+static void assign(Value::Ranges* result, const vector<Range>& ranges)
+{
+  const int count = static_cast<int>(ranges.size());
 
   // Shrink result if it is too large by deleting trailing subrange.
   if (count < result->range_size()) {
@@ -229,6 +280,90 @@ void coalesce(Value::Ranges* result, vector<Range> ranges)
   CHECK_EQ(result->range_size(), count);
 }
 
+
+// Coalesces the vector of ranges provided and modifies `result` to contain the
+// solution.
+void coalesce(Value::Ranges* result, vector<Range> ranges)
+{
+  coalesce(&ranges);
+  assign(result, ranges);
+}
+
+
+// Returns the union of two sorted vectors of disjoint and non-adjacent
+// ranges, computed in a single pass.
+static vector<Range> unite(
+    const vector<Range>& left,
+    const vector<Range>& right)
+{
+  vector<Range> result;
+  result.reserve(left.size() + right.size());
+
+  size_t i = 0;
+  size_t j = 0;
+
+  while (i < left.size() || j < right.size()) {
+    const bool takeLeft = j == right.size() ||
+      (i < left.size() && left[i].start < right[j].start);
+
+    const Range& range = takeLeft ? left[i++] : right[j++];
+
+    // Extend the last range if the range overlaps or is adjacent to it.
+    if (!result.empty() &&
+        (range.start <= result.back().end ||
+         range.start - result.back().end == 1)) {
+      result.back().end = max(result.back().end, range.end);
+    } else {
+      result.push_back(range);
+    }
+  }
+
+  return result;
+}
+
+
+// Returns the difference of two sorted vectors of disjoint and
+// non-adjacent ranges, computed in a single pass.
+static vector<Range> subtract(
+    const vector<Range>& left,
+    const vector<Range>& right)
+{
+  vector<Range> result;
+  result.reserve(left.size());
+
+  size_t j = 0;
+
+  foreach (Range range, left) {
+    // Skip the ranges that end before this range.
+    while (j < right.size() && right[j].end < range.start) {
+      ++j;
+    }
+
+    bool remaining = true;
+
+    // Cut out the ranges that overlap with this range. The last of them
+    // might also overlap with the next range, so we do not skip it.
+    for (; j < right.size() && right[j].start <= range.end; ++j) {
+      if (right[j].start > range.start) {
+        result.push_back({range.start, right[j].start - 1});
+      }
+
+      if (right[j].end >= range.end) {
+        remaining = false;
+        break;
+      }
+
+      range.start = right[j].end + 1;
+    }
+
+    if (remaining) {
+      result.push_back(range);
+    }
+  }
+
+  return result;
+}
+
 } // namespace internal {
 
 
@@ -295,55 +430,41 @@ ostream& operator<<(ostream& stream, const Value::Ranges& ranges)
 
 bool operator==(const Value::Ranges& _left, const Value::Ranges& _right)
 {
-  Value::Ranges left;
-  coalesce(&left, {_left});
+  const vector<internal::Range> left = internal::intervals(_left);
+  const vector<internal::Range> right = internal::intervals(_right);
 
-  Value::Ranges right;
-  coalesce(&right, {_right});
-
-  if (left.range_size() == right.range_size()) {
-    for (int i = 0; i < left.range_size(); i++) {
-      // Make sure this range is equal to a range in the right.
-      bool found = false;
-      for (int j = 0; j < right.range_size(); j++) {
-        if (left.range(i).begin() == right.range(j).begin() &&
-            left.range(i).end() == right.range(j).end()) {
-          found = true;
-          break;
-        }
-      }
+  if (left.size() != right.size()) {
+    return false;
+  }
 
-      if (!found) {
-        return false;
-      }
+  for (size_t i = 0; i < left.size(); i++) {
+    if (left[i].start != right[i].start || left[i].end != right[i].end) {
+      return false;
     }
-
-    return true;
   }
 
-  return false;
+  return true;
 }
 
 
 bool operator<=(const Value::Ranges& _left, const Value::Ranges& _right)
 {
-  Value::Ranges left;
-  coalesce(&left, {_left});
+  const vector<internal::Range> left = internal::intervals(_left);
+  const vector<internal::Range> right = internal::intervals(_right);
 
-  Value::Ranges right;
-  coalesce(&right, {_right});
+  // As the ranges are coalesced, each range in left must be a subset
+  // of a single range in right. Since both are sorted, we only need to
+  // walk right once.
+  size_t j = 0;
 
-  for (int i = 0; i < left.range_size(); i++) {
-    // Make sure this range is a subset of a range in right.
-    bool matched = false;
-    for (int j = 0; j < right.range_size(); j++) {
-      if (left.range(i).begin() >= right.range(j).begin() &&
-          left.range(i).end() <= right.range(j).end()) {
-        matched = true;
-        break;
-      }
+  foreach (const internal::Range& range, left) {
+    while (j < right.size() && right[j].end < range.start) {
+      ++j;
     }
-    if (!matched) {
+
+    if (j == right.size() ||
+        right[j].start > range.start ||
+        right[j].end < range.end) {
       return false;
     }
   }
@@ -355,7 +476,10 @@ bool operator<=(const Value::Ranges& _left, const Value::Ranges& _right)
 Value::Ranges operator+(const Value::Ranges& left, const Value::Ranges& right)
 {
   Value::Ranges result;
-  coalesce(&result, {left, right});
+  internal::assign(
+      &result,
+      internal::unite(internal::intervals(left), internal::intervals(right)));
+
   return result;
 }
 
@@ -363,27 +487,33 @@ Value::Ranges operator+(const Value::Ranges& left, const Value::Ranges& right)
 Value::Ranges operator-(const Value::Ranges& left, const Value::Ranges& right)
 {
   Value::Ranges result;
-  coalesce(&result, {left});
-  return result -= right;
+  internal::assign(
+      &result,
+      internal::subtract(
+          internal::intervals(left), internal::intervals(right)));
+
+  return result;
 }
 
 
 Value::Ranges& operator+=(Value::Ranges& left, const Value::Ranges& right)
 {
-  coalesce(&left, {right});
+  internal::assign(
+      &left,
+      internal::unite(internal::intervals(left), internal::intervals(right)));
+
   return left;
 }
 
 
-Value::Ranges& operator-=(Value::Ranges& _left, const Value::Ranges& _right)
+Value::Ranges& operator-=(Value::Ranges& left, const Value::Ranges& right)
 {
-  IntervalSet<uint64_t> left, right;
-
-  left = rangesToIntervalSet<uint64_t>(_left).get();
-  right = rangesToIntervalSet<uint64_t>(_right).get();
-  _left = intervalSetToRanges(left - right);
+  internal::assign(
+      &left,
+      internal::subtract(
+          internal::intervals(left), internal::intervals(right)));
 
-  return _left;
+  return left;
 }
 
 
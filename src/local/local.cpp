@@ -229,7 +229,12 @@ PID<Master> launch(const Flags& flags, Allocator* _allocator)
           set<UPID>(),
           masterFlags.log_auto_initialize,
           "registrar/");
-      storage = new mesos::state::LogStorage(log);
+      storage = new mesos::state::LogStorage(
+          log,
+          masterFlags.registry_log_max_diffs,
+          masterFlags.registry_log_diff_format == "delta"
+            ? mesos::state::LogStorage::DELTA
+            : mesos::state::LogStorage::SVN);
 #endif // __WINDOWS__
     } else {
       EXIT(EXIT_FAILURE)
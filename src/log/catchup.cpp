@@ -16,13 +16,20 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <list>
+#include <set>
+#include <vector>
 
+#include <process/clock.hpp>
 #include <process/collect.hpp>
+#include <process/defer.hpp>
 #include <process/id.hpp>
 #include <process/process.hpp>
+#include <process/time.hpp>
 #include <process/timer.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/stringify.hpp>
 
@@ -34,11 +41,18 @@
 using namespace process;
 
 using std::list;
+using std::vector;
 
 namespace mesos {
 namespace internal {
 namespace log {
 
+// The maximum number of positions that are caught up as a chunk,
+// i.e., whose learned actions are fetched from the other replicas at
+// once.
+static const uint64_t MAX_FETCH_POSITIONS = 1000;
+
+
 class CatchUpProcess : public Process<CatchUpProcess>
 {
 public:
@@ -165,10 +179,14 @@ static Future<uint64_t> catchup(
 }
 
 
-// TODO(jieyu): Our current implementation catches-up each position in
-// the set sequentially. In the future, we may want to parallelize it
-// to improve the performance. Also, we may want to implement rate
-// control here so that we don't saturate the network or disk.
+// Catches up the positions in the given interval in chunks. For each
+// chunk, the learned actions at the missing positions are fetched
+// from the other replicas and persisted at once, for as long as that
+// makes progress. The positions that are still missing afterwards
+// (e.g., those not learned by any of the other replicas) are caught
+// up one at a time using 'catchup' above.
+// TODO(jieyu): We may want to implement rate control here so that we
+// don't saturate the network or disk.
 class BulkCatchUpProcess : public Process<BulkCatchUpProcess>
 {
 public:
@@ -178,14 +196,19 @@ public:
       const Shared<Network>& _network,
       uint64_t _proposal,
       const Interval<uint64_t>& _positions,
-      const Duration& _timeout)
+      const Duration& _timeout,
+      const Option<CatchUpMetrics>& _metrics)
     : ProcessBase(ID::generate("log-bulk-catch-up")),
       quorum(_quorum),
       replica(_replica),
       network(_network),
       positions(_positions),
       timeout(_timeout),
-      proposal(_proposal) {}
+      metrics(_metrics),
+      proposal(_proposal),
+      fetchable(true),
+      replied(false),
+      progressed(false) {}
 
   virtual ~BulkCatchUpProcess() {}
 
@@ -198,18 +221,22 @@ protected:
     promise.future().onDiscard(lambda::bind(
         static_cast<void(*)(const UPID&, bool)>(terminate), self(), true));
 
-    // Catch-up sequentially.
     current = positions.lower();
 
-    catchup();
+    next();
   }
 
   virtual void finalize()
   {
+    checking.discard();
+    broadcasting.discard();
+    fetching.discard();
+    discard(responses);
+    learning.discard();
     catching.discard();
 
-    // TODO(benh): Discard our promise only after 'catching' has
-    // completed (ready, failed, or discarded).
+    // TODO(benh): Discard our promise only after the futures above
+    // have completed (ready, failed, or discarded).
     promise.discard();
   }
 
@@ -219,7 +246,13 @@ private:
     catching.discard();
   }
 
-  void catchup()
+  static void _timedout(Future<Future<FetchResponse>> fetching)
+  {
+    fetching.discard();
+  }
+
+  // Starts catching up the next chunk of positions.
+  void next()
   {
     if (current >= positions.upper()) {
       // Stop the process if there is nothing left to catch-up. This
@@ -229,37 +262,243 @@ private:
       return;
     }
 
+    last = std::min(current + MAX_FETCH_POSITIONS, positions.upper()) - 1;
+    counted = false;
+
+    check();
+  }
+
+  void check()
+  {
+    checking = replica->missing(current, last);
+    checking.onAny(defer(self(), &Self::checked));
+  }
+
+  void checked()
+  {
+    // The future 'checking' can only be discarded in 'finalize'.
+    CHECK(!checking.isDiscarded());
+
+    if (checking.isFailed()) {
+      promise.fail("Failed to get missing positions: " + checking.failure());
+      terminate(self());
+      return;
+    }
+
+    const IntervalSet<uint64_t>& missing = checking.get();
+
+    if (!counted) {
+      if (metrics.isSome()) {
+        metrics->positions_missing += missing.size();
+      }
+
+      counted = true;
+    }
+
+    if (missing.empty()) {
+      // The remaining replies to the current fetch request are no
+      // longer needed.
+      discard(responses);
+      responses.clear();
+      current = last + 1;
+      next();
+    } else if (!responses.empty()) {
+      // Look for the remaining positions in the replies of the other
+      // replicas to the current fetch request first.
+      receive();
+    } else if (fetchable) {
+      fetch();
+    } else {
+      unfilled = missing;
+      fill();
+    }
+  }
+
+  void fetch()
+  {
+    const IntervalSet<uint64_t>& missing = checking.get();
+
+    FetchRequest request;
+    request.set_from(missing.begin()->lower());
+    request.set_to(missing.rbegin()->upper() - 1);
+
+    broadcasting = network->broadcast(
+        protocol::fetch,
+        request,
+        std::set<UPID>{replica->pid()});
+
+    broadcasting.onAny(defer(self(), &Self::broadcasted));
+  }
+
+  void broadcasted()
+  {
+    // The future 'broadcasting' can only be discarded in 'finalize'.
+    CHECK(!broadcasting.isDiscarded());
+
+    if (broadcasting.isFailed()) {
+      promise.fail("Failed to fetch positions: " + broadcasting.failure());
+      terminate(self());
+      return;
+    }
+
+    responses = broadcasting.get();
+    deadline = Clock::now() + timeout;
+    replied = false;
+    progressed = false;
+
+    receive();
+  }
+
+  // Waits for the next reply of the replicas that have not replied to
+  // the current fetch request yet.
+  void receive()
+  {
+    if (responses.empty()) {
+      _fetched();
+      return;
+    }
+
+    // NOTE: 'select' only captures the replies that are ready.
+    fetching = process::select(responses);
+    fetching.onAny(defer(self(), &Self::fetched));
+
+    Clock::timer(
+        std::max(deadline - Clock::now(), Duration::zero()),
+        lambda::bind(&Self::_timedout, fetching));
+  }
+
+  void fetched()
+  {
+    if (fetching.isDiscarded()) {
+      LOG(INFO) << "Unable to fetch positions " << checking.get()
+                << " in " << timeout;
+
+      discard(responses);
+      responses.clear();
+      _fetched();
+      return;
+    }
+
+    const Future<FetchResponse> response = fetching.get();
+    responses.erase(response);
+    replied = true;
+
+    const IntervalSet<uint64_t>& missing = checking.get();
+
+    vector<Action> actions;
+    foreach (const Action& action, response->actions()) {
+      if (action.learned() && missing.contains(action.position())) {
+        actions.push_back(action);
+      }
+    }
+
+    if (actions.empty()) {
+      // This replica has not learned any of the remaining positions,
+      // but the replicas that did not reply yet might have.
+      receive();
+      return;
+    }
+
+    LOG(INFO) << "Fetched " << actions.size() << " learned positions from "
+              << actions.front().position() << " to "
+              << actions.back().position();
+
+    progressed = true;
+
+    learning = replica->learn(actions);
+    learning.onAny(defer(self(), &Self::learned, actions.size()));
+  }
+
+  // Invoked once all the replicas replied to the current fetch
+  // request, or it timed out.
+  void _fetched()
+  {
+    if (progressed) {
+      // Fetch again, since the replies might have been limited in size.
+      fetch();
+      return;
+    }
+
+    if (!replied) {
+      // The other replicas might not support fetch requests (e.g.,
+      // they are running an older version), thus we fill the
+      // remaining positions instead, also in the following chunks.
+      LOG(INFO) << "No replica replied to the fetch request, filling "
+                << "positions instead";
+
+      fetchable = false;
+    }
+
+    // None of the replicas has learned the remaining positions.
+    unfilled = checking.get();
+    fill();
+  }
+
+  void learned(size_t count)
+  {
+    // The future 'learning' can only be discarded in 'finalize'.
+    CHECK(!learning.isDiscarded());
+
+    if (learning.isFailed() || !learning.get()) {
+      promise.fail(
+          "Failed to persist fetched positions" +
+          (learning.isFailed() ? ": " + learning.failure() : ""));
+
+      terminate(self());
+      return;
+    }
+
+    if (metrics.isSome()) {
+      metrics->positions_fetched += count;
+    }
+
+    check();
+  }
+
+  void fill()
+  {
+    if (unfilled.empty()) {
+      current = last + 1;
+      next();
+      return;
+    }
+
+    const uint64_t position = unfilled.begin()->lower();
+
     // Store the future so that we can discard it if the user wants to
     // cancel the catch-up operation.
-    catching = log::catchup(quorum, replica, network, proposal, current)
-      .onDiscarded(defer(self(), &Self::discarded))
-      .onFailed(defer(self(), &Self::failed))
-      .onReady(defer(self(), &Self::succeeded));
+    catching = log::catchup(quorum, replica, network, proposal, position)
+      .onDiscarded(defer(self(), &Self::discarded, position))
+      .onFailed(defer(self(), &Self::failed, position))
+      .onReady(defer(self(), &Self::succeeded, position));
 
     Clock::timer(timeout, lambda::bind(&Self::timedout, catching));
   }
 
-
-  void discarded()
+  void discarded(uint64_t position)
   {
-    LOG(INFO) << "Unable to catch-up position " << current
+    LOG(INFO) << "Unable to catch-up position " << position
               << " in " << timeout << ", retrying";
 
-    catchup();
+    fill();
   }
 
-  void failed()
+  void failed(uint64_t position)
   {
     promise.fail(
-        "Failed to catch-up position " + stringify(current) +
+        "Failed to catch-up position " + stringify(position) +
         ": " + catching.failure());
 
     terminate(self());
   }
 
-  void succeeded()
+  void succeeded(uint64_t position)
   {
-    ++current;
+    unfilled -= position;
+
+    if (metrics.isSome()) {
+      ++metrics->positions_filled;
+    }
 
     // The single position catch-up function: 'log::catchup' will
     // return the highest proposal number seen so far. We use this
@@ -268,7 +507,7 @@ private:
     // proposal number bumps.
     proposal = catching.get();
 
-    catchup();
+    fill();
   }
 
   const size_t quorum;
@@ -277,10 +516,41 @@ private:
   const Interval<uint64_t> positions;
   const Duration timeout;
 
+  Option<CatchUpMetrics> metrics;
+
   uint64_t proposal;
+
+  // The first and the last position of the current chunk.
   uint64_t current;
+  uint64_t last;
+
+  // Whether the missing positions of the current chunk have been
+  // counted in the metrics.
+  bool counted;
+
+  // Whether the other replicas (are believed to) handle fetch
+  // requests.
+  bool fetchable;
+
+  // The replies to the current fetch request that have not been
+  // received yet, and the time until which we wait for them.
+  std::set<Future<FetchResponse>> responses;
+  Time deadline;
+
+  // Whether any replica replied to the current fetch request, and
+  // whether any of the replies contained a missing position.
+  bool replied;
+  bool progressed;
+
+  // The missing positions of the current chunk that are caught up one
+  // at a time.
+  IntervalSet<uint64_t> unfilled;
 
   process::Promise<Nothing> promise;
+  Future<IntervalSet<uint64_t>> checking;
+  Future<std::set<Future<FetchResponse>>> broadcasting;
+  Future<Future<FetchResponse>> fetching;
+  Future<bool> learning;
   Future<uint64_t> catching;
 };
 
@@ -291,7 +561,8 @@ static Future<Nothing> catchup(
     const Shared<Network>& network,
     const Option<uint64_t>& proposal,
     const Interval<uint64_t>& positions,
-    const Duration& timeout)
+    const Duration& timeout,
+    const Option<CatchUpMetrics>& metrics)
 {
   BulkCatchUpProcess* process =
     new BulkCatchUpProcess(
@@ -300,7 +571,8 @@ static Future<Nothing> catchup(
         network,
         proposal.getOrElse(0),
         positions,
-        timeout);
+        timeout,
+        metrics);
 
   Future<Nothing> future = process->future();
   spawn(process, true);
@@ -319,7 +591,8 @@ Future<Nothing> catchup(
     const Shared<Network>& network,
     const Option<uint64_t>& proposal,
     const IntervalSet<uint64_t>& positions,
-    const Duration& timeout)
+    const Duration& timeout,
+    const Option<CatchUpMetrics>& metrics)
 {
   // Necessary to disambiguate overloaded functions.
   Future<Nothing> (*f)(
@@ -328,7 +601,8 @@ Future<Nothing> catchup(
       const Shared<Network>& network,
       const Option<uint64_t>& proposal,
       const Interval<uint64_t>& positions,
-      const Duration& timeout) = &catchup;
+      const Duration& timeout,
+      const Option<CatchUpMetrics>& metrics) = &catchup;
 
   Future<Nothing> future = Nothing();
 
@@ -341,7 +615,8 @@ Future<Nothing> catchup(
             network,
             proposal,
             interval,
-            timeout));
+            timeout,
+            metrics));
   }
 
   return future;
@@ -19,11 +19,16 @@
 
 #include <stdint.h>
 
+#include <string>
+
 #include <process/future.hpp>
 #include <process/shared.hpp>
 
+#include <process/metrics/counter.hpp>
+
 #include <stout/duration.hpp>
 #include <stout/interval.hpp>
+#include <stout/none.hpp>
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
 
@@ -34,21 +39,50 @@ namespace mesos {
 namespace internal {
 namespace log {
 
-// Catches-up a set of log positions in the local replica. The user of
-// this function can provide a hint on the proposal number that will
-// be used for Paxos. This could potentially save us a few Paxos
-// rounds. However, if the user has no idea what proposal number to
-// use, they can just use none. We also allow the user to specify a
-// timeout for the catch-up operation on each position and retry the
-// operation if timeout happens. This can help us tolerate network
-// blips.
+// Counters that report the progress of catching up a replica. The
+// number of positions that are left to catch up is the number of
+// missing positions less the fetched and the filled ones. Copies
+// share the same counters, which are added to (and removed from)
+// the metrics endpoint by the owner of the original.
+struct CatchUpMetrics
+{
+  explicit CatchUpMetrics(const Option<std::string>& prefix)
+    : positions_missing(
+          prefix.getOrElse("") + "log/catchup/positions_missing"),
+      positions_fetched(
+          prefix.getOrElse("") + "log/catchup/positions_fetched"),
+      positions_filled(
+          prefix.getOrElse("") + "log/catchup/positions_filled") {}
+
+  // The positions that were found missing in the local replica.
+  process::metrics::Counter positions_missing;
+
+  // The missing positions that were learned from other replicas.
+  process::metrics::Counter positions_fetched;
+
+  // The missing positions that were filled with a round of Paxos.
+  process::metrics::Counter positions_filled;
+};
+
+
+// Catches-up a set of log positions in the local replica. The learned
+// actions are fetched from the other replicas in bulk, and only the
+// positions that none of them has learned are filled (i.e., agreed on)
+// one at a time with Paxos. The user of this function can provide a
+// hint on the proposal number that will be used for Paxos. This could
+// potentially save us a few Paxos rounds. However, if the user has no
+// idea what proposal number to use, they can just use none. We also
+// allow the user to specify a timeout for fetching and for the
+// catch-up operation on each position and retry the operation if
+// timeout happens. This can help us tolerate network blips.
 extern process::Future<Nothing> catchup(
     size_t quorum,
     const process::Shared<Replica>& replica,
     const process::Shared<Network>& network,
     const Option<uint64_t>& proposal,
     const IntervalSet<uint64_t>& positions,
-    const Duration& timeout = Seconds(10));
+    const Duration& timeout = Seconds(10),
+    const Option<CatchUpMetrics>& metrics = None());
 
 } // namespace log {
 } // namespace internal {
@@ -17,12 +17,16 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <deque>
 #include <set>
+#include <string>
+#include <vector>
 
 #include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/id.hpp>
 #include <process/process.hpp>
+#include <process/protobuf.hpp>
 
 #include <stout/check.hpp>
 #include <stout/duration.hpp>
@@ -30,13 +34,17 @@
 #include <stout/os.hpp>
 #include <stout/nothing.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
 
 #include "log/consensus.hpp"
 #include "log/replica.hpp"
 
 using namespace process;
 
+using std::deque;
 using std::set;
+using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -434,109 +442,116 @@ private:
 };
 
 
-class WriteProcess : public Process<WriteProcess>
+// Collects the responses of the replicas to the write requests of a
+// round. The requests are sent on behalf of this process by the
+// network (see 'broadcastWrite' below), so that the requests of
+// several rounds can be sent in order.
+class WriteProcess : public ProtobufProcess<WriteProcess>
 {
 public:
   WriteProcess(
       size_t _quorum,
-      const Shared<Network>& _network,
       uint64_t _proposal,
-      const Action& _action)
+      const vector<Action>& _actions)
     : ProcessBase(ID::generate("log-write")),
       quorum(_quorum),
-      network(_network),
       proposal(_proposal),
-      action(_action),
-      responsesReceived(0),
-      ignoresReceived(0) {}
+      actions(_actions),
+      ignoresReceived(0)
+  {
+    CHECK(!actions.empty());
+
+    install<WriteResponse>(&WriteProcess::received);
+    install<BatchWriteResponse>(&WriteProcess::batchReceived);
+  }
 
   virtual ~WriteProcess() {}
 
   Future<WriteResponse> future() { return promise.future(); }
 
+  void fail(const string& message)
+  {
+    promise.fail(message);
+    terminate(self());
+  }
+
 protected:
   virtual void initialize()
   {
     // Stop when no one cares.
     promise.future().onDiscard(lambda::bind(
         static_cast<void(*)(const UPID&, bool)>(terminate), self(), true));
-
-    // Wait until there are enough (i.e., quorum of) replicas in the
-    // network. This is because if there are less than quorum number
-    // of replicas in the network, the operation will not finish.
-    network->watch(quorum, Network::GREATER_THAN_OR_EQUAL_TO)
-      .onAny(defer(self(), &Self::watched, lambda::_1));
   }
 
   virtual void finalize()
   {
     // This process will be terminated when we get responses from a
     // quorum of replicas. In that case, we no longer care about
-    // responses from other replicas, thus discarding them here.
-    discard(responses);
-
+    // responses from other replicas, which are simply dropped.
     promise.discard();
   }
 
 private:
-  void watched(const Future<size_t>& future)
+  void batchReceived(const UPID& from, const BatchWriteResponse& batch)
   {
-    if (!future.isReady()) {
-      promise.fail(
-          future.isFailed() ?
-          future.failure() :
-          "Not expecting discarded future");
+    received(from, combine(batch));
+  }
 
-      terminate(self());
-      return;
+  // Combines the responses of a replica to the requests of a batch
+  // into the response of the replica to the batch: the batch is
+  // ignored or rejected if any of its requests is, and accepted
+  // otherwise.
+  WriteResponse combine(const BatchWriteResponse& batch) const
+  {
+    WriteResponse result;
+    result.set_position(actions.front().position());
+
+    bool ignored =
+      static_cast<size_t>(batch.responses().size()) != actions.size();
+    Option<uint64_t> highestNackProposal;
+
+    foreach (const WriteResponse& response, batch.responses()) {
+      if (response.has_type() && response.type() == WriteResponse::IGNORED) {
+        ignored = true;
+      } else if (isRejectedWrite(response)) {
+        if (highestNackProposal.isNone() ||
+            highestNackProposal.get() < response.proposal()) {
+          highestNackProposal = response.proposal();
+        }
+      }
     }
 
-    CHECK_GE(future.get(), quorum);
-
-    request.set_proposal(proposal);
-    request.set_position(action.position());
-    request.set_type(action.type());
-    switch (action.type()) {
-      case Action::NOP:
-        CHECK(action.has_nop());
-        request.mutable_nop();
-        break;
-      case Action::APPEND:
-        CHECK(action.has_append());
-        request.mutable_append()->CopyFrom(action.append());
-        break;
-      case Action::TRUNCATE:
-        CHECK(action.has_truncate());
-        request.mutable_truncate()->CopyFrom(action.truncate());
-        break;
-      default:
-        LOG(FATAL) << "Unknown Action::Type " << action.type();
+    if (ignored) {
+      result.set_type(WriteResponse::IGNORED);
+      result.set_okay(false);
+      result.set_proposal(proposal);
+    } else if (highestNackProposal.isSome()) {
+      result.set_type(WriteResponse::REJECT);
+      result.set_okay(false);
+      result.set_proposal(highestNackProposal.get());
+    } else {
+      result.set_type(WriteResponse::ACCEPT);
+      result.set_okay(true);
+      result.set_proposal(proposal);
     }
 
-    network->broadcast(protocol::write, request)
-      .onAny(defer(self(), &Self::broadcasted, lambda::_1));
+    return result;
   }
 
-  void broadcasted(const Future<set<Future<WriteResponse>>>& future)
+  void received(const UPID& from, const WriteResponse& response)
   {
-    if (!future.isReady()) {
-      promise.fail(
-          future.isFailed() ?
-          "Failed to broadcast the write request: " + future.failure() :
-          "Not expecting discarded future");
-      terminate(self());
+    if (response.position() != actions.front().position()) {
+      LOG(WARNING) << "Ignoring write response from " << from
+                   << " for position " << response.position();
       return;
     }
 
-    responses = future.get();
-    foreach (const Future<WriteResponse>& response, responses) {
-      response.onReady(defer(self(), &Self::received, lambda::_1));
+    // Only the first response of each replica counts.
+    if (replied.contains(from)) {
+      return;
     }
-  }
 
-  void received(const WriteResponse& response)
-  {
-    CHECK_EQ(response.position(), request.position());
+    replied.insert(from);
 
     if (response.has_type() && response.type() ==
         WriteResponse::IGNORED) {
@@ -558,8 +573,6 @@ private:
       return;
     }
 
-    responsesReceived++;
-
     if (isRejectedWrite(response)) {
       // A replica rejects the write request because this position has
       // been promised to a proposer with a higher proposal number.
@@ -572,7 +585,7 @@ private:
       }
     }
 
-    if (responsesReceived >= quorum) {
+    if (replied.size() - ignoresReceived >= quorum) {
       // A quorum of replicas have replied.
       WriteResponse result;
 
@@ -591,13 +604,10 @@ private:
   }
 
   const size_t quorum;
-  const Shared<Network> network;
   const uint64_t proposal;
-  const Action action;
+  const vector<Action> actions;
 
-  WriteRequest request;
-  set<Future<WriteResponse>> responses;
-  size_t responsesReceived;
+  hashset<UPID> replied;
   size_t ignoresReceived;
   Option<uint64_t> highestNackProposal;
 
@@ -605,6 +615,176 @@ private:
 };
 
 
+static WriteRequest createWriteRequest(
+    uint64_t proposal,
+    const Action& action)
+{
+  WriteRequest request;
+  request.set_proposal(proposal);
+  request.set_position(action.position());
+  request.set_type(action.type());
+  switch (action.type()) {
+    case Action::NOP:
+      CHECK(action.has_nop());
+      request.mutable_nop();
+      break;
+    case Action::APPEND:
+      CHECK(action.has_append());
+      request.mutable_append()->CopyFrom(action.append());
+      break;
+    case Action::TRUNCATE:
+      CHECK(action.has_truncate());
+      request.mutable_truncate()->CopyFrom(action.truncate());
+      break;
+    default:
+      LOG(FATAL) << "Unknown Action::Type " << action.type();
+  }
+
+  return request;
+}
+
+
+// Broadcasts the write requests of a round on behalf of the given
+// write process once there are enough (i.e., quorum of) replicas in
+// the network, which is what 'watched' tells.
+static void broadcastWrite(
+    const Future<size_t>& watched,
+    const Shared<Network>& network,
+    const PID<WriteProcess>& pid,
+    uint64_t proposal,
+    const vector<Action>& actions)
+{
+  if (!watched.isReady()) {
+    dispatch(
+        pid,
+        &WriteProcess::fail,
+        watched.isFailed() ?
+        watched.failure() :
+        "Not expecting discarded future");
+    return;
+  }
+
+  Future<Nothing> broadcasted;
+
+  // A single action is written with a plain write request, so that
+  // replicas that do not know about batches can still vote on it.
+  if (actions.size() == 1) {
+    broadcasted = network->broadcast(
+        pid, createWriteRequest(proposal, actions.front()));
+  } else {
+    BatchWriteRequest batch;
+    foreach (const Action& action, actions) {
+      batch.add_requests()->CopyFrom(createWriteRequest(proposal, action));
+    }
+
+    broadcasted = network->broadcast(pid, batch);
+  }
+
+  broadcasted.onFailed([=](const string& failure) {
+    dispatch(
+        pid,
+        &WriteProcess::fail,
+        "Failed to broadcast the write request: " + failure);
+  });
+}
+
+
+// Sends the write requests of the rounds of a proposer in the order
+// in which they are written, see 'Proposer' in consensus.hpp.
+class ProposerProcess : public Process<ProposerProcess>
+{
+public:
+  ProposerProcess(size_t _quorum, const Shared<Network>& _network)
+    : ProcessBase(ID::generate("log-proposer")),
+      quorum(_quorum),
+      network(_network) {}
+
+  virtual ~ProposerProcess() {}
+
+  Future<WriteResponse> write(
+      uint64_t proposal,
+      const vector<Action>& actions)
+  {
+    WriteProcess* process = new WriteProcess(quorum, proposal, actions);
+    Future<WriteResponse> future = process->future();
+    waiting.push_back(Round{spawn(process, true), proposal, actions});
+
+    // Wait until there are enough (i.e., quorum of) replicas in the
+    // network, then send all the rounds that have been waiting, in
+    // order. This is because if there are less than quorum number
+    // of replicas in the network, the operation will not finish.
+    if (watching.isNone()) {
+      watching = network->watch(quorum, Network::GREATER_THAN_OR_EQUAL_TO);
+      watching->onAny(defer(self(), &Self::watched));
+    }
+
+    return future;
+  }
+
+  Future<Nothing> learn(const vector<Action>& actions)
+  {
+    CHECK(!actions.empty());
+
+    if (actions.size() == 1) {
+      return log::learn(network, actions.front());
+    }
+
+    BatchLearnedMessage message;
+    foreach (const Action& action, actions) {
+      Action* learned = message.add_actions();
+      learned->CopyFrom(action);
+      learned->set_learned(true);
+    }
+
+    return network->broadcast(message);
+  }
+
+protected:
+  virtual void finalize()
+  {
+    if (watching.isSome()) {
+      watching->discard();
+    }
+
+    foreach (const Round& round, waiting) {
+      terminate(round.pid);
+    }
+
+    waiting.clear();
+  }
+
+private:
+  struct Round
+  {
+    PID<WriteProcess> pid;
+    uint64_t proposal;
+    vector<Action> actions;
+  };
+
+  void watched()
+  {
+    CHECK_SOME(watching);
+
+    const Future<size_t> future = watching.get();
+    watching = None();
+
+    foreach (const Round& round, waiting) {
+      broadcastWrite(
+          future, network, round.pid, round.proposal, round.actions);
+    }
+
+    waiting.clear();
+  }
+
+  const size_t quorum;
+  const Shared<Network> network;
+
+  // The rounds that wait for a quorum of replicas in the network.
+  deque<Round> waiting;
+  Option<Future<size_t>> watching;
+};
+
+
 class FillProcess : public Process<FillProcess>
 {
 public:
@@ -833,15 +1013,24 @@ Future<WriteResponse> write(
     uint64_t proposal,
     const Action& action)
 {
+  const vector<Action> actions = {action};
+
   WriteProcess* process =
     new WriteProcess(
         quorum,
-        network,
         proposal,
-        action);
+        actions);
 
   Future<WriteResponse> future = process->future();
-  spawn(process, true);
+  const PID<WriteProcess> pid = spawn(process, true);
+
+  // Wait until there are enough (i.e., quorum of) replicas in the
+  // network. This is because if there are less than quorum number
+  // of replicas in the network, the operation will not finish.
+  network->watch(quorum, Network::GREATER_THAN_OR_EQUAL_TO)
+    .onAny(lambda::bind(
+        &broadcastWrite, lambda::_1, network, pid, proposal, actions));
+
   return future;
 }
 
@@ -859,6 +1048,35 @@ Future<Nothing> learn(const Shared<Network>& network, const Action& action)
 }
 
 
+Proposer::Proposer(size_t quorum, const Shared<Network>& network)
+{
+  process = new ProposerProcess(quorum, network);
+  spawn(process);
+}
+
+
+Proposer::~Proposer()
+{
+  terminate(process);
+  process::wait(process);
+  delete process;
+}
+
+
+Future<WriteResponse> Proposer::write(
+    uint64_t proposal,
+    const vector<Action>& actions)
+{
+  return dispatch(process, &ProposerProcess::write, proposal, actions);
+}
+
+
+Future<Nothing> Proposer::learn(const vector<Action>& actions)
+{
+  return dispatch(process, &ProposerProcess::learn, actions);
+}
+
+
 Future<Action> fill(
     size_t quorum,
     const Shared<Network>& network,
@@ -19,6 +19,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include <process/future.hpp>
 #include <process/shared.hpp>
 
@@ -113,6 +115,41 @@ extern process::Future<Nothing> learn(
     const Action& action);
 
 
+// Forward declaration.
+class ProposerProcess;
+
+
+// Runs the write and learn phases for the rounds of a proposer (e.g.,
+// an elected coordinator) that may have several rounds in progress at
+// the same time. Each round writes the actions of consecutive
+// positions in a single request (i.e., group commit); the round
+// succeeds if a quorum of replicas accept all of its writes, and the
+// response is defined as for 'write' above otherwise, with the
+// position of the first action. Unlike with separate calls to 'write'
+// and 'learn', the requests and learned messages of all rounds are
+// sent by a single process in the order of the calls, thus each
+// replica receives and persists the rounds in that order.
+class Proposer
+{
+public:
+  Proposer(size_t quorum, const process::Shared<Network>& network);
+  ~Proposer();
+
+  process::Future<WriteResponse> write(
+      uint64_t proposal,
+      const std::vector<Action>& actions);
+
+  process::Future<Nothing> learn(const std::vector<Action>& actions);
+
+private:
+  // Not copyable, not assignable.
+  Proposer(const Proposer&);
+  Proposer& operator=(const Proposer&);
+
+  ProposerProcess* process;
+};
+
+
 // Tries to reach consensus for the given log position by running a
 // full Paxos round (i.e., promise -> write -> learn). If no value has
 // been previously agreed on for the given log position, a NOP will be
@@ -17,14 +17,25 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <deque>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
+#include <process/check.hpp>
+#include <process/clock.hpp>
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/time.hpp>
 
+#include <process/metrics/timer.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/interval.hpp>
 #include <stout/none.hpp>
 
 #include "log/catchup.hpp"
@@ -35,26 +46,43 @@
 
 using namespace process;
 
+using std::deque;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
 namespace log {
 
+// The maximum number of queued writes that are written in a single
+// round of write requests.
+static const size_t MAX_WRITE_BATCH_SIZE = 64;
+
+
 class CoordinatorProcess : public Process<CoordinatorProcess>
 {
 public:
   CoordinatorProcess(
       size_t _quorum,
       const Shared<Replica>& _replica,
-      const Shared<Network>& _network)
+      const Shared<Network>& _network,
+      size_t _pipelineDepth,
+      bool batchWrites,
+      const Option<CoordinatorMetrics>& _metrics)
     : ProcessBase(ID::generate("log-coordinator")),
       quorum(_quorum),
       replica(_replica),
       network(_network),
+      proposer(_quorum, _network),
+      pipelineDepth(_pipelineDepth),
+      maxBatchSize(batchWrites ? MAX_WRITE_BATCH_SIZE : 1),
+      metrics(_metrics),
       state(INITIAL),
       proposal(0),
-      index(0) {}
+      index(0)
+  {
+    CHECK_GT(pipelineDepth, 0u);
+  }
 
   virtual ~CoordinatorProcess() {}
 
@@ -68,7 +96,23 @@ protected:
   virtual void finalize()
   {
     electing.discard();
-    writing.discard();
+
+    // The continuations of the batches that are being written are not
+    // invoked anymore, thus the pending writes are discarded here.
+    foreach (const Owned<Batch>& batch, batches) {
+      batch->writing.discard();
+
+      foreach (const Owned<Write>& write, batch->writes) {
+        write->promise.discard();
+      }
+    }
+
+    foreach (const Owned<Write>& write, queued) {
+      write->promise.discard();
+    }
+
+    batches.clear();
+    pipelined();
   }
 
 private:
@@ -92,22 +136,66 @@ private:
   // Writing related functions.  //
   /////////////////////////////////
 
+  // A write (i.e., an append or a truncate) requested by a client.
+  struct Write
+  {
+    explicit Write(const Action& _action)
+      : action(_action), requested(Clock::now()) {}
+
+    Action action;
+    process::Promise<Option<uint64_t>> promise;
+
+    // Used for the commit latency metric.
+    Time requested;
+  };
+
+  // The writes that are written to consecutive positions in a single
+  // round of write requests.
+  struct Batch
+  {
+    vector<Owned<Write>> writes;
+
+    // Set to the position of the first write once the batch has been
+    // written, or none if the batch has been rejected.
+    Future<Option<uint64_t>> writing;
+  };
+
   Future<Option<uint64_t>> write(const Action& action);
-  Future<WriteResponse> runWritePhase(const Action& action);
+  void writeBatch();
+  void discarded(const Future<Option<uint64_t>>& future);
+  Future<WriteResponse> runWritePhase(const vector<Action>& actions);
   Future<Option<uint64_t>> checkWritePhase(
-      const Action& action,
+      const vector<Action>& actions,
       const WriteResponse& response);
-  Future<Nothing> runLearnPhase(const Action& action);
-  Future<bool> checkLearnPhase(const Action& action);
-  Future<Option<uint64_t>> updateIndexAfterWritten(bool missing);
-  void writingFinished();
-  void writingFailed();
-  void writingAborted();
+  Future<Nothing> runLearnPhase(const vector<Action>& actions);
+  Future<IntervalSet<uint64_t>> checkLearnPhase(const vector<Action>& actions);
+  Future<Option<uint64_t>> checkLearnedPositions(
+      const vector<Action>& actions,
+      const IntervalSet<uint64_t>& missing);
+  void written();
+  void drop(const Option<string>& failure);
+
+  // Reports the number of batches that are being written.
+  void pipelined();
 
   const size_t quorum;
   const Shared<Replica> replica;
   const Shared<Network> network;
 
+  // Sends the requests of all the batches that are being written, in
+  // the order of their positions.
+  Proposer proposer;
+
+  // The maximum number of batches that are written at the same time.
+  const size_t pipelineDepth;
+
+  // The maximum number of writes in a batch. Batches of more than one
+  // write are only sent if enabled, since replicas of older versions
+  // drop them (see 'Coordinator').
+  const size_t maxBatchSize;
+
+  Option<CoordinatorMetrics> metrics;
+
   // The current state of the coordinator. A coordinator needs to be
   // elected first to perform append and truncate operations. If one
   // tries to do an append or a truncate while the coordinator is not
@@ -115,7 +203,8 @@ private:
   // coordinator does not declare itself as elected until it wins the
   // election and has filled all existing positions. A coordinator is
   // put in electing state after it decides to go for an election and
-  // before it is elected.
+  // before it is elected. An elected coordinator is in writing state
+  // as long as a batch is being written.
   enum
   {
     INITIAL,
@@ -127,11 +216,21 @@ private:
   // The current proposal number used by this coordinator.
   uint64_t proposal;
 
-  // The position to which the next entry will be written.
+  // The position to which the next entry will be written. Positions
+  // are assigned when a batch is sent, so that the next batch can be
+  // sent before the previous one is written (i.e., pipelining).
   uint64_t index;
 
   Future<Option<uint64_t>> electing;
-  Future<Option<uint64_t>> writing;
+
+  // The batches that are being written, in the order of their
+  // positions.
+  deque<Owned<Batch>> batches;
+
+  // The writes that have been requested while 'pipelineDepth'
+  // batches were being written, which are written in a single batch
+  // once the first of those is written (i.e., group commit).
+  deque<Owned<Write>> queued;
 };
 
 
@@ -307,14 +406,9 @@ Future<Option<uint64_t>> CoordinatorProcess::append(const string& bytes)
 {
   if (state == INITIAL || state == ELECTING) {
     return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
   }
 
   Action action;
-  action.set_position(index);
-  action.set_promised(proposal);
-  action.set_performed(proposal);
   action.set_type(Action::APPEND);
   Action::Append* append = action.mutable_append();
   append->set_bytes(bytes);
@@ -327,14 +421,9 @@ Future<Option<uint64_t>> CoordinatorProcess::truncate(uint64_t to)
 {
   if (state == INITIAL || state == ELECTING) {
     return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
   }
 
   Action action;
-  action.set_position(index);
-  action.set_promised(proposal);
-  action.set_performed(proposal);
   action.set_type(Action::TRUNCATE);
   Action::Truncate* truncate = action.mutable_truncate();
   truncate->set_to(to);
@@ -345,96 +434,297 @@ Future<Option<uint64_t>> CoordinatorProcess::truncate(uint64_t to)
 
 Future<Option<uint64_t>> CoordinatorProcess::write(const Action& action)
 {
-  LOG(INFO) << "Coordinator attempting to write " << action.type()
-            << " action at position " << action.position();
+  CHECK(state == ELECTED || state == WRITING);
+  CHECK(action.has_type());
 
-  CHECK_EQ(state, ELECTED);
-  CHECK(action.has_performed() && action.has_type());
+  Owned<Write> write(new Write(action));
+  queued.push_back(write);
+
+  Future<Option<uint64_t>> future = write->promise.future();
+  future.onDiscard(defer(self(), &Self::discarded, future));
+
+  if (batches.size() < pipelineDepth) {
+    writeBatch();
+  }
+
+  return future;
+}
+
+
+void CoordinatorProcess::writeBatch()
+{
+  CHECK(state == ELECTED || state == WRITING);
+  CHECK_LT(batches.size(), pipelineDepth);
+  CHECK(!queued.empty());
+
+  Owned<Batch> batch(new Batch());
+
+  // The writes of a batch are written to consecutive positions.
+  vector<Action> actions;
+
+  while (!queued.empty() && actions.size() < maxBatchSize) {
+    Owned<Write> write = queued.front();
+    queued.pop_front();
+
+    write->action.set_position(index + actions.size());
+    write->action.set_promised(proposal);
+    write->action.set_performed(proposal);
+
+    actions.push_back(write->action);
+    batch->writes.push_back(write);
+  }
+
+  index += actions.size();
+
+  if (actions.size() == 1) {
+    LOG(INFO) << "Coordinator attempting to write " << actions.front().type()
+              << " action at position " << actions.front().position();
+  } else {
+    LOG(INFO) << "Coordinator attempting to write " << actions.size()
+              << " actions at positions " << actions.front().position()
+              << " to " << actions.back().position();
+  }
 
   state = WRITING;
 
-  writing = runWritePhase(action)
-    .then(defer(self(), &Self::checkWritePhase, action, lambda::_1))
-    .onReady(defer(self(), &Self::writingFinished))
-    .onFailed(defer(self(), &Self::writingFailed))
-    .onDiscarded(defer(self(), &Self::writingAborted));
+  // NOTE: The write requests of all batches are sent by the proposer
+  // in the order of their positions, and a replica handles them in
+  // the order in which it receives them, thus each replica persists
+  // the batches in order even if several of them are in progress.
+  batch->writing = runWritePhase(actions)
+    .then(defer(self(), &Self::checkWritePhase, actions, lambda::_1))
+    .onAny(defer(self(), &Self::written));
 
-  return writing;
+  batches.push_back(batch);
+  pipelined();
 }
 
 
-Future<WriteResponse> CoordinatorProcess::runWritePhase(const Action& action)
+void CoordinatorProcess::discarded(const Future<Option<uint64_t>>& future)
 {
-  return log::write(quorum, network, proposal, action);
+  // A write that has not been sent yet is simply dropped.
+  for (auto it = queued.begin(); it != queued.end(); ++it) {
+    if ((*it)->promise.future() == future) {
+      (*it)->promise.discard();
+      queued.erase(it);
+      return;
+    }
+  }
+
+  // Otherwise, the write is detached from the client while the batch
+  // that it is part of is still written, since the other writes of
+  // the batch might still be waited for. The batch is aborted only
+  // once all of its writes have been discarded.
+  foreach (const Owned<Batch>& batch, batches) {
+    foreach (const Owned<Write>& write, batch->writes) {
+      if (write->promise.future() == future) {
+        write->promise.discard();
+
+        bool abort = true;
+        foreach (const Owned<Write>& other, batch->writes) {
+          if (!other->promise.future().isDiscarded()) {
+            abort = false;
+            break;
+          }
+        }
+
+        if (abort) {
+          batch->writing.discard();
+        }
+
+        return;
+      }
+    }
+  }
+}
+
+
+Future<WriteResponse> CoordinatorProcess::runWritePhase(
+    const vector<Action>& actions)
+{
+  return proposer.write(proposal, actions);
 }
 
 
 Future<Option<uint64_t>> CoordinatorProcess::checkWritePhase(
-    const Action& action,
+    const vector<Action>& actions,
     const WriteResponse& response)
 {
   if (!response.okay()) {
-    // Received a NACK. Save the proposal number.
-    CHECK_LE(proposal, response.proposal());
-    proposal = response.proposal();
+    // Received a NACK. Save the proposal number. NOTE: The proposal
+    // number might have been saved already if another batch that is
+    // being written received a NACK too.
+    proposal = std::max(proposal, response.proposal());
 
     return None();
   }
 
-  return runLearnPhase(action)
-    .then(defer(self(), &Self::checkLearnPhase, action))
-    .then(defer(self(), &Self::updateIndexAfterWritten, lambda::_1));
+  return runLearnPhase(actions)
+    .then(defer(self(), &Self::checkLearnPhase, actions))
+    .then(defer(self(), &Self::checkLearnedPositions, actions, lambda::_1));
 }
 
 
-Future<Nothing> CoordinatorProcess::runLearnPhase(const Action& action)
+Future<Nothing> CoordinatorProcess::runLearnPhase(
+    const vector<Action>& actions)
 {
-  return log::learn(network, action);
+  return proposer.learn(actions);
 }
 
 
-Future<bool> CoordinatorProcess::checkLearnPhase(const Action& action)
+Future<IntervalSet<uint64_t>> CoordinatorProcess::checkLearnPhase(
+    const vector<Action>& actions)
 {
   // Make sure that the local replica has learned the newly written
-  // log entry. Since messages are delivered and dispatched in order
-  // locally, we should always have the new entry learned by now.
-  return replica->missing(action.position());
+  // log entries. Since messages are delivered and dispatched in order
+  // locally, we should always have the new entries learned by now.
+  return replica->missing(
+      actions.front().position(),
+      actions.back().position());
 }
 
 
-Future<Option<uint64_t>> CoordinatorProcess::updateIndexAfterWritten(
-    bool missing)
+Future<Option<uint64_t>> CoordinatorProcess::checkLearnedPositions(
+    const vector<Action>& actions,
+    const IntervalSet<uint64_t>& missing)
 {
-  CHECK(!missing) << "Not expecting local replica to be missing position "
-                  << index << " after the writing is done";
+  CHECK(missing.empty())
+    << "Not expecting local replica to be missing positions " << missing
+    << " after the writing is done";
 
-  return index++;
+  return actions.front().position();
 }
 
 
-void CoordinatorProcess::writingFinished()
+void CoordinatorProcess::written()
 {
-  CHECK_EQ(state, WRITING);
-  state = ELECTED;
+  // The batches are completed in the order of their positions, thus
+  // a batch that is written before the batches preceding it waits
+  // for them. NOTE: This might be invoked for a batch that has been
+  // dropped already, in which case there is nothing to complete.
+  while (!batches.empty() && !batches.front()->writing.isPending()) {
+    CHECK_EQ(state, WRITING);
+
+    Owned<Batch> batch = batches.front();
+    batches.pop_front();
+
+    // NOTE: This is reported before the writes are completed, so that
+    // the metrics are up to date once they are.
+    pipelined();
+
+    const Future<Option<uint64_t>>& writing = batch->writing;
+
+    if (writing.isReady() && writing->isSome()) {
+      const Time now = Clock::now();
+
+      for (size_t i = 0; i < batch->writes.size(); i++) {
+        const Owned<Write>& write = batch->writes[i];
+
+        // NOTE: A write that has been discarded by its client is
+        // written nonetheless (see 'discarded').
+        if (write->promise.set(Option<uint64_t>(writing->get() + i)) &&
+            metrics.isSome()) {
+          metrics->commit_latency.record(now - write->requested);
+        }
+      }
+
+      continue;
+    }
+
+    if (writing.isReady()) {
+      foreach (const Owned<Write>& write, batch->writes) {
+        write->promise.set(Option<uint64_t>::none());
+      }
+
+      if (batches.empty()) {
+        // No batch has been sent after the rejected one, thus the
+        // coordinator stays elected and its next write is written to
+        // the first position of the rejected batch.
+        index = batch->writes.front()->action.position();
+        state = ELECTED;
+      } else {
+        // We don't know whether the batches that have been sent after
+        // the rejected one were written, so we demote the coordinator
+        // like when a write is discarded (see below).
+        state = INITIAL;
+      }
+
+      // The batch was rejected because another coordinator has been
+      // elected since, thus the following writes would be rejected
+      // too.
+      drop(None());
+    } else if (writing.isFailed()) {
+      state = INITIAL;
+
+      foreach (const Owned<Write>& write, batch->writes) {
+        write->promise.fail(writing.failure());
+      }
+
+      drop(writing.failure());
+    } else {
+      CHECK_DISCARDED(writing);
+
+      // Demote the coordinator if a write operation is discarded
+      // since we don't actually know the write was successful or not
+      // and we really need to "catch-up" that position before we try
+      // and do another write (see MESOS-1038 for more details).
+      state = INITIAL;
+
+      foreach (const Owned<Write>& write, batch->writes) {
+        write->promise.discard();
+      }
+
+      drop(None());
+    }
+
+    return;
+  }
+
+  if (state == WRITING && batches.empty()) {
+    state = ELECTED;
+  }
+
+  while (!queued.empty() && batches.size() < pipelineDepth) {
+    writeBatch();
+  }
 }
 
 
-void CoordinatorProcess::writingFailed()
+void CoordinatorProcess::drop(const Option<string>& failure)
 {
-  CHECK_EQ(state, WRITING);
-  state = INITIAL;
+  CHECK_NE(state, WRITING);
+
+  // The following batches are aborted, and their writes are treated
+  // like the queued writes, i.e., like writes that are requested
+  // after the coordinator has stopped writing.
+  foreach (const Owned<Batch>& batch, batches) {
+    batch->writing.discard();
+
+    foreach (const Owned<Write>& write, batch->writes) {
+      queued.push_back(write);
+    }
+  }
+
+  batches.clear();
+  pipelined();
+
+  foreach (const Owned<Write>& write, queued) {
+    if (failure.isSome()) {
+      write->promise.fail(failure.get());
+    } else {
+      write->promise.set(Option<uint64_t>::none());
+    }
+  }
+
+  queued.clear();
 }
 
 
-void CoordinatorProcess::writingAborted()
+void CoordinatorProcess::pipelined()
 {
-  CHECK_EQ(state, WRITING);
-
-  // Demote the coordinator if a write operation is discarded since we
-  // don't actually know the write was successful or not and we really
-  // need to "catch-up" that position before we try and do another
-  // write (see MESOS-1038 for more details).
-  state = INITIAL;
+  if (metrics.isSome()) {
+    metrics->pipelined(self(), batches.size());
+  }
 }
 
 
@@ -446,9 +736,13 @@ void CoordinatorProcess::writingAborted()
 Coordinator::Coordinator(
     size_t quorum,
     const Shared<Replica>& replica,
-    const Shared<Network>& network)
+    const Shared<Network>& network,
+    size_t pipelineDepth,
+    bool batchWrites,
+    const Option<CoordinatorMetrics>& metrics)
 {
-  process = new CoordinatorProcess(quorum, replica, network);
+  process = new CoordinatorProcess(
+      quorum, replica, network, pipelineDepth, batchWrites, metrics);
   spawn(process);
 }
 
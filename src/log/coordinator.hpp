@@ -22,8 +22,14 @@
 #include <string>
 
 #include <process/future.hpp>
+#include <process/pid.hpp>
 #include <process/shared.hpp>
 
+#include <process/metrics/timer.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/lambda.hpp>
+#include <stout/none.hpp>
 #include <stout/option.hpp>
 
 #include "log/network.hpp"
@@ -37,13 +43,35 @@ namespace log {
 class CoordinatorProcess;
 
 
+// The metrics of the writes of a coordinator. They are owned by the
+// log, so that the writes of all of its writers are reported
+// together. Copies share the same timer.
+struct CoordinatorMetrics
+{
+  // Invoked with the PID of the coordinator and the number of rounds
+  // of writes that it has in progress whenever that number changes.
+  lambda::function<void(const process::UPID&, size_t)> pipelined;
+
+  // The time from requesting a write until it is written.
+  process::metrics::Timer<Milliseconds> commit_latency;
+};
+
+
 class Coordinator
 {
 public:
+  // Up to 'pipelineDepth' rounds of writes are sent to the replicas
+  // before the first of them is written (see 'append'). Unless
+  // 'batchWrites' is set, each round writes a single position, since
+  // replicas of older versions drop the messages of a batch. The
+  // writes are reported to 'metrics' if given.
   Coordinator(
       size_t quorum,
       const process::Shared<Replica>& replica,
-      const process::Shared<Network>& network);
+      const process::Shared<Network>& network,
+      size_t pipelineDepth = 1,
+      bool batchWrites = false,
+      const Option<CoordinatorMetrics>& metrics = None());
 
   ~Coordinator();
 
@@ -60,7 +88,13 @@ public:
 
   // Appends the specified bytes to the end of the log. Returns the
   // position of the appended entry if the operation succeeds or none
-  // if the coordinator was demoted.
+  // if the coordinator was demoted. Writes (i.e., appends and
+  // truncates) are sent to the replicas right away as long as fewer
+  // than 'pipelineDepth' rounds are in progress. Otherwise they are
+  // queued, and written together in a single round once a round
+  // finishes (i.e., group commit) if 'batchWrites' is set, or one
+  // per round otherwise. Writes are always completed in the order of
+  // their positions.
   process::Future<Option<uint64_t>> append(const std::string& bytes);
 
   // Removes all log entries preceding the log entry at the given
@@ -23,8 +23,12 @@
 
 #include <stdint.h>
 
+#include <memory>
+
 #include <stout/check.hpp>
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/interval.hpp>
 #include <stout/numify.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
@@ -33,6 +37,7 @@
 #include "log/leveldb.hpp"
 
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -81,6 +86,16 @@ public:
 // static Varint64Comparator comparator;
 
 
+// The number of actions that are persisted between two snapshots,
+// which bounds the number of actions read on restore.
+static const size_t SNAPSHOT_INTERVAL = 1000;
+
+
+// The number of keys that are deleted by truncations before the
+// deleted keys are compacted.
+static const size_t COMPACTION_THRESHOLD = 1000;
+
+
 // Returns a string representing the specified position. Note that we
 // adjust the actual position by incrementing it by 1 because we
 // reserve 0 for storing the promise record (Record::Promise,
@@ -126,10 +141,54 @@ static string encode(uint64_t position, bool adjust = true)
 // }
 
 
+// Updates the state after the given action has been persisted.
+static void update(Storage::State* state, const Action& action)
+{
+  if (action.has_learned() && action.learned()) {
+    state->learned.insert(action.position());
+    state->unlearned.erase(action.position());
+    if (action.has_type() && action.type() == Action::TRUNCATE) {
+      state->begin = std::max(state->begin, action.truncate().to());
+    }
+  } else {
+    state->learned.erase(action.position());
+    state->unlearned.insert(action.position());
+  }
+  state->end = std::max(state->end, action.position());
+}
+
+
+static void convert(
+    const IntervalSet<uint64_t>& set,
+    google::protobuf::RepeatedPtrField<Snapshot::Interval>* intervals)
+{
+  foreach (const Interval<uint64_t>& interval, set) {
+    Snapshot::Interval* _interval = intervals->Add();
+    _interval->set_begin(interval.lower());
+    _interval->set_end(interval.upper() - 1);
+  }
+}
+
+
+static IntervalSet<uint64_t> convert(
+    const google::protobuf::RepeatedPtrField<Snapshot::Interval>& intervals)
+{
+  IntervalSet<uint64_t> set;
+
+  foreach (const Snapshot::Interval& interval, intervals) {
+    set += (Bound<uint64_t>::closed(interval.begin()),
+            Bound<uint64_t>::closed(interval.end()));
+  }
+
+  return set;
+}
+
+
 LevelDBStorage::LevelDBStorage()
-  : db(nullptr), first(None())
+  : db(nullptr), first(None()), unsnapshotted(0), uncompacted(0)
 {
-  // Nothing to see here.
+  state.begin = 0;
+  state.end = 0;
 }
 
 
@@ -173,39 +232,139 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
 
   VLOG(1) << "Opened db in " << stopwatch.elapsed();
 
-  stopwatch.start(); // Restart the stopwatch.
+  // The metadata record is stored along with a snapshot, unless it
+  // was written by an older version (or not written at all).
+  Option<Record> record;
 
-  // TODO(benh): Conditionally compact to avoid long recovery times?
-  db->CompactRange(nullptr, nullptr);
+  string value;
 
-  VLOG(1) << "Compacted db in " << stopwatch.elapsed();
+  status = db->Get(leveldb::ReadOptions(), encode(0, false), &value);
 
-  State state;
-  state.begin = 0;
-  state.end = 0;
+  if (status.ok()) {
+    record = Record();
 
-  // TODO(benh): Consider just reading the "promise" record (e.g.,
-  // 'encode(0, false)') and then iterating over the rest of the
-  // records and confirming that they are all indeed of type
-  // Record::Action.
+    if (!record->ParseFromString(value)) {
+      return Error("Failed to deserialize record");
+    }
+  } else if (!status.IsNotFound()) {
+    return Error(status.ToString());
+  }
 
   stopwatch.start(); // Restart the stopwatch.
 
-  leveldb::Iterator* iterator = db->NewIterator(leveldb::ReadOptions());
+  if (record.isNone() || !record->has_snapshot()) {
+    // Without a snapshot, we need to iterate through all the records.
+    // We compact the db first so that we don't need to iterate
+    // through the deleted keys (which is what a snapshot avoids).
+    db->CompactRange(nullptr, nullptr);
 
-  VLOG(1) << "Created db iterator in " << stopwatch.elapsed();
+    VLOG(1) << "Compacted db in " << stopwatch.elapsed();
 
-  stopwatch.start(); // Restart the stopwatch.
+    stopwatch.start(); // Restart the stopwatch.
 
-  iterator->SeekToFirst();
+    Try<uint64_t> keys = scan(encode(0, false), None());
+    if (keys.isError()) {
+      return Error(keys.error());
+    }
 
-  VLOG(1) << "Seeked to beginning of db in " << stopwatch.elapsed();
+    VLOG(1) << "Iterated through " << keys.get()
+            << " keys in the db in " << stopwatch.elapsed();
 
-  stopwatch.start(); // Restart the stopwatch.
+    // Write a snapshot with the next persisted action.
+    unsnapshotted = SNAPSHOT_INTERVAL;
+  } else {
+    CHECK_EQ(Record::METADATA, record->type());
+    CHECK(record->has_metadata());
+
+    const Snapshot& snapshot = record->snapshot();
+
+    state.metadata.CopyFrom(record->metadata());
+    state.begin = snapshot.begin();
+    state.end = snapshot.end();
+    state.learned = convert(snapshot.learned());
+    state.unlearned = convert(snapshot.unlearned());
+
+    // A learned action stays learned, thus we only need to read the
+    // positions that were not learned when the snapshot was written
+    // (i.e., unlearned positions and holes), and the positions after
+    // the end of the snapshot.
+    IntervalSet<uint64_t> positions(
+        Bound<uint64_t>::closed(snapshot.begin()),
+        Bound<uint64_t>::closed(snapshot.end()));
+
+    positions -= state.learned;
+
+    uint64_t keys = 0;
+
+    foreach (const Interval<uint64_t>& interval, positions) {
+      Try<uint64_t> _keys =
+        scan(encode(interval.lower()), encode(interval.upper()));
+
+      if (_keys.isError()) {
+        return Error(_keys.error());
+      }
+
+      keys += _keys.get();
+    }
+
+    Try<uint64_t> _keys = scan(encode(snapshot.end() + 1), None());
+    if (_keys.isError()) {
+      return Error(_keys.error());
+    }
+
+    keys += _keys.get();
+
+    VLOG(1) << "Read " << keys << " keys in the db after the snapshot at "
+            << "position " << snapshot.end() << " in " << stopwatch.elapsed();
+
+    // Find the first position still in leveldb (see 'truncate').
+    std::unique_ptr<leveldb::Iterator> iterator(
+        db->NewIterator(leveldb::ReadOptions()));
+
+    iterator->Seek(encode(0));
+
+    if (iterator->Valid()) {
+      const leveldb::Slice& slice = iterator->value();
+
+      Record _record;
+
+      if (!_record.ParseFromArray(slice.data(), slice.size())) {
+        return Error("Failed to deserialize record");
+      }
+
+      if (_record.type() != Record::ACTION) {
+        return Error("Bad record");
+      }
+
+      first = min(first, _record.action().position());
+    }
+  }
+
+  // No longer consider truncated positions as unlearned, like the
+  // replica does when it learns the truncation.
+  state.unlearned -=
+    (Bound<uint64_t>::closed(0), Bound<uint64_t>::open(state.begin));
+
+  return state;
+}
+
+
+Try<uint64_t> LevelDBStorage::scan(
+    const string& from,
+    const Option<string>& to)
+{
+  std::unique_ptr<leveldb::Iterator> iterator(
+      db->NewIterator(leveldb::ReadOptions()));
+
+  iterator->Seek(from);
 
   uint64_t keys = 0;
 
   while (iterator->Valid()) {
+    if (to.isSome() && iterator->key().compare(to.get()) >= 0) {
+      break;
+    }
+
     keys++;
     const leveldb::Slice& slice = iterator->value();
 
@@ -237,18 +396,7 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
 
       case Record::ACTION: {
         CHECK(record.has_action());
-        const Action& action = record.action();
-        if (action.has_learned() && action.learned()) {
-          state.learned.insert(action.position());
-          state.unlearned.erase(action.position());
-          if (action.has_type() && action.type() == Action::TRUNCATE) {
-            state.begin = std::max(state.begin, action.truncate().to());
-          }
-        } else {
-          state.learned.erase(action.position());
-          state.unlearned.insert(action.position());
-        }
-        state.end = std::max(state.end, action.position());
+        update(&state, record.action());
 
         // Cache the first position in this replica so during a
         // truncation, we can attempt to delete all positions from the
@@ -256,7 +404,7 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
         // is not the beginning position of the log, but rather the
         // first position that remains (i.e., hasn't been deleted) in
         // leveldb.
-        first = min(first, action.position());
+        first = min(first, record.action().position());
         break;
       }
 
@@ -268,12 +416,7 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
     iterator->Next();
   }
 
-  VLOG(1) << "Iterated through " << keys
-          << " keys in the db in " << stopwatch.elapsed();
-
-  delete iterator;
-
-  return state;
+  return keys;
 }
 
 
@@ -282,29 +425,80 @@ Try<Nothing> LevelDBStorage::persist(const Metadata& metadata)
   Stopwatch stopwatch;
   stopwatch.start();
 
-  leveldb::WriteOptions options;
-  options.sync = true;
+  Try<size_t> size = write(metadata, true);
+  if (size.isError()) {
+    return Error(size.error());
+  }
+
+  VLOG(1) << "Persisting metadata (" << size.get()
+          << " bytes) to leveldb took " << stopwatch.elapsed();
+
+  return Nothing();
+}
+
 
+Try<size_t> LevelDBStorage::write(const Metadata& metadata, bool sync)
+{
   Record record;
   record.set_type(Record::METADATA);
   record.mutable_metadata()->CopyFrom(metadata);
 
+  // The positions preceding the beginning of the log are not needed.
+  const IntervalSet<uint64_t> learned = state.learned -
+    (Bound<uint64_t>::closed(0), Bound<uint64_t>::open(state.begin));
+
+  Snapshot* snapshot = record.mutable_snapshot();
+  snapshot->set_begin(state.begin);
+  snapshot->set_end(state.end);
+  convert(learned, snapshot->mutable_learned());
+  convert(state.unlearned, snapshot->mutable_unlearned());
+
   string value;
 
   if (!record.SerializeToString(&value)) {
     return Error("Failed to serialize record");
   }
 
+  leveldb::WriteOptions options;
+  options.sync = sync;
+
   leveldb::Status status = db->Put(options, encode(0, false), value);
 
   if (!status.ok()) {
     return Error(status.ToString());
   }
 
-  VLOG(1) << "Persisting metadata (" << value.size()
-          << " bytes) to leveldb took " << stopwatch.elapsed();
+  state.metadata.CopyFrom(metadata);
+  unsnapshotted = 0;
 
-  return Nothing();
+  return value.size();
+}
+
+
+void LevelDBStorage::snapshot()
+{
+  // The snapshot is stored in the metadata record, thus we can only
+  // write it once the metadata has been persisted (the required
+  // fields of the metadata are unset before).
+  if (unsnapshotted < SNAPSHOT_INTERVAL || !state.metadata.IsInitialized()) {
+    return;
+  }
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  // The snapshot only reflects actions that have been persisted, thus
+  // we can write it asynchronously: if it gets lost, the previous
+  // snapshot is used instead.
+  Try<size_t> size = write(state.metadata, false);
+
+  if (size.isError()) {
+    LOG(WARNING) << "Ignoring failure to write a snapshot to leveldb: "
+                 << size.error();
+  } else {
+    VLOG(1) << "Writing a snapshot (" << size.get()
+            << " bytes) to leveldb took " << stopwatch.elapsed();
+  }
 }
 
 
@@ -338,74 +532,159 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
   // catch-up policy is used).
   first = min(first, action.position());
 
+  update(&state, action);
+  unsnapshotted++;
+
   VLOG(1) << "Persisting action (" << value.size()
           << " bytes) to leveldb took " << stopwatch.elapsed();
 
-  // Delete positions if a truncate action has been *learned*. Note
-  // that we do this in a best-effort fashion (i.e., we ignore any
-  // failures to the database since we can always try again).
+  // Delete positions if a truncate action has been *learned*.
   if (action.has_type() && action.type() == Action::TRUNCATE &&
       action.has_learned() && action.learned()) {
     CHECK(action.has_truncate());
+    truncate(action.truncate().to());
+  }
 
-    stopwatch.start(); // Restart the stopwatch.
+  snapshot();
+
+  return Nothing();
+}
+
+
+Try<Nothing> LevelDBStorage::persist(const vector<Action>& actions)
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  leveldb::WriteBatch batch;
+  size_t size = 0;
+
+  foreach (const Action& action, actions) {
+    Record record;
+    record.set_type(Record::ACTION);
+    record.mutable_action()->MergeFrom(action);
 
-    // To actually perform the truncation in leveldb we need to remove
-    // all the keys that represent positions no longer in the log. We
-    // do this by attempting to delete all keys that represent the
-    // first position we know is still in leveldb up to (but
-    // excluding) the truncate position. Note that this works because
-    // the semantics of WriteBatch are such that even if the position
-    // doesn't exist (which is possible because this replica has some
-    // holes), we can attempt to delete the key that represents it and
-    // it will just ignore that key. This is *much* cheaper than
-    // actually iterating through the entire database instead (which
-    // was, for posterity, the original implementation). In addition,
-    // caching the "first" position we know is in the database is
-    // cheaper than using an iterator to determine the first position
-    // (which was, for posterity, the second implementation).
-
-    leveldb::WriteBatch batch;
-
-    CHECK_SOME(first);
-
-    // Add positions up to (but excluding) the truncate position to
-    // the batch starting at the first position still in leveldb. It's
-    // likely that the first position is greater than the truncate
-    // position (e.g., during catch-up). In that case, we do nothing
-    // because there is nothing we can truncate.
-    // TODO(jieyu): We might miss a truncation if we do random (i.e.,
-    // out of order) bulk catch-up and the truncate operation is
-    // caught up first.
-    uint64_t index = 0;
-    while ((first.get() + index) < action.truncate().to()) {
-      batch.Delete(encode(first.get() + index));
-      index++;
+    string value;
+
+    if (!record.SerializeToString(&value)) {
+      return Error("Failed to serialize record");
     }
 
-    // If we added any positions, attempt to delete them!
-    if (index > 0) {
-      // We do this write asynchronously (e.g., using default options).
-      leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
-
-      if (!status.ok()) {
-        LOG(WARNING) << "Ignoring leveldb batch delete failure: "
-                     << status.ToString();
-      } else {
-        // Save the new first position!
-        CHECK_LT(first.get(), action.truncate().to());
-        first = action.truncate().to();
-
-        VLOG(1) << "Deleting ~" << index
-                << " keys from leveldb took " << stopwatch.elapsed();
-      }
+    batch.Put(encode(action.position()), value);
+    size += value.size();
+  }
+
+  leveldb::WriteOptions options;
+  options.sync = true;
+
+  leveldb::Status status = db->Write(options, &batch);
+
+  if (!status.ok()) {
+    return Error(status.ToString());
+  }
+
+  foreach (const Action& action, actions) {
+    first = min(first, action.position());
+    update(&state, action);
+  }
+
+  unsnapshotted += actions.size();
+
+  VLOG(1) << "Persisting " << actions.size() << " actions (" << size
+          << " bytes) to leveldb took " << stopwatch.elapsed();
+
+  foreach (const Action& action, actions) {
+    if (action.has_type() && action.type() == Action::TRUNCATE &&
+        action.has_learned() && action.learned()) {
+      CHECK(action.has_truncate());
+      truncate(action.truncate().to());
     }
   }
 
+  snapshot();
+
   return Nothing();
 }
 
 
+void LevelDBStorage::truncate(uint64_t to)
+{
+  // Note that we do this in a best-effort fashion (i.e., we ignore
+  // any failures to the database since we can always try again).
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  // To actually perform the truncation in leveldb we need to remove
+  // all the keys that represent positions no longer in the log. We
+  // do this by attempting to delete all keys that represent the
+  // first position we know is still in leveldb up to (but
+  // excluding) the truncate position. Note that this works because
+  // the semantics of WriteBatch are such that even if the position
+  // doesn't exist (which is possible because this replica has some
+  // holes), we can attempt to delete the key that represents it and
+  // it will just ignore that key. This is *much* cheaper than
+  // actually iterating through the entire database instead (which
+  // was, for posterity, the original implementation). In addition,
+  // caching the "first" position we know is in the database is
+  // cheaper than using an iterator to determine the first position
+  // (which was, for posterity, the second implementation).
+
+  leveldb::WriteBatch batch;
+
+  CHECK_SOME(first);
+
+  // Add positions up to (but excluding) the truncate position to
+  // the batch starting at the first position still in leveldb. It's
+  // likely that the first position is greater than the truncate
+  // position (e.g., during catch-up). In that case, we do nothing
+  // because there is nothing we can truncate.
+  // TODO(jieyu): We might miss a truncation if we do random (i.e.,
+  // out of order) bulk catch-up and the truncate operation is
+  // caught up first.
+  uint64_t index = 0;
+  while ((first.get() + index) < to) {
+    batch.Delete(encode(first.get() + index));
+    index++;
+  }
+
+  // If we added any positions, attempt to delete them!
+  if (index > 0) {
+    // We do this write asynchronously (e.g., using default options).
+    leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
+
+    if (!status.ok()) {
+      LOG(WARNING) << "Ignoring leveldb batch delete failure: "
+                   << status.ToString();
+    } else {
+      // Save the new first position!
+      CHECK_LT(first.get(), to);
+      first = to;
+
+      VLOG(1) << "Deleting ~" << index
+              << " keys from leveldb took " << stopwatch.elapsed();
+
+      uncompacted += index;
+
+      // Compact the deleted keys every once in a while, so that they
+      // don't need to be skipped when iterating through the db.
+      if (uncompacted >= COMPACTION_THRESHOLD) {
+        stopwatch.start(); // Restart the stopwatch.
+
+        const string limit = encode(to);
+        const leveldb::Slice slice(limit);
+
+        db->CompactRange(nullptr, &slice);
+
+        uncompacted = 0;
+
+        VLOG(1) << "Compacting truncated keys in leveldb took "
+                << stopwatch.elapsed();
+      }
+    }
+  }
+}
+
+
 Try<Action> LevelDBStorage::read(uint64_t position)
 {
   Stopwatch stopwatch;
@@ -21,7 +21,12 @@
 
 #include <stdint.h>
 
+#include <string>
+#include <vector>
+
+#include <stout/nothing.hpp>
 #include <stout/option.hpp>
+#include <stout/try.hpp>
 
 #include "log/storage.hpp"
 
@@ -39,13 +44,42 @@ public:
   virtual Try<State> restore(const std::string& path);
   virtual Try<Nothing> persist(const Metadata& metadata);
   virtual Try<Nothing> persist(const Action& action);
+  virtual Try<Nothing> persist(const std::vector<Action>& actions);
   virtual Try<Action> read(uint64_t position);
 
 private:
+  // Reads the records with keys in ['from', 'to') into 'state', or
+  // up to the end of the db if 'to' is none. Returns the number of
+  // records read.
+  Try<uint64_t> scan(const std::string& from, const Option<std::string>& to);
+
+  // Writes the metadata record, along with a snapshot of 'state'.
+  // Returns the size of the record.
+  Try<size_t> write(const Metadata& metadata, bool sync);
+
+  // Writes a snapshot with the last persisted metadata, once enough
+  // actions have been persisted since the last snapshot.
+  void snapshot();
+
+  // Deletes the positions preceding the given position, once a
+  // truncate action has been learned.
+  void truncate(uint64_t to);
+
   leveldb::DB* db;
 
   // First position still in leveldb, used during truncation.
   Option<uint64_t> first;
+
+  // The state as of the last persisted action (i.e., what 'restore'
+  // would return), which is written out every once in a while as a
+  // snapshot to bound the time that it takes to restore.
+  State state;
+
+  // The number of actions persisted since the last snapshot.
+  size_t unsnapshotted;
+
+  // The number of keys deleted since the last compaction.
+  size_t uncompacted;
 };
 
 } // namespace log {
@@ -67,12 +67,13 @@ LogProcess::LogProcess(
     const string& path,
     const set<UPID>& pids,
     bool _autoInitialize,
-    const Option<string>& metricsPrefix)
+    const Option<string>& _metricsPrefix)
   : ProcessBase(ID::generate("log")),
     quorum(_quorum),
     replica(new Replica(path)),
     network(new Network(pids + (UPID) replica->pid())),
     autoInitialize(_autoInitialize),
+    metricsPrefix(_metricsPrefix),
     group(nullptr),
     metrics(*this, metricsPrefix) {}
 
@@ -85,7 +86,7 @@ LogProcess::LogProcess(
     const string& znode,
     const Option<zookeeper::Authentication>& auth,
     bool _autoInitialize,
-    const Option<string>& metricsPrefix)
+    const Option<string>& _metricsPrefix)
   : ProcessBase(ID::generate("log")),
     quorum(_quorum),
     replica(new Replica(path)),
@@ -96,6 +97,7 @@ LogProcess::LogProcess(
         auth,
         {replica->pid()})),
     autoInitialize(_autoInitialize),
+    metricsPrefix(_metricsPrefix),
     group(new zookeeper::Group(servers, timeout, znode, auth)),
     metrics(*this, metricsPrefix) {}
 
@@ -191,7 +193,8 @@ Future<Shared<Replica>> LogProcess::recover()
           quorum,
           replica.own().get(),
           network,
-          autoInitialize)
+          autoInitialize,
+          metrics.catchup)
       .onAny(defer(self(), &Self::_recover));
   }
 
@@ -248,6 +251,27 @@ double LogProcess::_recovered()
 }
 
 
+void LogProcess::pipelined(const UPID& coordinator, size_t depth)
+{
+  if (depth == 0) {
+    pipelines.erase(coordinator);
+  } else {
+    pipelines[coordinator] = depth;
+  }
+}
+
+
+double LogProcess::_pipeline_depth()
+{
+  size_t depth = 0;
+  foreachvalue (size_t pipelined, pipelines) {
+    depth += pipelined;
+  }
+
+  return depth;
+}
+
+
 void LogProcess::watch(
     const UPID& pid,
     const set<zookeeper::Group::Membership>& memberships)
@@ -442,11 +466,19 @@ Log::Position LogReaderProcess::position(uint64_t value)
 /////////////////////////////////////////////////
 
 
-LogWriterProcess::LogWriterProcess(Log* log)
+LogWriterProcess::LogWriterProcess(
+    Log* log,
+    size_t _pipelineDepth,
+    bool _batchWrites)
   : ProcessBase(ID::generate("log-writer")),
     quorum(log->process->quorum),
     network(log->process->network),
+    pipelineDepth(_pipelineDepth),
+    batchWrites(_batchWrites),
     recovering(dispatch(log->process, &LogProcess::recover)),
+    metrics(CoordinatorMetrics{
+        defer(log->process, &LogProcess::pipelined, lambda::_1, lambda::_2),
+        log->process->metrics.commit_latency}),
     coordinator(nullptr),
     error(None()) {}
 
@@ -531,7 +563,13 @@ Future<Option<Log::Position>> LogWriterProcess::_start()
 
   CHECK_READY(recovering);
 
-  coordinator = new Coordinator(quorum, recovering.get(), network);
+  coordinator = new Coordinator(
+      quorum,
+      recovering.get(),
+      network,
+      pipelineDepth,
+      batchWrites,
+      metrics);
 
   LOG(INFO) << "Attempting to start the writer";
 
@@ -719,9 +757,9 @@ Future<Log::Position> Log::Reader::ending()
 /////////////////////////////////////////////////
 
 
-Log::Writer::Writer(Log* log)
+Log::Writer::Writer(Log* log, size_t pipelineDepth, bool batchWrites)
 {
-  process = new LogWriterProcess(log);
+  process = new LogWriterProcess(log, pipelineDepth, batchWrites);
   spawn(process);
 }
 
@@ -28,6 +28,7 @@
 
 #include <process/metrics/gauge.hpp>
 
+#include <stout/hashmap.hpp>
 #include <stout/nothing.hpp>
 
 #include "log/coordinator.hpp"
@@ -48,7 +49,7 @@ public:
       const std::string& path,
       const std::set<process::UPID>& pids,
       bool _autoInitialize,
-      const Option<std::string>& metricsPrefix);
+      const Option<std::string>& _metricsPrefix);
 
   LogProcess(
       size_t _quorum,
@@ -58,7 +59,7 @@ public:
       const std::string& znode,
       const Option<zookeeper::Authentication>& auth,
       bool _autoInitialize,
-      const Option<std::string>& metricsPrefix);
+      const Option<std::string>& _metricsPrefix);
 
   // Recovers the log by catching up if needed. Returns a shared
   // pointer to the local replica if the recovery succeeds.
@@ -78,6 +79,12 @@ private:
   // Return true if the log has finished recovery.
   double _recovered();
 
+  // Records the number of rounds of writes that the coordinator of a
+  // writer has in progress (see 'CoordinatorMetrics').
+  void pipelined(const process::UPID& coordinator, size_t depth);
+
+  double _pipeline_depth();
+
   // TODO(benh): Factor this out into "membership renewer".
   void watch(
       const process::UPID& pid,
@@ -90,6 +97,7 @@ private:
   process::Shared<Replica> replica;
   process::Shared<Network> network;
   const bool autoInitialize;
+  const Option<std::string> metricsPrefix;
 
   // For replica recovery.
   Option<process::Future<process::Owned<Replica>>> recovering;
@@ -101,6 +109,10 @@ private:
   zookeeper::Group* group;
   process::Future<zookeeper::Group::Membership> membership;
 
+  // The number of rounds of writes in progress for each coordinator
+  // that has any.
+  hashmap<process::UPID, size_t> pipelines;
+
   friend Metrics;
   Metrics metrics;
 
@@ -163,7 +175,10 @@ private:
 class LogWriterProcess : public process::Process<LogWriterProcess>
 {
 public:
-  explicit LogWriterProcess(mesos::log::Log* log);
+  LogWriterProcess(
+      mesos::log::Log* log,
+      size_t _pipelineDepth,
+      bool _batchWrites);
 
   process::Future<Option<mesos::log::Log::Position>> start();
   process::Future<Option<mesos::log::Log::Position>> append(
@@ -195,10 +210,15 @@ private:
 
   const size_t quorum;
   const process::Shared<Network> network;
+  const size_t pipelineDepth;
+  const bool batchWrites;
 
   process::Future<process::Shared<Replica>> recovering;
   std::list<process::Promise<Nothing>*> promises;
 
+  // The metrics of the log that the coordinators report to.
+  const CoordinatorMetrics metrics;
+
   Coordinator* coordinator;
   Option<std::string> error;
 };
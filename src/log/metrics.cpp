@@ -38,10 +38,21 @@ Metrics::Metrics(
         defer(process, &LogProcess::_recovered)),
     ensemble_size(
         prefix.getOrElse("") + "log/ensemble_size",
-        defer(process, &LogProcess::_ensemble_size))
+        defer(process, &LogProcess::_ensemble_size)),
+    pipeline_depth(
+        prefix.getOrElse("") + "log/pipeline_depth",
+        defer(process, &LogProcess::_pipeline_depth)),
+    commit_latency(prefix.getOrElse("") + "log/commit_latency"),
+    catchup(prefix)
 {
   process::metrics::add(recovered);
   process::metrics::add(ensemble_size);
+  process::metrics::add(pipeline_depth);
+  process::metrics::add(commit_latency);
+
+  process::metrics::add(catchup.positions_missing);
+  process::metrics::add(catchup.positions_fetched);
+  process::metrics::add(catchup.positions_filled);
 }
 
 
@@ -49,6 +60,12 @@ Metrics::~Metrics()
 {
   process::metrics::remove(recovered);
   process::metrics::remove(ensemble_size);
+  process::metrics::remove(pipeline_depth);
+  process::metrics::remove(commit_latency);
+
+  process::metrics::remove(catchup.positions_missing);
+  process::metrics::remove(catchup.positions_fetched);
+  process::metrics::remove(catchup.positions_filled);
 }
 
 } // namespace log {
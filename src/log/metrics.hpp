@@ -20,6 +20,12 @@
 #include <string>
 
 #include <process/metrics/gauge.hpp>
+#include <process/metrics/timer.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/option.hpp>
+
+#include "log/catchup.hpp"
 
 namespace mesos {
 namespace internal {
@@ -39,6 +45,16 @@ struct Metrics
   process::metrics::Gauge recovered;
 
   process::metrics::Gauge ensemble_size;
+
+  // The number of rounds of writes that are in progress, summed over
+  // the writers of the log.
+  process::metrics::Gauge pipeline_depth;
+
+  // The time from requesting a write until it is written, recorded by
+  // the coordinators of the writers of the log.
+  process::metrics::Timer<Milliseconds> commit_latency;
+
+  CatchUpMetrics catchup;
 };
 
 } // namespace log {
@@ -96,6 +96,17 @@ public:
       const M& m,
       const std::set<process::UPID>& filter = std::set<process::UPID>()) const;
 
+  // Sends a message to each member of the network on behalf of
+  // 'from', which receives the responses. Unlike the requests that
+  // are broadcasted with a protocol, the messages are sent by the
+  // network itself, thus each member receives them in the order in
+  // which they are broadcasted.
+  template <typename M>
+  process::Future<Nothing> broadcast(
+      const process::UPID& from,
+      const M& m,
+      const std::set<process::UPID>& filter = std::set<process::UPID>()) const;
+
 private:
   // Not copyable, not assignable.
   Network(const Network&);
@@ -254,6 +265,23 @@ public:
     return Nothing();
   }
 
+  // Sends a message to each of the group members on behalf of 'from'.
+  template <typename M>
+  Nothing broadcast(
+      const process::UPID& from,
+      const M& m,
+      const std::set<process::UPID>& filter)
+  {
+    std::set<process::UPID>::const_iterator iterator;
+    for (iterator = pids.begin(); iterator != pids.end(); ++iterator) {
+      const process::UPID& pid = *iterator;
+      if (filter.count(pid) == 0) {
+        process::post(from, pid, m);
+      }
+    }
+    return Nothing();
+  }
+
 protected:
   virtual void finalize()
   {
@@ -395,6 +423,21 @@ process::Future<Nothing> Network::broadcast(
 }
 
 
+template <typename M>
+process::Future<Nothing> Network::broadcast(
+    const process::UPID& from,
+    const M& m,
+    const std::set<process::UPID>& filter) const
+{
+  // Need to disambiguate overloaded function.
+  Nothing (NetworkProcess::*broadcast)(
+      const process::UPID&, const M&, const std::set<process::UPID>&)
+    = &NetworkProcess::broadcast<M>;
+
+  return process::dispatch(process, broadcast, from, m, filter);
+}
+
+
 inline ZooKeeperNetwork::ZooKeeperNetwork(
     const std::string& servers,
     const Duration& timeout,
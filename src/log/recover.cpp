@@ -73,7 +73,7 @@ namespace log {
 // We re-use RecoverResponse to specify the return value. The 'status'
 // field specifies the next status of the local replica. If the next
 // status is RECOVERING, we set the fields 'begin' and 'end' to be the
-// lowest begin and highest end position seen in these responses.
+// highest begin and highest end position seen in these responses.
 class RecoverProtocolProcess : public Process<RecoverProtocolProcess>
 {
 public:
@@ -159,7 +159,7 @@ private:
 
     // Reset the counters.
     responsesReceived.clear();
-    lowestBeginPosition = None();
+    highestBeginPosition = None();
     highestEndPosition = None();
 
     return Nothing();
@@ -199,12 +199,12 @@ private:
 
     responsesReceived[response.status()]++;
 
-    // We need to remember the lowest begin position and highest end
+    // We need to remember the highest begin position and highest end
     // position seen from VOTING replicas.
     if (response.status() == Metadata::VOTING) {
       CHECK(response.has_begin() && response.has_end());
 
-      lowestBeginPosition = min(lowestBeginPosition, response.begin());
+      highestBeginPosition = max(highestBeginPosition, response.begin());
       highestEndPosition = max(highestEndPosition, response.end());
     }
 
@@ -212,19 +212,19 @@ private:
     // replica will be put in RECOVERING status and start catching up.
     // It is likely that the local replica is in RECOVERING status
     // already. This is the case where the replica crashes during
-    // catch-up. When it restarts, we need to recalculate the lowest
+    // catch-up. When it restarts, we need to recalculate the highest
     // begin position and the highest end position since we haven't
     // persisted this information on disk.
     if (responsesReceived[Metadata::VOTING] >= quorum) {
       process::discard(responses);
 
-      CHECK_SOME(lowestBeginPosition);
+      CHECK_SOME(highestBeginPosition);
       CHECK_SOME(highestEndPosition);
-      CHECK_LE(lowestBeginPosition.get(), highestEndPosition.get());
+      CHECK_LE(highestBeginPosition.get(), highestEndPosition.get());
 
       RecoverResponse result;
       result.set_status(Metadata::RECOVERING);
-      result.set_begin(lowestBeginPosition.get());
+      result.set_begin(highestBeginPosition.get());
       result.set_end(highestEndPosition.get());
 
       return result;
@@ -355,7 +355,7 @@ private:
 
   set<Future<RecoverResponse>> responses;
   hashmap<Metadata::Status, size_t> responsesReceived;
-  Option<uint64_t> lowestBeginPosition;
+  Option<uint64_t> highestBeginPosition;
   Option<uint64_t> highestEndPosition;
   Future<Option<RecoverResponse>> chain;
   bool terminating;
@@ -436,12 +436,14 @@ public:
       size_t _quorum,
       const Owned<Replica>& _replica,
       const Shared<Network>& _network,
-      bool _autoInitialize)
+      bool _autoInitialize,
+      const Option<CatchUpMetrics>& _metrics)
     : ProcessBase(ID::generate("log-recover")),
       quorum(_quorum),
       replica(_replica),
       network(_network),
-      autoInitialize(_autoInitialize) {}
+      autoInitialize(_autoInitialize),
+      metrics(_metrics) {}
 
   Future<Owned<Replica>> future() { return promise.future(); }
 
@@ -529,8 +531,8 @@ private:
     // Now, the question is how many positions the local replica
     // should catch up before it can be allowed to vote. We find that
     // it is sufficient to catch-up positions from _begin_ to _end_
-    // where _begin_ is the smallest position seen in a quorum of
-    // VOTING replicas and _end_ is the largest position seen in a
+    // where _begin_ is the largest begin position seen in a quorum
+    // of VOTING replicas and _end_ is the largest position seen in a
     // quorum of VOTING replicas. Here is the correctness argument.
     // For a position _e_ larger than _end_, obviously no value has
     // been agreed on for that position. Otherwise, we should find at
@@ -539,9 +541,16 @@ private:
     // coordinator should not have collected enough promises for
     // position _e_. Therefore, it's safe for the local replica to
     // vote for that position. For a position _b_ smaller than
-    // _begin_, it should have already been truncated and the
-    // truncation should have already been agreed. Therefore, allowing
-    // the local replica to vote for that position is safe.
+    // _begin_, it has already been truncated since the begin
+    // position of a replica only moves once it has learned a
+    // truncation (i.e., the truncation has been agreed). Therefore,
+    // allowing the local replica to vote for that position is safe.
+    // Note that the truncation itself is written at a position in
+    // [_begin_, _end_], thus the local replica learns it (and moves
+    // its begin position) while catching up. Using the largest
+    // rather than the smallest begin position saves the local
+    // replica from filling positions that a lagging replica has not
+    // truncated yet, one at a time.
     CHECK_LE(begin, end);
 
     LOG(INFO) << "Starting catch-up from position " << begin << " to " << end;
@@ -558,7 +567,8 @@ private:
     // Since we do not know what proposal number to use (the log is
     // empty), we use none and leave log::catchup to automatically
     // bump the proposal number.
-    return log::catchup(quorum, shared, network, None(), positions)
+    return log::catchup(
+        quorum, shared, network, None(), positions, Seconds(10), metrics)
       .then(defer(self(), &Self::getReplicaOwnership, shared))
       .then(defer(self(), &Self::updateReplicaStatus, Metadata::VOTING));
   }
@@ -617,6 +627,7 @@ private:
   Owned<Replica> replica;
   const Shared<Network> network;
   const bool autoInitialize;
+  const Option<CatchUpMetrics> metrics;
 
   Future<Nothing> chain;
 
@@ -628,14 +639,16 @@ Future<Owned<Replica>> recover(
     size_t quorum,
     const Owned<Replica>& replica,
     const Shared<Network>& network,
-    bool autoInitialize)
+    bool autoInitialize,
+    const Option<CatchUpMetrics>& metrics)
 {
   RecoverProcess* process =
     new RecoverProcess(
         quorum,
         replica,
         network,
-        autoInitialize);
+        autoInitialize,
+        metrics);
 
   Future<Owned<Replica>> future = process->future();
   spawn(process, true);
@@ -23,8 +23,11 @@
 #include <process/owned.hpp>
 #include <process/shared.hpp>
 
+#include <stout/none.hpp>
 #include <stout/nothing.hpp>
+#include <stout/option.hpp>
 
+#include "log/catchup.hpp"
 #include "log/network.hpp"
 #include "log/replica.hpp"
 
@@ -49,11 +52,14 @@ namespace log {
 // an empty replica will be allowed to vote if ALL replicas (i.e.,
 // quorum * 2 - 1) are empty. This allows us to bootstrap the
 // replicated log without explicitly using an initialization tool.
+// The progress of catching up missing positions is reported with
+// the given metrics (see 'catchup').
 extern process::Future<process::Owned<Replica>> recover(
     size_t quorum,
     const process::Owned<Replica>& replica,
     const process::Shared<Network>& network,
-    bool autoInitialize = false);
+    bool autoInitialize = false,
+    const Option<CatchUpMetrics>& metrics = None());
 
 } // namespace log {
 } // namespace internal {
@@ -17,6 +17,7 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
@@ -31,6 +32,7 @@
 #include <stout/nothing.hpp>
 #include <stout/result.hpp>
 #include <stout/try.hpp>
+#include <stout/stringify.hpp>
 #include <stout/utils.hpp>
 
 #ifndef __WINDOWS__
@@ -43,17 +45,25 @@ using namespace process;
 
 using std::list;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
 namespace log {
 
+// The maximum size of the actions in a fetch response. A response
+// includes at least one action, even if that action is larger.
+static const size_t MAX_FETCH_RESPONSE_SIZE = 4 * 1024 * 1024;
+
+
 namespace protocol {
 
 // Some replica protocol definitions.
 Protocol<PromiseRequest, PromiseResponse> promise;
 Protocol<WriteRequest, WriteResponse> write;
+Protocol<BatchWriteRequest, BatchWriteResponse> batchWrite;
 Protocol<RecoverRequest, RecoverResponse> recover;
+Protocol<FetchRequest, FetchResponse> fetch;
 
 } // namespace protocol {
 
@@ -103,6 +113,10 @@ public:
   // to storage. Returns true on success and false otherwise.
   bool update(const Metadata::Status& status);
 
+  // Persists the specified learned actions at once. Returns true on
+  // success and false otherwise.
+  bool learn(const vector<Action>& actions);
+
 private:
   // Handles a request from a proposer to promise not to accept writes
   // from any other proposer with lower proposal number.
@@ -111,16 +125,40 @@ private:
   // Handles a request from a proposer to write an action.
   void write(const UPID& from, const WriteRequest& request);
 
+  // Handles a request from a proposer to write the actions of a
+  // batch, which are persisted at once.
+  void batchWrite(const UPID& from, const BatchWriteRequest& request);
+
+  // Decides on a write request. Returns the action to persist if the
+  // request is accepted, in which case `response` is the response to
+  // send once the action is persisted. Otherwise returns none, and
+  // sets `response` unless the request is ignored silently.
+  Result<Action> decide(const WriteRequest& request, WriteResponse* response);
+
   // Handles a request from a recover process.
   void recover(const UPID& from, const RecoverRequest& request);
 
   // Handles a message notifying of a learned action.
   void learned(const UPID& from, const Action& action);
 
+  // Handles a message notifying of the learned actions of a batch.
+  void batchLearned(const UPID& from, const BatchLearnedMessage& message);
+
+  // Handles a request for the learned actions within a range of
+  // positions (e.g., from a replica that is catching up).
+  void fetch(const UPID& from, const FetchRequest& request);
+
   // Persists the specified action to storage. Returns true on success
   // and false otherwise.
   bool persist(const Action& action);
 
+  // Persists the specified actions to storage at once. Returns true on
+  // success and false otherwise.
+  bool persist(const std::vector<Action>& actions);
+
+  // Updates the positions of the log after an action is persisted.
+  void updatePositions(const Action& action);
+
   // Updates the highest promise this replica has given. The update
   // will be persisted to storage. Returns true on success and false
   // otherwise.
@@ -167,12 +205,21 @@ ReplicaProcess::ReplicaProcess(const string& path)
   install<WriteRequest>(
       &ReplicaProcess::write);
 
+  install<BatchWriteRequest>(
+      &ReplicaProcess::batchWrite);
+
   install<RecoverRequest>(
       &ReplicaProcess::recover);
 
   install<LearnedMessage>(
       &ReplicaProcess::learned,
       &LearnedMessage::action);
+
+  install<BatchLearnedMessage>(
+      &ReplicaProcess::batchLearned);
+
+  install<FetchRequest>(
+      &ReplicaProcess::fetch);
 }
 
 
@@ -540,19 +587,106 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
   LOG(INFO) << "Replica received write request for position "
             << request.position() << " from " << from;
 
+  WriteResponse response;
+  Result<Action> action = decide(request, &response);
+
+  if (action.isError()) {
+    LOG(ERROR) << action.error();
+  } else if (action.isNone()) {
+    if (response.has_type()) {
+      reply(response);
+    }
+  } else if (persist(action.get())) {
+    reply(response);
+  }
+}
+
+
+void ReplicaProcess::batchWrite(
+    const UPID& from,
+    const BatchWriteRequest& request)
+{
+  if (request.requests().empty()) {
+    return;
+  }
+
+  // Ignore write requests if this replica is not in VOTING status; we
+  // also inform the requester, so that they can retry promptly.
+  if (status() != Metadata::VOTING) {
+    LOG(INFO) << "Replica ignoring " << request.requests().size()
+              << " write requests from " << from
+              << " as it is in " << status() << " status";
+
+    BatchWriteResponse responses;
+    foreach (const WriteRequest& request_, request.requests()) {
+      WriteResponse* response = responses.add_responses();
+      response->set_type(WriteResponse::IGNORED);
+      response->set_okay(false);
+      response->set_proposal(request_.proposal());
+      response->set_position(request_.position());
+    }
+
+    reply(responses);
+    return;
+  }
+
+  LOG(INFO) << "Replica received write requests for positions "
+            << request.requests(0).position() << " to "
+            << request.requests(request.requests().size() - 1).position()
+            << " from " << from;
+
+  BatchWriteResponse responses;
+  vector<Action> actions;
+
+  // We only reply if there is a response for each of the requests,
+  // see `decide` below.
+  bool complete = true;
+
+  foreach (const WriteRequest& request_, request.requests()) {
+    WriteResponse response;
+    Result<Action> action = decide(request_, &response);
+
+    if (action.isError()) {
+      LOG(ERROR) << action.error();
+      return;
+    } else if (action.isSome()) {
+      actions.push_back(action.get());
+    }
+
+    if (response.has_type()) {
+      responses.add_responses()->CopyFrom(response);
+    } else {
+      complete = false;
+    }
+  }
+
+  if (!actions.empty() && !persist(actions)) {
+    return;
+  }
+
+  if (complete) {
+    reply(responses);
+  }
+}
+
+
+Result<Action> ReplicaProcess::decide(
+    const WriteRequest& request,
+    WriteResponse* response)
+{
   Result<Action> result = read(request.position());
 
   if (result.isError()) {
-    LOG(ERROR) << "Error getting log record at " << request.position()
-               << ": " << result.error();
+    return Error(
+        "Error getting log record at " + stringify(request.position()) +
+        ": " + result.error());
   } else if (result.isNone()) {
     if (request.proposal() < promised()) {
-      WriteResponse response;
-      response.set_type(WriteResponse::REJECT);
-      response.set_okay(false);
-      response.set_proposal(promised());
-      response.set_position(request.position());
-      reply(response);
+      response->set_type(WriteResponse::REJECT);
+      response->set_okay(false);
+      response->set_proposal(promised());
+      response->set_position(request.position());
+      return None();
     } else {
       Action action;
       action.set_position(request.position());
@@ -578,26 +712,23 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
           LOG(FATAL) << "Unknown Action::Type!";
       }
 
-      if (persist(action)) {
-        WriteResponse response;
-        response.set_type(WriteResponse::ACCEPT);
-        response.set_okay(true);
-        response.set_proposal(request.proposal());
-        response.set_position(request.position());
-        reply(response);
-      }
+      response->set_type(WriteResponse::ACCEPT);
+      response->set_okay(true);
+      response->set_proposal(request.proposal());
+      response->set_position(request.position());
+      return action;
     }
-  } else if (result.isSome()) {
+  } else {
+    CHECK_SOME(result);
     Action action = result.get();
     CHECK_EQ(action.position(), request.position());
 
     if (request.proposal() < action.promised()) {
-      WriteResponse response;
-      response.set_type(WriteResponse::REJECT);
-      response.set_okay(false);
-      response.set_proposal(action.promised());
-      response.set_position(request.position());
-      reply(response);
+      response->set_type(WriteResponse::REJECT);
+      response->set_okay(false);
+      response->set_proposal(action.promised());
+      response->set_position(request.position());
+      return None();
     } else {
       if (action.has_learned() && action.learned()) {
         // We ignore the write request if this position has already
@@ -630,6 +761,7 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
         // R3 and R4 during the explicit promise phase. Therefore, it
         // will try to write an append operation at position 5 to R5
         // while R5 currently have a learned NOP stored at position 5.
+        return None();
       } else {
         action.set_performed(request.proposal());
         action.clear_learned();
@@ -657,14 +789,11 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
             LOG(FATAL) << "Unknown Action::Type!";
         }
 
-        if (persist(action)) {
-          WriteResponse response;
-          response.set_type(WriteResponse::ACCEPT);
-          response.set_okay(true);
-          response.set_proposal(request.proposal());
-          response.set_position(request.position());
-          reply(response);
-        }
+        response->set_type(WriteResponse::ACCEPT);
+        response->set_okay(true);
+        response->set_proposal(request.proposal());
+        response->set_position(request.position());
+        return action;
       }
     }
   }
@@ -699,6 +828,82 @@ void ReplicaProcess::learned(const UPID& from, const Action& action)
 }
 
 
+void ReplicaProcess::batchLearned(
+    const UPID& from,
+    const BatchLearnedMessage& message)
+{
+  if (message.actions().empty()) {
+    return;
+  }
+
+  LOG(INFO) << "Replica received learned notice for positions "
+            << message.actions(0).position() << " to "
+            << message.actions(message.actions().size() - 1).position()
+            << " from " << from;
+
+  vector<Action> actions;
+  foreach (const Action& action, message.actions()) {
+    CHECK(action.learned());
+    actions.push_back(action);
+  }
+
+  persist(actions);
+}
+
+
+void ReplicaProcess::fetch(const UPID& from, const FetchRequest& request)
+{
+  VLOG(1) << "Replica received a fetch request for positions "
+          << request.from() << " to " << request.to() << " from " << from;
+
+  FetchResponse response;
+  size_t size = 0;
+
+  // Truncated positions and positions past the end are skipped, like
+  // the positions that are not learned.
+  const uint64_t to = std::min(request.to(), end);
+
+  for (uint64_t position = std::max(request.from(), begin);
+       position <= to && size < MAX_FETCH_RESPONSE_SIZE;
+       position++) {
+    if (missing(position)) {
+      continue;
+    }
+
+    Result<Action> action = read(position);
+
+    if (action.isError()) {
+      LOG(ERROR) << "Failed to read position " << position
+                 << " for a fetch request: " << action.error();
+      break;
+    } else if (action.isNone()) {
+      continue;
+    }
+
+    CHECK(action->learned());
+
+    size += action->ByteSize();
+    response.add_actions()->CopyFrom(action.get());
+  }
+
+  reply(response);
+}
+
+
+bool ReplicaProcess::learn(const vector<Action>& actions)
+{
+  if (actions.empty()) {
+    return true;
+  }
+
+  foreach (const Action& action, actions) {
+    CHECK(action.learned());
+  }
+
+  return persist(actions);
+}
+
+
 bool ReplicaProcess::persist(const Action& action)
 {
   Try<Nothing> persisted = storage->persist(action);
@@ -711,6 +916,33 @@ bool ReplicaProcess::persist(const Action& action)
   VLOG(1) << "Persisted action " << action.type()
           << " at position " << action.position();
 
+  updatePositions(action);
+
+  return true;
+}
+
+
+bool ReplicaProcess::persist(const vector<Action>& actions)
+{
+  Try<Nothing> persisted = storage->persist(actions);
+
+  if (persisted.isError()) {
+    LOG(ERROR) << "Error writing to log: " << persisted.error();
+    return false;
+  }
+
+  VLOG(1) << "Persisted " << actions.size() << " actions";
+
+  foreach (const Action& action, actions) {
+    updatePositions(action);
+  }
+
+  return true;
+}
+
+
+void ReplicaProcess::updatePositions(const Action& action)
+{
   // No longer a hole here (if there even was one).
   holes -= action.position();
 
@@ -745,8 +977,6 @@ bool ReplicaProcess::persist(const Action& action)
 
   // And update the end position.
   end = std::max(end, action.position());
-
-  return true;
 }
 
 
@@ -847,6 +1077,12 @@ Future<bool> Replica::update(const Metadata::Status& status)
 }
 
 
+Future<bool> Replica::learn(const vector<Action>& actions) const
+{
+  return dispatch(process, &ReplicaProcess::learn, actions);
+}
+
+
 PID<ReplicaProcess> Replica::pid() const
 {
   return process->self();
@@ -21,6 +21,7 @@
 
 #include <list>
 #include <string>
+#include <vector>
 
 #include <process/future.hpp>
 #include <process/pid.hpp>
@@ -39,7 +40,9 @@ namespace protocol {
 // Some replica protocol declarations.
 extern Protocol<PromiseRequest, PromiseResponse> promise;
 extern Protocol<WriteRequest, WriteResponse> write;
+extern Protocol<BatchWriteRequest, BatchWriteResponse> batchWrite;
 extern Protocol<RecoverRequest, RecoverResponse> recover;
+extern Protocol<FetchRequest, FetchResponse> fetch;
 
 } // namespace protocol {
 
@@ -94,6 +97,11 @@ public:
   // mocking in tests.
   virtual process::Future<bool> update(const Metadata::Status& status);
 
+  // Persists the specified learned actions (e.g., fetched from other
+  // replicas during catch-up) at once. Returns true on success and
+  // false otherwise.
+  process::Future<bool> learn(const std::vector<Action>& actions) const;
+
   // Returns the PID associated with this replica.
   process::PID<ReplicaProcess> pid() const;
 
@@ -18,6 +18,10 @@
 
 #include <mesos/module/allocator.hpp>
 
+#include <stout/foreach.hpp>
+#include <stout/numify.hpp>
+#include <stout/strings.hpp>
+
 #include "master/constants.hpp"
 
 #include "master/allocator/mesos/hierarchical.hpp"
@@ -25,6 +29,7 @@
 #include "module/manager.hpp"
 
 using std::string;
+using std::vector;
 
 using mesos::internal::master::allocator::HierarchicalDRFAllocator;
 
@@ -44,5 +49,61 @@ Try<Allocator*> Allocator::create(const string& name)
   return modules::ModuleManager::create<Allocator>(name);
 }
 
+
+Try<Options::OfferPackingPolicy> Options::parseOfferPackingPolicy(
+    const string& value)
+{
+  if (value == "random") {
+    return OfferPackingPolicy::RANDOM;
+  } else if (value == "binpack") {
+    return OfferPackingPolicy::BINPACK;
+  } else if (value == "spread") {
+    return OfferPackingPolicy::SPREAD;
+  } else if (value == "attribute_weighted") {
+    return OfferPackingPolicy::ATTRIBUTE_WEIGHTED;
+  }
+
+  return Error(
+      "Unknown offer packing policy '" + value + "': Expected one of"
+      " 'random', 'binpack', 'spread' or 'attribute_weighted'");
+}
+
+
+Try<vector<Options::AttributeWeight>> Options::parseAttributeWeights(
+    const string& value)
+{
+  vector<AttributeWeight> weights;
+
+  foreach (const string& token, strings::tokenize(value, ",")) {
+    const size_t separator = token.rfind('=');
+
+    Try<double> weight = Error("Missing weight");
+    if (separator != string::npos && separator > 0) {
+      weight = numify<double>(token.substr(separator + 1));
+    }
+
+    if (weight.isError()) {
+      return Error(
+          "Invalid attribute weight '" + token + "': Expected"
+          " 'name=weight' or 'name:value=weight'");
+    }
+
+    const string key = token.substr(0, separator);
+    const size_t colon = key.find(':');
+
+    AttributeWeight attributeWeight;
+    attributeWeight.name = key.substr(0, colon);
+    attributeWeight.weight = weight.get();
+
+    if (colon != string::npos) {
+      attributeWeight.value = key.substr(colon + 1);
+    }
+
+    weights.push_back(attributeWeight);
+  }
+
+  return weights;
+}
+
 } // namespace allocator {
 } // namespace mesos {
@@ -0,0 +1,360 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "master/allocator/mesos/agent_order.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stout/check.hpp>
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
+#include <stout/unreachable.hpp>
+
+using std::pair;
+using std::string;
+using std::vector;
+
+using mesos::allocator::Options;
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+namespace internal {
+
+typedef Options::AttributeWeight AttributeWeight;
+typedef Options::OfferPackingPolicy OfferPackingPolicy;
+
+
+Try<AgentOrder*> AgentOrder::create(
+    OfferPackingPolicy policy,
+    const vector<AttributeWeight>& attributeWeights)
+{
+  switch (policy) {
+    case OfferPackingPolicy::RANDOM:
+      return new RandomAgentOrder();
+    case OfferPackingPolicy::BINPACK:
+      return new BinPackAgentOrder();
+    case OfferPackingPolicy::SPREAD:
+      return new SpreadAgentOrder();
+    case OfferPackingPolicy::ATTRIBUTE_WEIGHTED:
+      if (attributeWeights.empty()) {
+        return Error(
+            "The `attribute_weighted` offer packing policy requires"
+            " attribute weights");
+      }
+
+      return new AttributeWeightedAgentOrder(attributeWeights);
+  }
+
+  UNREACHABLE();
+}
+
+
+void RandomAgentOrder::order(vector<SlaveID>* slaveIds) const
+{
+  CHECK_NOTNULL(slaveIds);
+
+  std::random_shuffle(slaveIds->begin(), slaveIds->end());
+}
+
+
+bool IndexedAgentOrder::Compare::operator()(
+    const Entry& left,
+    const Entry& right) const
+{
+  if (left.score != right.score) {
+    return left.score > right.score;
+  }
+
+  return left.slaveId.value() < right.slaveId.value();
+}
+
+
+void IndexedAgentOrder::add(
+    const SlaveID& slaveId,
+    const SlaveInfo& slaveInfo,
+    const Resources& total,
+    const Resources& allocated)
+{
+  CHECK(!agents.contains(slaveId));
+
+  Agent& agent = agents[slaveId];
+  agent.attributes = slaveInfo.attributes();
+  agent.nonSharedTotal = total.nonShared().scalarQuantities();
+  agent.nonSharedAllocated = allocated.nonShared().scalarQuantities();
+  agent.score = evaluate(agent);
+
+  index.insert(Entry{agent.score, slaveId});
+}
+
+
+void IndexedAgentOrder::remove(const SlaveID& slaveId)
+{
+  CHECK(agents.contains(slaveId));
+
+  CHECK_EQ(1u, index.erase(Entry{agents.at(slaveId).score, slaveId}));
+  agents.erase(slaveId);
+}
+
+
+void IndexedAgentOrder::update(const SlaveID& slaveId, const Resources& total)
+{
+  CHECK(agents.contains(slaveId));
+
+  Agent& agent = agents.at(slaveId);
+  agent.nonSharedTotal = total.nonShared().scalarQuantities();
+
+  reindex(slaveId, &agent);
+}
+
+
+void IndexedAgentOrder::allocated(
+    const SlaveID& slaveId,
+    const Resources& resources)
+{
+  CHECK(agents.contains(slaveId));
+
+  Agent& agent = agents.at(slaveId);
+
+  foreachpair (const string& name,
+               const Value::Scalar& quantity,
+               resources.nonShared().scalarQuantities()) {
+    agent.nonSharedAllocated[name] += quantity;
+  }
+
+  reindex(slaveId, &agent);
+}
+
+
+void IndexedAgentOrder::unallocated(
+    const SlaveID& slaveId,
+    const Resources& resources)
+{
+  CHECK(agents.contains(slaveId));
+
+  Agent& agent = agents.at(slaveId);
+
+  foreachpair (const string& name,
+               const Value::Scalar& quantity,
+               resources.nonShared().scalarQuantities()) {
+    agent.nonSharedAllocated[name] -= quantity;
+  }
+
+  reindex(slaveId, &agent);
+}
+
+
+void IndexedAgentOrder::reindex(const SlaveID& slaveId, Agent* agent)
+{
+  Score score = evaluate(*agent);
+
+  if (score == agent->score) {
+    return;
+  }
+
+  CHECK_EQ(1u, index.erase(Entry{agent->score, slaveId}));
+
+  agent->score = std::move(score);
+  index.insert(Entry{agent->score, slaveId});
+}
+
+
+IndexedAgentOrder::Score IndexedAgentOrder::evaluate(const Agent& agent) const
+{
+  // The available quantity of a resource is the part of its total that
+  // is not allocated. An over-allocated resource is not available.
+  Quantities available;
+  foreachpair (const string& name,
+               const Value::Scalar& total,
+               agent.nonSharedTotal) {
+    auto allocation = agent.nonSharedAllocated.find(name);
+
+    if (allocation == agent.nonSharedAllocated.end()) {
+      available[name] = total;
+    } else if (!(total <= allocation->second)) {
+      available[name] = total - allocation->second;
+    }
+  }
+
+  return score(agent.attributes, agent.nonSharedTotal, available);
+}
+
+
+void IndexedAgentOrder::order(vector<SlaveID>* slaveIds) const
+{
+  CHECK_NOTNULL(slaveIds);
+
+  const size_t count = slaveIds->size();
+
+  // Reading the candidates off the index visits every known agent. If
+  // only a few agents are candidates (e.g., after a single agent was
+  // added), sorting them by their indexed scores is cheaper.
+  if (count * std::log2(count + 1) < index.size()) {
+    std::sort(
+        slaveIds->begin(),
+        slaveIds->end(),
+        [this](const SlaveID& left, const SlaveID& right) {
+          const Score& leftScore = agents.at(left).score;
+          const Score& rightScore = agents.at(right).score;
+
+          if (leftScore != rightScore) {
+            return leftScore > rightScore;
+          }
+
+          return left.value() < right.value();
+        });
+
+    return;
+  }
+
+  hashset<SlaveID> candidates;
+  foreach (const SlaveID& slaveId, *slaveIds) {
+    CHECK(agents.contains(slaveId));
+    candidates.insert(slaveId);
+  }
+
+  slaveIds->clear();
+
+  foreach (const Entry& entry, index) {
+    if (candidates.contains(entry.slaveId)) {
+      slaveIds->push_back(entry.slaveId);
+    }
+  }
+
+  CHECK_EQ(count, slaveIds->size());
+}
+
+
+double IndexedAgentOrder::utilization(
+    const Quantities& total,
+    const Quantities& available)
+{
+  double result = 0.0;
+
+  foreachpair (const string& name, const Value::Scalar& quantity, total) {
+    const double value = quantity.value();
+
+    if (value <= 0.0) {
+      continue;
+    }
+
+    auto free = available.find(name);
+
+    result = std::max(
+        result,
+        1.0 - (free != available.end() ? free->second.value() : 0.0) / value);
+  }
+
+  return result;
+}
+
+
+IndexedAgentOrder::Score IndexedAgentOrder::free(const Quantities& available)
+{
+  auto get = [&available](const string& name) {
+    auto quantity = available.find(name);
+    return quantity != available.end() ? quantity->second.value() : 0.0;
+  };
+
+  // Like `Resources::mem()` and `Resources::disk()`, this only counts
+  // whole megabytes.
+  return {
+    get("cpus"),
+    std::floor(get("mem")),
+    std::floor(get("disk")),
+    get("gpus")
+  };
+}
+
+
+IndexedAgentOrder::Score BinPackAgentOrder::score(
+    const Attributes& attributes,
+    const Quantities& total,
+    const Quantities& available) const
+{
+  // Among equally utilized agents, larger agents come first.
+  Score score = free(available);
+  score.insert(score.begin(), utilization(total, available));
+
+  return score;
+}
+
+
+IndexedAgentOrder::Score SpreadAgentOrder::score(
+    const Attributes& attributes,
+    const Quantities& total,
+    const Quantities& available) const
+{
+  // Among equally utilized agents, larger agents come first.
+  Score score = free(available);
+  score.insert(score.begin(), -utilization(total, available));
+
+  return score;
+}
+
+
+AttributeWeightedAgentOrder::AttributeWeightedAgentOrder(
+    const vector<AttributeWeight>& weights)
+{
+  foreach (const AttributeWeight& weight, weights) {
+    if (weight.value.isNone()) {
+      nameWeights[weight.name] += weight.weight;
+    } else {
+      valueWeights.push_back(std::make_pair(
+          Attributes::parse(weight.name, weight.value.get()),
+          weight.weight));
+    }
+  }
+}
+
+
+IndexedAgentOrder::Score AttributeWeightedAgentOrder::score(
+    const Attributes& attributes,
+    const Quantities& total,
+    const Quantities& available) const
+{
+  double weight = 0.0;
+
+  foreach (const Attribute& attribute, attributes) {
+    if (nameWeights.contains(attribute.name())) {
+      weight += nameWeights.at(attribute.name());
+    }
+  }
+
+  foreach (const auto& valueWeight, valueWeights) {
+    if (attributes.contains(valueWeight.first)) {
+      weight += valueWeight.second;
+    }
+  }
+
+  Score score = free(available);
+  score.insert(score.begin(), utilization(total, available));
+  score.insert(score.begin(), weight);
+
+  return score;
+}
+
+} // namespace internal {
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,262 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_ALLOCATOR_MESOS_AGENT_ORDER_HPP__
+#define __MASTER_ALLOCATOR_MESOS_AGENT_ORDER_HPP__
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <mesos/attributes.hpp>
+#include <mesos/mesos.hpp>
+#include <mesos/resources.hpp>
+
+#include <mesos/allocator/allocator.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+namespace internal {
+
+// Determines the order in which the hierarchical allocator considers
+// agents in an allocation run, see `--offer_packing_policy`.
+//
+// The allocator informs the order about every change of the total or
+// allocated resources of an agent, which allows implementations to
+// maintain the order incrementally rather than to sort all candidate
+// agents in every allocation run.
+//
+// NOTE: The `SlaveInfo` of an agent is only passed to `add()`. The
+// master never changes the `SlaveInfo` of a registered agent: an agent
+// that registers again with a different `SlaveInfo` (e.g., after a
+// master failover) is removed and added again.
+class AgentOrder
+{
+public:
+  // Creates the order for the given packing policy. The attribute
+  // weights are only used by the `ATTRIBUTE_WEIGHTED` policy.
+  static Try<AgentOrder*> create(
+      mesos::allocator::Options::OfferPackingPolicy policy,
+      const std::vector<mesos::allocator::Options::AttributeWeight>&
+        attributeWeights = {});
+
+  virtual ~AgentOrder() {}
+
+  virtual void add(
+      const SlaveID& slaveId,
+      const SlaveInfo& slaveInfo,
+      const Resources& total,
+      const Resources& allocated) = 0;
+
+  virtual void remove(const SlaveID& slaveId) = 0;
+
+  // Updates the total resources of the agent.
+  virtual void update(const SlaveID& slaveId, const Resources& total) = 0;
+
+  // Informs the order about resources of the agent that have been
+  // allocated or unallocated, i.e., the delta of the allocation rather
+  // than the allocated resources of the agent.
+  virtual void allocated(
+      const SlaveID& slaveId,
+      const Resources& resources) = 0;
+
+  virtual void unallocated(
+      const SlaveID& slaveId,
+      const Resources& resources) = 0;
+
+  // Reorders the given agents, all of which must have been added.
+  virtual void order(std::vector<SlaveID>* slaveIds) const = 0;
+};
+
+
+// Shuffles the agents randomly in every allocation run.
+class RandomAgentOrder : public AgentOrder
+{
+public:
+  virtual void add(
+      const SlaveID& slaveId,
+      const SlaveInfo& slaveInfo,
+      const Resources& total,
+      const Resources& allocated) {}
+
+  virtual void remove(const SlaveID& slaveId) {}
+
+  virtual void update(const SlaveID& slaveId, const Resources& total) {}
+
+  virtual void allocated(
+      const SlaveID& slaveId,
+      const Resources& resources) {}
+
+  virtual void unallocated(
+      const SlaveID& slaveId,
+      const Resources& resources) {}
+
+  virtual void order(std::vector<SlaveID>* slaveIds) const;
+};
+
+
+// Orders agents by decreasing score. The agents are kept in an index
+// that is sorted by score and updated whenever an agent changes, so
+// the order of the candidates of an allocation run can be read off
+// the index. Agents with equal scores are ordered by their IDs.
+//
+// Only the scalar quantities of the resources of an agent are kept,
+// and allocations are applied to them as deltas, so that an update
+// does not need to look at all the allocated resources of the agent.
+class IndexedAgentOrder : public AgentOrder
+{
+public:
+  // Scores are compared lexicographically.
+  typedef std::vector<double> Score;
+
+  // The quantity of each scalar resource, keyed by resource name.
+  typedef std::map<std::string, Value::Scalar> Quantities;
+
+  virtual void add(
+      const SlaveID& slaveId,
+      const SlaveInfo& slaveInfo,
+      const Resources& total,
+      const Resources& allocated);
+
+  virtual void remove(const SlaveID& slaveId);
+
+  virtual void update(const SlaveID& slaveId, const Resources& total);
+
+  virtual void allocated(
+      const SlaveID& slaveId,
+      const Resources& resources);
+
+  virtual void unallocated(
+      const SlaveID& slaveId,
+      const Resources& resources);
+
+  virtual void order(std::vector<SlaveID>* slaveIds) const;
+
+protected:
+  // Returns the score of an agent given its attributes and the scalar
+  // quantities of its total and available resources that are not
+  // shared.
+  virtual Score score(
+      const Attributes& attributes,
+      const Quantities& total,
+      const Quantities& available) const = 0;
+
+  // Returns the largest fraction of any scalar resource of the agent
+  // that is allocated.
+  static double utilization(
+      const Quantities& total,
+      const Quantities& available);
+
+  // Returns the amounts of available cpus, mem, disk and gpus.
+  static Score free(const Quantities& available);
+
+private:
+  struct Entry
+  {
+    Score score;
+    SlaveID slaveId;
+  };
+
+  struct Compare
+  {
+    bool operator()(const Entry& left, const Entry& right) const;
+  };
+
+  struct Agent
+  {
+    Attributes attributes;
+
+    // The quantities of the total and allocated resources that are not
+    // shared. Shared resources are neither counted as available, as in
+    // the allocator's `Slave::available()`, nor as utilized, since an
+    // agent could otherwise look fully utilized just because its disk
+    // is a shared persistent volume.
+    Quantities nonSharedTotal;
+    Quantities nonSharedAllocated;
+
+    Score score;
+  };
+
+  Score evaluate(const Agent& agent) const;
+
+  // Recomputes the score of an indexed agent and moves it in the index.
+  void reindex(const SlaveID& slaveId, Agent* agent);
+
+  hashmap<SlaveID, Agent> agents;
+  std::set<Entry, Compare> index;
+};
+
+
+// Offers the most utilized agents first, so that frameworks fill up
+// partially used agents and other agents stay free for large tasks.
+class BinPackAgentOrder : public IndexedAgentOrder
+{
+protected:
+  virtual Score score(
+      const Attributes& attributes,
+      const Quantities& total,
+      const Quantities& available) const;
+};
+
+
+// Offers the least utilized agents first, so that load is spread
+// across the cluster.
+class SpreadAgentOrder : public IndexedAgentOrder
+{
+protected:
+  virtual Score score(
+      const Attributes& attributes,
+      const Quantities& total,
+      const Quantities& available) const;
+};
+
+
+// Offers agents with the highest sum of attribute weights first and
+// bin packs agents with equal weights. A weight applies to all agents
+// with an attribute of the given name, or, if a value is given as in
+// `name:value`, only to those where the attribute has that value.
+class AttributeWeightedAgentOrder : public IndexedAgentOrder
+{
+public:
+  explicit AttributeWeightedAgentOrder(
+      const std::vector<mesos::allocator::Options::AttributeWeight>& weights);
+
+protected:
+  virtual Score score(
+      const Attributes& attributes,
+      const Quantities& total,
+      const Quantities& available) const;
+
+private:
+  hashmap<std::string, double> nameWeights;
+  std::vector<std::pair<Attribute, double>> valueWeights;
+};
+
+} // namespace internal {
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_ALLOCATOR_MESOS_AGENT_ORDER_HPP__
@@ -46,6 +46,17 @@ public:
 
   ~MesosAllocator();
 
+  void initialize(
+      const mesos::allocator::Options& options,
+      const lambda::function<
+          void(const FrameworkID&,
+               const hashmap<std::string, hashmap<SlaveID, Resources>>&)>&
+                   offerCallback,
+      const lambda::function<
+          void(const FrameworkID&,
+               const hashmap<SlaveID, UnavailableResources>&)>&
+        inverseOfferCallback);
+
   void initialize(
       const Duration& allocationInterval,
       const lambda::function<
@@ -187,7 +198,7 @@ public:
   using process::ProcessBase::initialize;
 
   virtual void initialize(
-      const Duration& allocationInterval,
+      const mesos::allocator::Options& options,
       const lambda::function<
           void(const FrameworkID&,
                const hashmap<std::string, hashmap<SlaveID, Resources>>&)>&
@@ -195,11 +206,7 @@ public:
       const lambda::function<
           void(const FrameworkID&,
                const hashmap<SlaveID, UnavailableResources>&)>&
-        inverseOfferCallback,
-      const Option<std::set<std::string>>&
-        fairnessExcludeResourceNames = None(),
-      bool filterGpuResources = true,
-      const Option<DomainInfo>& domain = None()) = 0;
+        inverseOfferCallback) = 0;
 
   virtual void recover(
       const int expectedAgentCount,
@@ -337,7 +344,7 @@ MesosAllocator<AllocatorProcess>::~MesosAllocator()
 
 template <typename AllocatorProcess>
 inline void MesosAllocator<AllocatorProcess>::initialize(
-    const Duration& allocationInterval,
+    const mesos::allocator::Options& options,
     const lambda::function<
         void(const FrameworkID&,
              const hashmap<std::string, hashmap<SlaveID, Resources>>&)>&
@@ -345,20 +352,39 @@ inline void MesosAllocator<AllocatorProcess>::initialize(
     const lambda::function<
         void(const FrameworkID&,
               const hashmap<SlaveID, UnavailableResources>&)>&
-      inverseOfferCallback,
-    const Option<std::set<std::string>>& fairnessExcludeResourceNames,
-    bool filterGpuResources,
-    const Option<DomainInfo>& domain)
+      inverseOfferCallback)
 {
   process::dispatch(
       process,
       &MesosAllocatorProcess::initialize,
-      allocationInterval,
+      options,
       offerCallback,
+      inverseOfferCallback);
+}
+
+
+template <typename AllocatorProcess>
+inline void MesosAllocator<AllocatorProcess>::initialize(
+    const Duration& allocationInterval,
+    const lambda::function<
+        void(const FrameworkID&,
+             const hashmap<std::string, hashmap<SlaveID, Resources>>&)>&
+                 offerCallback,
+    const lambda::function<
+        void(const FrameworkID&,
+              const hashmap<SlaveID, UnavailableResources>&)>&
       inverseOfferCallback,
-      fairnessExcludeResourceNames,
-      filterGpuResources,
-      domain);
+    const Option<std::set<std::string>>& fairnessExcludeResourceNames,
+    bool filterGpuResources,
+    const Option<DomainInfo>& domain)
+{
+  mesos::allocator::Options options;
+  options.allocationInterval = allocationInterval;
+  options.fairnessExcludeResourceNames = fairnessExcludeResourceNames;
+  options.filterGpuResources = filterGpuResources;
+  options.domain = domain;
+
+  initialize(options, offerCallback, inverseOfferCallback);
 }
 
 
@@ -26,15 +26,20 @@
 #include <mesos/type_utils.hpp>
 
 #include <process/after.hpp>
+#include <process/clock.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/event.hpp>
+#include <process/help.hpp>
+#include <process/http.hpp>
 #include <process/id.hpp>
 #include <process/loop.hpp>
 #include <process/timeout.hpp>
 
 #include <stout/check.hpp>
 #include <stout/hashset.hpp>
+#include <stout/json.hpp>
+#include <stout/numify.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 
@@ -47,14 +52,23 @@ using std::vector;
 using mesos::allocator::InverseOfferStatus;
 
 using process::after;
+using process::Clock;
 using process::Continue;
 using process::ControlFlow;
+using process::DESCRIPTION;
 using process::Failure;
 using process::Future;
+using process::HELP;
 using process::loop;
 using process::Owned;
 using process::PID;
 using process::Timeout;
+using process::TLDR;
+
+using process::http::OK;
+using process::http::Response;
+
+using process::http::authentication::Principal;
 
 using mesos::internal::protobuf::framework::Capabilities;
 
@@ -139,8 +153,18 @@ HierarchicalAllocatorProcess::Framework::Framework(
     capabilities(frameworkInfo.capabilities()) {}
 
 
+void HierarchicalAllocatorProcess::initialize()
+{
+  route(
+      "/debug",
+      READONLY_HTTP_AUTHENTICATION_REALM,
+      debugHelp(),
+      lambda::bind(&Self::debug, this, lambda::_1, lambda::_2));
+}
+
+
 void HierarchicalAllocatorProcess::initialize(
-    const Duration& _allocationInterval,
+    const mesos::allocator::Options& options,
     const lambda::function<
         void(const FrameworkID&,
              const hashmap<string, hashmap<SlaveID, Resources>>&)>&
@@ -148,18 +172,26 @@ void HierarchicalAllocatorProcess::initialize(
     const lambda::function<
         void(const FrameworkID&,
              const hashmap<SlaveID, UnavailableResources>&)>&
-      _inverseOfferCallback,
-    const Option<set<string>>& _fairnessExcludeResourceNames,
-    bool _filterGpuResources,
-    const Option<DomainInfo>& _domain)
+      _inverseOfferCallback)
 {
-  allocationInterval = _allocationInterval;
+  allocationInterval = options.allocationInterval;
   offerCallback = _offerCallback;
   inverseOfferCallback = _inverseOfferCallback;
-  fairnessExcludeResourceNames = _fairnessExcludeResourceNames;
-  filterGpuResources = _filterGpuResources;
-  domain = _domain;
+  fairnessExcludeResourceNames = options.fairnessExcludeResourceNames;
+  filterGpuResources = options.filterGpuResources;
+  domain = options.domain;
+  maxOffersPerFramework = options.maxOffersPerFramework;
   initialized = true;
+
+  Try<AgentOrder*> order = AgentOrder::create(
+      options.offerPackingPolicy,
+      options.offerPackingAttributeWeights);
+
+  // NOTE: The master refuses to start with an offer packing policy
+  // that is missing its attribute weights.
+  CHECK_SOME(order);
+
+  agentOrder.reset(order.get());
   paused = false;
 
   // Resources for quota'ed roles are allocated separately and prior to
@@ -172,6 +204,7 @@ void HierarchicalAllocatorProcess::initialize(
 
   // Start a loop to run allocation periodically.
   PID<HierarchicalAllocatorProcess> _self = self();
+  Duration _allocationInterval = allocationInterval;
 
   loop(
       None(), // Use `None` so we iterate outside the allocator process.
@@ -296,6 +329,7 @@ void HierarchicalAllocatorProcess::addFramework(
         // See comment at `quotaRoleSorter` declaration
         // regarding non-revocable.
         quotaRoleSorter->allocated(role, slaveId, allocation.nonRevocable());
+        updateUnallocatedQuota(role);
       }
     }
   }
@@ -340,6 +374,7 @@ void HierarchicalAllocatorProcess::removeFramework(
         // See comment at `quotaRoleSorter` declaration
         // regarding non-revocable.
         quotaRoleSorter->unallocated(role, slaveId, allocated.nonRevocable());
+        updateUnallocatedQuota(role);
       }
     }
 
@@ -548,6 +583,7 @@ void HierarchicalAllocatorProcess::addSlave(
       if (quotas.contains(role)) {
         // See comment at `quotaRoleSorter` declaration regarding non-revocable.
         quotaRoleSorter->allocated(role, slaveId, allocated.nonRevocable());
+        updateUnallocatedQuota(role);
       }
     }
   }
@@ -566,6 +602,8 @@ void HierarchicalAllocatorProcess::addSlave(
     slave.domain = slaveInfo.domain();
   }
 
+  agentOrder->add(slaveId, slaveInfo, slave.total, slave.allocated);
+
   // NOTE: We currently implement maintenance in the allocator to be able to
   // leverage state and features such as the FrameworkSorter and OfferFilter.
   if (unavailability.isSome()) {
@@ -617,6 +655,7 @@ void HierarchicalAllocatorProcess::removeSlave(
 
   slaves.erase(slaveId);
   allocationCandidates.erase(slaveId);
+  agentOrder->remove(slaveId);
 
   // Note that we DO NOT actually delete any filters associated with
   // this slave, that will occur when the delayed
@@ -829,6 +868,9 @@ void HierarchicalAllocatorProcess::updateAllocation(
   slave.allocated -= offeredResources;
   slave.allocated += updatedOfferedResources;
 
+  agentOrder->unallocated(slaveId, offeredResources);
+  agentOrder->allocated(slaveId, updatedOfferedResources);
+
   // Update the allocation in the framework sorter.
   frameworkSorter->update(
       frameworkId.value(),
@@ -852,6 +894,8 @@ void HierarchicalAllocatorProcess::updateAllocation(
         slaveId,
         offeredResources.nonRevocable(),
         updatedOfferedResources.nonRevocable());
+
+    updateUnallocatedQuota(role);
   }
 
   // Update the agent total resources so they are consistent with the updated
@@ -1138,6 +1182,8 @@ void HierarchicalAllocatorProcess::recoverResources(
         // regarding non-revocable
         quotaRoleSorter->unallocated(
             role, slaveId, resources.nonRevocable());
+
+        updateUnallocatedQuota(role);
       }
 
       // Stop tracking the framework under this role if it's no longer
@@ -1160,6 +1206,8 @@ void HierarchicalAllocatorProcess::recoverResources(
 
     slave.allocated -= resources;
 
+    agentOrder->unallocated(slaveId, resources);
+
     VLOG(1) << "Recovered " << resources
             << " (total: " << slave.total
             << ", allocated: " << slave.allocated << ")"
@@ -1342,6 +1390,8 @@ void HierarchicalAllocatorProcess::setQuota(
     }
   }
 
+  updateUnallocatedQuota(role);
+
   metrics.setQuota(role, quota);
 
   // TODO(alexr): Print all quota info for the role.
@@ -1374,6 +1424,11 @@ void HierarchicalAllocatorProcess::removeQuota(
   quotas.erase(role);
   quotaRoleSorter->remove(role);
 
+  CHECK(unallocatedQuota.contains(role));
+  CHECK(unallocatedQuotaResources.contains(unallocatedQuota.at(role)));
+  unallocatedQuotaResources -= unallocatedQuota.at(role);
+  unallocatedQuota.erase(role);
+
   metrics.removeQuota(role);
 
   // NOTE: Since quota changes do not result in rebalancing of
@@ -1472,21 +1527,37 @@ Nothing HierarchicalAllocatorProcess::_allocate()
 
   ++metrics.allocation_runs;
 
+  AllocationCycle cycle;
+  cycle.timestamp = Clock::now();
+  cycle.candidateAgents = allocationCandidates.size();
+  cycle.roles = roles.size();
+  cycle.frameworks = frameworks.size();
+
   Stopwatch stopwatch;
   stopwatch.start();
   metrics.allocation_run.start();
 
-  __allocate();
+  __allocate(&cycle);
 
   // NOTE: For now, we implement maintenance inverse offers within the
   // allocator. We leverage the existing timer/cycle of offers to also do any
   // "deallocation" (inverse offers) necessary to satisfy maintenance needs.
+  Stopwatch deallocation;
+  deallocation.start();
+
   deallocate();
 
+  cycle.deallocation = deallocation.elapsed();
+
   metrics.allocation_run.stop();
 
+  cycle.duration = stopwatch.elapsed();
+
+  metrics.recordAllocationCycle(cycle);
+  recentAllocationCycles.push_back(cycle);
+
   VLOG(1) << "Performed allocation for " << allocationCandidates.size()
-          << " agents in " << stopwatch.elapsed();
+          << " agents in " << cycle.duration;
 
   // Clear the candidates on completion of the allocation run.
   allocationCandidates.clear();
@@ -1496,7 +1567,7 @@ Nothing HierarchicalAllocatorProcess::_allocate()
 
 
 // TODO(alexr): Consider factoring out the quota allocation logic.
-void HierarchicalAllocatorProcess::__allocate()
+void HierarchicalAllocatorProcess::__allocate(AllocationCycle* cycle)
 {
   // Compute the offerable resources, per framework:
   //   (1) For reserved resources on the slave, allocate these to a
@@ -1522,10 +1593,30 @@ void HierarchicalAllocatorProcess::__allocate()
     }
   }
 
-  // Randomize the order in which slaves' resources are allocated.
-  //
-  // TODO(vinod): Implement a smarter sorting algorithm.
-  std::random_shuffle(slaveIds.begin(), slaveIds.end());
+  cycle->eligibleAgents = slaveIds.size();
+
+  // Determine the order in which slaves' resources are allocated.
+  agentOrder->order(&slaveIds);
+
+  // The agents each framework has been offered resources on in this
+  // cycle, used to bound the number of offers per framework.
+  hashmap<FrameworkID, hashset<SlaveID>> offeredSlaves;
+
+  // Returns true if the framework cannot be offered resources on one
+  // more agent in this cycle because of `maxOffersPerFramework`.
+  auto offerLimitReached = [this, &offeredSlaves](
+      const FrameworkID& frameworkId,
+      const SlaveID& slaveId) {
+    if (maxOffersPerFramework.isNone() ||
+        !offeredSlaves.contains(frameworkId)) {
+      return false;
+    }
+
+    const hashset<SlaveID>& offered = offeredSlaves.at(frameworkId);
+
+    return !offered.contains(slaveId) &&
+           offered.size() >= maxOffersPerFramework.get();
+  };
 
   // Returns the __quantity__ of resources allocated to a quota role. Since we
   // account for reservations and persistent volumes toward quota, we strip
@@ -1555,6 +1646,9 @@ void HierarchicalAllocatorProcess::__allocate()
   // allocated in the current cycle.
   hashmap<SlaveID, Resources> offeredSharedResources;
 
+  Stopwatch stage;
+  stage.start();
+
   // Quota comes first and fair share second. Here we process only those
   // roles for which quota is set (quota'ed roles). Such roles form a
   // special allocation group with a dedicated sorter.
@@ -1631,6 +1725,13 @@ void HierarchicalAllocatorProcess::__allocate()
           continue;
         }
 
+        // Offer resources on at most `maxOffersPerFramework` agents
+        // to each framework per cycle, leaving the other agents to
+        // the frameworks that follow.
+        if (offerLimitReached(frameworkId, slaveId)) {
+          continue;
+        }
+
         // Calculate the currently available resources on the slave, which
         // is the difference in non-shared resources between total and
         // allocated, plus all shared resources on the agent (if applicable).
@@ -1707,9 +1808,13 @@ void HierarchicalAllocatorProcess::__allocate()
         // quota. This is fine since quota currently represents a guarantee.
         offerable[frameworkId][role][slaveId] += resources;
         offeredSharedResources[slaveId] += resources.shared();
+        offeredSlaves[frameworkId].insert(slaveId);
+        ++cycle->allocations;
 
         slave.allocated += resources;
 
+        agentOrder->allocated(slaveId, resources);
+
         // Resources allocated as part of the quota count towards the
         // role's and the framework's fair share.
         //
@@ -1718,10 +1823,14 @@ void HierarchicalAllocatorProcess::__allocate()
         frameworkSorter->allocated(frameworkId_, slaveId, resources);
         roleSorter->allocated(role, slaveId, resources);
         quotaRoleSorter->allocated(role, slaveId, resources);
+        updateUnallocatedQuota(role);
       }
     }
   }
 
+  cycle->quotaStage = stage.elapsed();
+  stage.start();
+
   // Calculate the total quantity of scalar resources (including revocable
   // and reserved) that are available for allocation in the next round. We
   // need this in order to ensure we do not over-allocate resources during
@@ -1734,23 +1843,18 @@ void HierarchicalAllocatorProcess::__allocate()
   // agents participating in the current allocation (i.e. provided as an
   // argument to the `allocate()` call) so that frameworks in roles without
   // quota are not unnecessarily deprived of resources.
-  Resources remainingClusterResources = roleSorter->totalScalarQuantities();
-  foreachkey (const string& role, roles) {
-    remainingClusterResources -= roleSorter->allocationScalarQuantities(role);
-  }
+  Resources remainingClusterResources =
+    roleSorter->totalScalarQuantities() -
+    roleSorter->allocationScalarQuantities();
 
   // Frameworks in a quota'ed role may temporarily reject resources by
   // filtering or suppressing offers. Hence quotas may not be fully allocated.
-  Resources unallocatedQuotaResources;
-  foreachpair (const string& name, const Quota& quota, quotas) {
-    // Compute the amount of quota that the role does not have allocated.
-    //
-    // NOTE: Revocable resources are excluded in `quotaRoleSorter`.
-    // NOTE: Only scalars are considered for quota.
-    Resources allocated = getQuotaRoleAllocatedResources(name);
-    const Resources required = quota.info.guarantee();
-    unallocatedQuotaResources += (required - allocated);
-  }
+  // The unallocated part of each quota is kept up to date as allocations
+  // change (see `updateUnallocatedQuota()`), which debug builds verify
+  // against a recomputation from the sorters.
+#ifndef NDEBUG
+  checkQuotaHeadroom();
+#endif // NDEBUG
 
   // Determine how many resources we may allocate during the next stage.
   //
@@ -1778,6 +1882,9 @@ void HierarchicalAllocatorProcess::__allocate()
   // (typically by using `Resources::createStrippedScalarQuantity`).
   Resources allocatedStage2;
 
+  cycle->headroom = stage.elapsed();
+  stage.start();
+
   // At this point resources for quotas are allocated or accounted for.
   // Proceed with allocating the remaining free pool.
   foreach (const SlaveID& slaveId, slaveIds) {
@@ -1816,6 +1923,13 @@ void HierarchicalAllocatorProcess::__allocate()
           continue;
         }
 
+        // Offer resources on at most `maxOffersPerFramework` agents
+        // to each framework per cycle, leaving the other agents to
+        // the frameworks that follow.
+        if (offerLimitReached(frameworkId, slaveId)) {
+          continue;
+        }
+
         // Calculate the currently available resources on the slave, which
         // is the difference in non-shared resources between total and
         // allocated, plus all shared resources on the agent (if applicable).
@@ -1924,10 +2038,14 @@ void HierarchicalAllocatorProcess::__allocate()
         // agent as part of quota.
         offerable[frameworkId][role][slaveId] += resources;
         offeredSharedResources[slaveId] += resources.shared();
+        offeredSlaves[frameworkId].insert(slaveId);
+        ++cycle->allocations;
         allocatedStage2 += scalarQuantity;
 
         slave.allocated += resources;
 
+        agentOrder->allocated(slaveId, resources);
+
         frameworkSorter->add(slaveId, resources);
         frameworkSorter->allocated(frameworkId_, slaveId, resources);
         roleSorter->allocated(role, slaveId, resources);
@@ -1936,18 +2054,26 @@ void HierarchicalAllocatorProcess::__allocate()
           // See comment at `quotaRoleSorter` declaration regarding
           // non-revocable.
           quotaRoleSorter->allocated(role, slaveId, resources.nonRevocable());
+          updateUnallocatedQuota(role);
         }
       }
     }
   }
 
+  cycle->fairShareStage = stage.elapsed();
+  cycle->offeredFrameworks = offerable.size();
+
   if (offerable.empty()) {
     VLOG(1) << "No allocations performed";
   } else {
+    stage.start();
+
     // Now offer the resources to each framework.
     foreachkey (const FrameworkID& frameworkId, offerable) {
       offerCallback(frameworkId, offerable.at(frameworkId));
     }
+
+    cycle->offerCallbacks = stage.elapsed();
   }
 }
 
@@ -2300,6 +2426,113 @@ double HierarchicalAllocatorProcess::_offer_filters_active(
 }
 
 
+Future<Response> HierarchicalAllocatorProcess::debug(
+    const process::http::Request& request,
+    const Option<Principal>&) const
+{
+  // The number of slowest cycles to return, defaults to 10.
+  Result<int> result = numify<int>(request.url.query.get("limit"));
+  size_t limit = result.isSome() && result.get() > 0 ? result.get() : 10;
+
+  vector<const AllocationCycle*> cycles;
+  cycles.reserve(recentAllocationCycles.size());
+
+  foreach (const AllocationCycle& cycle, recentAllocationCycles) {
+    cycles.push_back(&cycle);
+  }
+
+  limit = std::min(limit, cycles.size());
+
+  std::partial_sort(
+      cycles.begin(),
+      cycles.begin() + limit,
+      cycles.end(),
+      [](const AllocationCycle* left, const AllocationCycle* right) {
+        return left->duration > right->duration;
+      });
+
+  JSON::Array slowest;
+
+  foreach (const AllocationCycle* cycle, cycles) {
+    if (slowest.values.size() == limit) {
+      break;
+    }
+
+    JSON::Object object;
+    object.values["timestamp"] = cycle->timestamp.secs();
+    object.values["duration_ms"] = cycle->duration.ms();
+    object.values["quota_stage_ms"] = cycle->quotaStage.ms();
+    object.values["headroom_ms"] = cycle->headroom.ms();
+    object.values["fair_share_stage_ms"] = cycle->fairShareStage.ms();
+    object.values["deallocation_ms"] = cycle->deallocation.ms();
+    object.values["offer_callbacks_ms"] = cycle->offerCallbacks.ms();
+    object.values["candidate_agents"] = cycle->candidateAgents;
+    object.values["eligible_agents"] = cycle->eligibleAgents;
+    object.values["roles"] = cycle->roles;
+    object.values["frameworks"] = cycle->frameworks;
+    object.values["allocations"] = cycle->allocations;
+    object.values["offered_frameworks"] = cycle->offeredFrameworks;
+
+    slowest.values.push_back(object);
+  }
+
+  JSON::Object object;
+  object.values["recent_cycles"] = recentAllocationCycles.size();
+  object.values["slowest_cycles"] = slowest;
+
+  return OK(object, request.url.query.get("jsonp"));
+}
+
+
+string HierarchicalAllocatorProcess::debugHelp()
+{
+  return HELP(
+      TLDR(
+          "Returns the slowest of the recent allocation cycles."),
+      DESCRIPTION(
+          "Returns a breakdown of the slowest of the last " +
+            stringify(MAX_RECENT_ALLOCATION_CYCLES) + " allocation",
+          "cycles, ordered by decreasing duration.",
+          "",
+          "For each cycle the time spent in the quota and the fair share",
+          "stages, in computing the headroom between the stages, in",
+          "deallocation (inverse offers) and in the offer callbacks is",
+          "reported, along with the number of candidate and eligible agents,",
+          "active roles and frameworks, allocations made and frameworks",
+          "offered resources.",
+          "",
+          "Query parameters:",
+          "",
+          ">        limit=VALUE          Maximum number of cycles returned "
+          "(default is 10).",
+          "",
+          "Example:",
+          "",
+          "```",
+          "{",
+          "  \"recent_cycles\": 100,",
+          "  \"slowest_cycles\": [",
+          "    {",
+          "      \"allocations\": 12,",
+          "      \"candidate_agents\": 1000,",
+          "      \"deallocation_ms\": 0.02,",
+          "      \"duration_ms\": 48.1,",
+          "      \"eligible_agents\": 998,",
+          "      \"fair_share_stage_ms\": 40.3,",
+          "      \"frameworks\": 15,",
+          "      \"headroom_ms\": 0.4,",
+          "      \"offer_callbacks_ms\": 0.7,",
+          "      \"offered_frameworks\": 12,",
+          "      \"quota_stage_ms\": 6.6,",
+          "      \"roles\": 4,",
+          "      \"timestamp\": 1508333130.51",
+          "    }",
+          "  ]",
+          "}",
+          "```"));
+}
+
+
 bool HierarchicalAllocatorProcess::isFrameworkTrackedUnderRole(
     const FrameworkID& frameworkId,
     const string& role) const
@@ -2389,6 +2622,8 @@ bool HierarchicalAllocatorProcess::updateSlaveTotal(
 
   slave.total = total;
 
+  agentOrder->update(slaveId, slave.total);
+
   // Currently `roleSorter` and `quotaRoleSorter`, being the root-level
   // sorters, maintain all of `slaves[slaveId].total` (or the `nonRevocable()`
   // portion in the case of `quotaRoleSorter`) in their own totals (which
@@ -2438,6 +2673,51 @@ bool HierarchicalAllocatorProcess::isRemoteSlave(const Slave& slave) const
   return masterRegion != slaveRegion;
 }
 
+
+void HierarchicalAllocatorProcess::updateUnallocatedQuota(const string& role)
+{
+  CHECK(quotas.contains(role));
+
+  if (unallocatedQuota.contains(role)) {
+    CHECK(unallocatedQuotaResources.contains(unallocatedQuota.at(role)));
+    unallocatedQuotaResources -= unallocatedQuota.at(role);
+  }
+
+  // NOTE: Revocable resources are excluded in `quotaRoleSorter`.
+  // NOTE: Only scalars are considered for quota.
+  const Resources unallocated =
+    quotas.at(role).info.guarantee() -
+    quotaRoleSorter->allocationScalarQuantities(role).toUnreserved();
+
+  unallocatedQuota[role] = unallocated;
+  unallocatedQuotaResources += unallocated;
+}
+
+
+void HierarchicalAllocatorProcess::checkQuotaHeadroom() const
+{
+  Resources allocated;
+  foreachkey (const string& role, roles) {
+    allocated += roleSorter->allocationScalarQuantities(role);
+  }
+
+  CHECK_EQ(allocated, roleSorter->allocationScalarQuantities());
+
+  Resources unallocated;
+  foreachpair (const string& role, const Quota& quota, quotas) {
+    const Resources required = quota.info.guarantee() -
+      quotaRoleSorter->allocationScalarQuantities(role).toUnreserved();
+
+    CHECK(unallocatedQuota.contains(role));
+    CHECK_EQ(required, unallocatedQuota.at(role)) << " for role " << role;
+
+    unallocated += required;
+  }
+
+  CHECK_EQ(unallocated, unallocatedQuotaResources);
+  CHECK_EQ(quotas.size(), unallocatedQuota.size());
+}
+
 } // namespace internal {
 } // namespace allocator {
 } // namespace master {
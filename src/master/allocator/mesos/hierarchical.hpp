@@ -19,10 +19,14 @@
 
 #include <set>
 #include <string>
+#include <vector>
+
+#include <boost/circular_buffer.hpp>
 
 #include <mesos/mesos.hpp>
 
 #include <process/future.hpp>
+#include <process/http.hpp>
 #include <process/id.hpp>
 #include <process/owned.hpp>
 
@@ -34,6 +38,7 @@
 
 #include "common/protobuf_utils.hpp"
 
+#include "master/allocator/mesos/agent_order.hpp"
 #include "master/allocator/mesos/allocator.hpp"
 #include "master/allocator/mesos/metrics.hpp"
 
@@ -80,6 +85,7 @@ public:
     : initialized(false),
       paused(true),
       metrics(*this),
+      recentAllocationCycles(MAX_RECENT_ALLOCATION_CYCLES),
       roleSorter(roleSorterFactory()),
       quotaRoleSorter(quotaRoleSorterFactory()),
       frameworkSorterFactory(_frameworkSorterFactory) {}
@@ -92,7 +98,7 @@ public:
   }
 
   void initialize(
-      const Duration& allocationInterval,
+      const mesos::allocator::Options& options,
       const lambda::function<
           void(const FrameworkID&,
                const hashmap<std::string, hashmap<SlaveID, Resources>>&)>&
@@ -100,11 +106,7 @@ public:
       const lambda::function<
           void(const FrameworkID&,
                const hashmap<SlaveID, UnavailableResources>&)>&
-        inverseOfferCallback,
-      const Option<std::set<std::string>>&
-        fairnessExcludeResourceNames = None(),
-      bool filterGpuResources = true,
-      const Option<DomainInfo>& domain = None());
+        inverseOfferCallback);
 
   void recover(
       const int _expectedAgentCount,
@@ -215,6 +217,8 @@ protected:
   typedef HierarchicalAllocatorProcess Self;
   typedef HierarchicalAllocatorProcess This;
 
+  virtual void initialize();
+
   // Idempotent helpers for pausing and resuming allocation.
   void pause();
   void resume();
@@ -232,8 +236,9 @@ protected:
   // Method that performs allocation work.
   Nothing _allocate();
 
-  // Helper for `_allocate()` that allocates resources for offers.
-  void __allocate();
+  // Helper for `_allocate()` that allocates resources for offers,
+  // accounting the time spent in each stage to the given cycle.
+  void __allocate(AllocationCycle* cycle);
 
   // Helper for `_allocate()` that deallocates resources for inverse offers.
   void deallocate();
@@ -297,6 +302,10 @@ protected:
   friend Metrics;
   Metrics metrics;
 
+  // The most recent allocation cycles, exposed for debugging the
+  // performance of the allocator.
+  boost::circular_buffer<AllocationCycle> recentAllocationCycles;
+
   struct Framework
   {
     explicit Framework(
@@ -442,6 +451,14 @@ protected:
   // change in the future.
   hashmap<std::string, Quota> quotas;
 
+  // The part of each role's quota guarantee that is not allocated to
+  // the role, and its sum across all quota'ed roles. These determine
+  // the headroom which the second allocation stage has to leave for
+  // quota'ed roles and are updated whenever the allocation of a
+  // quota'ed role changes, rather than once per allocation run.
+  hashmap<std::string, Resources> unallocatedQuota;
+  Resources unallocatedQuotaResources;
+
   // Slaves to send offers for.
   Option<hashset<std::string>> whitelist;
 
@@ -454,6 +471,15 @@ protected:
   // The master's domain, if any.
   Option<DomainInfo> domain;
 
+  // Determines the order in which agents are allocated from, according
+  // to the offer packing policy. It must be kept informed about every
+  // change of an agent's total or allocated resources.
+  process::Owned<AgentOrder> agentOrder;
+
+  // The maximum number of agents a framework is offered resources on
+  // in a single allocation cycle, if any.
+  Option<size_t> maxOffersPerFramework;
+
   // There are two stages of allocation. During the first stage resources
   // are allocated only to frameworks in roles with quota set. During the
   // second stage remaining resources that would not be required to satisfy
@@ -517,6 +543,13 @@ protected:
   const std::function<Sorter*()> frameworkSorterFactory;
 
 private:
+  // HTTP handlers.
+  // /hierarchical-allocator(N)/debug
+  process::Future<process::http::Response> debug(
+      const process::http::Request& request,
+      const Option<process::http::authentication::Principal>&) const;
+  static std::string debugHelp();
+
   bool isFrameworkTrackedUnderRole(
       const FrameworkID& frameworkId,
       const std::string& role) const;
@@ -538,6 +571,14 @@ private:
   // different region than the master. This can only be the case if
   // the agent and the master are both configured with a fault domain.
   bool isRemoteSlave(const Slave& slave) const;
+
+  // Recomputes the unallocated quota of the given quota'ed role after
+  // its allocation changed, see `unallocatedQuota`.
+  void updateUnallocatedQuota(const std::string& role);
+
+  // Checks that the incrementally maintained headroom aggregates match
+  // a full recomputation from the sorters.
+  void checkQuotaHeadroom() const;
 };
 
 
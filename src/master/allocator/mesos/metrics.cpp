@@ -49,13 +49,28 @@ Metrics::Metrics(const HierarchicalAllocatorProcess& _allocator)
             allocator, &HierarchicalAllocatorProcess::_event_queue_dispatches)),
     allocation_runs("allocator/mesos/allocation_runs"),
     allocation_run("allocator/mesos/allocation_run", Hours(1)),
-    allocation_run_latency("allocator/mesos/allocation_run_latency", Hours(1))
+    allocation_run_latency("allocator/mesos/allocation_run_latency", Hours(1)),
+    allocation_run_quota_stage(
+        "allocator/mesos/allocation_run/quota_stage", Hours(1)),
+    allocation_run_headroom(
+        "allocator/mesos/allocation_run/headroom", Hours(1)),
+    allocation_run_fair_share_stage(
+        "allocator/mesos/allocation_run/fair_share_stage", Hours(1)),
+    allocation_run_deallocation(
+        "allocator/mesos/allocation_run/deallocation", Hours(1)),
+    allocation_run_offer_callbacks(
+        "allocator/mesos/allocation_run/offer_callbacks", Hours(1))
 {
   process::metrics::add(event_queue_dispatches);
   process::metrics::add(event_queue_dispatches_);
   process::metrics::add(allocation_runs);
   process::metrics::add(allocation_run);
   process::metrics::add(allocation_run_latency);
+  process::metrics::add(allocation_run_quota_stage);
+  process::metrics::add(allocation_run_headroom);
+  process::metrics::add(allocation_run_fair_share_stage);
+  process::metrics::add(allocation_run_deallocation);
+  process::metrics::add(allocation_run_offer_callbacks);
 
   // Create and install gauges for the total and allocated
   // amount of standard scalar resources.
@@ -95,6 +110,11 @@ Metrics::~Metrics()
   process::metrics::remove(allocation_runs);
   process::metrics::remove(allocation_run);
   process::metrics::remove(allocation_run_latency);
+  process::metrics::remove(allocation_run_quota_stage);
+  process::metrics::remove(allocation_run_headroom);
+  process::metrics::remove(allocation_run_fair_share_stage);
+  process::metrics::remove(allocation_run_deallocation);
+  process::metrics::remove(allocation_run_offer_callbacks);
 
   foreach (const Gauge& gauge, resources_total) {
     process::metrics::remove(gauge);
@@ -201,6 +221,16 @@ void Metrics::removeRole(const string& role)
   process::metrics::remove(gauge.get());
 }
 
+
+void Metrics::recordAllocationCycle(const AllocationCycle& cycle)
+{
+  allocation_run_quota_stage.record(cycle.quotaStage);
+  allocation_run_headroom.record(cycle.headroom);
+  allocation_run_fair_share_stage.record(cycle.fairShareStage);
+  allocation_run_deallocation.record(cycle.deallocation);
+  allocation_run_offer_callbacks.record(cycle.offerCallbacks);
+}
+
 } // namespace internal {
 } // namespace allocator {
 } // namespace master {
@@ -27,7 +27,9 @@
 #include <process/metrics/timer.hpp>
 
 #include <process/pid.hpp>
+#include <process/time.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 
 namespace mesos {
@@ -39,6 +41,38 @@ namespace internal {
 // Forward declarations.
 class HierarchicalAllocatorProcess;
 
+
+// Breakdown of a single run of the allocation algorithm. The stage
+// durations cover the two allocation stages and the work between and
+// after them.
+struct AllocationCycle
+{
+  process::Time timestamp;
+  Duration duration;
+
+  Duration quotaStage;
+  Duration headroom;
+  Duration fairShareStage;
+  Duration deallocation;
+  Duration offerCallbacks;
+
+  // Number of agents that triggered the allocation run.
+  size_t candidateAgents = 0;
+
+  // Number of candidate agents that were eligible for allocation.
+  size_t eligibleAgents = 0;
+
+  // Number of active roles and frameworks at the time of the run.
+  size_t roles = 0;
+  size_t frameworks = 0;
+
+  // Number of (framework, role, agent) allocations that were made
+  // and the number of frameworks that received offers.
+  size_t allocations = 0;
+  size_t offeredFrameworks = 0;
+};
+
+
 // Collection of metrics for the allocator; these begin
 // with the following prefix: `allocator/mesos/`.
 struct Metrics
@@ -53,6 +87,8 @@ struct Metrics
   void addRole(const std::string& role);
   void removeRole(const std::string& role);
 
+  void recordAllocationCycle(const AllocationCycle& cycle);
+
   const process::PID<HierarchicalAllocatorProcess> allocator;
 
   // Number of dispatch events currently waiting in the allocator process.
@@ -72,6 +108,13 @@ struct Metrics
   // The latency of allocation runs due to the batching of allocation requests.
   process::metrics::Timer<Milliseconds> allocation_run_latency;
 
+  // Time spent in the individual stages of the allocation algorithm.
+  process::metrics::Timer<Milliseconds> allocation_run_quota_stage;
+  process::metrics::Timer<Milliseconds> allocation_run_headroom;
+  process::metrics::Timer<Milliseconds> allocation_run_fair_share_stage;
+  process::metrics::Timer<Milliseconds> allocation_run_deallocation;
+  process::metrics::Timer<Milliseconds> allocation_run_offer_callbacks;
+
   // Gauges for the total amount of each resource in the cluster.
   std::vector<process::metrics::Gauge> resources_total;
 
@@ -0,0 +1,1060 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A standalone harness that replays a recorded cluster trace against
+// the hierarchical allocator under a paused clock and reports
+// allocation latency, offer fairness and quota satisfaction.
+//
+// The trace is a file with one JSON object per line. Each object has
+// a "type", an optional "timestamp" (seconds since the start of the
+// trace, non-decreasing) and type specific fields:
+//
+//   {"type": "ADD_AGENT", "agent_info": <SlaveInfo>}
+//   {"type": "REMOVE_AGENT", "agent_id": "..."}
+//   {"type": "ADD_FRAMEWORK", "framework_info": <FrameworkInfo>}
+//   {"type": "REMOVE_FRAMEWORK", "framework_id": "..."}
+//   {"type": "ACCEPT", "framework_id": "...", "agent_id": "..."}
+//   {"type": "DECLINE", "framework_id": "...", "agent_id": "...",
+//    "refuse_seconds": 5}
+//   {"type": "RECOVER_RESOURCES", "framework_id": "...",
+//    "agent_id": "...", "resources": "cpus:1;mem:128"}
+//   {"type": "SUPPRESS", "framework_id": "...", "roles": ["..."]}
+//   {"type": "REVIVE", "framework_id": "...", "roles": ["..."]}
+//   {"type": "SET_QUOTA", "role": "...", "guarantee": "cpus:10"}
+//   {"type": "REMOVE_QUOTA", "role": "..."}
+//
+// `ACCEPT` and `DECLINE` act on the offers that are outstanding for
+// the framework (optionally restricted to one agent): an accepted
+// offer becomes used by the framework until it is released through
+// `RECOVER_RESOURCES`, a declined offer is recovered immediately,
+// optionally installing a filter. Resources in the trace may be
+// given either in the text or the JSON format of `Resources::parse`.
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+#include <mesos/resources.hpp>
+
+#include <mesos/allocator/allocator.hpp>
+
+#include <mesos/quota/quota.hpp>
+
+#include <process/clock.hpp>
+#include <process/process.hpp>
+#include <process/time.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/flags.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/option.hpp>
+#include <stout/path.hpp>
+#include <stout/protobuf.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+#include <stout/try.hpp>
+
+#include "logging/flags.hpp"
+#include "logging/logging.hpp"
+
+#include "master/constants.hpp"
+
+#include "master/allocator/mesos/hierarchical.hpp"
+
+#include "slave/constants.hpp"
+
+using namespace mesos;
+using namespace mesos::internal;
+
+using mesos::allocator::Allocator;
+
+using mesos::internal::master::allocator::HierarchicalDRFAllocator;
+
+using mesos::internal::slave::AGENT_CAPABILITIES;
+
+using process::Clock;
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::ifstream;
+using std::ofstream;
+using std::set;
+using std::string;
+using std::vector;
+
+
+class Flags : public virtual logging::Flags
+{
+public:
+  Flags()
+  {
+    add(&Flags::trace,
+        "trace",
+        "Path to the trace file to replay. Each line of the trace\n"
+        "is a JSON object describing one allocator event.");
+
+    add(&Flags::output,
+        "output",
+        "Path to an optional output file to which the duration,\n"
+        "offer count and fairness of every batch allocation\n"
+        "cycle are written.");
+
+    add(&Flags::allocation_interval,
+        "allocation_interval",
+        "Amount of simulated time between (batch) allocations.",
+        mesos::internal::master::DEFAULT_ALLOCATION_INTERVAL);
+
+    add(&Flags::fair_sharing_excluded_resource_names,
+        "fair_sharing_excluded_resource_names",
+        "A comma-separated list of the resource names (e.g. 'gpus')\n"
+        "that will be excluded from fair sharing constraints.");
+
+    add(&Flags::filter_gpu_resources,
+        "filter_gpu_resources",
+        "When set to true, only frameworks with the GPU_RESOURCES\n"
+        "capability are offered resources of agents with GPUs.",
+        true);
+
+    add(&Flags::offer_packing_policy,
+        "offer_packing_policy",
+        "The order in which agents are considered when making offers\n"
+        "(`random`, `binpack`, `spread` or `attribute_weighted`).",
+        "random");
+
+    add(&Flags::offer_packing_attribute_weights,
+        "offer_packing_attribute_weights",
+        "The agent attribute weights used by the `attribute_weighted`\n"
+        "offer packing policy, e.g., `rack:r1=2,ssd=1`.");
+
+    add(&Flags::max_offers_per_framework,
+        "max_offers_per_framework",
+        "The maximum number of agents a framework is offered resources\n"
+        "on in a single allocation cycle.");
+  }
+
+  Option<string> trace;
+  Option<string> output;
+  Duration allocation_interval;
+  Option<string> fair_sharing_excluded_resource_names;
+  bool filter_gpu_resources;
+  string offer_packing_policy;
+  Option<string> offer_packing_attribute_weights;
+  Option<size_t> max_offers_per_framework;
+};
+
+
+struct Event
+{
+  // Simulated time since the start of the trace.
+  Duration timestamp;
+
+  string type;
+  JSON::Object object;
+};
+
+
+// Statistics collected for one batch allocation cycle.
+struct Cycle
+{
+  Duration elapsed;
+  size_t offers;
+  double fairness;
+};
+
+
+// Returns the `p`-th percentile (with `p` in [0, 1]) of the sorted
+// `values` using the nearest-rank method.
+template <typename T>
+static T percentile(const vector<T>& values, double p)
+{
+  CHECK(!values.empty());
+
+  size_t rank = static_cast<size_t>(p * values.size());
+  return values[std::min(rank, values.size() - 1)];
+}
+
+
+static Try<Resources> parseResources(const JSON::Value& value)
+{
+  if (value.is<JSON::String>()) {
+    return Resources::parse(value.as<JSON::String>().value);
+  }
+
+  return Resources::parse(stringify(value));
+}
+
+
+static Try<vector<Event>> parseTrace(const string& path)
+{
+  ifstream input(path.c_str());
+  if (!input.is_open()) {
+    return Error("Failed to open the trace file " + path);
+  }
+
+  vector<Event> events;
+
+  string line;
+  size_t lineNumber = 0;
+  while (getline(input, line)) {
+    ++lineNumber;
+
+    line = strings::trim(line);
+    if (line.empty() || strings::startsWith(line, "#")) {
+      continue;
+    }
+
+    Try<JSON::Object> object = JSON::parse<JSON::Object>(line);
+    if (object.isError()) {
+      return Error(
+          "Failed to parse line " + stringify(lineNumber) +
+          " of the trace: " + object.error());
+    }
+
+    Result<JSON::String> type = object->at<JSON::String>("type");
+    if (!type.isSome()) {
+      return Error(
+          "Missing 'type' on line " + stringify(lineNumber) + " of the trace");
+    }
+
+    Event event;
+    event.type = type->value;
+    event.object = object.get();
+    event.timestamp = events.empty() ? Duration::zero() :
+      events.back().timestamp;
+
+    Result<JSON::Number> timestamp = object->at<JSON::Number>("timestamp");
+    if (timestamp.isSome()) {
+      Try<Duration> duration = Duration::create(timestamp->as<double>());
+      if (duration.isError() || duration.get() < event.timestamp) {
+        return Error(
+            "Invalid 'timestamp' on line " + stringify(lineNumber) +
+            " of the trace: timestamps must be non-decreasing");
+      }
+
+      event.timestamp = duration.get();
+    }
+
+    events.push_back(event);
+  }
+
+  return events;
+}
+
+
+// Drives an `Allocator` through the events of a trace and keeps
+// track of the outstanding offers and the used resources of every
+// framework, so that the trace can refer to them symbolically.
+class Simulator
+{
+public:
+  Simulator(Allocator* _allocator, const Flags& _flags)
+    : allocator(_allocator), flags(_flags), offers(0) {}
+
+  Try<Nothing> initialize()
+  {
+    mesos::allocator::Options options;
+
+    Try<mesos::allocator::Options::OfferPackingPolicy> offerPackingPolicy =
+      mesos::allocator::Options::parseOfferPackingPolicy(
+          flags.offer_packing_policy);
+
+    if (offerPackingPolicy.isError()) {
+      return Error(offerPackingPolicy.error());
+    }
+
+    if (flags.offer_packing_attribute_weights.isSome()) {
+      Try<vector<mesos::allocator::Options::AttributeWeight>> weights =
+        mesos::allocator::Options::parseAttributeWeights(
+            flags.offer_packing_attribute_weights.get());
+
+      if (weights.isError()) {
+        return Error(weights.error());
+      }
+
+      options.offerPackingAttributeWeights = weights.get();
+    }
+
+    if (offerPackingPolicy.get() ==
+          mesos::allocator::Options::OfferPackingPolicy::ATTRIBUTE_WEIGHTED &&
+        options.offerPackingAttributeWeights.empty()) {
+      return Error(
+          "The `attribute_weighted` offer packing policy requires"
+          " `--offer_packing_attribute_weights`");
+    }
+
+    if (flags.fair_sharing_excluded_resource_names.isSome()) {
+      vector<string> names = strings::split(
+          flags.fair_sharing_excluded_resource_names.get(), ",");
+
+      options.fairnessExcludeResourceNames =
+        set<string>(names.begin(), names.end());
+    }
+
+    options.allocationInterval = flags.allocation_interval;
+    options.filterGpuResources = flags.filter_gpu_resources;
+    options.offerPackingPolicy = offerPackingPolicy.get();
+    options.maxOffersPerFramework = flags.max_offers_per_framework;
+
+    allocator->initialize(
+        options,
+        [this](const FrameworkID& frameworkId,
+               const hashmap<string, hashmap<SlaveID, Resources>>& resources) {
+          offer(frameworkId, resources);
+        },
+        [](const FrameworkID&, const hashmap<SlaveID, UnavailableResources>&) {
+        });
+
+    return Nothing();
+  }
+
+  Try<Nothing> replay(const Event& event);
+
+  // Advances the paused clock through every batch allocation that
+  // happens before `timestamp`, recording each allocation cycle.
+  void advance(const Duration& timestamp);
+
+  void report(std::ostream& stream) const;
+
+  const vector<Cycle>& cycles() const { return _cycles; }
+
+private:
+  void offer(
+      const FrameworkID& frameworkId,
+      const hashmap<string, hashmap<SlaveID, Resources>>& resources);
+
+  // Returns Jain's fairness index over the dominant shares of the
+  // resources currently offered to or used by each framework.
+  double fairness() const;
+
+  // Returns the fraction of its guarantee that is currently offered
+  // to or used by each role with quota.
+  hashmap<string, double> quotaSatisfaction() const;
+
+  Resources holding(const FrameworkID& frameworkId) const;
+
+  Allocator* allocator;
+  const Flags flags;
+
+  // Protects the members below, which are updated from the offer
+  // callback that runs in the context of the allocator process.
+  mutable std::mutex mutex;
+
+  Resources total;
+  hashmap<SlaveID, Resources> agents;
+  hashmap<FrameworkID, FrameworkInfo> frameworks;
+  hashmap<string, Quota> quotas;
+
+  hashmap<FrameworkID, hashmap<SlaveID, Resources>> outstanding;
+  hashmap<FrameworkID, hashmap<SlaveID, Resources>> used;
+
+  // Cumulative number of offers (per framework and agent) made.
+  size_t offers;
+  hashmap<FrameworkID, size_t> offersPerFramework;
+
+  Duration now;
+  vector<Cycle> _cycles;
+  vector<Duration> eventLatencies;
+  hashmap<string, vector<double>> satisfaction;
+};
+
+
+void Simulator::offer(
+    const FrameworkID& frameworkId,
+    const hashmap<string, hashmap<SlaveID, Resources>>& resources)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  foreachvalue (const auto& offerable, resources) {
+    foreachpair (const SlaveID& slaveId, const Resources& offered, offerable) {
+      outstanding[frameworkId][slaveId] += offered;
+      ++offersPerFramework[frameworkId];
+      ++offers;
+    }
+  }
+}
+
+
+Resources Simulator::holding(const FrameworkID& frameworkId) const
+{
+  Resources result;
+
+  if (outstanding.contains(frameworkId)) {
+    foreachvalue (const Resources& resources, outstanding.at(frameworkId)) {
+      result += resources;
+    }
+  }
+
+  if (used.contains(frameworkId)) {
+    foreachvalue (const Resources& resources, used.at(frameworkId)) {
+      result += resources;
+    }
+  }
+
+  return result;
+}
+
+
+double Simulator::fairness() const
+{
+  const Resources totalQuantity = total.createStrippedScalarQuantity();
+
+  double sum = 0.0;
+  double sumOfSquares = 0.0;
+
+  foreachkey (const FrameworkID& frameworkId, frameworks) {
+    Resources quantity = holding(frameworkId).createStrippedScalarQuantity();
+
+    double share = 0.0;
+    foreach (const string& name, totalQuantity.names()) {
+      Option<Value::Scalar> scalar = totalQuantity.get<Value::Scalar>(name);
+      if (scalar.isNone() || scalar->value() <= 0.0) {
+        continue;
+      }
+
+      Option<Value::Scalar> allocated = quantity.get<Value::Scalar>(name);
+      if (allocated.isSome()) {
+        share = std::max(share, allocated->value() / scalar->value());
+      }
+    }
+
+    sum += share;
+    sumOfSquares += share * share;
+  }
+
+  if (frameworks.empty() || sumOfSquares == 0.0) {
+    return 1.0;
+  }
+
+  return (sum * sum) / (frameworks.size() * sumOfSquares);
+}
+
+
+hashmap<string, double> Simulator::quotaSatisfaction() const
+{
+  hashmap<string, Resources> allocated;
+  foreachkey (const FrameworkID& frameworkId, frameworks) {
+    foreachpair (const string& role,
+                 const Resources& resources,
+                 holding(frameworkId).allocations()) {
+      if (quotas.contains(role)) {
+        allocated[role] +=
+          resources.nonRevocable().createStrippedScalarQuantity();
+      }
+    }
+  }
+
+  hashmap<string, double> result;
+
+  foreachpair (const string& role, const Quota& quota, quotas) {
+    const Resources guarantee =
+      Resources(quota.info.guarantee()).createStrippedScalarQuantity();
+
+    double satisfied = 1.0;
+    foreach (const string& name, guarantee.names()) {
+      Option<Value::Scalar> required = guarantee.get<Value::Scalar>(name);
+      if (required.isNone() || required->value() <= 0.0) {
+        continue;
+      }
+
+      Option<Value::Scalar> scalar = allocated.contains(role)
+        ? allocated.at(role).get<Value::Scalar>(name)
+        : None();
+
+      double value = scalar.isSome() ? scalar->value() : 0.0;
+      satisfied = std::min(satisfied, value / required->value());
+    }
+
+    result[role] = std::min(satisfied, 1.0);
+  }
+
+  return result;
+}
+
+
+void Simulator::advance(const Duration& timestamp)
+{
+  // The batch allocation loop started by `initialize()` fires once
+  // per `allocation_interval` of (paused) clock time.
+  while (now + flags.allocation_interval <= timestamp) {
+    size_t before;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      before = offers;
+    }
+
+    Stopwatch stopwatch;
+    stopwatch.start();
+
+    Clock::advance(flags.allocation_interval);
+    Clock::settle();
+
+    Cycle cycle;
+    cycle.elapsed = stopwatch.elapsed();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      cycle.offers = offers - before;
+      cycle.fairness = fairness();
+
+      foreachpair (const string& role,
+                   double value,
+                   quotaSatisfaction()) {
+        satisfaction[role].push_back(value);
+      }
+    }
+
+    _cycles.push_back(cycle);
+
+    now += flags.allocation_interval;
+  }
+
+  // Account for the remaining time without triggering a batch
+  // allocation so that the filter timeouts stay accurate.
+  if (now < timestamp) {
+    Clock::advance(timestamp - now);
+    Clock::settle();
+    now = timestamp;
+  }
+}
+
+
+Try<Nothing> Simulator::replay(const Event& event)
+{
+  const JSON::Object& object = event.object;
+
+  auto getString = [&object](const string& key) -> Try<string> {
+    Result<JSON::String> value = object.at<JSON::String>(key);
+    if (!value.isSome()) {
+      return Error("Missing '" + key + "'");
+    }
+    return value->value;
+  };
+
+  auto getRoles = [&object]() -> set<string> {
+    set<string> roles;
+
+    Result<JSON::Array> array = object.at<JSON::Array>("roles");
+    if (array.isSome()) {
+      foreach (const JSON::Value& value, array->values) {
+        if (value.is<JSON::String>()) {
+          roles.insert(value.as<JSON::String>().value);
+        }
+      }
+    }
+
+    return roles;
+  };
+
+  // The events below mirror what the master does when it calls into
+  // the allocator. The bookkeeping is done under the mutex, the calls
+  // into the allocator are made without it to not deadlock with the
+  // offer callback.
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  if (event.type == "ADD_AGENT") {
+    Result<JSON::Object> json = object.at<JSON::Object>("agent_info");
+    if (!json.isSome()) {
+      return Error("Missing 'agent_info'");
+    }
+
+    Try<SlaveInfo> agentInfo = ::protobuf::parse<SlaveInfo>(json.get());
+    if (agentInfo.isError()) {
+      return Error("Invalid 'agent_info': " + agentInfo.error());
+    }
+
+    if (!agentInfo->has_id()) {
+      return Error("Missing 'agent_info.id'");
+    }
+
+    const Resources resources = agentInfo->resources();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      if (agents.contains(agentInfo->id())) {
+        return Error("Agent " + stringify(agentInfo->id()) + " already added");
+      }
+
+      agents[agentInfo->id()] = resources;
+      total += resources;
+    }
+
+    allocator->addSlave(
+        agentInfo->id(),
+        agentInfo.get(),
+        AGENT_CAPABILITIES(),
+        None(),
+        resources,
+        {});
+  } else if (event.type == "REMOVE_AGENT") {
+    Try<string> id = getString("agent_id");
+    if (id.isError()) {
+      return Error(id.error());
+    }
+
+    SlaveID slaveId;
+    slaveId.set_value(id.get());
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      if (!agents.contains(slaveId)) {
+        return Error("Unknown agent " + id.get());
+      }
+
+      total -= agents.at(slaveId);
+      agents.erase(slaveId);
+
+      foreachkey (const FrameworkID& frameworkId, frameworks) {
+        outstanding[frameworkId].erase(slaveId);
+        used[frameworkId].erase(slaveId);
+      }
+    }
+
+    allocator->removeSlave(slaveId);
+  } else if (event.type == "ADD_FRAMEWORK") {
+    Result<JSON::Object> json = object.at<JSON::Object>("framework_info");
+    if (!json.isSome()) {
+      return Error("Missing 'framework_info'");
+    }
+
+    Try<FrameworkInfo> frameworkInfo =
+      ::protobuf::parse<FrameworkInfo>(json.get());
+
+    if (frameworkInfo.isError()) {
+      return Error("Invalid 'framework_info': " + frameworkInfo.error());
+    }
+
+    if (!frameworkInfo->has_id()) {
+      return Error("Missing 'framework_info.id'");
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      if (frameworks.contains(frameworkInfo->id())) {
+        return Error(
+            "Framework " + stringify(frameworkInfo->id()) + " already added");
+      }
+
+      frameworks[frameworkInfo->id()] = frameworkInfo.get();
+    }
+
+    allocator->addFramework(
+        frameworkInfo->id(), frameworkInfo.get(), {}, true, getRoles());
+  } else if (event.type == "REMOVE_FRAMEWORK") {
+    Try<string> id = getString("framework_id");
+    if (id.isError()) {
+      return Error(id.error());
+    }
+
+    FrameworkID frameworkId;
+    frameworkId.set_value(id.get());
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      if (!frameworks.contains(frameworkId)) {
+        return Error("Unknown framework " + id.get());
+      }
+
+      frameworks.erase(frameworkId);
+      outstanding.erase(frameworkId);
+      used.erase(frameworkId);
+    }
+
+    allocator->removeFramework(frameworkId);
+  } else if (event.type == "ACCEPT" || event.type == "DECLINE") {
+    Try<string> id = getString("framework_id");
+    if (id.isError()) {
+      return Error(id.error());
+    }
+
+    FrameworkID frameworkId;
+    frameworkId.set_value(id.get());
+
+    Option<SlaveID> slaveId;
+    if (getString("agent_id").isSome()) {
+      slaveId = SlaveID();
+      slaveId->set_value(getString("agent_id").get());
+    }
+
+    Option<Filters> filters;
+    Result<JSON::Number> refuseSeconds =
+      object.at<JSON::Number>("refuse_seconds");
+
+    if (refuseSeconds.isSome()) {
+      filters = Filters();
+      filters->set_refuse_seconds(refuseSeconds->as<double>());
+    }
+
+    hashmap<SlaveID, Resources> declined;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      if (!frameworks.contains(frameworkId)) {
+        return Error("Unknown framework " + id.get());
+      }
+
+      // Iterate over a copy since we erase the handled offers.
+      const hashmap<SlaveID, Resources> offered = outstanding[frameworkId];
+
+      foreachpair (const SlaveID& agentId,
+                   const Resources& resources,
+                   offered) {
+        if (slaveId.isSome() && slaveId.get() != agentId) {
+          continue;
+        }
+
+        if (event.type == "ACCEPT") {
+          used[frameworkId][agentId] += resources;
+        } else {
+          declined[agentId] = resources;
+        }
+
+        outstanding[frameworkId].erase(agentId);
+      }
+    }
+
+    foreachpair (const SlaveID& agentId,
+                 const Resources& resources,
+                 declined) {
+      // Resources are recovered one allocation role at a time.
+      foreachvalue (const Resources& allocation, resources.allocations()) {
+        allocator->recoverResources(frameworkId, agentId, allocation, filters);
+      }
+    }
+  } else if (event.type == "RECOVER_RESOURCES") {
+    Try<string> id = getString("framework_id");
+    if (id.isError()) {
+      return Error(id.error());
+    }
+
+    Try<string> agentId = getString("agent_id");
+    if (agentId.isError()) {
+      return Error(agentId.error());
+    }
+
+    FrameworkID frameworkId;
+    frameworkId.set_value(id.get());
+
+    SlaveID slaveId;
+    slaveId.set_value(agentId.get());
+
+    Option<Resources> requested;
+    Result<JSON::Value> json = object.at<JSON::Value>("resources");
+    if (json.isSome()) {
+      Try<Resources> resources = parseResources(json.get());
+      if (resources.isError()) {
+        return Error("Invalid 'resources': " + resources.error());
+      }
+
+      requested = resources.get();
+    }
+
+    Resources recovered;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      if (!used.contains(frameworkId) ||
+          !used.at(frameworkId).contains(slaveId)) {
+        // The simulated allocation decisions may differ from the
+        // recorded ones, in which case there is nothing to recover.
+        VLOG(1) << "Ignoring recovery for framework " << frameworkId
+                << " on agent " << slaveId << ": nothing is used";
+
+        return Nothing();
+      }
+
+      Resources& inUse = used.at(frameworkId).at(slaveId);
+
+      if (requested.isNone()) {
+        recovered = inUse;
+      } else {
+        // Recover the requested resources from the first allocation
+        // role that holds all of them.
+        foreachkey (const string& role, inUse.allocations()) {
+          Resources resources = requested.get();
+          resources.allocate(role);
+
+          if (inUse.contains(resources)) {
+            recovered = resources;
+            break;
+          }
+        }
+      }
+
+      inUse -= recovered;
+      if (inUse.empty()) {
+        used.at(frameworkId).erase(slaveId);
+      }
+    }
+
+    foreachvalue (const Resources& allocation, recovered.allocations()) {
+      allocator->recoverResources(frameworkId, slaveId, allocation, None());
+    }
+  } else if (event.type == "SUPPRESS" || event.type == "REVIVE") {
+    Try<string> id = getString("framework_id");
+    if (id.isError()) {
+      return Error(id.error());
+    }
+
+    FrameworkID frameworkId;
+    frameworkId.set_value(id.get());
+
+    if (event.type == "SUPPRESS") {
+      allocator->suppressOffers(frameworkId, getRoles());
+    } else {
+      allocator->reviveOffers(frameworkId, getRoles());
+    }
+  } else if (event.type == "SET_QUOTA") {
+    Try<string> role = getString("role");
+    if (role.isError()) {
+      return Error(role.error());
+    }
+
+    Result<JSON::Value> json = object.at<JSON::Value>("guarantee");
+    if (!json.isSome()) {
+      return Error("Missing 'guarantee'");
+    }
+
+    Try<Resources> guarantee = parseResources(json.get());
+    if (guarantee.isError()) {
+      return Error("Invalid 'guarantee': " + guarantee.error());
+    }
+
+    mesos::quota::QuotaInfo quotaInfo;
+    quotaInfo.set_role(role.get());
+    quotaInfo.mutable_guarantee()->CopyFrom(guarantee.get());
+
+    const Quota quota{quotaInfo};
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      quotas[role.get()] = quota;
+    }
+
+    allocator->setQuota(role.get(), quota);
+  } else if (event.type == "REMOVE_QUOTA") {
+    Try<string> role = getString("role");
+    if (role.isError()) {
+      return Error(role.error());
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      quotas.erase(role.get());
+    }
+
+    allocator->removeQuota(role.get());
+  } else {
+    return Error("Unknown event type '" + event.type + "'");
+  }
+
+  // Wait for the allocator to process the event (and any allocation
+  // it triggered) before moving on to the next one.
+  Clock::settle();
+
+  eventLatencies.push_back(stopwatch.elapsed());
+
+  return Nothing();
+}
+
+
+void Simulator::report(std::ostream& stream) const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  stream << "Replayed " << eventLatencies.size() << " events over "
+         << now << " of simulated time" << endl;
+
+  stream << "Agents: " << agents.size()
+         << ", frameworks: " << frameworks.size()
+         << ", offers: " << offers << endl;
+
+  if (!_cycles.empty()) {
+    vector<Duration> latencies;
+    double fairness = 0.0;
+
+    foreach (const Cycle& cycle, _cycles) {
+      latencies.push_back(cycle.elapsed);
+      fairness += cycle.fairness;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    stream << "Batch allocation cycles: " << _cycles.size() << endl
+           << "  p50:   " << percentile(latencies, 0.5) << endl
+           << "  p90:   " << percentile(latencies, 0.9) << endl
+           << "  p99:   " << percentile(latencies, 0.99) << endl
+           << "  p999:  " << percentile(latencies, 0.999) << endl
+           << "  max:   " << latencies.back() << endl;
+
+    stream << "Mean fairness (Jain's index over dominant shares): "
+           << fairness / _cycles.size() << endl;
+  }
+
+  if (!eventLatencies.empty()) {
+    vector<Duration> latencies = eventLatencies;
+    std::sort(latencies.begin(), latencies.end());
+
+    stream << "Event processing (including triggered allocations):" << endl
+           << "  p50:   " << percentile(latencies, 0.5) << endl
+           << "  p99:   " << percentile(latencies, 0.99) << endl
+           << "  max:   " << latencies.back() << endl;
+  }
+
+  foreachpair (const FrameworkID& frameworkId,
+               size_t count,
+               offersPerFramework) {
+    stream << "Framework " << frameworkId << " received " << count
+           << " offers" << endl;
+  }
+
+  foreachpair (const string& role,
+               const vector<double>& values,
+               satisfaction) {
+    if (values.empty()) {
+      continue;
+    }
+
+    double sum = 0.0;
+    size_t satisfied = 0;
+    foreach (double value, values) {
+      sum += value;
+      if (value >= 1.0) {
+        ++satisfied;
+      }
+    }
+
+    stream << "Quota role '" << role << "': mean satisfaction "
+           << sum / values.size() << ", fully satisfied in "
+           << satisfied << "/" << values.size() << " cycles" << endl;
+  }
+}
+
+
+int main(int argc, char** argv)
+{
+  Flags flags;
+  flags.setUsageMessage(
+      "Usage: " + Path(argv[0]).basename() + " [options]\n"
+      "\n"
+      "Replays a recorded trace of allocator events against the\n"
+      "hierarchical allocator under a paused clock and reports\n"
+      "allocation latency, offer fairness and quota satisfaction.\n"
+      "\n");
+
+  Try<flags::Warnings> load = flags.load(None(), argc, argv);
+
+  if (flags.help) {
+    cout << flags.usage() << endl;
+    return EXIT_SUCCESS;
+  }
+
+  if (load.isError()) {
+    cerr << flags.usage(load.error()) << endl;
+    return EXIT_FAILURE;
+  }
+
+  if (flags.trace.isNone()) {
+    cerr << flags.usage("Missing required option --trace") << endl;
+    return EXIT_FAILURE;
+  }
+
+  process::initialize();
+  logging::initialize(argv[0], false, flags);
+
+  // Log any flag warnings (after logging is initialized).
+  foreach (const flags::Warning& warning, load->warnings) {
+    LOG(WARNING) << warning.message;
+  }
+
+  Try<vector<Event>> events = parseTrace(flags.trace.get());
+  if (events.isError()) {
+    cerr << events.error() << endl;
+    return EXIT_FAILURE;
+  }
+
+  Try<Allocator*> allocator = HierarchicalDRFAllocator::create();
+  if (allocator.isError()) {
+    cerr << "Failed to create allocator: " << allocator.error() << endl;
+    return EXIT_FAILURE;
+  }
+
+  // Pause the clock so that the trace is replayed in simulated
+  // time: batch allocations only happen when we advance the clock.
+  Clock::pause();
+
+  Simulator simulator(allocator.get(), flags);
+
+  Try<Nothing> initialize = simulator.initialize();
+  if (initialize.isError()) {
+    cerr << "Failed to initialize allocator: " << initialize.error() << endl;
+    return EXIT_FAILURE;
+  }
+
+  foreach (const Event& event, events.get()) {
+    simulator.advance(event.timestamp);
+
+    Try<Nothing> replay = simulator.replay(event);
+    if (replay.isError()) {
+      cerr << "Failed to replay '" << event.type << "' event at "
+           << event.timestamp << ": " << replay.error() << endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Run one more batch allocation to account for the last events.
+  simulator.advance(
+      (events->empty() ? Duration::zero() : events->back().timestamp) +
+      flags.allocation_interval);
+
+  simulator.report(cout);
+
+  if (flags.output.isSome()) {
+    ofstream output(flags.output->c_str());
+    if (!output.is_open()) {
+      cerr << "Failed to open the output file " << flags.output.get() << endl;
+      return EXIT_FAILURE;
+    }
+
+    foreach (const Cycle& cycle, simulator.cycles()) {
+      output << cycle.elapsed.ms() << " ms, "
+             << cycle.offers << " offers, "
+             << "fairness " << cycle.fairness << endl;
+    }
+  }
+
+  delete allocator.get();
+
+  return EXIT_SUCCESS;
+}
@@ -187,6 +187,10 @@ void DRFSorter::remove(const string& clientPath)
   const hashmap<SlaveID, Resources> leafAllocation =
     current->allocation.resources;
 
+  CHECK(allocatedScalarQuantities.contains(
+      current->allocation.scalarQuantities));
+  allocatedScalarQuantities -= current->allocation.scalarQuantities;
+
   // Remove the lookup table entry for the client.
   CHECK(clients.contains(clientPath));
   clients.erase(clientPath);
@@ -322,6 +326,9 @@ void DRFSorter::allocated(
 {
   Node* current = CHECK_NOTNULL(find(clientPath));
 
+  allocatedScalarQuantities += current->allocation.add(slaveId, resources);
+  current = CHECK_NOTNULL(current->parent);
+
   // NOTE: We don't currently update the `allocation` for the root
   // node. This is debatable, but the current implementation doesn't
   // require looking at the allocation of the root node.
@@ -356,6 +363,13 @@ void DRFSorter::update(
     current = CHECK_NOTNULL(current->parent);
   }
 
+  const Resources oldAllocationQuantity =
+    oldAllocation.createStrippedScalarQuantity();
+
+  CHECK(allocatedScalarQuantities.contains(oldAllocationQuantity));
+  allocatedScalarQuantities -= oldAllocationQuantity;
+  allocatedScalarQuantities += newAllocation.createStrippedScalarQuantity();
+
   // Just assume the total has changed, per the TODO above.
   dirty = true;
 }
@@ -368,6 +382,14 @@ void DRFSorter::unallocated(
 {
   Node* current = CHECK_NOTNULL(find(clientPath));
 
+  const Resources quantities =
+    current->allocation.subtract(slaveId, resources);
+
+  CHECK(allocatedScalarQuantities.contains(quantities));
+  allocatedScalarQuantities -= quantities;
+
+  current = CHECK_NOTNULL(current->parent);
+
   // NOTE: We don't currently update the `allocation` for the root
   // node. This is debatable, but the current implementation doesn't
   // require looking at the allocation of the root node.
@@ -397,6 +419,12 @@ const Resources& DRFSorter::allocationScalarQuantities(
 }
 
 
+const Resources& DRFSorter::allocationScalarQuantities() const
+{
+  return allocatedScalarQuantities;
+}
+
+
 hashmap<string, Resources> DRFSorter::allocation(const SlaveID& slaveId) const
 {
   hashmap<string, Resources> result;
@@ -598,21 +626,22 @@ double DRFSorter::calculateShare(const Node* node) const
   // currently does not take into account resources that are not
   // scalars.
 
+  // Only the resources allocated to the node contribute to its share,
+  // so we iterate over these (which are usually a few) rather than
+  // over all the resources in the total.
   foreachpair (const string& resourceName,
-               const Value::Scalar& scalar,
-               total_.totals) {
+               const Value::Scalar& allocation,
+               node->allocation.totals) {
     // Filter out the resources excluded from fair sharing.
     if (fairnessExcludeResourceNames.isSome() &&
         fairnessExcludeResourceNames->count(resourceName) > 0) {
       continue;
     }
 
-    if (scalar.value() > 0.0 &&
-        node->allocation.totals.contains(resourceName)) {
-      const double allocation =
-        node->allocation.totals.at(resourceName).value();
+    auto total = total_.totals.find(resourceName);
 
-      share = std::max(share, allocation / scalar.value());
+    if (total != total_.totals.end() && total->second.value() > 0.0) {
+      share = std::max(share, allocation.value() / total->second.value());
     }
   }
 
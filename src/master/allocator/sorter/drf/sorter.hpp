@@ -86,6 +86,8 @@ public:
   virtual const Resources& allocationScalarQuantities(
       const std::string& clientPath) const;
 
+  virtual const Resources& allocationScalarQuantities() const;
+
   virtual hashmap<std::string, Resources> allocation(
       const SlaveID& slaveId) const;
 
@@ -178,6 +180,11 @@ private:
     hashmap<std::string, Value::Scalar> totals;
   } total_;
 
+  // The sum of the scalar quantities allocated to all clients. This
+  // is maintained along with the allocation of the clients' leaf nodes
+  // so that it does not have to be aggregated across clients.
+  Resources allocatedScalarQuantities;
+
   // Metrics are optionally exposed by the sorter.
   friend Metrics;
   Option<Metrics> metrics;
@@ -321,7 +328,8 @@ struct DRFSorter::Node
   {
     Allocation() : count(0) {}
 
-    void add(const SlaveID& slaveId, const Resources& toAdd)
+    // Returns the scalar quantities by which the allocation grew.
+    Resources add(const SlaveID& slaveId, const Resources& toAdd)
     {
       // Add shared resources to the allocated quantities when the same
       // resources don't already exist in the allocation.
@@ -341,9 +349,12 @@ struct DRFSorter::Node
       }
 
       count++;
+
+      return quantitiesToAdd;
     }
 
-    void subtract(const SlaveID& slaveId, const Resources& toRemove)
+    // Returns the scalar quantities by which the allocation shrank.
+    Resources subtract(const SlaveID& slaveId, const Resources& toRemove)
     {
       CHECK(resources.contains(slaveId));
       CHECK(resources.at(slaveId).contains(toRemove));
@@ -370,6 +381,8 @@ struct DRFSorter::Node
       if (resources[slaveId].empty()) {
         resources.erase(slaveId);
       }
+
+      return quantitiesToRemove;
     }
 
     void update(
@@ -113,6 +113,11 @@ public:
   virtual const Resources& allocationScalarQuantities(
       const std::string& client) const = 0;
 
+  // Returns the sum of the scalar resource quantities that are allocated
+  // to all clients, i.e., the sum of `allocationScalarQuantities(client)`
+  // across all clients.
+  virtual const Resources& allocationScalarQuantities() const = 0;
+
   // Returns the clients that have allocations on this slave.
   virtual hashmap<std::string, Resources> allocation(
       const SlaveID& slaveId) const = 0;
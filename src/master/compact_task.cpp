@@ -0,0 +1,144 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "master/compact_task.hpp"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+#include <stout/foreach.hpp>
+
+using std::shared_ptr;
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+constexpr size_t CompactTask::Pool::MIN_THRESHOLD;
+
+
+shared_ptr<const string> CompactTask::Pool::intern(const string& value)
+{
+  // Look the value up through a pointer that does not own it, which
+  // avoids copying the value unless it is not in the pool yet.
+  auto iterator = values.find(shared_ptr<const string>(
+      shared_ptr<const string>(), &value));
+
+  if (iterator != values.end()) {
+    return *iterator;
+  }
+
+  if (values.size() >= threshold) {
+    prune();
+    threshold = std::max(MIN_THRESHOLD, values.size() * 2);
+  }
+
+  shared_ptr<const string> interned(new string(value));
+  values.insert(interned);
+
+  return interned;
+}
+
+
+size_t CompactTask::Pool::bytes() const
+{
+  size_t bytes = 0;
+
+  foreach (const shared_ptr<const string>& value, values) {
+    bytes += value->capacity();
+  }
+
+  return bytes;
+}
+
+
+void CompactTask::Pool::prune()
+{
+  auto iterator = values.begin();
+  while (iterator != values.end()) {
+    // The pool holds the only reference.
+    if (iterator->use_count() == 1) {
+      iterator = values.erase(iterator);
+    } else {
+      ++iterator;
+    }
+  }
+}
+
+
+CompactTask::CompactTask(const Task& task, Pool* pool)
+  : state_(task.state())
+{
+  CHECK_NOTNULL(pool);
+
+  frameworkId = pool->intern(task.framework_id().value());
+  slaveId_ = pool->intern(task.slave_id().value());
+
+  if (task.has_executor_id()) {
+    executorId = pool->intern(task.executor_id().value());
+  }
+
+  // The resources are serialized as a `Task` that only has resources,
+  // so that they can be merged into the materialized task.
+  Task _resources;
+  _resources.mutable_resources()->CopyFrom(task.resources());
+  resources = pool->intern(_resources.SerializePartialAsString());
+
+  Task _task = task;
+  _task.clear_framework_id();
+  _task.clear_slave_id();
+  _task.clear_executor_id();
+  _task.clear_resources();
+
+  remainder = _task.SerializePartialAsString();
+}
+
+
+Task CompactTask::materialize() const
+{
+  // Parsing the concatenation of serialized messages merges them.
+  Task task;
+  CHECK(task.ParsePartialFromString(remainder + *resources));
+
+  task.mutable_framework_id()->set_value(*frameworkId);
+  task.mutable_slave_id()->set_value(*slaveId_);
+
+  if (executorId) {
+    task.mutable_executor_id()->set_value(*executorId);
+  }
+
+  return task;
+}
+
+
+SlaveID CompactTask::slaveId() const
+{
+  SlaveID slaveId;
+  slaveId.set_value(*slaveId_);
+  return slaveId;
+}
+
+
+size_t CompactTask::bytes() const
+{
+  return sizeof(*this) + remainder.capacity();
+}
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
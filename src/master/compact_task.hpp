@@ -0,0 +1,121 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_COMPACT_TASK_HPP__
+#define __MASTER_COMPACT_TASK_HPP__
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <mesos/mesos.hpp>
+
+#include <stout/hashset.hpp>
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// A memory-compact, immutable copy of a task, which the master keeps
+// for the tasks that have completed. The framework, agent and executor
+// IDs and the resources, which tend to be the same for many tasks, are
+// shared through a `Pool`. The rest of the task, including its status
+// history, is kept serialized. The full `Task` is only materialized
+// when it is needed, e.g., to serve an HTTP request.
+class CompactTask
+{
+public:
+  // Shares equal values between the tasks created with it.
+  //
+  // NOTE: This is not thread-safe, the master only uses it from
+  // within its own actor.
+  class Pool
+  {
+  public:
+    Pool() : threshold(MIN_THRESHOLD) {}
+
+    std::shared_ptr<const std::string> intern(const std::string& value);
+
+    // Returns the number of bytes of the values in the pool.
+    size_t bytes() const;
+
+  private:
+    // Drops the values that are not used by any task anymore.
+    void prune();
+
+    static constexpr size_t MIN_THRESHOLD = 1024;
+
+    // Hash and compare the pooled values rather than the pointers, so
+    // that each value is only stored once.
+    struct Hash
+    {
+      size_t operator()(const std::shared_ptr<const std::string>& value) const
+      {
+        return std::hash<std::string>()(*value);
+      }
+    };
+
+    struct Equal
+    {
+      bool operator()(
+          const std::shared_ptr<const std::string>& left,
+          const std::shared_ptr<const std::string>& right) const
+      {
+        return *left == *right;
+      }
+    };
+
+    hashset<std::shared_ptr<const std::string>, Hash, Equal> values;
+
+    // The pool is pruned once it grows to this size, which is doubled
+    // after every pruning so that pruning costs amortized constant
+    // time per value.
+    size_t threshold;
+  };
+
+  CompactTask(const Task& task, Pool* pool);
+
+  // Returns the full task.
+  Task materialize() const;
+
+  SlaveID slaveId() const;
+  TaskState state() const { return state_; }
+
+  // Returns the number of bytes used by this task, excluding the
+  // values that are shared through the pool.
+  size_t bytes() const;
+
+private:
+  std::shared_ptr<const std::string> frameworkId;
+  std::shared_ptr<const std::string> slaveId_;
+
+  // Not set if the task has no executor ID.
+  std::shared_ptr<const std::string> executorId;
+
+  // The serialized resources of the task.
+  std::shared_ptr<const std::string> resources;
+
+  // The serialized task without the fields above.
+  std::string remainder;
+
+  TaskState state_;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_COMPACT_TASK_HPP__
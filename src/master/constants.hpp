@@ -49,6 +49,18 @@ constexpr Bytes MIN_MEM = Megabytes(32);
 // scheduler.
 constexpr Duration DEFAULT_HEARTBEAT_INTERVAL = Seconds(15);
 
+// Maximum number of events the master queues for a subscriber of the
+// operator API while the subscriber is being authorized. A subscriber
+// that falls further behind is disconnected.
+constexpr size_t MAX_SUBSCRIBER_PENDING_EVENTS = 1000;
+
+// Maximum number of tasks the master answers for a reconciliation
+// before it processes the other messages that are queued.
+constexpr size_t RECONCILIATION_CHUNK_SIZE = 1000;
+
+// Maximum number of removed offers the master keeps for reuse.
+constexpr size_t MAX_POOLED_OFFERS = 1000;
+
 // Amount of time within which a slave PING should be received.
 // NOTE: The slave uses these PING constants to determine when
 // the master has stopped sending pings. If these are made
@@ -131,6 +143,10 @@ constexpr char DEFAULT_ALLOCATOR[] = "HierarchicalDRF";
 // The default interval between allocations.
 constexpr Duration DEFAULT_ALLOCATION_INTERVAL = Seconds(1);
 
+// Maximum number of recent allocation cycles the allocator keeps
+// around for debugging.
+constexpr size_t MAX_RECENT_ALLOCATION_CYCLES = 100;
+
 // Name of the default, local authorizer.
 constexpr char DEFAULT_AUTHORIZER[] = "local";
 
@@ -14,9 +14,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <string>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
+#include <mesos/allocator/allocator.hpp>
+
 #include <stout/flags.hpp>
 
 #include "common/http.hpp"
@@ -25,6 +29,7 @@
 #include "master/flags.hpp"
 
 using std::string;
+using std::vector;
 
 mesos::internal::master::Flags::Flags()
 {
@@ -114,6 +119,47 @@ mesos::internal::master::Flags::Flags()
       "after which the operation is considered a failure.",
       Seconds(20));
 
+  add(&Flags::registry_max_journal_entries,
+      "registry_max_journal_entries",
+      "Maximum number of registry updates that are stored as deltas in a\n"
+      "journal rather than by storing the whole registry. Once the journal\n"
+      "holds this many deltas, the next update stores the whole registry\n"
+      "and thereby compacts the journal. Storing deltas avoids writing\n"
+      "the information about all agents on every update, which limits the\n"
+      "rate at which agents can be (re-)admitted in large clusters.\n"
+      "If set to 0, the whole registry is stored on every update.\n"
+      "NOTE: Masters that do not support the journal ignore it. Before\n"
+      "downgrading, restart the leading master with this flag set to 0,\n"
+      "which stores the whole registry upon recovery.",
+      0);
+
+  add(&Flags::registry_log_max_diffs,
+      "registry_log_max_diffs",
+      "Maximum number of diffs that the `replicated_log` based registry\n"
+      "writes to the log between two snapshots of the registry. A diff\n"
+      "is only written if it is smaller than the registry. If set to 0,\n"
+      "a snapshot of the whole registry is written on every update.",
+      0);
+
+  add(&Flags::registry_log_diff_format,
+      "registry_log_diff_format",
+      "Format of the diffs written by the `replicated_log` based registry\n"
+      "(see `--registry_log_max_diffs`); available options are `svn` and\n"
+      "`delta`. A `delta` is much cheaper to compute than an `svn` diff\n"
+      "for large registries.\n"
+      "NOTE: Masters that do not support the `delta` format can not\n"
+      "recover from a log that contains deltas. Before downgrading,\n"
+      "restart the leading master with `--registry_log_max_diffs` set\n"
+      "to 0 and let it store one update, which writes a snapshot.",
+      "svn",
+      [](const string& value) -> Option<Error> {
+        if (value != "svn" && value != "delta") {
+          return Error("Expected `svn` or `delta` for"
+                       " '--registry_log_diff_format'");
+        }
+        return None();
+      });
+
   add(&Flags::log_auto_initialize,
       "log_auto_initialize",
       "Whether to automatically initialize the replicated log used for the\n"
@@ -474,6 +520,70 @@ mesos::internal::master::Flags::Flags()
       "  https://issues.apache.org/jira/browse/MESOS-7576",
       true);
 
+  add(&Flags::offer_packing_policy,
+      "offer_packing_policy",
+      "The order in which the allocator considers agents when making\n"
+      "offers in an allocation cycle. Options are:\n"
+      "  `random`:  agents are shuffled randomly in every cycle.\n"
+      "  `binpack`: the most utilized agents are offered first, so that\n"
+      "             frameworks fill up partially used agents and other\n"
+      "             agents stay free for large tasks.\n"
+      "  `spread`:  the least utilized agents are offered first, so\n"
+      "             that load is spread across the cluster.\n"
+      "  `attribute_weighted`: agents with the highest sum of attribute\n"
+      "             weights are offered first, see\n"
+      "             `--offer_packing_attribute_weights`; agents with\n"
+      "             equal weights are bin packed.\n"
+      "All policies other than `random` prefer agents with larger amounts\n"
+      "of free resources among otherwise equal agents.",
+      "random",
+      [](const string& value) -> Option<Error> {
+        if (mesos::allocator::Options::parseOfferPackingPolicy(value)
+              .isError()) {
+          return Error(
+              "Expected `--offer_packing_policy` to be one of `random`,"
+              " `binpack`, `spread` or `attribute_weighted`");
+        }
+        return None();
+      });
+
+  add(&Flags::offer_packing_attribute_weights,
+      "offer_packing_attribute_weights",
+      "A comma-separated list of agent attribute weights used by the\n"
+      "`attribute_weighted` offer packing policy. A weight of the form\n"
+      "`name=weight` applies to all agents with the attribute `name`,\n"
+      "one of the form `name:value=weight` only to agents where the\n"
+      "attribute has the given value. The weights of all matching\n"
+      "attributes of an agent are summed up. Required by the\n"
+      "`attribute_weighted` policy.\n"
+      "Example: `rack:r1=2,ssd=1`",
+      [](const Option<string>& value) -> Option<Error> {
+        if (value.isSome()) {
+          Try<vector<mesos::allocator::Options::AttributeWeight>> weights =
+            mesos::allocator::Options::parseAttributeWeights(value.get());
+
+          if (weights.isError()) {
+            return Error(
+                "Invalid `--offer_packing_attribute_weights`: " +
+                weights.error());
+          }
+        }
+        return None();
+      });
+
+  add(&Flags::max_offers_per_framework,
+      "max_offers_per_framework",
+      "The maximum number of agents a framework is offered resources on\n"
+      "in a single allocation cycle. Combined with\n"
+      "`--offer_packing_policy`, this bounds the number of (small) offers\n"
+      "frameworks receive and decline. If not set, there is no limit.",
+      [](const Option<size_t>& value) -> Option<Error> {
+        if (value.isSome() && value.get() == 0) {
+          return Error("Expected `--max_offers_per_framework` to be positive");
+        }
+        return None();
+      });
+
   add(&Flags::hooks,
       "hooks",
       "A comma-separated list of hook modules to be\n"
@@ -607,6 +717,27 @@ mesos::internal::master::Flags::Flags()
       "`registry_max_agent_age` flag.",
       DEFAULT_REGISTRY_MAX_AGENT_COUNT);
 
+  add(&Flags::state_snapshot_interval,
+      "state_snapshot_interval",
+      "How often at most the leading master captures a snapshot of its\n"
+      "state. If set, the `GET_STATE`, `GET_TASKS`, `GET_FRAMEWORKS`,\n"
+      "`GET_EXECUTORS` and `GET_AGENTS` calls of the operator API and the\n"
+      "`/state`, `/state-summary`, `/frameworks`, `/slaves` and `/tasks`\n"
+      "endpoints are served from the latest snapshot outside of the\n"
+      "master actor. Snapshots are only captured on demand, once a request\n"
+      "finds the latest one older than this interval, so responses may be\n"
+      "stale by up to twice this interval. If not set, they are served\n"
+      "from the current state.");
+
+  add(&Flags::http_response_cache_ttl,
+      "http_response_cache_ttl",
+      "If set, identical concurrent requests by the same principal to the\n"
+      "`/state`, `/state-summary`, `/frameworks`, `/slaves` and `/tasks`\n"
+      "endpoints and for the `GET_STATE` call of the operator API are\n"
+      "served by a single computation, whose response is then reused for\n"
+      "this long after the computation started. A value of `0secs` only\n"
+      "coalesces concurrent requests.");
+
   add(&Flags::ip,
       "ip",
       "IP address to listen on. This cannot be used in conjunction\n"
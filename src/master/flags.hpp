@@ -54,6 +54,9 @@ public:
   bool registry_strict;
   Duration registry_fetch_timeout;
   Duration registry_store_timeout;
+  size_t registry_max_journal_entries;
+  size_t registry_log_max_diffs;
+  std::string registry_log_diff_format;
   bool log_auto_initialize;
   Duration agent_reregister_timeout;
   std::string recovery_agent_removal_limit;
@@ -82,6 +85,9 @@ public:
   std::string allocator;
   Option<std::set<std::string>> fair_sharing_excluded_resource_names;
   bool filter_gpu_resources;
+  std::string offer_packing_policy;
+  Option<std::string> offer_packing_attribute_weights;
+  Option<size_t> max_offers_per_framework;
   Option<std::string> hooks;
   Duration agent_ping_timeout;
   size_t max_agent_ping_timeouts;
@@ -96,6 +102,8 @@ public:
   Duration registry_gc_interval;
   Duration registry_max_agent_age;
   size_t registry_max_agent_count;
+  Option<Duration> state_snapshot_interval;
+  Option<Duration> http_response_cache_ttl;
   Option<DomainInfo> domain;
 
   // The following flags are executable specific (e.g., since we only
@@ -78,6 +78,8 @@
 #include "master/machine.hpp"
 #include "master/maintenance.hpp"
 #include "master/master.hpp"
+#include "master/state_view.hpp"
+#include "master/task_index.hpp"
 #include "master/validation.hpp"
 
 #include "mesos/mesos.hpp"
@@ -119,6 +121,7 @@ using std::copy_if;
 using std::list;
 using std::map;
 using std::set;
+using std::shared_ptr;
 using std::string;
 using std::tie;
 using std::tuple;
@@ -210,8 +213,246 @@ struct Full : Representation<T>
 };
 
 
+// Returns the resources of a state snapshot, which are in the format of
+// the operator API, in the format used within the master.
+static Resources snapshotResources(const RepeatedPtrField<Resource>& resources)
+{
+  RepeatedPtrField<Resource> _resources = resources;
+  convertResourceFormat(&_resources, POST_RESERVATION_REFINEMENT);
+
+  return Resources(_resources);
+}
+
+
+// Returns the time of a state snapshot in seconds, akin to `Time::secs()`.
+static double snapshotSecs(const TimeInfo& time)
+{
+  return Nanoseconds(time.nanoseconds()).secs();
+}
+
+
+// The state of a framework that is rendered by the v0 endpoints. It is
+// read either from a `Framework` of the master, or from a framework of
+// a state snapshot (see `StateView`), so that both are rendered by the
+// same writers.
+struct FrameworkState
+{
+  explicit FrameworkState(const Framework& framework)
+    : info(framework.info),
+      usedResources(framework.totalUsedResources),
+      offeredResources(framework.totalOfferedResources),
+      active(framework.active()),
+      connected(framework.connected()),
+      recovered(framework.recovered()),
+      multiRole(framework.capabilities.multiRole),
+      registeredTime(framework.registeredTime.secs()),
+      unregisteredTime(framework.unregisteredTime.secs()),
+      framework_(&framework),
+      snapshotFramework_(nullptr),
+      tasks_(nullptr)
+  {
+    if (framework.pid.isSome()) {
+      pid = string(framework.pid.get());
+    }
+
+    // TODO(benh): Consider making reregisteredTime an Option.
+    if (framework.registeredTime != framework.reregisteredTime) {
+      reregisteredTime = framework.reregisteredTime.secs();
+    }
+  }
+
+  FrameworkState(
+      const StateSnapshot& snapshot,
+      const mesos::master::Response::GetFrameworks::Framework& framework)
+    : info(framework.framework_info()),
+      usedResources(snapshotResources(framework.allocated_resources())),
+      offeredResources(snapshotResources(framework.offered_resources())),
+      active(framework.active()),
+      connected(framework.connected()),
+      recovered(framework.recovered()),
+      multiRole(protobuf::frameworkHasCapability(
+          info, FrameworkInfo::Capability::MULTI_ROLE)),
+      registeredTime(snapshotSecs(framework.registered_time())),
+      unregisteredTime(snapshotSecs(framework.unregistered_time())),
+      framework_(nullptr),
+      snapshotFramework_(&framework),
+      tasks_(&snapshot.tasks.at(info.id()))
+  {
+    if (snapshot.frameworkPids.contains(info.id())) {
+      pid = snapshot.frameworkPids.at(info.id());
+    }
+
+    if (framework.registered_time().nanoseconds() !=
+        framework.reregistered_time().nanoseconds()) {
+      reregisteredTime = snapshotSecs(framework.reregistered_time());
+    }
+  }
+
+  // Invokes `f` for each pending task, which is modeled as a `Task`
+  // like in the operator API.
+  void foreachPendingTask(const lambda::function<void(const Task&)>& f) const
+  {
+    if (framework_ != nullptr) {
+      foreachvalue (const TaskInfo& taskInfo, framework_->pendingTasks) {
+        f(protobuf::createTask(taskInfo, TASK_STAGING, framework_->id()));
+      }
+    } else {
+      foreach (const Task* task, tasks_->pending) {
+        f(*task);
+      }
+    }
+  }
+
+  void foreachTask(const lambda::function<void(const Task&)>& f) const
+  {
+    if (framework_ != nullptr) {
+      foreachvalue (Task* task, framework_->tasks) {
+        f(*task);
+      }
+    } else {
+      foreach (const Task* task, tasks_->active) {
+        f(*task);
+      }
+    }
+  }
+
+  void foreachUnreachableTask(
+      const lambda::function<void(const Task&)>& f) const
+  {
+    if (framework_ != nullptr) {
+      foreachvalue (const Owned<Task>& task, framework_->unreachableTasks) {
+        f(*task.get());
+      }
+    } else {
+      foreach (const Task* task, tasks_->unreachable) {
+        f(*task);
+      }
+    }
+  }
+
+  void foreachCompletedTask(
+      const lambda::function<void(const Task&)>& f) const
+  {
+    if (framework_ != nullptr) {
+      foreach (const CompactTask& completedTask, framework_->completedTasks) {
+        f(completedTask.materialize());
+      }
+    } else {
+      foreach (const Task* task, tasks_->completed) {
+        f(*task);
+      }
+    }
+  }
+
+  void foreachOffer(const lambda::function<void(const Offer&)>& f) const
+  {
+    if (framework_ != nullptr) {
+      foreach (Offer* offer, framework_->offers) {
+        f(*offer);
+      }
+    } else {
+      foreach (const Offer& offer, snapshotFramework_->offers()) {
+        f(offer);
+      }
+    }
+  }
+
+  // Invokes `f` for each executor and the ID of its agent.
+  void foreachExecutor(
+      const lambda::function<
+          void(const ExecutorInfo&, const SlaveID&)>& f) const
+  {
+    if (framework_ != nullptr) {
+      foreachpair (
+          const SlaveID& slaveId,
+          const auto& executorsMap,
+          framework_->executors) {
+        foreachvalue (const ExecutorInfo& executor, executorsMap) {
+          f(executor, slaveId);
+        }
+      }
+    } else {
+      foreach (const mesos::master::Response::GetExecutors::Executor* executor,
+               tasks_->executors) {
+        f(executor->executor_info(), executor->slave_id());
+      }
+    }
+  }
+
+  const FrameworkInfo& info;
+  Option<string> pid;
+  Resources usedResources;
+  Resources offeredResources;
+  bool active;
+  bool connected;
+  bool recovered;
+  bool multiRole;
+  double registeredTime;
+  double unregisteredTime;
+  Option<double> reregisteredTime;
+
+private:
+  // Exactly one of `framework_` and `snapshotFramework_` is set, the
+  // latter along with the tasks of the framework in the snapshot.
+  const Framework* framework_;
+  const mesos::master::Response::GetFrameworks::Framework* snapshotFramework_;
+  const StateSnapshot::Tasks* tasks_;
+};
+
+
+// The state of an agent that is rendered by the v0 endpoints, see
+// `FrameworkState`.
+struct SlaveState
+{
+  explicit SlaveState(const Slave& slave)
+    : info(slave.info),
+      pid(slave.pid),
+      registeredTime(slave.registeredTime.secs()),
+      totalResources(slave.totalResources),
+      usedResources(Resources::sum(slave.usedResources)),
+      offeredResources(slave.offeredResources),
+      active(slave.active),
+      version(slave.version),
+      capabilities(slave.capabilities.toRepeatedPtrField())
+  {
+    if (slave.reregisteredTime.isSome()) {
+      reregisteredTime = slave.reregisteredTime->secs();
+    }
+  }
+
+  explicit SlaveState(const mesos::master::Response::GetAgents::Agent& agent)
+    : info(agent.agent_info()),
+      pid(agent.pid()),
+      registeredTime(snapshotSecs(agent.registered_time())),
+      totalResources(snapshotResources(agent.total_resources())),
+      usedResources(snapshotResources(agent.allocated_resources())),
+      offeredResources(snapshotResources(agent.offered_resources())),
+      active(agent.active()),
+      version(agent.version()),
+      capabilities(agent.capabilities())
+  {
+    if (agent.has_reregistered_time()) {
+      reregisteredTime = snapshotSecs(agent.reregistered_time());
+    }
+  }
+
+  const SlaveInfo& info;
+  string pid;
+  double registeredTime;
+  Option<double> reregisteredTime;
+  Resources totalResources;
+  Resources usedResources;
+  Resources offeredResources;
+  bool active;
+  string version;
+  RepeatedPtrField<SlaveInfo::Capability> capabilities;
+};
+
+
 // Forward declaration for `FullFrameworkWriter`.
-static void json(JSON::ObjectWriter* writer, const Summary<Framework>& summary);
+static void json(
+    JSON::ObjectWriter* writer,
+    const Summary<FrameworkState>& summary);
 
 
 // Filtered representation of Full<Framework>.
@@ -221,36 +462,35 @@ struct FullFrameworkWriter {
   FullFrameworkWriter(
       const Owned<AuthorizationAcceptor>& authorizeTask,
       const Owned<AuthorizationAcceptor>& authorizeExecutorInfo,
-      const Framework* framework)
+      const FrameworkState& framework)
     : authorizeTask_(authorizeTask),
       authorizeExecutorInfo_(authorizeExecutorInfo),
       framework_(framework) {}
 
   void operator()(JSON::ObjectWriter* writer) const
   {
-    json(writer, Summary<Framework>(*framework_));
+    json(writer, Summary<FrameworkState>(framework_));
 
     // Add additional fields to those generated by the
-    // `Summary<Framework>` overload.
-    writer->field("user", framework_->info.user());
-    writer->field("failover_timeout", framework_->info.failover_timeout());
-    writer->field("checkpoint", framework_->info.checkpoint());
-    writer->field("registered_time", framework_->registeredTime.secs());
-    writer->field("unregistered_time", framework_->unregisteredTime.secs());
-
-    if (framework_->info.has_principal()) {
-      writer->field("principal", framework_->info.principal());
+    // `Summary<FrameworkState>` overload.
+    writer->field("user", framework_.info.user());
+    writer->field("failover_timeout", framework_.info.failover_timeout());
+    writer->field("checkpoint", framework_.info.checkpoint());
+    writer->field("registered_time", framework_.registeredTime);
+    writer->field("unregistered_time", framework_.unregisteredTime);
+
+    if (framework_.info.has_principal()) {
+      writer->field("principal", framework_.info.principal());
     }
 
     // TODO(bmahler): Consider deprecating this in favor of the split
-    // used and offered resources added in `Summary<Framework>`.
+    // used and offered resources added in `Summary<FrameworkState>`.
     writer->field(
         "resources",
-        framework_->totalUsedResources + framework_->totalOfferedResources);
+        framework_.usedResources + framework_.offeredResources);
 
-    // TODO(benh): Consider making reregisteredTime an Option.
-    if (framework_->registeredTime != framework_->reregisteredTime) {
-      writer->field("reregistered_time", framework_->reregisteredTime.secs());
+    if (framework_.reregisteredTime.isSome()) {
+      writer->field("reregistered_time", framework_.reregisteredTime.get());
     }
 
     // For multi-role frameworks the `role` field will be unset.
@@ -258,132 +498,125 @@ struct FullFrameworkWriter {
     // would make tooling simpler (only need to look for `roles`).
     // However, we opted to just mirror the protobuf akin to how
     // generic protobuf -> JSON translation works.
-    if (framework_->capabilities.multiRole) {
-      writer->field("roles", framework_->info.roles());
+    if (framework_.multiRole) {
+      writer->field("roles", framework_.info.roles());
     } else {
-      writer->field("role", framework_->info.role());
+      writer->field("role", framework_.info.role());
     }
 
     // Model all of the tasks associated with a framework.
     writer->field("tasks", [this](JSON::ArrayWriter* writer) {
-      foreachvalue (const TaskInfo& taskInfo, framework_->pendingTasks) {
+      framework_.foreachPendingTask([this, writer](const Task& task) {
         // Skip unauthorized tasks.
-        if (!authorizeTask_->accept(taskInfo, framework_->info)) {
-          continue;
+        if (!authorizeTask_->accept(task, framework_.info)) {
+          return;
         }
 
-        writer->element([this, &taskInfo](JSON::ObjectWriter* writer) {
-          writer->field("id", taskInfo.task_id().value());
-          writer->field("name", taskInfo.name());
-          writer->field("framework_id", framework_->id().value());
-
-          writer->field(
-              "executor_id",
-              taskInfo.executor().executor_id().value());
-
-          writer->field("slave_id", taskInfo.slave_id().value());
+        writer->element([&task](JSON::ObjectWriter* writer) {
+          writer->field("id", task.task_id().value());
+          writer->field("name", task.name());
+          writer->field("framework_id", task.framework_id().value());
+          writer->field("executor_id", task.executor_id().value());
+          writer->field("slave_id", task.slave_id().value());
           writer->field("state", TaskState_Name(TASK_STAGING));
-          writer->field("resources", Resources(taskInfo.resources()));
+          writer->field("resources", Resources(task.resources()));
 
           // Tasks are not allowed to mix resources allocated to
           // different roles, see MESOS-6636.
           writer->field(
               "role",
-              taskInfo.resources().begin()->allocation_info().role());
+              task.resources().begin()->allocation_info().role());
 
           writer->field("statuses", std::initializer_list<TaskStatus>{});
 
-          if (taskInfo.has_labels()) {
-            writer->field("labels", taskInfo.labels());
+          if (task.has_labels()) {
+            writer->field("labels", task.labels());
           }
 
-          if (taskInfo.has_discovery()) {
-            writer->field("discovery", JSON::Protobuf(taskInfo.discovery()));
+          if (task.has_discovery()) {
+            writer->field("discovery", JSON::Protobuf(task.discovery()));
           }
 
-          if (taskInfo.has_container()) {
-            writer->field("container", JSON::Protobuf(taskInfo.container()));
+          if (task.has_container()) {
+            writer->field("container", JSON::Protobuf(task.container()));
           }
         });
-      }
+      });
 
-      foreachvalue (Task* task, framework_->tasks) {
+      framework_.foreachTask([this, writer](const Task& task) {
         // Skip unauthorized tasks.
-        if (!authorizeTask_->accept(*task, framework_->info)) {
-          continue;
+        if (!authorizeTask_->accept(task, framework_.info)) {
+          return;
         }
 
-        writer->element(*task);
-      }
+        writer->element(task);
+      });
     });
 
     writer->field("unreachable_tasks", [this](JSON::ArrayWriter* writer) {
-      foreachvalue (const Owned<Task>& task, framework_->unreachableTasks) {
+      framework_.foreachUnreachableTask([this, writer](const Task& task) {
         // Skip unauthorized tasks.
-        if (!authorizeTask_->accept(*task.get(), framework_->info)) {
-          continue;
+        if (!authorizeTask_->accept(task, framework_.info)) {
+          return;
         }
 
-        writer->element(*task.get());
-      }
+        writer->element(task);
+      });
     });
 
     writer->field("completed_tasks", [this](JSON::ArrayWriter* writer) {
-      foreach (const Owned<Task>& task, framework_->completedTasks) {
+      framework_.foreachCompletedTask([this, writer](const Task& task) {
         // Skip unauthorized tasks.
-        if (!authorizeTask_->accept(*task.get(), framework_->info)) {
-          continue;
+        if (!authorizeTask_->accept(task, framework_.info)) {
+          return;
         }
 
-        writer->element(*task.get());
-      }
+        writer->element(task);
+      });
     });
 
     // Model all of the offers associated with a framework.
     writer->field("offers", [this](JSON::ArrayWriter* writer) {
-      foreach (Offer* offer, framework_->offers) {
-        writer->element(*offer);
-      }
+      framework_.foreachOffer([writer](const Offer& offer) {
+        writer->element(offer);
+      });
     });
 
     // Model all of the executors of a framework.
     writer->field("executors", [this](JSON::ArrayWriter* writer) {
-      foreachpair (
-          const SlaveID& slaveId,
-          const auto& executorsMap,
-          framework_->executors) {
-        foreachvalue (const ExecutorInfo& executor, executorsMap) {
-          writer->element([this,
-                           &executor,
-                           &slaveId](JSON::ObjectWriter* writer) {
-            // Skip unauthorized executors.
-            if (!authorizeExecutorInfo_->accept(executor, framework_->info)) {
-              return;
-            }
+      framework_.foreachExecutor([this, writer](
+          const ExecutorInfo& executor,
+          const SlaveID& slaveId) {
+        writer->element([this,
+                         &executor,
+                         &slaveId](JSON::ObjectWriter* writer) {
+          // Skip unauthorized executors.
+          if (!authorizeExecutorInfo_->accept(executor, framework_.info)) {
+            return;
+          }
 
-            json(writer, executor);
-            writer->field("slave_id", slaveId.value());
-          });
-        }
-      }
+          json(writer, executor);
+          writer->field("slave_id", slaveId.value());
+        });
+      });
     });
 
     // Model all of the labels associated with a framework.
-    if (framework_->info.has_labels()) {
-      writer->field("labels", framework_->info.labels());
+    if (framework_.info.has_labels()) {
+      writer->field("labels", framework_.info.labels());
     }
   }
 
   const Owned<AuthorizationAcceptor>& authorizeTask_;
   const Owned<AuthorizationAcceptor>& authorizeExecutorInfo_;
-  const Framework* framework_;
+  const FrameworkState& framework_;
 };
 
 
 struct SlaveWriter
 {
   SlaveWriter(
-      const Slave& slave,
+      const SlaveState& slave,
       const Owned<AuthorizationAcceptor>& authorizeRole)
     : slave_(slave), authorizeRole_(authorizeRole) {}
 
@@ -391,16 +624,16 @@ struct SlaveWriter
   {
     json(writer, slave_.info);
 
-    writer->field("pid", string(slave_.pid));
-    writer->field("registered_time", slave_.registeredTime.secs());
+    writer->field("pid", slave_.pid);
+    writer->field("registered_time", slave_.registeredTime);
 
     if (slave_.reregisteredTime.isSome()) {
-      writer->field("reregistered_time", slave_.reregisteredTime.get().secs());
+      writer->field("reregistered_time", slave_.reregisteredTime.get());
     }
 
     const Resources& totalResources = slave_.totalResources;
     writer->field("resources", totalResources);
-    writer->field("used_resources", Resources::sum(slave_.usedResources));
+    writer->field("used_resources", slave_.usedResources);
     writer->field("offered_resources", slave_.offeredResources);
     writer->field(
         "reserved_resources",
@@ -419,14 +652,88 @@ struct SlaveWriter
 
     writer->field("active", slave_.active);
     writer->field("version", slave_.version);
-    writer->field("capabilities", slave_.capabilities.toRepeatedPtrField());
+    writer->field("capabilities", slave_.capabilities);
   }
 
-  const Slave& slave_;
+  const SlaveState& slave_;
   const Owned<AuthorizationAcceptor>& authorizeRole_;
 };
 
 
+// Adds the complete protobuf->JSON for all used, reserved, and
+// offered resources of an agent to the `/slaves` endpoint. The other
+// endpoints summarize resource information, which omits the details
+// of reservations and persistent volumes. Full resource information
+// is necessary so that operators can use the `/unreserve` and
+// `/destroy-volumes` endpoints.
+static void writeSlaveResourcesFull(
+    JSON::ObjectWriter* writer,
+    const SlaveState& slave,
+    const Owned<AuthorizationAcceptor>& authorizeRole)
+{
+  hashmap<string, Resources> reserved = slave.totalResources.reservations();
+
+  writer->field(
+      "reserved_resources_full",
+      [&reserved, &authorizeRole](JSON::ObjectWriter* writer) {
+        foreachpair (const string& role,
+                     const Resources& resources,
+                     reserved) {
+          if (authorizeRole->accept(role)) {
+            writer->field(role, [&resources, &authorizeRole](
+                JSON::ArrayWriter* writer) {
+              foreach (Resource resource, resources) {
+                if (authorizeResource(resource, authorizeRole)) {
+                  convertResourceFormat(&resource, ENDPOINT);
+                  writer->element(JSON::Protobuf(resource));
+                }
+              }
+            });
+          }
+        }
+      });
+
+  Resources unreservedResources = slave.totalResources.unreserved();
+
+  writer->field(
+      "unreserved_resources_full",
+      [&unreservedResources, &authorizeRole](JSON::ArrayWriter* writer) {
+        foreach (Resource resource, unreservedResources) {
+          if (authorizeResource(resource, authorizeRole)) {
+            convertResourceFormat(&resource, ENDPOINT);
+            writer->element(JSON::Protobuf(resource));
+          }
+        }
+      });
+
+  const Resources& usedResources = slave.usedResources;
+
+  writer->field(
+      "used_resources_full",
+      [&usedResources, &authorizeRole](JSON::ArrayWriter* writer) {
+        foreach (Resource resource, usedResources) {
+          if (authorizeResource(resource, authorizeRole)) {
+            convertResourceFormat(&resource, ENDPOINT);
+            writer->element(JSON::Protobuf(resource));
+          }
+        }
+      });
+
+  const Resources& offeredResources = slave.offeredResources;
+
+  writer->field(
+      "offered_resources_full",
+      [&offeredResources, &authorizeRole](JSON::ArrayWriter* writer) {
+        foreach (Resource resource, offeredResources) {
+          if (authorizeResource(resource, authorizeRole)) {
+            convertResourceFormat(&resource, ENDPOINT);
+            writer->element(JSON::Protobuf(resource));
+          }
+        }
+      });
+}
+
+
 struct SlavesWriter
 {
   SlavesWriter(
@@ -466,75 +773,10 @@ struct SlavesWriter
 
   void writeSlave(const Slave* slave, JSON::ObjectWriter* writer) const
   {
-    SlaveWriter(*slave, authorizeRole_)(writer);
-
-    // Add the complete protobuf->JSON for all used, reserved,
-    // and offered resources. The other endpoints summarize
-    // resource information, which omits the details of
-    // reservations and persistent volumes. Full resource
-    // information is necessary so that operators can use the
-    // `/unreserve` and `/destroy-volumes` endpoints.
-
-    hashmap<string, Resources> reserved = slave->totalResources.reservations();
+    const SlaveState state(*slave);
 
-    writer->field(
-        "reserved_resources_full",
-        [&reserved, this](JSON::ObjectWriter* writer) {
-          foreachpair (const string& role,
-                       const Resources& resources,
-                       reserved) {
-            if (authorizeRole_->accept(role)) {
-              writer->field(role, [&resources, this](
-                  JSON::ArrayWriter* writer) {
-                foreach (Resource resource, resources) {
-                  if (authorizeResource(resource, authorizeRole_)) {
-                    convertResourceFormat(&resource, ENDPOINT);
-                    writer->element(JSON::Protobuf(resource));
-                  }
-                }
-              });
-            }
-          }
-        });
-
-    Resources unreservedResources = slave->totalResources.unreserved();
-
-    writer->field(
-        "unreserved_resources_full",
-        [&unreservedResources, this](JSON::ArrayWriter* writer) {
-          foreach (Resource resource, unreservedResources) {
-            if (authorizeResource(resource, authorizeRole_)) {
-              convertResourceFormat(&resource, ENDPOINT);
-              writer->element(JSON::Protobuf(resource));
-            }
-          }
-        });
-
-    Resources usedResources = Resources::sum(slave->usedResources);
-
-    writer->field(
-        "used_resources_full",
-        [&usedResources, this](JSON::ArrayWriter* writer) {
-          foreach (Resource resource, usedResources) {
-            if (authorizeResource(resource, authorizeRole_)) {
-              convertResourceFormat(&resource, ENDPOINT);
-              writer->element(JSON::Protobuf(resource));
-            }
-          }
-        });
-
-    const Resources& offeredResources = slave->offeredResources;
-
-    writer->field(
-        "offered_resources_full",
-        [&offeredResources, this](JSON::ArrayWriter* writer) {
-          foreach (Resource resource, offeredResources) {
-            if (authorizeResource(resource, authorizeRole_)) {
-              convertResourceFormat(&resource, ENDPOINT);
-              writer->element(JSON::Protobuf(resource));
-            }
-          }
-        });
+    SlaveWriter(state, authorizeRole_)(writer);
+    writeSlaveResourcesFull(writer, state, authorizeRole_);
   }
 
   const Master::Slaves& slaves_;
@@ -543,27 +785,29 @@ struct SlavesWriter
 };
 
 
-static void json(JSON::ObjectWriter* writer, const Summary<Framework>& summary)
+static void json(
+    JSON::ObjectWriter* writer,
+    const Summary<FrameworkState>& summary)
 {
-  const Framework& framework = summary;
+  const FrameworkState& framework = summary;
 
-  writer->field("id", framework.id().value());
+  writer->field("id", framework.info.id().value());
   writer->field("name", framework.info.name());
 
   // Omit pid for http frameworks.
   if (framework.pid.isSome()) {
-    writer->field("pid", string(framework.pid.get()));
+    writer->field("pid", framework.pid.get());
   }
 
   // TODO(bmahler): Use these in the webui.
-  writer->field("used_resources", framework.totalUsedResources);
-  writer->field("offered_resources", framework.totalOfferedResources);
+  writer->field("used_resources", framework.usedResources);
+  writer->field("offered_resources", framework.offeredResources);
   writer->field("capabilities", framework.info.capabilities());
   writer->field("hostname", framework.info.hostname());
   writer->field("webui_url", framework.info.webui_url());
-  writer->field("active", framework.active());
-  writer->field("connected", framework.connected());
-  writer->field("recovered", framework.recovered());
+  writer->field("active", framework.active);
+  writer->field("connected", framework.connected);
+  writer->field("recovered", framework.recovered);
 }
 
 
@@ -712,7 +956,12 @@ Future<Response> Master::Http::api(
       return readFile(call, principal, acceptType);
 
     case mesos::master::Call::GET_STATE:
-      return getState(call, principal, acceptType);
+      return master->cached(
+          "GET_STATE " + stringify(acceptType),
+          principal,
+          [this, call, principal, acceptType]() {
+            return getState(call, principal, acceptType);
+          });
 
     case mesos::master::Call::GET_AGENTS:
       return getAgents(call, principal, acceptType);
@@ -1549,6 +1798,89 @@ Future<Response> Master::Http::frameworks(
   Future<IDAcceptor<FrameworkID>> selectFrameworkId =
     IDAcceptor<FrameworkID>(request.url.query.get("framework_id"));
 
+  if (master->stateView.isSome()) {
+    const Owned<StateView>& stateView = master->stateView.get();
+    Option<string> jsonp = request.url.query.get("jsonp");
+
+    return collect(
+        authorizeFrameworkInfo,
+        authorizeTask,
+        authorizeExecutorInfo,
+        selectFrameworkId)
+      .then([=](const tuple<Owned<AuthorizationAcceptor>,
+                            Owned<AuthorizationAcceptor>,
+                            Owned<AuthorizationAcceptor>,
+                            IDAcceptor<FrameworkID>>& acceptors) {
+        return stateView->read([=](const StateSnapshot& snapshot) {
+          auto frameworks = [&snapshot, &acceptors](
+              JSON::ObjectWriter* writer) {
+            Owned<AuthorizationAcceptor> authorizeFrameworkInfo;
+            Owned<AuthorizationAcceptor> authorizeTask;
+            Owned<AuthorizationAcceptor> authorizeExecutorInfo;
+            IDAcceptor<FrameworkID> selectFrameworkId;
+            tie(authorizeFrameworkInfo,
+                authorizeTask,
+                authorizeExecutorInfo,
+                selectFrameworkId) = acceptors;
+
+            // Model all of the frameworks and completed frameworks.
+            auto write = [&snapshot,
+                          &authorizeFrameworkInfo,
+                          &authorizeTask,
+                          &authorizeExecutorInfo,
+                          &selectFrameworkId](
+                const RepeatedPtrField<
+                    mesos::master::Response::GetFrameworks::Framework>&
+                  frameworks,
+                JSON::ArrayWriter* writer) {
+              foreach (const mesos::master::Response::GetFrameworks::
+                         Framework& framework,
+                       frameworks) {
+                const FrameworkInfo& frameworkInfo =
+                  framework.framework_info();
+
+                // Skip unauthorized frameworks or frameworks without a
+                // matching ID.
+                if (!selectFrameworkId.accept(frameworkInfo.id()) ||
+                    !authorizeFrameworkInfo->accept(frameworkInfo)) {
+                  continue;
+                }
+
+                const FrameworkState frameworkState(snapshot, framework);
+
+                writer->element(FullFrameworkWriter(
+                    authorizeTask,
+                    authorizeExecutorInfo,
+                    frameworkState));
+              }
+            };
+
+            writer->field(
+                "frameworks",
+                [&snapshot, &write](JSON::ArrayWriter* writer) {
+                  write(snapshot.state.get_frameworks().frameworks(), writer);
+                });
+
+            writer->field(
+                "completed_frameworks",
+                [&snapshot, &write](JSON::ArrayWriter* writer) {
+                  write(
+                      snapshot.state.get_frameworks().completed_frameworks(),
+                      writer);
+                });
+
+            // Unregistered frameworks are no longer possible. We emit an
+            // empty array for the sake of backward compatibility.
+            writer->field(
+                "unregistered_frameworks",
+                [](JSON::ArrayWriter*) {});
+          };
+
+          return OK(jsonify(frameworks), jsonp);
+        });
+      });
+  }
+
   return collect(
       authorizeFrameworkInfo,
       authorizeTask,
@@ -1587,10 +1919,12 @@ Future<Response> Master::Http::frameworks(
               continue;
             }
 
+            const FrameworkState frameworkState(*framework);
+
             FullFrameworkWriter frameworkWriter(
                 authorizeTask,
                 authorizeExecutorInfo,
-                framework);
+                frameworkState);
 
             writer->element(frameworkWriter);
           }
@@ -1612,10 +1946,12 @@ Future<Response> Master::Http::frameworks(
               continue;
             }
 
+            const FrameworkState frameworkState(*framework);
+
             FullFrameworkWriter frameworkWriter(
                 authorizeTask,
                 authorizeExecutorInfo,
-                framework.get());
+                frameworkState);
 
             writer->element(frameworkWriter);
           }
@@ -1681,6 +2017,168 @@ mesos::master::Response::GetFrameworks::Framework model(
 }
 
 
+// Helpers for serving the read-only operator API calls from a state
+// snapshot (see `StateView`). They filter the unfiltered state of the
+// snapshot in the same way as `_getFrameworks()`, `_getTasks()`,
+// `_getExecutors()` and `_getAgents()` filter the state of the master.
+
+// Returns the frameworks of the snapshot that may be viewed.
+static hashmap<FrameworkID, const FrameworkInfo*> approvedFrameworks(
+    const StateSnapshot& snapshot,
+    const Owned<ObjectApprover>& frameworksApprover)
+{
+  hashmap<FrameworkID, const FrameworkInfo*> frameworks;
+
+  foreachpair (const FrameworkID& frameworkId,
+               const FrameworkInfo& frameworkInfo,
+               snapshot.frameworks) {
+    if (approveViewFrameworkInfo(frameworksApprover, frameworkInfo)) {
+      frameworks.put(frameworkId, &frameworkInfo);
+    }
+  }
+
+  return frameworks;
+}
+
+
+static mesos::master::Response::GetFrameworks filterFrameworks(
+    const StateSnapshot& snapshot,
+    const Owned<ObjectApprover>& frameworksApprover)
+{
+  typedef mesos::master::Response::GetFrameworks::Framework Framework;
+
+  const mesos::master::Response::GetFrameworks& frameworks =
+    snapshot.state.get_frameworks();
+
+  mesos::master::Response::GetFrameworks getFrameworks;
+
+  foreach (const Framework& framework, frameworks.frameworks()) {
+    if (approveViewFrameworkInfo(
+            frameworksApprover, framework.framework_info())) {
+      getFrameworks.add_frameworks()->CopyFrom(framework);
+    }
+  }
+
+  foreach (const Framework& framework, frameworks.completed_frameworks()) {
+    if (approveViewFrameworkInfo(
+            frameworksApprover, framework.framework_info())) {
+      getFrameworks.add_completed_frameworks()->CopyFrom(framework);
+    }
+  }
+
+  return getFrameworks;
+}
+
+
+static mesos::master::Response::GetTasks filterTasks(
+    const StateSnapshot& snapshot,
+    const Owned<ObjectApprover>& frameworksApprover,
+    const Owned<ObjectApprover>& tasksApprover)
+{
+  const hashmap<FrameworkID, const FrameworkInfo*> frameworks =
+    approvedFrameworks(snapshot, frameworksApprover);
+
+  auto filter = [&](
+      const RepeatedPtrField<Task>& tasks,
+      RepeatedPtrField<Task>* approved) {
+    foreach (const Task& task, tasks) {
+      // Skip unauthorized frameworks and tasks.
+      if (!frameworks.contains(task.framework_id()) ||
+          !approveViewTask(
+              tasksApprover, task, *frameworks.at(task.framework_id()))) {
+        continue;
+      }
+
+      approved->Add()->CopyFrom(task);
+    }
+  };
+
+  const mesos::master::Response::GetTasks& tasks = snapshot.state.get_tasks();
+
+  mesos::master::Response::GetTasks getTasks;
+
+  filter(tasks.pending_tasks(), getTasks.mutable_pending_tasks());
+  filter(tasks.tasks(), getTasks.mutable_tasks());
+  filter(tasks.unreachable_tasks(), getTasks.mutable_unreachable_tasks());
+  filter(tasks.completed_tasks(), getTasks.mutable_completed_tasks());
+
+  return getTasks;
+}
+
+
+static mesos::master::Response::GetExecutors filterExecutors(
+    const StateSnapshot& snapshot,
+    const Owned<ObjectApprover>& frameworksApprover,
+    const Owned<ObjectApprover>& executorsApprover)
+{
+  typedef mesos::master::Response::GetExecutors::Executor Executor;
+
+  const hashmap<FrameworkID, const FrameworkInfo*> frameworks =
+    approvedFrameworks(snapshot, frameworksApprover);
+
+  mesos::master::Response::GetExecutors getExecutors;
+
+  foreach (const Executor& executor,
+           snapshot.state.get_executors().executors()) {
+    const FrameworkID& frameworkId = executor.executor_info().framework_id();
+
+    // Skip unauthorized frameworks and executors.
+    if (!frameworks.contains(frameworkId) ||
+        !approveViewExecutorInfo(
+            executorsApprover,
+            executor.executor_info(),
+            *frameworks.at(frameworkId))) {
+      continue;
+    }
+
+    getExecutors.add_executors()->CopyFrom(executor);
+  }
+
+  return getExecutors;
+}
+
+
+// Removes the resources that are reserved or allocated to roles which
+// may not be viewed.
+static void filterResources(
+    RepeatedPtrField<Resource>* resources,
+    const Owned<AuthorizationAcceptor>& rolesAcceptor)
+{
+  RepeatedPtrField<Resource> approved;
+
+  foreach (Resource& resource, *resources) {
+    if (authorizeResource(resource, rolesAcceptor)) {
+      approved.Add()->Swap(&resource);
+    }
+  }
+
+  resources->Swap(&approved);
+}
+
+
+static mesos::master::Response::GetAgents filterAgents(
+    const StateSnapshot& snapshot,
+    const Owned<AuthorizationAcceptor>& rolesAcceptor)
+{
+  mesos::master::Response::GetAgents getAgents = snapshot.state.get_agents();
+
+  foreach (mesos::master::Response::GetAgents::Agent& agent,
+           *getAgents.mutable_agents()) {
+    filterResources(
+        agent.mutable_agent_info()->mutable_resources(), rolesAcceptor);
+    filterResources(agent.mutable_total_resources(), rolesAcceptor);
+    filterResources(agent.mutable_allocated_resources(), rolesAcceptor);
+    filterResources(agent.mutable_offered_resources(), rolesAcceptor);
+  }
+
+  foreach (SlaveInfo& agent, *getAgents.mutable_recovered_agents()) {
+    filterResources(agent.mutable_resources(), rolesAcceptor);
+  }
+
+  return getAgents;
+}
+
+
 Future<Response> Master::Http::getFrameworks(
     const mesos::master::Call& call,
     const Option<Principal>& principal,
@@ -1700,6 +2198,23 @@ Future<Response> Master::Http::getFrameworks(
     frameworksApprover = Owned<ObjectApprover>(new AcceptingObjectApprover());
   }
 
+  if (master->stateView.isSome()) {
+    const Owned<StateView>& stateView = master->stateView.get();
+
+    return frameworksApprover
+      .then([=](const Owned<ObjectApprover>& frameworksApprover) {
+        return stateView->read([=](const StateSnapshot& snapshot) {
+          mesos::master::Response response;
+          response.set_type(mesos::master::Response::GET_FRAMEWORKS);
+          response.mutable_get_frameworks()->CopyFrom(
+              filterFrameworks(snapshot, frameworksApprover));
+
+          return OK(serialize(contentType, evolve(response)),
+                    stringify(contentType));
+        });
+      });
+  }
+
   return frameworksApprover
     .then(defer(master->self(),
         [=](const Owned<ObjectApprover>& frameworksApprover)
@@ -1766,6 +2281,30 @@ Future<Response> Master::Http::getExecutors(
     executorsApprover = Owned<ObjectApprover>(new AcceptingObjectApprover());
   }
 
+  if (master->stateView.isSome()) {
+    const Owned<StateView>& stateView = master->stateView.get();
+
+    return collect(frameworksApprover, executorsApprover)
+      .then([=](const tuple<Owned<ObjectApprover>,
+                            Owned<ObjectApprover>>& approvers) {
+        return stateView->read([=](const StateSnapshot& snapshot) {
+          // Get approver from tuple.
+          Owned<ObjectApprover> frameworksApprover;
+          Owned<ObjectApprover> executorsApprover;
+          tie(frameworksApprover, executorsApprover) = approvers;
+
+          mesos::master::Response response;
+          response.set_type(mesos::master::Response::GET_EXECUTORS);
+          response.mutable_get_executors()->CopyFrom(
+              filterExecutors(
+                  snapshot, frameworksApprover, executorsApprover));
+
+          return OK(serialize(contentType, evolve(response)),
+                    stringify(contentType));
+        });
+      });
+  }
+
   return collect(frameworksApprover, executorsApprover)
     .then(defer(master->self(),
         [=](const tuple<Owned<ObjectApprover>,
@@ -1874,6 +2413,51 @@ Future<Response> Master::Http::getState(
         master->authorizer,
         authorization::VIEW_ROLE);
 
+  if (master->stateView.isSome()) {
+    const Owned<StateView>& stateView = master->stateView.get();
+
+    return collect(
+        frameworksApprover, tasksApprover, executorsApprover, rolesAcceptor)
+      .then([=](const tuple<Owned<ObjectApprover>,
+                            Owned<ObjectApprover>,
+                            Owned<ObjectApprover>,
+                            Owned<AuthorizationAcceptor>>& approvers) {
+        return stateView->read([=](const StateSnapshot& snapshot) {
+          // Get approver from tuple.
+          Owned<ObjectApprover> frameworksApprover;
+          Owned<ObjectApprover> tasksApprover;
+          Owned<ObjectApprover> executorsApprover;
+          Owned<AuthorizationAcceptor> rolesAcceptor;
+          tie(frameworksApprover,
+              tasksApprover,
+              executorsApprover,
+              rolesAcceptor) = approvers;
+
+          mesos::master::Response response;
+          response.set_type(mesos::master::Response::GET_STATE);
+
+          mesos::master::Response::GetState* getState =
+            response.mutable_get_state();
+
+          getState->mutable_get_tasks()->CopyFrom(
+              filterTasks(snapshot, frameworksApprover, tasksApprover));
+
+          getState->mutable_get_executors()->CopyFrom(
+              filterExecutors(
+                  snapshot, frameworksApprover, executorsApprover));
+
+          getState->mutable_get_frameworks()->CopyFrom(
+              filterFrameworks(snapshot, frameworksApprover));
+
+          getState->mutable_get_agents()->CopyFrom(
+              filterAgents(snapshot, rolesAcceptor));
+
+          return OK(
+              serialize(contentType, evolve(response)), stringify(contentType));
+        });
+      });
+  }
+
   return collect(
       frameworksApprover, tasksApprover, executorsApprover, rolesAcceptor)
     .then(defer(master->self(),
@@ -1929,9 +2513,60 @@ mesos::master::Response::GetState Master::Http::_getState(
   getState.mutable_get_frameworks()->CopyFrom(
       _getFrameworks(frameworksApprover));
 
-  getState.mutable_get_agents()->CopyFrom(_getAgents(rolesAcceptor));
+  getState.mutable_get_agents()->CopyFrom(_getAgents(rolesAcceptor));
+
+  return getState;
+}
+
+
+shared_ptr<StateSnapshot> Master::Http::snapshot() const
+{
+  Owned<ObjectApprover> approver(new AcceptingObjectApprover());
+
+  // Without an authorizer, the acceptor accepts all roles.
+  Future<Owned<AuthorizationAcceptor>> rolesAcceptor =
+    AuthorizationAcceptor::create(None(), None(), authorization::VIEW_ROLE);
+
+  CHECK_READY(rolesAcceptor);
+
+  mesos::master::Response::GetState state =
+    _getState(approver, approver, approver, rolesAcceptor.get());
+
+  shared_ptr<StateSnapshot> snapshot(new StateSnapshot());
+  snapshot->time = Clock::now();
+  snapshot->state.Swap(&state);
+
+  snapshot->info = master->info();
+  snapshot->pid = string(master->self());
+  snapshot->startTime = master->startTime;
+  snapshot->electedTime = master->electedTime;
+  snapshot->leader = master->leader;
+  snapshot->unreachableAgents = master->slaves.unreachable.size();
+  snapshot->cluster = master->flags.cluster;
+  snapshot->logDir = master->flags.log_dir;
+  snapshot->externalLogFile = master->flags.external_log_file;
+
+  foreachvalue (const flags::Flag& flag, master->flags) {
+    Option<string> value = flag.stringify(master->flags);
+    if (value.isSome()) {
+      snapshot->flags[flag.effective_name().value] = value.get();
+    }
+  }
+
+  foreachvalue (const Framework* framework, master->frameworks.registered) {
+    if (framework->pid.isSome()) {
+      snapshot->frameworkPids[framework->id()] = string(framework->pid.get());
+    }
+  }
+
+  foreachvalue (const Owned<Framework>& framework,
+                master->frameworks.completed) {
+    if (framework->pid.isSome()) {
+      snapshot->frameworkPids[framework->id()] = string(framework->pid.get());
+    }
+  }
 
-  return getState;
+  return snapshot;
 }
 
 
@@ -2521,6 +3156,64 @@ Future<Response> Master::Http::slaves(
   Master* master = this->master;
   Option<string> jsonp = request.url.query.get("jsonp");
 
+  if (master->stateView.isSome()) {
+    const Owned<StateView>& stateView = master->stateView.get();
+
+    return collect(authorizeRole, selectSlaveId)
+      .then([=](const tuple<Owned<AuthorizationAcceptor>,
+                            IDAcceptor<SlaveID>>& acceptors) {
+        return stateView->read([=](const StateSnapshot& snapshot) {
+          auto slaves = [&snapshot, &acceptors](JSON::ObjectWriter* writer) {
+            Owned<AuthorizationAcceptor> authorizeRole;
+            IDAcceptor<SlaveID> selectSlaveId;
+            tie(authorizeRole, selectSlaveId) = acceptors;
+
+            const mesos::master::Response::GetAgents& agents =
+              snapshot.state.get_agents();
+
+            writer->field(
+                "slaves",
+                [&agents,
+                 &authorizeRole,
+                 &selectSlaveId](JSON::ArrayWriter* writer) {
+                  foreach (const mesos::master::Response::GetAgents::Agent&
+                             agent,
+                           agents.agents()) {
+                    if (!selectSlaveId.accept(agent.agent_info().id())) {
+                      continue;
+                    }
+
+                    writer->element(
+                        [&agent, &authorizeRole](JSON::ObjectWriter* writer) {
+                          const SlaveState state(agent);
+
+                          SlaveWriter(state, authorizeRole)(writer);
+                          writeSlaveResourcesFull(writer, state, authorizeRole);
+                        });
+                  }
+                });
+
+            writer->field(
+                "recovered_slaves",
+                [&agents, &selectSlaveId](JSON::ArrayWriter* writer) {
+                  foreach (const SlaveInfo& slaveInfo,
+                           agents.recovered_agents()) {
+                    if (!selectSlaveId.accept(slaveInfo.id())) {
+                      continue;
+                    }
+
+                    writer->element([&slaveInfo](JSON::ObjectWriter* writer) {
+                      json(writer, slaveInfo);
+                    });
+                  }
+                });
+          };
+
+          return OK(jsonify(slaves), jsonp);
+        });
+      });
+  }
+
   return collect(authorizeRole, selectSlaveId)
     .then(defer(master->self(),
         [master, jsonp](const tuple<Owned<AuthorizationAcceptor>,
@@ -2544,6 +3237,26 @@ Future<process::http::Response> Master::Http::getAgents(
 {
   CHECK_EQ(mesos::master::Call::GET_AGENTS, call.type());
 
+  if (master->stateView.isSome()) {
+    const Owned<StateView>& stateView = master->stateView.get();
+
+    return AuthorizationAcceptor::create(
+        principal,
+        master->authorizer,
+        authorization::VIEW_ROLE)
+      .then([=](const Owned<AuthorizationAcceptor>& rolesAcceptor) {
+        return stateView->read([=](const StateSnapshot& snapshot) {
+          mesos::master::Response response;
+          response.set_type(mesos::master::Response::GET_AGENTS);
+          response.mutable_get_agents()->CopyFrom(
+              filterAgents(snapshot, rolesAcceptor));
+
+          return OK(serialize(contentType, evolve(response)),
+                    stringify(contentType));
+        });
+      });
+  }
+
   return AuthorizationAcceptor::create(
       principal,
       master->authorizer,
@@ -2845,6 +3558,199 @@ Future<Response> Master::Http::state(
     AuthorizationAcceptor::create(
         principal, master->authorizer, authorization::VIEW_FLAGS);
 
+  if (master->stateView.isSome()) {
+    const Owned<StateView>& stateView = master->stateView.get();
+    Option<string> jsonp = request.url.query.get("jsonp");
+
+    return collect(
+        authorizeRole,
+        authorizeFrameworkInfo,
+        authorizeTask,
+        authorizeExecutorInfo,
+        authorizeFlags)
+      .then([=](const tuple<Owned<AuthorizationAcceptor>,
+                            Owned<AuthorizationAcceptor>,
+                            Owned<AuthorizationAcceptor>,
+                            Owned<AuthorizationAcceptor>,
+                            Owned<AuthorizationAcceptor>>& acceptors) {
+        return stateView->read([=](const StateSnapshot& snapshot) {
+          auto state = [&snapshot, &acceptors](JSON::ObjectWriter* writer) {
+            Owned<AuthorizationAcceptor> authorizeRole;
+            Owned<AuthorizationAcceptor> authorizeFrameworkInfo;
+            Owned<AuthorizationAcceptor> authorizeTask;
+            Owned<AuthorizationAcceptor> authorizeExecutorInfo;
+            Owned<AuthorizationAcceptor> authorizeFlags;
+            tie(authorizeRole,
+                authorizeFrameworkInfo,
+                authorizeTask,
+                authorizeExecutorInfo,
+                authorizeFlags) = acceptors;
+
+            const mesos::master::Response::GetAgents& agents =
+              snapshot.state.get_agents();
+
+            writer->field("version", MESOS_VERSION);
+
+            if (build::GIT_SHA.isSome()) {
+              writer->field("git_sha", build::GIT_SHA.get());
+            }
+
+            if (build::GIT_BRANCH.isSome()) {
+              writer->field("git_branch", build::GIT_BRANCH.get());
+            }
+
+            if (build::GIT_TAG.isSome()) {
+              writer->field("git_tag", build::GIT_TAG.get());
+            }
+
+            writer->field("build_date", build::DATE);
+            writer->field("build_time", build::TIME);
+            writer->field("build_user", build::USER);
+            writer->field("start_time", snapshot.startTime.secs());
+
+            if (snapshot.electedTime.isSome()) {
+              writer->field("elected_time", snapshot.electedTime->secs());
+            }
+
+            // Like the master metrics, the agent counts are doubles.
+            double activeAgents = 0.0;
+            foreach (const mesos::master::Response::GetAgents::Agent& agent,
+                     agents.agents()) {
+              if (agent.active()) {
+                activeAgents++;
+              }
+            }
+
+            writer->field("id", snapshot.info.id());
+            writer->field("pid", snapshot.pid);
+            writer->field("hostname", snapshot.info.hostname());
+            writer->field("activated_slaves", activeAgents);
+            writer->field(
+                "deactivated_slaves",
+                agents.agents_size() - activeAgents);
+            writer->field(
+                "unreachable_slaves",
+                static_cast<double>(snapshot.unreachableAgents));
+
+            if (snapshot.info.has_domain()) {
+              writer->field("domain", snapshot.info.domain());
+            }
+
+            // TODO(haosdent): Deprecated this in favor of `leader_info`
+            // below.
+            if (snapshot.leader.isSome()) {
+              writer->field("leader", snapshot.leader->pid());
+            }
+
+            if (snapshot.leader.isSome()) {
+              writer->field(
+                  "leader_info",
+                  [&snapshot](JSON::ObjectWriter* writer) {
+                    json(writer, snapshot.leader.get());
+                  });
+            }
+
+            if (authorizeFlags->accept()) {
+              if (snapshot.cluster.isSome()) {
+                writer->field("cluster", snapshot.cluster.get());
+              }
+
+              if (snapshot.logDir.isSome()) {
+                writer->field("log_dir", snapshot.logDir.get());
+              }
+
+              if (snapshot.externalLogFile.isSome()) {
+                writer->field(
+                    "external_log_file",
+                    snapshot.externalLogFile.get());
+              }
+
+              writer->field("flags", snapshot.flags);
+            }
+
+            // Model all of the registered slaves.
+            writer->field(
+                "slaves",
+                [&agents, &authorizeRole](JSON::ArrayWriter* writer) {
+                  foreach (const mesos::master::Response::GetAgents::Agent&
+                             agent,
+                           agents.agents()) {
+                    writer->element(
+                        SlaveWriter(SlaveState(agent), authorizeRole));
+                  }
+                });
+
+            // Model all of the recovered slaves.
+            writer->field(
+                "recovered_slaves",
+                [&agents](JSON::ArrayWriter* writer) {
+                  foreach (const SlaveInfo& slaveInfo,
+                           agents.recovered_agents()) {
+                    writer->element([&slaveInfo](JSON::ObjectWriter* writer) {
+                      json(writer, slaveInfo);
+                    });
+                  }
+                });
+
+            // Model all of the frameworks and completed frameworks.
+            auto frameworks = [&snapshot,
+                               &authorizeFrameworkInfo,
+                               &authorizeTask,
+                               &authorizeExecutorInfo](
+                const RepeatedPtrField<
+                    mesos::master::Response::GetFrameworks::Framework>&
+                  frameworks,
+                JSON::ArrayWriter* writer) {
+              foreach (const mesos::master::Response::GetFrameworks::
+                         Framework& framework,
+                       frameworks) {
+                // Skip unauthorized frameworks.
+                if (!authorizeFrameworkInfo->accept(
+                        framework.framework_info())) {
+                  continue;
+                }
+
+                const FrameworkState frameworkState(snapshot, framework);
+
+                writer->element(FullFrameworkWriter(
+                    authorizeTask,
+                    authorizeExecutorInfo,
+                    frameworkState));
+              }
+            };
+
+            writer->field(
+                "frameworks",
+                [&snapshot, &frameworks](JSON::ArrayWriter* writer) {
+                  frameworks(
+                      snapshot.state.get_frameworks().frameworks(),
+                      writer);
+                });
+
+            writer->field(
+                "completed_frameworks",
+                [&snapshot, &frameworks](JSON::ArrayWriter* writer) {
+                  frameworks(
+                      snapshot.state.get_frameworks().completed_frameworks(),
+                      writer);
+                });
+
+            // Orphan tasks are no longer possible. We emit an empty array
+            // for the sake of backward compatibility.
+            writer->field("orphan_tasks", [](JSON::ArrayWriter*) {});
+
+            // Unregistered frameworks are no longer possible. We emit an
+            // empty array for the sake of backward compatibility.
+            writer->field(
+                "unregistered_frameworks",
+                [](JSON::ArrayWriter*) {});
+          };
+
+          return OK(jsonify(state), jsonp);
+        });
+      });
+  }
+
   return collect(
       authorizeRole,
       authorizeFrameworkInfo,
@@ -2946,7 +3852,7 @@ Future<Response> Master::Http::state(
         writer->field("slaves",
           [this, &authorizeRole](JSON::ArrayWriter* writer) {
             foreachvalue (Slave* slave, master->slaves.registered) {
-              writer->element(SlaveWriter(*slave, authorizeRole));
+              writer->element(SlaveWriter(SlaveState(*slave), authorizeRole));
             }
           });
 
@@ -2974,10 +3880,12 @@ Future<Response> Master::Http::state(
               continue;
             }
 
+            const FrameworkState frameworkState(*framework);
+
             auto frameworkWriter = FullFrameworkWriter(
                 authorizeTask,
                 authorizeExecutorInfo,
-                framework);
+                frameworkState);
 
             writer->element(frameworkWriter);
           }
@@ -2997,10 +3905,12 @@ Future<Response> Master::Http::state(
               continue;
             }
 
+            const FrameworkState frameworkState(*framework);
+
             auto frameworkWriter = FullFrameworkWriter(
                 authorizeTask,
                 authorizeExecutorInfo,
-                framework.get());
+                frameworkState);
 
             writer->element(frameworkWriter);
           }
@@ -3097,13 +4007,38 @@ public:
         slavesToFrameworks[task->slave_id()].insert(frameworkId);
       }
 
-      foreach (const Owned<Task>& task, framework->completedTasks) {
-        frameworksToSlaves[frameworkId].insert(task->slave_id());
-        slavesToFrameworks[task->slave_id()].insert(frameworkId);
+      foreach (const CompactTask& task, framework->completedTasks) {
+        const SlaveID slaveId = task.slaveId();
+        frameworksToSlaves[frameworkId].insert(slaveId);
+        slavesToFrameworks[slaveId].insert(frameworkId);
       }
     }
   }
 
+  // Computes the mapping for the registered frameworks of a snapshot.
+  explicit SlaveFrameworkMapping(const StateSnapshot& snapshot)
+  {
+    foreach (const mesos::master::Response::GetFrameworks::Framework&
+               framework,
+             snapshot.state.get_frameworks().frameworks()) {
+      const FrameworkID& frameworkId = framework.framework_info().id();
+
+      auto add = [this, &frameworkId](const vector<const Task*>& tasks) {
+        foreach (const Task* task, tasks) {
+          frameworksToSlaves[frameworkId].insert(task->slave_id());
+          slavesToFrameworks[task->slave_id()].insert(frameworkId);
+        }
+      };
+
+      const StateSnapshot::Tasks& tasks = snapshot.tasks.at(frameworkId);
+
+      add(tasks.pending);
+      add(tasks.active);
+      add(tasks.unreachable);
+      add(tasks.completed);
+    }
+  }
+
   const hashset<FrameworkID>& frameworks(const SlaveID& slaveId) const
   {
     const auto iterator = slavesToFrameworks.find(slaveId);
@@ -3148,10 +4083,10 @@ struct TaskStateSummary
       gone_by_operator(0),
       unknown(0) {}
 
-  // Account for the state of the given task.
-  void count(const Task& task)
+  // Account for a task in the given state.
+  void count(const TaskState& state)
   {
-    switch (task.state()) {
+    switch (state) {
       case TASK_STAGING: { ++staging; break; }
       case TASK_STARTING: { ++starting; break; }
       case TASK_RUNNING: { ++running; break; }
@@ -3191,6 +4126,28 @@ struct TaskStateSummary
 const TaskStateSummary TaskStateSummary::EMPTY;
 
 
+// Adds the counts of a 'TaskState' summary. Certain per-agent status
+// totals will always be zero (e.g., TASK_ERROR, TASK_UNREACHABLE). We
+// report them anyway, for completeness.
+//
+// TODO(neilc): Update for TASK_GONE and TASK_GONE_BY_OPERATOR.
+static void writeTaskStateSummary(
+    JSON::ObjectWriter* writer,
+    const TaskStateSummary& summary)
+{
+  writer->field("TASK_STAGING", summary.staging);
+  writer->field("TASK_STARTING", summary.starting);
+  writer->field("TASK_RUNNING", summary.running);
+  writer->field("TASK_KILLING", summary.killing);
+  writer->field("TASK_FINISHED", summary.finished);
+  writer->field("TASK_KILLED", summary.killed);
+  writer->field("TASK_FAILED", summary.failed);
+  writer->field("TASK_LOST", summary.lost);
+  writer->field("TASK_ERROR", summary.error);
+  writer->field("TASK_UNREACHABLE", summary.unreachable);
+}
+
+
 // This abstraction has no side-effects. It factors out computing the
 // 'TaskState' summaries for frameworks and slaves. This answers the
 // questions 'How many tasks are in each state for a given framework?'
@@ -3209,22 +4166,47 @@ public:
       }
 
       foreachvalue (const Task* task, framework->tasks) {
-        frameworkTaskSummaries[frameworkId].count(*task);
-        slaveTaskSummaries[task->slave_id()].count(*task);
+        frameworkTaskSummaries[frameworkId].count(task->state());
+        slaveTaskSummaries[task->slave_id()].count(task->state());
       }
 
       foreachvalue (const Owned<Task>& task, framework->unreachableTasks) {
-        frameworkTaskSummaries[frameworkId].count(*task.get());
-        slaveTaskSummaries[task->slave_id()].count(*task.get());
+        frameworkTaskSummaries[frameworkId].count(task->state());
+        slaveTaskSummaries[task->slave_id()].count(task->state());
       }
 
-      foreach (const Owned<Task>& task, framework->completedTasks) {
-        frameworkTaskSummaries[frameworkId].count(*task.get());
-        slaveTaskSummaries[task->slave_id()].count(*task.get());
+      foreach (const CompactTask& task, framework->completedTasks) {
+        frameworkTaskSummaries[frameworkId].count(task.state());
+        slaveTaskSummaries[task.slaveId()].count(task.state());
       }
     }
   }
 
+  // Computes the summaries for the registered frameworks of a snapshot.
+  // Pending tasks are in TASK_STAGING there.
+  explicit TaskStateSummaries(const StateSnapshot& snapshot)
+  {
+    foreach (const mesos::master::Response::GetFrameworks::Framework&
+               framework,
+             snapshot.state.get_frameworks().frameworks()) {
+      const FrameworkID& frameworkId = framework.framework_info().id();
+
+      auto count = [this, &frameworkId](const vector<const Task*>& tasks) {
+        foreach (const Task* task, tasks) {
+          frameworkTaskSummaries[frameworkId].count(task->state());
+          slaveTaskSummaries[task->slave_id()].count(task->state());
+        }
+      };
+
+      const StateSnapshot::Tasks& tasks = snapshot.tasks.at(frameworkId);
+
+      count(tasks.pending);
+      count(tasks.active);
+      count(tasks.unreachable);
+      count(tasks.completed);
+    }
+  }
+
   const TaskStateSummary& framework(const FrameworkID& frameworkId) const
   {
     const auto iterator = frameworkTaskSummaries.find(frameworkId);
@@ -3298,6 +4280,126 @@ Future<Response> Master::Http::stateSummary(
     AuthorizationAcceptor::create(
         principal, master->authorizer, authorization::VIEW_FRAMEWORK);
 
+  if (master->stateView.isSome()) {
+    const Owned<StateView>& stateView = master->stateView.get();
+    Option<string> jsonp = request.url.query.get("jsonp");
+
+    return collect(authorizeRole, authorizeFrameworkInfo)
+      .then([=](const tuple<Owned<AuthorizationAcceptor>,
+                            Owned<AuthorizationAcceptor>>& acceptors) {
+        return stateView->read([=](const StateSnapshot& snapshot) {
+          auto stateSummary = [&snapshot, &acceptors](
+              JSON::ObjectWriter* writer) {
+            Owned<AuthorizationAcceptor> authorizeRole;
+            Owned<AuthorizationAcceptor> authorizeFrameworkInfo;
+            tie(authorizeRole, authorizeFrameworkInfo) = acceptors;
+
+            writer->field("hostname", snapshot.info.hostname());
+
+            if (snapshot.cluster.isSome()) {
+              writer->field("cluster", snapshot.cluster.get());
+            }
+
+            SlaveFrameworkMapping slaveFrameworkMapping(snapshot);
+            TaskStateSummaries taskStateSummaries(snapshot);
+
+            // Model all of the slaves.
+            writer->field(
+                "slaves",
+                [&snapshot,
+                 &slaveFrameworkMapping,
+                 &taskStateSummaries,
+                 &authorizeRole](JSON::ArrayWriter* writer) {
+                  foreach (const mesos::master::Response::GetAgents::Agent&
+                             agent,
+                           snapshot.state.get_agents().agents()) {
+                    writer->element(
+                        [&agent,
+                         &slaveFrameworkMapping,
+                         &taskStateSummaries,
+                         &authorizeRole](JSON::ObjectWriter* writer) {
+                          SlaveWriter(SlaveState(agent), authorizeRole)(writer);
+
+                          const SlaveID& slaveId = agent.agent_info().id();
+
+                          // Add the 'TaskState' summary for this slave.
+                          writeTaskStateSummary(
+                              writer,
+                              taskStateSummaries.slave(slaveId));
+
+                          // Add the ids of all the frameworks running on
+                          // this slave.
+                          const hashset<FrameworkID>& frameworks =
+                              slaveFrameworkMapping.frameworks(slaveId);
+
+                          writer->field(
+                              "framework_ids",
+                              [&frameworks](JSON::ArrayWriter* writer) {
+                                foreach (
+                                    const FrameworkID& frameworkId,
+                                    frameworks) {
+                                  writer->element(frameworkId.value());
+                                }
+                              });
+                        });
+                  }
+                });
+
+            // Model all of the frameworks.
+            writer->field(
+                "frameworks",
+                [&snapshot,
+                 &slaveFrameworkMapping,
+                 &taskStateSummaries,
+                 &authorizeFrameworkInfo](JSON::ArrayWriter* writer) {
+                  foreach (const mesos::master::Response::GetFrameworks::
+                             Framework& framework,
+                           snapshot.state.get_frameworks().frameworks()) {
+                    // Skip unauthorized frameworks.
+                    if (!authorizeFrameworkInfo->accept(
+                            framework.framework_info())) {
+                      continue;
+                    }
+
+                    writer->element(
+                        [&snapshot,
+                         &framework,
+                         &slaveFrameworkMapping,
+                         &taskStateSummaries](JSON::ObjectWriter* writer) {
+                          const FrameworkState state(snapshot, framework);
+
+                          json(writer, Summary<FrameworkState>(state));
+
+                          const FrameworkID& frameworkId =
+                            framework.framework_info().id();
+
+                          // Add the 'TaskState' summary for this framework.
+                          writeTaskStateSummary(
+                              writer,
+                              taskStateSummaries.framework(frameworkId));
+
+                          // Add the ids of all the slaves running this
+                          // framework.
+                          const hashset<SlaveID>& slaves =
+                              slaveFrameworkMapping.slaves(frameworkId);
+
+                          writer->field(
+                              "slave_ids",
+                              [&slaves](JSON::ArrayWriter* writer) {
+                                foreach (const SlaveID& slaveId, slaves) {
+                                  writer->element(slaveId.value());
+                                }
+                              });
+                        });
+                  }
+                });
+          };
+
+          return OK(jsonify(stateSummary), jsonp);
+        });
+      });
+  }
+
   return collect(authorizeRole, authorizeFrameworkInfo).then(defer(
       master->self(),
       [this, request](const tuple<Owned<AuthorizationAcceptor>,
@@ -3342,29 +4444,15 @@ Future<Response> Master::Http::stateSummary(
                        &slaveFrameworkMapping,
                        &taskStateSummaries,
                        &authorizeRole](JSON::ObjectWriter* writer) {
-                        SlaveWriter slaveWriter(*slave, authorizeRole);
+                        const SlaveState state(*slave);
+
+                        SlaveWriter slaveWriter(state, authorizeRole);
                         slaveWriter(writer);
 
                         // Add the 'TaskState' summary for this slave.
-                        const TaskStateSummary& summary =
-                            taskStateSummaries.slave(slave->id);
-
-                        // Certain per-agent status totals will always be zero
-                        // (e.g., TASK_ERROR, TASK_UNREACHABLE). We report them
-                        // here anyway, for completeness.
-                        //
-                        // TODO(neilc): Update for TASK_GONE and
-                        // TASK_GONE_BY_OPERATOR.
-                        writer->field("TASK_STAGING", summary.staging);
-                        writer->field("TASK_STARTING", summary.starting);
-                        writer->field("TASK_RUNNING", summary.running);
-                        writer->field("TASK_KILLING", summary.killing);
-                        writer->field("TASK_FINISHED", summary.finished);
-                        writer->field("TASK_KILLED", summary.killed);
-                        writer->field("TASK_FAILED", summary.failed);
-                        writer->field("TASK_LOST", summary.lost);
-                        writer->field("TASK_ERROR", summary.error);
-                        writer->field("TASK_UNREACHABLE", summary.unreachable);
+                        writeTaskStateSummary(
+                            writer,
+                            taskStateSummaries.slave(slave->id));
 
                         // Add the ids of all the frameworks running on this
                         // slave.
@@ -3404,24 +4492,14 @@ Future<Response> Master::Http::stateSummary(
                        &framework,
                        &slaveFrameworkMapping,
                        &taskStateSummaries](JSON::ObjectWriter* writer) {
-                        json(writer, Summary<Framework>(*framework));
+                        const FrameworkState state(*framework);
+
+                        json(writer, Summary<FrameworkState>(state));
 
                         // Add the 'TaskState' summary for this framework.
-                        const TaskStateSummary& summary =
-                            taskStateSummaries.framework(frameworkId);
-
-                        // TODO(neilc): Update for TASK_GONE and
-                        // TASK_GONE_BY_OPERATOR.
-                        writer->field("TASK_STAGING", summary.staging);
-                        writer->field("TASK_STARTING", summary.starting);
-                        writer->field("TASK_RUNNING", summary.running);
-                        writer->field("TASK_KILLING", summary.killing);
-                        writer->field("TASK_FINISHED", summary.finished);
-                        writer->field("TASK_KILLED", summary.killed);
-                        writer->field("TASK_FAILED", summary.failed);
-                        writer->field("TASK_LOST", summary.lost);
-                        writer->field("TASK_ERROR", summary.error);
-                        writer->field("TASK_UNREACHABLE", summary.unreachable);
+                        writeTaskStateSummary(
+                            writer,
+                            taskStateSummaries.framework(frameworkId));
 
                         // Add the ids of all the slaves running this framework.
                         const hashset<SlaveID>& slaves =
@@ -3905,6 +4983,85 @@ struct TaskComparator
 };
 
 
+// Parses the task selection criteria of the '/tasks' endpoint.
+static Try<TaskFilter> parseTaskFilter(const Request& request)
+{
+  TaskFilter filter;
+
+  Option<string> frameworkId = request.url.query.get("framework_id");
+  if (frameworkId.isSome()) {
+    filter.frameworkId = FrameworkID();
+    filter.frameworkId->set_value(frameworkId.get());
+  }
+
+  Option<string> agentId = request.url.query.get("agent_id");
+  if (agentId.isSome()) {
+    filter.slaveId = SlaveID();
+    filter.slaveId->set_value(agentId.get());
+  }
+
+  Option<string> state = request.url.query.get("state");
+  if (state.isSome()) {
+    TaskState _state;
+    if (!TaskState_Parse(state.get(), &_state)) {
+      return Error("Invalid task state '" + state.get() + "'");
+    }
+
+    filter.state = _state;
+  }
+
+  filter.role = request.url.query.get("role");
+
+  // Labels are given as 'key' or 'key:value'.
+  Option<string> label = request.url.query.get("label");
+  if (label.isSome()) {
+    const size_t separator = label->find(':');
+
+    filter.label = Label();
+    filter.label->set_key(label->substr(0, separator));
+
+    if (separator != string::npos) {
+      filter.label->set_value(label->substr(separator + 1));
+    }
+  }
+
+  return filter;
+}
+
+
+// Sorts the tasks by status timestamp and returns the requested page
+// of them as the response of the '/tasks' endpoint.
+static Response tasksResponse(
+    vector<const Task*> tasks,
+    const string& order,
+    size_t limit,
+    size_t offset,
+    const Option<string>& jsonp)
+{
+  // Sort tasks by task status timestamp. Default order is descending.
+  // The earliest timestamp is chosen for comparison when
+  // multiple are present.
+  if (order == "asc") {
+    sort(tasks.begin(), tasks.end(), TaskComparator::ascending);
+  } else {
+    sort(tasks.begin(), tasks.end(), TaskComparator::descending);
+  }
+
+  auto tasksWriter = [&tasks, limit, offset](JSON::ObjectWriter* writer) {
+    writer->field("tasks",
+                  [&tasks, limit, offset](JSON::ArrayWriter* writer) {
+      // Collect 'limit' number of tasks starting from 'offset'.
+      size_t end = std::min(offset + limit, tasks.size());
+      for (size_t i = offset; i < end; i++) {
+        writer->element(*tasks[i]);
+      }
+    });
+  };
+
+  return OK(jsonify(tasksWriter), jsonp);
+}
+
+
 string Master::Http::TASKS_HELP()
 {
   return HELP(
@@ -3925,13 +5082,21 @@ string Master::Http::TASKS_HELP()
         "",
         "Query parameters:",
         "",
+        ">        agent_id=VALUE       Only return tasks running on the "
+        "agent with this ID.",
         ">        framework_id=VALUE   Only return tasks belonging to the "
         "framework with this ID.",
+        ">        label=KEY[:VALUE]    Only return tasks with a label with "
+        "this key (and value).",
         ">        limit=VALUE          Maximum number of tasks returned "
         "(default is " + stringify(TASK_LIMIT) + ").",
         ">        offset=VALUE         Starts task list at offset.",
         ">        order=(asc|desc)     Ascending or descending sort order "
         "(default is descending).",
+        ">        role=VALUE           Only return tasks whose resources "
+        "are allocated to this role.",
+        ">        state=VALUE          Only return tasks in this state "
+        "(e.g., TASK_RUNNING).",
         ">        task_id=VALUE        Only return tasks with this ID "
         "(should be used together with parameter 'framework_id')."
         ""),
@@ -3972,6 +5137,13 @@ Future<Response> Master::Http::tasks(
   Option<string> order = request.url.query.get("order");
   string _order = order.isSome() && (order.get() == "asc") ? "asc" : "des";
 
+  Try<TaskFilter> parse = parseTaskFilter(request);
+  if (parse.isError()) {
+    return BadRequest(parse.error());
+  }
+
+  const TaskFilter filter = parse.get();
+
   Future<Owned<AuthorizationAcceptor>> authorizeFrameworkInfo =
     AuthorizationAcceptor::create(
         principal,
@@ -3987,6 +5159,69 @@ Future<Response> Master::Http::tasks(
   Future<IDAcceptor<TaskID>> selectTaskId =
     IDAcceptor<TaskID>(request.url.query.get("task_id"));
 
+  if (master->stateView.isSome()) {
+    const Owned<StateView>& stateView = master->stateView.get();
+    Option<string> jsonp = request.url.query.get("jsonp");
+
+    return collect(
+        authorizeFrameworkInfo,
+        authorizeTask,
+        selectFrameworkId,
+        selectTaskId)
+      .then([=](const tuple<Owned<AuthorizationAcceptor>,
+                            Owned<AuthorizationAcceptor>,
+                            IDAcceptor<FrameworkID>,
+                            IDAcceptor<TaskID>>& acceptors) {
+        return stateView->read([=](const StateSnapshot& snapshot) {
+          Owned<AuthorizationAcceptor> authorizeFrameworkInfo;
+          Owned<AuthorizationAcceptor> authorizeTask;
+          IDAcceptor<FrameworkID> selectFrameworkId;
+          IDAcceptor<TaskID> selectTaskId;
+          tie(authorizeFrameworkInfo,
+              authorizeTask,
+              selectFrameworkId,
+              selectTaskId) = acceptors;
+
+          vector<const Task*> tasks;
+
+          auto select = [&](const RepeatedPtrField<Task>& candidates) {
+            foreach (const Task& task, candidates) {
+              // Skip tasks without matching framework ID or task ID or
+              // that do not match the filter.
+              if (!selectFrameworkId.accept(task.framework_id()) ||
+                  !selectTaskId.accept(task.task_id()) ||
+                  !filter.matches(task) ||
+                  !snapshot.frameworks.contains(task.framework_id())) {
+                continue;
+              }
+
+              const FrameworkInfo& frameworkInfo =
+                snapshot.frameworks.at(task.framework_id());
+
+              // Skip unauthorized frameworks or tasks.
+              if (!authorizeFrameworkInfo->accept(frameworkInfo) ||
+                  !authorizeTask->accept(task, frameworkInfo)) {
+                continue;
+              }
+
+              tasks.push_back(&task);
+            }
+          };
+
+          // Construct task list with both running,
+          // completed and unreachable tasks.
+          const mesos::master::Response::GetTasks& getTasks =
+            snapshot.state.get_tasks();
+
+          select(getTasks.tasks());
+          select(getTasks.unreachable_tasks());
+          select(getTasks.completed_tasks());
+
+          return tasksResponse(tasks, _order, limit, offset, jsonp);
+        });
+      });
+  }
+
   return collect(
       authorizeFrameworkInfo,
       authorizeTask,
@@ -4009,6 +5244,7 @@ Future<Response> Master::Http::tasks(
 
           // Construct framework list with both active and completed frameworks.
           vector<const Framework*> frameworks;
+          hashmap<FrameworkID, const Framework*> registered;
           foreachvalue (Framework* framework, master->frameworks.registered) {
             // Skip unauthorized frameworks or frameworks without matching
             // framework ID.
@@ -4018,6 +5254,7 @@ Future<Response> Master::Http::tasks(
             }
 
             frameworks.push_back(framework);
+            registered.put(framework->id(), framework);
           }
 
           foreachvalue (const Owned<Framework>& framework,
@@ -4035,23 +5272,43 @@ Future<Response> Master::Http::tasks(
           // Construct task list with both running,
           // completed and unreachable tasks.
           vector<const Task*> tasks;
-          foreach (const Framework* framework, frameworks) {
-            foreachvalue (Task* task, framework->tasks) {
-              CHECK_NOTNULL(task);
-              // Skip unauthorized tasks or tasks without matching task ID.
-              if (!selectTaskId.accept(task->task_id()) ||
-                  !authorizeTask->accept(*task, framework->info)) {
-                continue;
-              }
 
-              tasks.push_back(task);
-            }
+          // Completed tasks are materialized from their compact
+          // representation, and must outlive `tasks`.
+          list<Task> completedTasks;
+
+          // The running tasks are selected from the indexes of the master.
+          master->frameworks.tasks.visit(
+              filter,
+              None(),
+              [&](const Task* task) {
+                // Skip tasks of unauthorized frameworks or frameworks
+                // without matching framework ID.
+                if (!registered.contains(task->framework_id())) {
+                  return true;
+                }
+
+                const Framework* framework =
+                  registered.at(task->framework_id());
 
+                // Skip unauthorized tasks or tasks without matching task ID.
+                if (!selectTaskId.accept(task->task_id()) ||
+                    !authorizeTask->accept(*task, framework->info)) {
+                  return true;
+                }
+
+                tasks.push_back(task);
+                return true;
+              });
+
+          foreach (const Framework* framework, frameworks) {
             foreachvalue (
                 const Owned<Task>& task,
                 framework->unreachableTasks) {
-              // Skip unauthorized tasks or tasks without matching task ID.
+              // Skip unauthorized tasks, tasks without matching task ID
+              // or tasks that do not match the filter.
               if (!selectTaskId.accept(task.get()->task_id()) ||
+                  !filter.matches(*task.get()) ||
                   !authorizeTask->accept(*task.get(), framework->info)) {
                 continue;
               }
@@ -4059,39 +5316,25 @@ Future<Response> Master::Http::tasks(
               tasks.push_back(task.get());
             }
 
-            foreach (const Owned<Task>& task, framework->completedTasks) {
-              // Skip unauthorized tasks or tasks without matching task ID.
-              if (!selectTaskId.accept(task.get()->task_id()) ||
-                  !authorizeTask->accept(*task.get(), framework->info)) {
+            foreach (const CompactTask& completedTask,
+                     framework->completedTasks) {
+              Task task = completedTask.materialize();
+
+              // Skip unauthorized tasks, tasks without matching task ID
+              // or tasks that do not match the filter.
+              if (!selectTaskId.accept(task.task_id()) ||
+                  !filter.matches(task) ||
+                  !authorizeTask->accept(task, framework->info)) {
                 continue;
               }
 
-              tasks.push_back(task.get());
+              completedTasks.push_back(std::move(task));
+              tasks.push_back(&completedTasks.back());
             }
           }
 
-          // Sort tasks by task status timestamp. Default order is descending.
-          // The earliest timestamp is chosen for comparison when
-          // multiple are present.
-          if (_order == "asc") {
-            sort(tasks.begin(), tasks.end(), TaskComparator::ascending);
-          } else {
-            sort(tasks.begin(), tasks.end(), TaskComparator::descending);
-          }
-
-          auto tasksWriter =
-            [&tasks, limit, offset](JSON::ObjectWriter* writer) {
-            writer->field("tasks",
-                          [&tasks, limit, offset](JSON::ArrayWriter* writer) {
-              // Collect 'limit' number of tasks starting from 'offset'.
-              size_t end = std::min(offset + limit, tasks.size());
-              for (size_t i = offset; i < end; i++) {
-                writer->element(*tasks[i]);
-              }
-            });
-          };
-
-          return OK(jsonify(tasksWriter), request.url.query.get("jsonp"));
+          return tasksResponse(
+              tasks, _order, limit, offset, request.url.query.get("jsonp"));
   }));
 }
 
@@ -4103,6 +5346,33 @@ Future<Response> Master::Http::getTasks(
 {
   CHECK_EQ(mesos::master::Call::GET_TASKS, call.type());
 
+  TaskFilter filter;
+  Option<TaskIndex::Key> after;
+  Option<size_t> limit;
+
+  if (call.has_get_tasks()) {
+    const mesos::master::Call::GetTasks& getTasks = call.get_tasks();
+
+    filter = TaskFilter::create(getTasks);
+
+    if (getTasks.has_cursor()) {
+      Try<TaskIndex::Key> key = TaskIndex::parse(getTasks.cursor());
+      if (key.isError()) {
+        return BadRequest(key.error());
+      }
+
+      after = key.get();
+    }
+
+    if (getTasks.has_limit()) {
+      if (getTasks.limit() == 0) {
+        return BadRequest("Expecting 'limit' to be positive");
+      }
+
+      limit = getTasks.limit();
+    }
+  }
+
   // Retrieve Approvers for authorizing frameworks and tasks.
   Future<Owned<ObjectApprover>> frameworksApprover;
   Future<Owned<ObjectApprover>> tasksApprover;
@@ -4119,6 +5389,31 @@ Future<Response> Master::Http::getTasks(
     tasksApprover = Owned<ObjectApprover>(new AcceptingObjectApprover());
   }
 
+  // Selecting tasks is cheap with the indexes of the master, so only
+  // unfiltered requests are served from the state snapshot.
+  if (master->stateView.isSome() && !call.has_get_tasks()) {
+    const Owned<StateView>& stateView = master->stateView.get();
+
+    return collect(frameworksApprover, tasksApprover)
+      .then([=](const tuple<Owned<ObjectApprover>,
+                            Owned<ObjectApprover>>& approvers) {
+        return stateView->read([=](const StateSnapshot& snapshot) {
+          // Get approver from tuple.
+          Owned<ObjectApprover> frameworksApprover;
+          Owned<ObjectApprover> tasksApprover;
+          tie(frameworksApprover, tasksApprover) = approvers;
+
+          mesos::master::Response response;
+          response.set_type(mesos::master::Response::GET_TASKS);
+          response.mutable_get_tasks()->CopyFrom(
+              filterTasks(snapshot, frameworksApprover, tasksApprover));
+
+          return OK(serialize(contentType, evolve(response)),
+                    stringify(contentType));
+        });
+      });
+  }
+
   return collect(frameworksApprover, tasksApprover)
     .then(defer(
         master->self(),
@@ -4135,7 +5430,10 @@ Future<Response> Master::Http::getTasks(
 
       response.mutable_get_tasks()->CopyFrom(
           _getTasks(frameworksApprover,
-                    tasksApprover));
+                    tasksApprover,
+                    filter,
+                    after,
+                    limit));
 
       return OK(serialize(contentType, evolve(response)),
                 stringify(contentType));
@@ -4145,10 +5443,14 @@ Future<Response> Master::Http::getTasks(
 
 mesos::master::Response::GetTasks Master::Http::_getTasks(
     const Owned<ObjectApprover>& frameworksApprover,
-    const Owned<ObjectApprover>& tasksApprover) const
+    const Owned<ObjectApprover>& tasksApprover,
+    const TaskFilter& filter,
+    const Option<TaskIndex::Key>& after,
+    const Option<size_t>& limit) const
 {
   // Construct framework list with both active and completed frameworks.
   vector<const Framework*> frameworks;
+  hashmap<FrameworkID, const Framework*> registered;
   foreachvalue (Framework* framework, master->frameworks.registered) {
     // Skip unauthorized frameworks.
     if (!approveViewFrameworkInfo(frameworksApprover, framework->info)) {
@@ -4156,6 +5458,7 @@ mesos::master::Response::GetTasks Master::Http::_getTasks(
     }
 
     frameworks.push_back(framework);
+    registered.put(framework->id(), framework);
   }
 
   foreachvalue (const Owned<Framework>& framework,
@@ -4170,53 +5473,90 @@ mesos::master::Response::GetTasks Master::Http::_getTasks(
 
   mesos::master::Response::GetTasks getTasks;
 
-  vector<const Task*> tasks;
-  foreach (const Framework* framework, frameworks) {
-    // Pending tasks.
-    foreachvalue (const TaskInfo& taskInfo, framework->pendingTasks) {
-      // Skip unauthorized tasks.
-      if (!approveViewTaskInfo(tasksApprover, taskInfo, framework->info)) {
+  // The pending, unreachable and completed tasks are only returned
+  // with the first page of the active tasks.
+  if (after.isNone()) {
+    foreach (const Framework* framework, frameworks) {
+      // Skip frameworks without matching framework ID.
+      if (filter.frameworkId.isSome() &&
+          filter.frameworkId.get() != framework->id()) {
         continue;
       }
 
-      const Task& task =
-        protobuf::createTask(taskInfo, TASK_STAGING, framework->id());
+      // Pending tasks.
+      foreachvalue (const TaskInfo& taskInfo, framework->pendingTasks) {
+        // Skip unauthorized tasks.
+        if (!approveViewTaskInfo(tasksApprover, taskInfo, framework->info)) {
+          continue;
+        }
 
-      getTasks.add_pending_tasks()->CopyFrom(task);
-    }
+        const Task& task =
+          protobuf::createTask(taskInfo, TASK_STAGING, framework->id());
 
-    // Active tasks.
-    foreachvalue (Task* task, framework->tasks) {
-      CHECK_NOTNULL(task);
-      // Skip unauthorized tasks.
-      if (!approveViewTask(tasksApprover, *task, framework->info)) {
-        continue;
+        // Skip tasks that do not match the filter.
+        if (!filter.matches(task)) {
+          continue;
+        }
+
+        getTasks.add_pending_tasks()->CopyFrom(task);
       }
 
-      getTasks.add_tasks()->CopyFrom(*task);
-    }
+      // Unreachable tasks.
+      foreachvalue (const Owned<Task>& task, framework->unreachableTasks) {
+        // Skip unauthorized tasks or tasks that do not match the filter.
+        if (!filter.matches(*task.get()) ||
+            !approveViewTask(tasksApprover, *task.get(), framework->info)) {
+          continue;
+        }
 
-    // Unreachable tasks.
-    foreachvalue (const Owned<Task>& task, framework->unreachableTasks) {
-      // Skip unauthorized tasks.
-      if (!approveViewTask(tasksApprover, *task.get(), framework->info)) {
-        continue;
+        getTasks.add_unreachable_tasks()->CopyFrom(*task);
       }
 
-      getTasks.add_unreachable_tasks()->CopyFrom(*task);
-    }
+      // Completed tasks.
+      foreach (const CompactTask& completedTask, framework->completedTasks) {
+        Task task = completedTask.materialize();
 
-    // Completed tasks.
-    foreach (const Owned<Task>& task, framework->completedTasks) {
-      // Skip unauthorized tasks.
-      if (!approveViewTask(tasksApprover, *task.get(), framework->info)) {
-        continue;
-      }
+        // Skip unauthorized tasks or tasks that do not match the filter.
+        if (!filter.matches(task) ||
+            !approveViewTask(tasksApprover, task, framework->info)) {
+          continue;
+        }
 
-      getTasks.add_completed_tasks()->CopyFrom(*task);
+        getTasks.add_completed_tasks()->Swap(&task);
+      }
     }
   }
 
+  // Active tasks, which are only known to registered frameworks.
+  master->frameworks.tasks.visit(
+      filter,
+      after,
+      [&](const Task* task) {
+        // Skip tasks of unauthorized frameworks.
+        if (!registered.contains(task->framework_id())) {
+          return true;
+        }
+
+        const Framework* framework = registered.at(task->framework_id());
+
+        // Skip unauthorized tasks.
+        if (!approveViewTask(tasksApprover, *task, framework->info)) {
+          return true;
+        }
+
+        // There are more tasks than requested, so the response refers
+        // to its last task as the cursor for the next page.
+        if (limit.isSome() &&
+            static_cast<size_t>(getTasks.tasks_size()) >= limit.get()) {
+          const Task& last = getTasks.tasks(getTasks.tasks_size() - 1);
+          getTasks.set_next_cursor(TaskIndex::cursor(TaskIndex::key(last)));
+          return false;
+        }
+
+        getTasks.add_tasks()->CopyFrom(*task);
+        return true;
+      });
+
   return getTasks;
 }
 
@@ -393,7 +393,12 @@ int main(int argc, char** argv)
           flags.log_auto_initialize,
           "registrar/");
     }
-    storage = new LogStorage(log);
+    storage = new LogStorage(
+        log,
+        flags.registry_log_max_diffs,
+        flags.registry_log_diff_format == "delta"
+          ? LogStorage::DELTA
+          : LogStorage::SVN);
 #endif // __WINDOWS__
   } else {
     EXIT(EXIT_FAILURE)
@@ -41,6 +41,7 @@
 
 #include <mesos/scheduler/scheduler.hpp>
 
+#include <process/async.hpp>
 #include <process/check.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
@@ -103,6 +104,7 @@ using std::tie;
 using std::tuple;
 using std::vector;
 
+using process::async;
 using process::await;
 using process::wait; // Necessary on some OS's to disambiguate.
 using process::Clock;
@@ -748,13 +750,56 @@ void Master::initialize()
   }
 
   // Initialize the allocator.
+  mesos::allocator::Options options;
+  options.allocationInterval = flags.allocation_interval;
+  options.fairnessExcludeResourceNames =
+    flags.fair_sharing_excluded_resource_names;
+  options.filterGpuResources = flags.filter_gpu_resources;
+  options.domain = flags.domain;
+  options.maxOffersPerFramework = flags.max_offers_per_framework;
+
+  // NOTE: The offer packing flags have been validated already.
+  Try<mesos::allocator::Options::OfferPackingPolicy> offerPackingPolicy =
+    mesos::allocator::Options::parseOfferPackingPolicy(
+        flags.offer_packing_policy);
+
+  CHECK_SOME(offerPackingPolicy);
+  options.offerPackingPolicy = offerPackingPolicy.get();
+
+  if (flags.offer_packing_attribute_weights.isSome()) {
+    Try<vector<mesos::allocator::Options::AttributeWeight>> weights =
+      mesos::allocator::Options::parseAttributeWeights(
+          flags.offer_packing_attribute_weights.get());
+
+    CHECK_SOME(weights);
+    options.offerPackingAttributeWeights = weights.get();
+  }
+
+  // Verify that the `attribute_weighted` policy has weights to use.
+  if (options.offerPackingPolicy ==
+        mesos::allocator::Options::OfferPackingPolicy::ATTRIBUTE_WEIGHTED &&
+      options.offerPackingAttributeWeights.empty()) {
+    EXIT(EXIT_FAILURE)
+      << "Invalid value '" << flags.offer_packing_policy << "'"
+      << " for --offer_packing_policy: Requires at least one weight in"
+      << " --offer_packing_attribute_weights";
+  }
+
   allocator->initialize(
-      flags.allocation_interval,
+      options,
       defer(self(), &Master::offer, lambda::_1, lambda::_2),
-      defer(self(), &Master::inverseOffer, lambda::_1, lambda::_2),
-      flags.fair_sharing_excluded_resource_names,
-      flags.filter_gpu_resources,
-      flags.domain);
+      defer(self(), &Master::inverseOffer, lambda::_1, lambda::_2));
+
+  if (flags.state_snapshot_interval.isSome()) {
+    stateView = Owned<StateView>(new StateView(
+        flags.state_snapshot_interval.get(),
+        defer(self(), &Self::captureStateSnapshot)));
+  }
+
+  if (flags.http_response_cache_ttl.isSome()) {
+    responseCache = Owned<ResponseCache>(
+        new ResponseCache(flags.http_response_cache_ttl.get()));
+  }
 
   // Parse the whitelist. Passing Allocator::updateWhitelist()
   // callback is safe because we shut down the whitelistWatcher in
@@ -932,7 +977,12 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.frameworks(request, principal);
+          return cached(
+              ResponseCache::key(request),
+              principal,
+              [this, request, principal]() {
+                return http.frameworks(request, principal);
+              });
         });
   route("/flags",
         READONLY_HTTP_AUTHENTICATION_REALM,
@@ -992,7 +1042,12 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.slaves(request, principal);
+          return cached(
+              ResponseCache::key(request),
+              principal,
+              [this, request, principal]() {
+                return http.slaves(request, principal);
+              });
         });
   // TODO(ijimenez): Remove this endpoint at the end of the
   // deprecation cycle on 0.26.
@@ -1002,7 +1057,12 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.state(request, principal);
+          return cached(
+              ResponseCache::key(request),
+              principal,
+              [this, request, principal]() {
+                return http.state(request, principal);
+              });
         });
   route("/state",
         READONLY_HTTP_AUTHENTICATION_REALM,
@@ -1010,7 +1070,12 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.state(request, principal);
+          return cached(
+              ResponseCache::key(request),
+              principal,
+              [this, request, principal]() {
+                return http.state(request, principal);
+              });
         });
   route("/state-summary",
         READONLY_HTTP_AUTHENTICATION_REALM,
@@ -1018,7 +1083,12 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.stateSummary(request, principal);
+          return cached(
+              ResponseCache::key(request),
+              principal,
+              [this, request, principal]() {
+                return http.stateSummary(request, principal);
+              });
         });
   // TODO(ijimenez): Remove this endpoint at the end of the
   // deprecation cycle.
@@ -1028,7 +1098,12 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.tasks(request, principal);
+          return cached(
+              ResponseCache::key(request),
+              principal,
+              [this, request, principal]() {
+                return http.tasks(request, principal);
+              });
         });
   route("/tasks",
         READONLY_HTTP_AUTHENTICATION_REALM,
@@ -1036,7 +1111,12 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.tasks(request, principal);
+          return cached(
+              ResponseCache::key(request),
+              principal,
+              [this, request, principal]() {
+                return http.tasks(request, principal);
+              });
         });
   route("/maintenance/schedule",
         READWRITE_HTTP_AUTHENTICATION_REALM,
@@ -1253,6 +1333,13 @@ void Master::finalize()
     Clock::cancel(registryGcTimer.get());
   }
 
+  if (offerExpirationTimer.isSome()) {
+    Clock::cancel(offerExpirationTimer.get());
+  }
+
+  stateView = None();
+  responseCache = None();
+
   terminate(whitelistWatcher);
   wait(whitelistWatcher);
   delete whitelistWatcher;
@@ -1805,6 +1892,29 @@ void Master::scheduleRegistryGc()
 }
 
 
+void Master::captureStateSnapshot()
+{
+  CHECK_SOME(stateView);
+
+  stateView.get()->update(http.snapshot());
+}
+
+
+Future<process::http::Response> Master::cached(
+    const string& key,
+    const Option<Principal>& principal,
+    const lambda::function<Future<process::http::Response>()>& f)
+{
+  // Requests to a master that is not leading are redirected, there is
+  // nothing worth sharing.
+  if (responseCache.isNone() || !elected()) {
+    return f();
+  }
+
+  return responseCache.get()->get(key, principal, f);
+}
+
+
 void Master::doRegistryGc()
 {
   // Schedule next periodic GC.
@@ -2768,6 +2878,10 @@ void Master::_subscribe(
     updateFramework(framework, frameworkInfo, suppressedRoles);
     framework->reregisteredTime = Clock::now();
 
+    // The framework is expected to reconcile again after it has
+    // re-subscribed, hence the previous reconciliation is dropped.
+    framework->reconciliation.reset();
+
     // Always failover the old framework connection. See MESOS-4712 for details.
     failoverFramework(framework, http);
   } else {
@@ -3109,6 +3223,10 @@ void Master::_subscribe(
 
     framework->reregisteredTime = Clock::now();
 
+    // The framework is expected to reconcile again after it has
+    // re-subscribed, hence the previous reconciliation is dropped.
+    framework->reconciliation.reset();
+
     if (force) {
       // TODO(vinod): Now that the scheduler pid is unique we don't
       // need to call 'failoverFramework()' if the pid hasn't changed
@@ -3130,14 +3248,7 @@ void Master::_subscribe(
       // NOTE: We need to do this because the scheduler might have
       // replied to the offers but the driver might have dropped
       // those messages since it wasn't connected to the master.
-      foreach (Offer* offer, utils::copy(framework->offers)) {
-        allocator->recoverResources(
-            offer->framework_id(),
-            offer->slave_id(),
-            offer->resources(),
-            None());
-        removeOffer(offer, true); // Rescind.
-      }
+      rescindOffers(framework->offers);
 
       // Also remove inverse offers.
       foreach (InverseOffer* inverseOffer,
@@ -3359,15 +3470,7 @@ void Master::deactivate(Slave* slave)
   allocator->deactivateSlave(slave->id);
 
   // Remove and rescind offers.
-  foreach (Offer* offer, utils::copy(slave->offers)) {
-    allocator->recoverResources(
-        offer->framework_id(),
-        slave->id,
-        offer->resources(),
-        None());
-
-    removeOffer(offer, true); // Rescind!
-  }
+  rescindOffers(slave->offers);
 
   // Remove and rescind inverse offers.
   foreach (InverseOffer* inverseOffer, utils::copy(slave->inverseOffers)) {
@@ -4507,15 +4610,13 @@ void Master::_accept(
           continue;
         }
 
-        // Test the given operation on the included resources.
-        Try<Resources> resources = _offeredResources.apply(operation);
-        if (resources.isError()) {
-          drop(framework, operation, resources.error());
+        // Apply the given operation to the included resources.
+        Try<Nothing> transformed = _offeredResources.transform(operation);
+        if (transformed.isError()) {
+          drop(framework, operation, transformed.error());
           continue;
         }
 
-        _offeredResources = resources.get();
-
         LOG(INFO) << "Applying RESERVE operation for resources "
                   << operation.reserve().resources() << " from framework "
                   << *framework << " to agent " << *slave;
@@ -4562,15 +4663,13 @@ void Master::_accept(
           continue;
         }
 
-        // Test the given operation on the included resources.
-        Try<Resources> resources = _offeredResources.apply(operation);
-        if (resources.isError()) {
-          drop(framework, operation, resources.error());
+        // Apply the given operation to the included resources.
+        Try<Nothing> transformed = _offeredResources.transform(operation);
+        if (transformed.isError()) {
+          drop(framework, operation, transformed.error());
           continue;
         }
 
-        _offeredResources = resources.get();
-
         LOG(INFO) << "Applying UNRESERVE operation for resources "
                   << operation.unreserve().resources() << " from framework "
                   << *framework << " to agent " << *slave;
@@ -4627,13 +4726,11 @@ void Master::_accept(
           continue;
         }
 
-        Try<Resources> resources = _offeredResources.apply(operation);
-        if (resources.isError()) {
-          drop(framework, operation, resources.error());
+        Try<Nothing> transformed = _offeredResources.transform(operation);
+        if (transformed.isError()) {
+          drop(framework, operation, transformed.error());
           continue;
         }
-
-        _offeredResources = resources.get();
         offeredSharedResources = _offeredResources.shared();
 
         LOG(INFO) << "Applying CREATE operation for volumes "
@@ -4708,13 +4805,11 @@ void Master::_accept(
           }
         }
 
-        Try<Resources> resources = _offeredResources.apply(operation);
-        if (resources.isError()) {
-          drop(framework, operation, resources.error());
+        Try<Nothing> transformed = _offeredResources.transform(operation);
+        if (transformed.isError()) {
+          drop(framework, operation, transformed.error());
           continue;
         }
-
-        _offeredResources = resources.get();
         offeredSharedResources = _offeredResources.shared();
 
         LOG(INFO) << "Applying DESTROY operation for volumes "
@@ -4735,6 +4830,19 @@ void Master::_accept(
         Offer::Operation _operation;
         _operation.set_type(Offer::Operation::LAUNCH);
 
+        // We add back offered shared resources for validation even if they
+        // are already consumed by other tasks in the same ACCEPT call. This
+        // allows these tasks to use more copies of the same shared resource
+        // than those being offered. e.g., 2 tasks can be launched on 1 copy
+        // of a shared persistent volume from the offer; 3 tasks can be
+        // launched on 2 copies of a shared persistent volume from 2 offers.
+        //
+        // NOTE: This is kept up to date as tasks are launched rather than
+        // recomputed for each task, which would be quadratic in the number
+        // of tasks.
+        Resources available =
+          _offeredResources.nonShared() + offeredSharedResources;
+
         foreach (const TaskInfo& task, operation.launch().task_infos()) {
           Future<bool> authorization = authorizations.front();
           authorizations.pop_front();
@@ -4795,16 +4903,6 @@ void Master::_accept(
           }
 
           // Validate the task.
-
-          // We add back offered shared resources for validation even if they
-          // are already consumed by other tasks in the same ACCEPT call. This
-          // allows these tasks to use more copies of the same shared resource
-          // than those being offered. e.g., 2 tasks can be launched on 1 copy
-          // of a shared persistent volume from the offer; 3 tasks can be
-          // launched on 2 copies of a shared persistent volume from 2 offers.
-          Resources available =
-            _offeredResources.nonShared() + offeredSharedResources;
-
           Option<Error> error =
             validation::task::validate(task, framework, slave, available);
 
@@ -4839,6 +4937,7 @@ void Master::_accept(
               << available << " does not contain " << consumed;
 
             _offeredResources -= consumed;
+            available -= consumed.nonShared();
 
             RunTaskMessage message;
             message.mutable_framework()->MergeFrom(framework->info);
@@ -6106,16 +6205,6 @@ void Master::reregisterSlave(
     return;
   }
 
-  Option<Error> error = validation::master::message::reregisterSlave(
-      slaveInfo, tasks, checkpointedResources, executorInfos, frameworks);
-
-  if (error.isSome()) {
-    LOG(WARNING) << "Dropping re-registration of agent at " << from
-                 << " because it sent an invalid re-registration: "
-                 << error->message;
-    return;
-  }
-
   LOG(INFO) << "Received re-register agent message from agent "
             << slaveInfo.id() << " at " << from << " ("
             << slaveInfo.hostname() << ")";
@@ -6127,39 +6216,164 @@ void Master::reregisterSlave(
   // `authenticated` while the authorization is pending.
   Option<string> principal = authenticated.get(from);
 
-  authorizeSlave(principal)
+  // Validating the message and converting the resources of its tasks
+  // and executors can take a while for agents with many tasks. This
+  // is done on a worker, concurrently with the authorization, so that
+  // many agents can be prepared in parallel after a master failover.
+  Future<Try<Reregistration>> reregistration =
+    metrics->slave_reregistration_preparation.time(
+        async(&Self::prepareReregistration,
+              slaveInfo,
+              checkpointedResources,
+              executorInfos,
+              tasks,
+              frameworks,
+              completedFrameworks,
+              agentCapabilities));
+
+  Future<bool> authorized = authorizeSlave(principal);
+
+  await(reregistration, authorized)
     .onAny(defer(self(),
                  &Self::_reregisterSlave,
                  slaveInfo,
                  from,
                  principal,
                  checkpointedResources,
-                 executorInfos,
-                 tasks,
                  frameworks,
-                 completedFrameworks,
                  version,
                  agentCapabilities,
-                 lambda::_1));
+                 reregistration,
+                 authorized));
 }
 
 
-void Master::_reregisterSlave(
+Try<Master::Reregistration> Master::prepareReregistration(
     const SlaveInfo& slaveInfo,
-    const UPID& pid,
-    const Option<string>& principal,
     const vector<Resource>& checkpointedResources,
     const vector<ExecutorInfo>& executorInfos,
     const vector<Task>& tasks,
     const vector<FrameworkInfo>& frameworks,
     const vector<Archive::Framework>& completedFrameworks,
+    const vector<SlaveInfo::Capability>& agentCapabilities)
+{
+  Option<Error> error = validation::master::message::reregisterSlave(
+      slaveInfo, tasks, checkpointedResources, executorInfos, frameworks);
+
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  // For agents without the MULTI_ROLE capability,
+  // we need to inject the allocation role inside
+  // the task and executor resources;
+  auto injectAllocationInfo = [](
+      RepeatedPtrField<Resource>* resources,
+      const FrameworkInfo& frameworkInfo)
+  {
+    set<string> roles = protobuf::framework::getRoles(frameworkInfo);
+
+    foreach (Resource& resource, *resources) {
+      if (!resource.has_allocation_info()) {
+        if (roles.size() != 1) {
+          LOG(FATAL) << "Missing 'Resource.AllocationInfo' for resources"
+                     << " allocated to MULTI_ROLE framework"
+                     << " '" << frameworkInfo.name() << "'";
+        }
+
+        resource.mutable_allocation_info()->set_role(*roles.begin());
+      }
+    }
+  };
+
+  // Adjust the agent's task and executor infos to ensure
+  // compatibility with old agents without certain capabilities.
+  protobuf::slave::Capabilities slaveCapabilities(agentCapabilities);
+
+  Reregistration reregistration;
+  reregistration.executorInfos = executorInfos;
+  reregistration.tasks = tasks;
+  reregistration.completedFrameworks = completedFrameworks;
+
+  // If the agent is not multi-role capable, inject allocation info.
+  if (!slaveCapabilities.multiRole) {
+    hashmap<FrameworkID, FrameworkInfo> frameworks_;
+    foreach (const FrameworkInfo& framework, frameworks) {
+      frameworks_[framework.id()] = framework;
+    }
+
+    foreach (Task& task, reregistration.tasks) {
+      CHECK(frameworks_.contains(task.framework_id()));
+
+      injectAllocationInfo(
+          task.mutable_resources(),
+          frameworks_.at(task.framework_id()));
+    }
+
+    foreach (ExecutorInfo& executor, reregistration.executorInfos) {
+      CHECK(frameworks_.contains(executor.framework_id()));
+
+      injectAllocationInfo(
+          executor.mutable_resources(),
+          frameworks_.at(executor.framework_id()));
+    }
+  }
+
+  // Currently, The agent always downgrades the resources such that
+  // a 1.4.0 agent can speak to a pre-1.4.0 master. We therefore
+  // unconditionally upgrade the resources back here.
+  foreach (Task& task, reregistration.tasks) {
+    convertResourceFormat(
+        task.mutable_resources(), POST_RESERVATION_REFINEMENT);
+  }
+
+  foreach (ExecutorInfo& executor, reregistration.executorInfos) {
+    convertResourceFormat(
+        executor.mutable_resources(), POST_RESERVATION_REFINEMENT);
+  }
+
+  foreach (Archive::Framework& completedFramework,
+           reregistration.completedFrameworks) {
+    foreach (Task& task, *completedFramework.mutable_tasks()) {
+      convertResourceFormat(
+          task.mutable_resources(), POST_RESERVATION_REFINEMENT);
+    }
+  }
+
+  return reregistration;
+}
+
+
+void Master::_reregisterSlave(
+    const SlaveInfo& slaveInfo,
+    const UPID& pid,
+    const Option<string>& principal,
+    const vector<Resource>& checkpointedResources,
+    const vector<FrameworkInfo>& frameworks,
     const string& version,
     const vector<SlaveInfo::Capability>& agentCapabilities,
+    const Future<Try<Reregistration>>& reregistration,
     const Future<bool>& authorized)
 {
+  CHECK_READY(reregistration);
   CHECK(!authorized.isDiscarded());
   CHECK(slaves.reregistering.contains(slaveInfo.id()));
 
+  if (reregistration->isError()) {
+    LOG(WARNING) << "Dropping re-registration of agent at " << pid
+                 << " because it sent an invalid re-registration: "
+                 << reregistration->error();
+
+    slaves.reregistering.erase(slaveInfo.id());
+    return;
+  }
+
+  const vector<ExecutorInfo>& executorInfos =
+    reregistration->get().executorInfos;
+  const vector<Task>& tasks = reregistration->get().tasks;
+  const vector<Archive::Framework>& completedFrameworks =
+    reregistration->get().completedFrameworks;
+
   Option<string> authorizationError = None();
 
   if (authorized.isFailed()) {
@@ -6370,10 +6584,10 @@ void Master::__reregisterSlave(
     const SlaveInfo& slaveInfo,
     const UPID& pid,
     const vector<Resource>& checkpointedResources,
-    const vector<ExecutorInfo>& executorInfos_,
-    const vector<Task>& tasks_,
+    const vector<ExecutorInfo>& executorInfos,
+    const vector<Task>& tasks,
     const vector<FrameworkInfo>& frameworks,
-    const vector<Archive::Framework>& completedFrameworks_,
+    const vector<Archive::Framework>& completedFrameworks,
     const string& version,
     const vector<SlaveInfo::Capability>& agentCapabilities,
     const Future<bool>& readmit)
@@ -6397,80 +6611,6 @@ void Master::__reregisterSlave(
   // we've recovered it from the registry.
   slaves.recovered.erase(slaveInfo.id());
 
-  // For agents without the MULTI_ROLE capability,
-  // we need to inject the allocation role inside
-  // the task and executor resources;
-  auto injectAllocationInfo = [](
-      RepeatedPtrField<Resource>* resources,
-      const FrameworkInfo& frameworkInfo)
-  {
-    set<string> roles = protobuf::framework::getRoles(frameworkInfo);
-
-    foreach (Resource& resource, *resources) {
-      if (!resource.has_allocation_info()) {
-        if (roles.size() != 1) {
-          LOG(FATAL) << "Missing 'Resource.AllocationInfo' for resources"
-                     << " allocated to MULTI_ROLE framework"
-                     << " '" << frameworkInfo.name() << "'";
-        }
-
-        resource.mutable_allocation_info()->set_role(*roles.begin());
-      }
-    }
-  };
-
-  // Adjust the agent's task and executor infos to ensure
-  // compatibility with old agents without certain capabilities.
-  protobuf::slave::Capabilities slaveCapabilities(agentCapabilities);
-  vector<Task> tasks = tasks_;
-  vector<ExecutorInfo> executorInfos = executorInfos_;
-  vector<Archive::Framework> completedFrameworks = completedFrameworks_;
-
-  // If the agent is not multi-role capable, inject allocation info.
-  if (!slaveCapabilities.multiRole) {
-    hashmap<FrameworkID, FrameworkInfo> frameworks_;
-    foreach (const FrameworkInfo& framework, frameworks) {
-      frameworks_[framework.id()] = framework;
-    }
-
-    foreach (Task& task, tasks) {
-      CHECK(frameworks_.contains(task.framework_id()));
-
-      injectAllocationInfo(
-          task.mutable_resources(),
-          frameworks_.at(task.framework_id()));
-    }
-
-    foreach (ExecutorInfo& executor, executorInfos) {
-      CHECK(frameworks_.contains(executor.framework_id()));
-
-      injectAllocationInfo(
-          executor.mutable_resources(),
-          frameworks_.at(executor.framework_id()));
-    }
-  }
-
-  // Currently, The agent always downgrades the resources such that
-  // a 1.4.0 agent can speak to a pre-1.4.0 master. We therefore
-  // unconditionally upgrade the resources back here.
-  foreach (Task& task, tasks) {
-    convertResourceFormat(
-        task.mutable_resources(), POST_RESERVATION_REFINEMENT);
-  }
-
-  foreach (ExecutorInfo& executor, executorInfos) {
-    convertResourceFormat(
-        executor.mutable_resources(), POST_RESERVATION_REFINEMENT);
-  }
-
-  foreach (Archive::Framework& completedFramework,
-           completedFrameworks) {
-    foreach (Task& task, *completedFramework.mutable_tasks()) {
-      convertResourceFormat(
-          task.mutable_resources(), POST_RESERVATION_REFINEMENT);
-    }
-  }
-
   MachineID machineId;
   machineId.set_hostname(slaveInfo.hostname());
   machineId.set_ip(stringify(pid.address.ip));
@@ -6916,12 +7056,7 @@ void Master::updateUnavailability(
 
       // Remove and rescind offers since we want to inform frameworks of the
       // unavailability change as soon as possible.
-      foreach (Offer* offer, utils::copy(slave->offers)) {
-        allocator->recoverResources(
-            offer->framework_id(), slave->id, offer->resources(), None());
-
-        removeOffer(offer, true); // Rescind!
-      }
+      rescindOffers(slave->offers);
 
       // Remove and rescind inverse offers since the allocator will send new
       // inverse offers for the updated unavailability.
@@ -7355,6 +7490,8 @@ void Master::_reconcileTasks(
 
   ++metrics->messages_reconcile_tasks;
 
+  Framework::Reconciliation& reconciliation = framework->reconciliation;
+
   if (statuses.empty()) {
     // Implicit reconciliation.
     LOG(INFO) << "Performing implicit task state reconciliation"
@@ -7383,48 +7520,42 @@ void Master::_reconcileTasks(
       framework->send(message);
     }
 
-    foreachvalue (Task* task, framework->tasks) {
-      const TaskState& state = task->has_status_update_state()
-          ? task->status_update_state()
-          : task->state();
-
-      const Option<ExecutorID>& executorId = task->has_executor_id()
-          ? Option<ExecutorID>(task->executor_id())
-          : None();
+    // The launched tasks are answered in chunks, see
+    // `__reconcileTasks`. A repeated implicit reconciliation joins the
+    // pass in progress (if any) rather than restarting it, otherwise
+    // a framework reconciling more often than a pass takes would never
+    // hear about the tasks beyond the first chunks.
+    if (!reconciliation.implicit) {
+      reconciliation.implicit = true;
+      reconciliation.after = None();
+    }
+  } else {
+    // Explicit reconciliation.
+    LOG(INFO) << "Performing explicit task state reconciliation for "
+              << statuses.size() << " tasks of framework " << *framework;
 
-      const StatusUpdate& update = protobuf::createStatusUpdate(
-          framework->id(),
-          task->slave_id(),
-          task->task_id(),
-          state,
-          TaskStatus::SOURCE_MASTER,
-          None(),
-          "Reconciliation: Latest task state",
-          TaskStatus::REASON_RECONCILIATION,
-          executorId,
-          protobuf::getTaskHealth(*task),
-          protobuf::getTaskCheckStatus(*task),
-          None(),
-          protobuf::getTaskContainerStatus(*task));
+    reconciliation.statuses.insert(
+        reconciliation.statuses.end(), statuses.begin(), statuses.end());
+  }
 
-      VLOG(1) << "Sending implicit reconciliation state "
-              << update.status().state()
-              << " for task " << update.status().task_id()
-              << " of framework " << *framework;
+  if (!reconciliation.dispatched) {
+    __reconcileTasks(framework->id());
+  }
+}
 
-      // TODO(bmahler): Consider using forward(); might lead to too
-      // much logging.
-      StatusUpdateMessage message;
-      message.mutable_update()->CopyFrom(update);
-      framework->send(message);
-    }
 
+void Master::__reconcileTasks(const FrameworkID& frameworkId)
+{
+  Framework* framework = getFramework(frameworkId);
+  if (framework == nullptr) {
     return;
   }
 
-  // Explicit reconciliation.
-  LOG(INFO) << "Performing explicit task state reconciliation for "
-            << statuses.size() << " tasks of framework " << *framework;
+  Framework::Reconciliation& reconciliation = framework->reconciliation;
+  reconciliation.dispatched = false;
+
+  // The number of tasks that may still be answered in this chunk.
+  size_t remaining = RECONCILIATION_CHUNK_SIZE;
 
   // Explicit reconciliation occurs for the following cases:
   //   (1) Task is known, but pending: TASK_STAGING.
@@ -7437,7 +7568,11 @@ void Master::_reconcileTasks(
   //
   // For cases (3), (5), (6) and (7) TASK_LOST is sent instead if the
   // framework has not opted-in to the PARTITION_AWARE capability.
-  foreach (const TaskStatus& status, statuses) {
+  while (remaining > 0 && !reconciliation.statuses.empty()) {
+    const TaskStatus status = reconciliation.statuses.front();
+    reconciliation.statuses.pop_front();
+    --remaining;
+
     Option<SlaveID> slaveId = None();
     if (status.has_slave_id()) {
       slaveId = status.slave_id();
@@ -7583,6 +7718,70 @@ void Master::_reconcileTasks(
       framework->send(message);
     }
   }
+
+  // Implicit reconciliation answers the launched tasks in the order
+  // of the task index, so that a chunk costs time proportional to its
+  // size rather than to the number of tasks of the framework.
+  if (reconciliation.implicit && remaining > 0) {
+    TaskFilter filter;
+    filter.frameworkId = framework->id();
+
+    frameworks.tasks.visit(
+        filter,
+        reconciliation.after,
+        [&](const Task* task) {
+          const TaskState& state = task->has_status_update_state()
+              ? task->status_update_state()
+              : task->state();
+
+          const Option<ExecutorID>& executorId = task->has_executor_id()
+              ? Option<ExecutorID>(task->executor_id())
+              : None();
+
+          const StatusUpdate& update = protobuf::createStatusUpdate(
+              framework->id(),
+              task->slave_id(),
+              task->task_id(),
+              state,
+              TaskStatus::SOURCE_MASTER,
+              None(),
+              "Reconciliation: Latest task state",
+              TaskStatus::REASON_RECONCILIATION,
+              executorId,
+              protobuf::getTaskHealth(*task),
+              protobuf::getTaskCheckStatus(*task),
+              None(),
+              protobuf::getTaskContainerStatus(*task));
+
+          VLOG(1) << "Sending implicit reconciliation state "
+                  << update.status().state()
+                  << " for task " << update.status().task_id()
+                  << " of framework " << *framework;
+
+          // TODO(bmahler): Consider using forward(); might lead to too
+          // much logging.
+          StatusUpdateMessage message;
+          message.mutable_update()->CopyFrom(update);
+          framework->send(message);
+
+          reconciliation.after = TaskIndex::key(*task);
+
+          return --remaining > 0;
+        });
+
+    if (remaining > 0) {
+      reconciliation.implicit = false;
+      reconciliation.after = None();
+    }
+  }
+
+  // Answer the next chunk after the messages that have been queued
+  // in the meantime, so that a large reconciliation does not hold up
+  // the master.
+  if (reconciliation.implicit || !reconciliation.statuses.empty()) {
+    reconciliation.dispatched = true;
+    dispatch(self(), &Master::__reconcileTasks, framework->id());
+  }
 }
 
 
@@ -7691,7 +7890,14 @@ void Master::offer(
       url.mutable_address()->set_port(slave->pid.address.port);
       url.set_path("/" + slave->pid.id);
 
-      Offer* offer = new Offer();
+      Offer* offer = nullptr;
+      if (offerPool.empty()) {
+        offer = new Offer();
+      } else {
+        offer = offerPool.back().release();
+        offerPool.pop_back();
+      }
+
       offer->mutable_id()->MergeFrom(newOfferId());
       offer->mutable_framework_id()->MergeFrom(framework->id());
       offer->mutable_slave_id()->MergeFrom(slave->id);
@@ -7729,13 +7935,17 @@ void Master::offer(
 
       if (flags.offer_timeout.isSome()) {
         // Rescind the offer after the timeout elapses.
-        offerTimers[offer->id()] =
-          delay(flags.offer_timeout.get(),
-                self(),
-                &Self::offerTimeout,
-                offer->id());
+        offerExpirations.push_back(std::make_pair(
+            Clock::now() + flags.offer_timeout.get(), offer->id()));
+
+        if (offerExpirationTimer.isNone()) {
+          offerExpirationTimer =
+            delay(flags.offer_timeout.get(), self(), &Self::expireOffers);
+        }
       }
 
+      ++metrics->offers_sent;
+
       // TODO(jieyu): For now, we strip 'ephemeral_ports' resource from
       // offers so that frameworks do not see this resource. This is a
       // short term workaround. Revisit this once we resolve MESOS-1654.
@@ -8606,8 +8816,10 @@ void Master::removeFramework(Framework* framework)
     }
   }
 
-  // Remove the framework.
+  // Remove the framework. The resources of its tasks that are still
+  // to be recovered are passed to the allocator first.
   frameworks.registered.erase(framework->id());
+  flushRecoveredResources();
   allocator->removeFramework(framework->id());
 
   // The framework pointer is now owned by `frameworks.completed`.
@@ -8877,6 +9089,7 @@ void Master::_removeSlave(
   // only within recoverResources() (see MESOS-621). The calls to
   // recoverResources() below are therefore required, even though
   // the slave is already removed.
+  flushRecoveredResources();
   allocator->removeSlave(slave->id);
 
   // Transition the tasks to lost and remove them.
@@ -8918,15 +9131,11 @@ void Master::_removeSlave(
     }
   }
 
-  foreach (Offer* offer, utils::copy(slave->offers)) {
-    // TODO(vinod): We don't need to call 'Allocator::recoverResources'
-    // once MESOS-621 is fixed.
-    allocator->recoverResources(
-        offer->framework_id(), slave->id, offer->resources(), None());
-
-    // Remove and rescind offers.
-    removeOffer(offer, true); // Rescind!
-  }
+  // Remove and rescind offers.
+  //
+  // TODO(vinod): We don't need to call 'Allocator::recoverResources'
+  // once MESOS-621 is fixed.
+  rescindOffers(slave->offers);
 
   // Remove inverse offers because sending them for a slave that is
   // gone doesn't make sense.
@@ -8980,6 +9189,7 @@ void Master::__removeSlave(
   // only within recoverResources() (see MESOS-621). The calls to
   // recoverResources() below are therefore required, even though
   // the slave is already removed.
+  flushRecoveredResources();
   allocator->removeSlave(slave->id);
 
   // Transition tasks to TASK_UNREACHABLE/TASK_GONE_BY_OPERATOR/TASK_LOST
@@ -9042,15 +9252,11 @@ void Master::__removeSlave(
     }
   }
 
-  foreach (Offer* offer, utils::copy(slave->offers)) {
-    // TODO(vinod): We don't need to call 'Allocator::recoverResources'
-    // once MESOS-621 is fixed.
-    allocator->recoverResources(
-        offer->framework_id(), slave->id, offer->resources(), None());
-
-    // Remove and rescind offers.
-    removeOffer(offer, true); // Rescind!
-  }
+  // Remove and rescind offers.
+  //
+  // TODO(vinod): We don't need to call 'Allocator::recoverResources'
+  // once MESOS-621 is fixed.
+  rescindOffers(slave->offers);
 
   // Remove inverse offers because sending them for a slave that is
   // unreachable doesn't make sense.
@@ -9117,6 +9323,7 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
         sendSubscribersUpdate = true;
       }
 
+      frameworks.tasks.update(task, latestState.get());
       task->set_state(latestState.get());
     }
   } else {
@@ -9130,6 +9337,7 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
         sendSubscribersUpdate = true;
       }
 
+      frameworks.tasks.update(task, status.state());
       task->set_state(status.state());
     }
   }
@@ -9161,11 +9369,7 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
 
   // Once the task becomes removable, recover the resources.
   if (removable) {
-    allocator->recoverResources(
-        task->framework_id(),
-        task->slave_id(),
-        task->resources(),
-        None());
+    batchRecoverResources(*task);
 
     // The slave owns the Task object and cannot be nullptr.
     Slave* slave = slaves.registered.get(task->slave_id());
@@ -9225,6 +9429,36 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
 }
 
 
+void Master::batchRecoverResources(const Task& task)
+{
+  // Schedule a flush behind the messages that are already queued,
+  // e.g., the status updates of a burst of task terminations.
+  if (recoveredResources.empty()) {
+    dispatch(self(), &Self::flushRecoveredResources);
+  }
+
+  recoveredResources[task.framework_id()][task.slave_id()] +=
+    task.resources();
+}
+
+
+void Master::flushRecoveredResources()
+{
+  foreachkey (const FrameworkID& frameworkId, recoveredResources) {
+    foreachpair (const SlaveID& slaveId,
+                 const Resources& resources,
+                 recoveredResources.at(frameworkId)) {
+      // The allocator recovers the resources of one role at a time.
+      foreachvalue (const Resources& allocation, resources.allocations()) {
+        allocator->recoverResources(frameworkId, slaveId, allocation, None());
+      }
+    }
+  }
+
+  recoveredResources.clear();
+}
+
+
 void Master::removeTask(Task* task)
 {
   CHECK_NOTNULL(task);
@@ -9340,13 +9574,29 @@ void Master::_apply(Slave* slave, const Offer::Operation& operation)
 }
 
 
-void Master::offerTimeout(const OfferID& offerId)
+void Master::expireOffers()
 {
-  Offer* offer = getOffer(offerId);
-  if (offer != nullptr) {
-    allocator->recoverResources(
-        offer->framework_id(), offer->slave_id(), offer->resources(), None());
-    removeOffer(offer, true);
+  offerExpirationTimer = None();
+
+  const Time now = Clock::now();
+
+  while (!offerExpirations.empty() && offerExpirations.front().first <= now) {
+    // The offer may have been removed in the meantime.
+    Offer* offer = getOffer(offerExpirations.front().second);
+    offerExpirations.pop_front();
+
+    if (offer != nullptr) {
+      allocator->recoverResources(
+          offer->framework_id(), offer->slave_id(), offer->resources(), None());
+      removeOffer(offer, true);
+
+      ++metrics->offers_expired;
+    }
+  }
+
+  if (!offerExpirations.empty()) {
+    offerExpirationTimer = delay(
+        offerExpirations.front().first - now, self(), &Self::expireOffers);
   }
 }
 
@@ -9376,19 +9626,53 @@ void Master::removeOffer(Offer* offer, bool rescind)
     RescindResourceOfferMessage message;
     message.mutable_offer_id()->MergeFrom(offer->id());
     framework->send(message);
-  }
 
-  // Remove and cancel offer removal timers. Canceling the Timers is
-  // only done to avoid having too many active Timers in libprocess.
-  if (offerTimers.contains(offer->id())) {
-    Clock::cancel(offerTimers[offer->id()]);
-    offerTimers.erase(offer->id());
+    ++metrics->offers_rescinded;
   }
 
-  // Delete it.
   LOG(INFO) << "Removing offer " << offer->id();
   offers.erase(offer->id());
-  delete offer;
+
+  // Drop the expirations of removed offers once they outnumber the
+  // outstanding offers, so that accepted and declined offers do not
+  // accumulate until they would have expired.
+  if (offerExpirations.size() > 2 * offers.size() + 1) {
+    offerExpirations.erase(
+        std::remove_if(
+            offerExpirations.begin(),
+            offerExpirations.end(),
+            [this](const std::pair<Time, OfferID>& expiration) {
+              return !offers.contains(expiration.second);
+            }),
+        offerExpirations.end());
+
+    if (offerExpirations.empty() && offerExpirationTimer.isSome()) {
+      Clock::cancel(offerExpirationTimer.get());
+      offerExpirationTimer = None();
+    }
+  }
+
+  // Keep the offer for reuse; clearing it retains the memory of its
+  // fields.
+  if (offerPool.size() < MAX_POOLED_OFFERS) {
+    offer->Clear();
+    offerPool.emplace_back(offer);
+  } else {
+    delete offer;
+  }
+}
+
+
+void Master::rescindOffers(const hashset<Offer*>& offers)
+{
+  // Iterate over a copy, since `offers` may be the offers of a
+  // framework or an agent, which removing the offers modifies.
+  foreach (Offer* offer, utils::copy(offers)) {
+    allocator->recoverResources(
+        offer->framework_id(), offer->slave_id(), offer->resources(), None());
+
+    removeOffer(offer, true); // Rescind!
+  }
 }
 
 
@@ -9565,6 +9849,12 @@ double Master::_slaves_unreachable()
 }
 
 
+double Master::_slaves_reregistering()
+{
+  return slaves.reregistering.size();
+}
+
+
 double Master::_frameworks_connected()
 {
   double count = 0.0;
@@ -9815,66 +10105,91 @@ void Master::Subscribers::send(const mesos::master::Event& event)
   VLOG(1) << "Notifying all active subscribers about " << event.type()
           << " event";
 
-  foreachvalue (const Owned<Subscriber>& subscriber, subscribed) {
-    Future<Owned<AuthorizationAcceptor>> authorizeRole =
-      AuthorizationAcceptor::create(
-          subscriber->principal,
-          subscriber->master->authorizer,
-          authorization::VIEW_ROLE);
-
-    Future<Owned<AuthorizationAcceptor>> authorizeFramework =
-      AuthorizationAcceptor::create(
-          subscriber->principal,
-          subscriber->master->authorizer,
-          authorization::VIEW_FRAMEWORK);
-
-    Future<Owned<AuthorizationAcceptor>> authorizeTask =
-      AuthorizationAcceptor::create(
-          subscriber->principal,
-          subscriber->master->authorizer,
-          authorization::VIEW_TASK);
-
-    Future<Owned<AuthorizationAcceptor>> authorizeExecutor =
-      AuthorizationAcceptor::create(
-          subscriber->principal,
-          subscriber->master->authorizer,
-          authorization::VIEW_EXECUTOR);
-
-    collect(authorizeRole, authorizeFramework, authorizeTask, authorizeExecutor)
-      .then(defer(subscriber->master->self(),
-          [=](const tuple<Owned<AuthorizationAcceptor>,
-                          Owned<AuthorizationAcceptor>,
-                          Owned<AuthorizationAcceptor>,
-                          Owned<AuthorizationAcceptor>>& acceptors) {
-        Owned<AuthorizationAcceptor> authorizeRole;
-        Owned<AuthorizationAcceptor> authorizeFramework;
-        Owned<AuthorizationAcceptor> authorizeTask;
-        Owned<AuthorizationAcceptor> authorizeExecutor;
-
-        tie(authorizeRole,
-            authorizeFramework,
-            authorizeTask,
-            authorizeExecutor) = acceptors;
-
-        subscriber->send(event,
-            authorizeRole,
-            authorizeFramework,
-            authorizeTask,
-            authorizeExecutor);
-
-        return Nothing();
-      }));
+  shared_ptr<SharedEvent> sharedEvent(new SharedEvent(event));
+
+  vector<UUID> disconnected;
+
+  foreachpair (const UUID& id,
+               const Owned<Subscriber>& subscriber,
+               subscribed) {
+    subscriber->pending.push_back(sharedEvent);
+
+    if (subscriber->authorized()) {
+      if (!subscriber->flush()) {
+        disconnected.push_back(id);
+      }
+    } else if (subscriber->pending.size() > MAX_SUBSCRIBER_PENDING_EVENTS) {
+      LOG(WARNING) << "Disconnecting subscriber " << id << " because more"
+                   << " than " << MAX_SUBSCRIBER_PENDING_EVENTS << " events"
+                   << " are pending while it is being authorized";
+
+      disconnected.push_back(id);
+    }
+  }
+
+  // Removing a subscriber closes its connection.
+  foreach (const UUID& id, disconnected) {
+    subscribed.erase(id);
+  }
+}
+
+
+const string& Master::Subscribers::SharedEvent::record(ContentType contentType)
+{
+  if (!records.count(contentType)) {
+    if (evolved.isNone()) {
+      evolved = evolve(event);
+    }
+
+    ::recordio::Encoder<v1::master::Event> encoder(lambda::bind(
+        serialize, contentType, lambda::_1));
+
+    records[contentType] = encoder.encode(evolved.get());
   }
+
+  return records.at(contentType);
+}
+
+
+bool Master::Subscribers::Subscriber::authorized() const
+{
+  return !authorizeRole.isPending() &&
+         !authorizeFramework.isPending() &&
+         !authorizeTask.isPending() &&
+         !authorizeExecutor.isPending();
+}
+
+
+bool Master::Subscribers::Subscriber::flush()
+{
+  CHECK(authorized());
+
+  if (!authorizeRole.isReady() ||
+      !authorizeFramework.isReady() ||
+      !authorizeTask.isReady() ||
+      !authorizeExecutor.isReady()) {
+    LOG(WARNING) << "Disconnecting subscriber " << http.streamId
+                 << " and dropping " << pending.size() << " events because"
+                 << " it could not be authorized";
+
+    pending.clear();
+    return false;
+  }
+
+  while (!pending.empty()) {
+    send(pending.front());
+    pending.pop_front();
+  }
+
+  return true;
 }
 
 
 void Master::Subscribers::Subscriber::send(
-    const mesos::master::Event& event,
-    const Owned<AuthorizationAcceptor>& authorizeRole,
-    const Owned<AuthorizationAcceptor>& authorizeFramework,
-    const Owned<AuthorizationAcceptor>& authorizeTask,
-    const Owned<AuthorizationAcceptor>& authorizeExecutor)
+    const shared_ptr<SharedEvent>& sharedEvent)
 {
+  const mesos::master::Event& event = sharedEvent->event;
+
   switch (event.type()) {
     case mesos::master::Event::TASK_ADDED: {
       Framework* framework =
@@ -9884,9 +10199,10 @@ void Master::Subscribers::Subscriber::send(
         break;
       }
 
-      if (authorizeTask->accept(event.task_added().task(), framework->info) &&
-          authorizeFramework->accept(framework->info)) {
-        http.send<mesos::master::Event, v1::master::Event>(event);
+      if (authorizeTask.get()->accept(
+              event.task_added().task(), framework->info) &&
+          authorizeFramework.get()->accept(framework->info)) {
+        http.write(sharedEvent->record(http.contentType));
       }
       break;
     }
@@ -9905,14 +10221,14 @@ void Master::Subscribers::Subscriber::send(
         break;
       }
 
-      if (authorizeTask->accept(*task, framework->info) &&
-          authorizeFramework->accept(framework->info)) {
-        http.send<mesos::master::Event, v1::master::Event>(event);
+      if (authorizeTask.get()->accept(*task, framework->info) &&
+          authorizeFramework.get()->accept(framework->info)) {
+        http.write(sharedEvent->record(http.contentType));
       }
       break;
     }
     case mesos::master::Event::FRAMEWORK_ADDED: {
-      if (authorizeFramework->accept(
+      if (authorizeFramework.get()->accept(
               event.framework_added().framework().framework_info())) {
         mesos::master::Event event_(event);
         event_.mutable_framework_added()->mutable_framework()->
@@ -9923,7 +10239,7 @@ void Master::Subscribers::Subscriber::send(
         foreach(
             const Resource& resource,
             event.framework_added().framework().allocated_resources()) {
-          if (authorizeResource(resource, authorizeRole)) {
+          if (authorizeResource(resource, authorizeRole.get())) {
             event_.mutable_framework_added()->mutable_framework()->
               add_allocated_resources()->CopyFrom(resource);
           }
@@ -9932,7 +10248,7 @@ void Master::Subscribers::Subscriber::send(
         foreach(
             const Resource& resource,
             event.framework_added().framework().offered_resources()) {
-          if (authorizeResource(resource, authorizeRole)) {
+          if (authorizeResource(resource, authorizeRole.get())) {
             event_.mutable_framework_added()->mutable_framework()->
               add_offered_resources()->CopyFrom(resource);
           }
@@ -9943,7 +10259,7 @@ void Master::Subscribers::Subscriber::send(
       break;
     }
     case mesos::master::Event::FRAMEWORK_UPDATED: {
-      if (authorizeFramework->accept(
+      if (authorizeFramework.get()->accept(
               event.framework_updated().framework().framework_info())) {
         mesos::master::Event event_(event);
         event_.mutable_framework_updated()->mutable_framework()->
@@ -9954,7 +10270,7 @@ void Master::Subscribers::Subscriber::send(
         foreach(
             const Resource& resource,
             event.framework_updated().framework().allocated_resources()) {
-          if (authorizeResource(resource, authorizeRole)) {
+          if (authorizeResource(resource, authorizeRole.get())) {
             event_.mutable_framework_updated()->mutable_framework()->
               add_allocated_resources()->CopyFrom(resource);
           }
@@ -9963,7 +10279,7 @@ void Master::Subscribers::Subscriber::send(
         foreach(
             const Resource& resource,
             event.framework_updated().framework().offered_resources()) {
-          if (authorizeResource(resource, authorizeRole)) {
+          if (authorizeResource(resource, authorizeRole.get())) {
             event_.mutable_framework_updated()->mutable_framework()->
               add_offered_resources()->CopyFrom(resource);
           }
@@ -9974,9 +10290,9 @@ void Master::Subscribers::Subscriber::send(
       break;
     }
     case mesos::master::Event::FRAMEWORK_REMOVED: {
-      if (authorizeFramework->accept(
+      if (authorizeFramework.get()->accept(
               event.framework_removed().framework_info())) {
-        http.send<mesos::master::Event, v1::master::Event>(event);
+        http.write(sharedEvent->record(http.contentType));
       }
       break;
     }
@@ -9988,7 +10304,7 @@ void Master::Subscribers::Subscriber::send(
       foreach(
           const Resource& resource,
           event.agent_added().agent().total_resources()) {
-        if (authorizeResource(resource, authorizeRole)) {
+        if (authorizeResource(resource, authorizeRole.get())) {
           event_.mutable_agent_added()->mutable_agent()->add_total_resources()
             ->CopyFrom(resource);
         }
@@ -9998,7 +10314,7 @@ void Master::Subscribers::Subscriber::send(
       break;
     }
     default:
-      http.send<mesos::master::Event, v1::master::Event>(event);
+      http.write(sharedEvent->record(http.contentType));
       break;
   }
 }
@@ -10031,10 +10347,27 @@ void Master::subscribe(
              exited(http.streamId);
            }));
 
-  subscribers.subscribed.put(
-      http.streamId,
-      Owned<Subscribers::Subscriber>(
-          new Subscribers::Subscriber{this, http, principal}));
+  Subscribers::Subscriber* subscriber =
+    new Subscribers::Subscriber{this, http, principal};
+
+  subscribers.subscribed.put(http.streamId, Owned<Subscribers::Subscriber>(
+      subscriber));
+
+  // Send the events that were queued while the acceptors of the
+  // subscriber were being created.
+  await(subscriber->authorizeRole,
+        subscriber->authorizeFramework,
+        subscriber->authorizeTask,
+        subscriber->authorizeExecutor)
+    .then(defer(self(), [this, http]() {
+      // Removing a subscriber closes its connection.
+      if (subscribers.subscribed.contains(http.streamId) &&
+          !subscribers.subscribed.at(http.streamId)->flush()) {
+        subscribers.subscribed.erase(http.streamId);
+      }
+
+      return Nothing();
+    }));
 }
 
 
@@ -19,10 +19,13 @@
 
 #include <stdint.h>
 
+#include <deque>
 #include <list>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/circular_buffer.hpp>
@@ -49,6 +52,7 @@
 #include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
+#include <process/time.hpp>
 #include <process/timer.hpp>
 
 #include <process/metrics/counter.hpp>
@@ -75,11 +79,15 @@
 #include "internal/devolve.hpp"
 #include "internal/evolve.hpp"
 
+#include "master/compact_task.hpp"
 #include "master/constants.hpp"
 #include "master/flags.hpp"
 #include "master/machine.hpp"
 #include "master/metrics.hpp"
 #include "master/registrar.hpp"
+#include "master/response_cache.hpp"
+#include "master/state_view.hpp"
+#include "master/task_index.hpp"
 #include "master/validation.hpp"
 
 #include "messages/messages.hpp"
@@ -290,6 +298,12 @@ struct HttpConnection
     return writer.write(encoder.encode(evolve(message)));
   }
 
+  // Sends a record that has already been encoded for `contentType`.
+  bool write(const std::string& record)
+  {
+    return writer.write(record);
+  }
+
   bool close()
   {
     return writer.close();
@@ -586,17 +600,36 @@ protected:
       const std::vector<SlaveInfo::Capability>& agentCapabilities,
       const process::Future<bool>& admit);
 
-  void _reregisterSlave(
+  // The executors, tasks and completed frameworks of a re-registering
+  // agent, with their resources in the format used by the master.
+  struct Reregistration
+  {
+    std::vector<ExecutorInfo> executorInfos;
+    std::vector<Task> tasks;
+    std::vector<Archive::Framework> completedFrameworks;
+  };
+
+  // Validates a re-registration message and prepares its executors,
+  // tasks and completed frameworks. This does not depend on the state
+  // of the master, so it is run off the master actor.
+  static Try<Reregistration> prepareReregistration(
       const SlaveInfo& slaveInfo,
-      const process::UPID& pid,
-      const Option<std::string>& principal,
       const std::vector<Resource>& checkpointedResources,
       const std::vector<ExecutorInfo>& executorInfos,
       const std::vector<Task>& tasks,
       const std::vector<FrameworkInfo>& frameworks,
       const std::vector<Archive::Framework>& completedFrameworks,
+      const std::vector<SlaveInfo::Capability>& agentCapabilities);
+
+  void _reregisterSlave(
+      const SlaveInfo& slaveInfo,
+      const process::UPID& pid,
+      const Option<std::string>& principal,
+      const std::vector<Resource>& checkpointedResources,
+      const std::vector<FrameworkInfo>& frameworks,
       const std::string& version,
       const std::vector<SlaveInfo::Capability>& agentCapabilities,
+      const process::Future<Try<Reregistration>>& reregistration,
       const process::Future<bool>& authorized);
 
   void __reregisterSlave(
@@ -634,6 +667,11 @@ protected:
       Framework* framework,
       const std::vector<TaskStatus>& statuses);
 
+  // Answers the next chunk of at most `RECONCILIATION_CHUNK_SIZE`
+  // tasks of the reconciliation that is in progress for the framework,
+  // and dispatches itself for the following chunk, if any.
+  void __reconcileTasks(const FrameworkID& frameworkId);
+
   // When a slave that was previously registered with this master
   // re-registers, we need to reconcile the master's view of the
   // slave's tasks and executors.  This function also sends the
@@ -852,6 +890,20 @@ protected:
   // terminal.
   void updateTask(Task* task, const StatusUpdate& update);
 
+  // Recovers the resources of a task that has become removable in the
+  // allocator. The resources are aggregated by framework and agent,
+  // and recovered with a single call per framework, agent and role
+  // once the messages that are already queued have been processed.
+  // This keeps bursts of terminal status updates, e.g., when a
+  // framework is torn down or an agent is lost, from flooding the
+  // allocator.
+  void batchRecoverResources(const Task& task);
+
+  // Recovers the resources aggregated by `batchRecoverResources()`.
+  // Must be called before removing a framework or an agent from the
+  // allocator.
+  void flushRecoveredResources();
+
   // Removes the task.
   void removeTask(Task* task);
 
@@ -876,12 +928,18 @@ protected:
       const process::UPID& acknowledgee,
       Framework* framework);
 
-  // Remove an offer after specified timeout
-  void offerTimeout(const OfferID& offerId);
+  // Rescinds the offers that have been outstanding for longer than
+  // `--offer_timeout`, and schedules itself for the next offer to
+  // expire, if any.
+  void expireOffers();
 
   // Remove an offer and optionally rescind the offer as well.
   void removeOffer(Offer* offer, bool rescind = false);
 
+  // Recovers the resources of the offers in the allocator, and removes
+  // and rescinds the offers, e.g., all offers of an agent.
+  void rescindOffers(const hashset<Offer*>& offers);
+
   // Remove an inverse offer after specified timeout
   void inverseOfferTimeout(const OfferID& inverseOfferId);
 
@@ -1027,6 +1085,18 @@ private:
 
   void doRegistryGc();
 
+  // Publishes a snapshot of the state to the state view, which asks
+  // for it when serving a request, see `StateView`.
+  void captureStateSnapshot();
+
+  // Serves a read-only HTTP request through the response cache, if
+  // enabled. Requests with the same `key` and principal share a single
+  // invocation of `f`, see `--http_response_cache_ttl`.
+  process::Future<process::http::Response> cached(
+      const std::string& key,
+      const Option<process::http::authentication::Principal>& principal,
+      const lambda::function<process::Future<process::http::Response>()>& f);
+
   void _doRegistryGc(
       const hashset<SlaveID>& toRemoveUnreachable,
       const hashset<SlaveID>& toRemoveGone,
@@ -1413,6 +1483,11 @@ private:
     static std::string QUOTA_HELP();
     static std::string WEIGHTS_HELP();
 
+    // Captures the unfiltered state of the master, from which the
+    // read-only operator API calls and endpoints are served if
+    // `--state_snapshot_interval` is set.
+    std::shared_ptr<StateSnapshot> snapshot() const;
+
   private:
     JSON::Object __flags() const;
 
@@ -1601,9 +1676,15 @@ private:
         const Option<process::http::authentication::Principal>& principal,
         ContentType contentType) const;
 
+    // Returns the tasks that match `filter`. The tasks that have been
+    // launched on agents are returned in the order of their keys in
+    // `TaskIndex`, starting after `after`, and at most `limit` of them.
     mesos::master::Response::GetTasks _getTasks(
         const process::Owned<ObjectApprover>& frameworksApprover,
-        const process::Owned<ObjectApprover>& tasksApprover) const;
+        const process::Owned<ObjectApprover>& tasksApprover,
+        const TaskFilter& filter = TaskFilter(),
+        const Option<TaskIndex::Key>& after = None(),
+        const Option<size_t>& limit = None()) const;
 
     process::Future<process::http::Response> createVolumes(
         const mesos::master::Call& call,
@@ -1744,6 +1825,18 @@ private:
   // should GC some information from the registry.
   Option<process::Timer> registryGcTimer;
 
+  // The snapshot of the state that the read-only operator API calls
+  // are served from, if `--state_snapshot_interval` is set.
+  Option<process::Owned<StateView>> stateView;
+
+  // Shares the responses to identical read-only HTTP requests, if
+  // `--http_response_cache_ttl` is set.
+  Option<process::Owned<ResponseCache>> responseCache;
+
+  // Resources of removable tasks that are yet to be recovered in the
+  // allocator, see `batchRecoverResources()`.
+  hashmap<FrameworkID, hashmap<SlaveID, Resources>> recoveredResources;
+
   struct Slaves
   {
     Slaves() : removed(MAX_REMOVED_SLAVES) {}
@@ -1914,10 +2007,33 @@ private:
     // The default limiter is for frameworks not specified in
     // 'flags.rate_limits'.
     Option<process::Owned<BoundedRateLimiter>> defaultLimiter;
+
+    // Secondary indexes over the tasks of the registered frameworks,
+    // which are used to select tasks in the operator API.
+    TaskIndex tasks;
+
+    // Shares the values of the completed tasks of all frameworks.
+    CompactTask::Pool pool;
   } frameworks;
 
   struct Subscribers
   {
+    // An event for the subscribers. The event is evolved and encoded
+    // at most once per content type, and the record is shared by all
+    // the subscribers that receive the event unmodified.
+    struct SharedEvent
+    {
+      explicit SharedEvent(const mesos::master::Event& _event)
+        : event(_event) {}
+
+      // Returns the record of the event for the content type.
+      const std::string& record(ContentType contentType);
+
+      const mesos::master::Event event;
+      Option<v1::master::Event> evolved;
+      std::map<ContentType, std::string> records;
+    };
+
     // Represents a client subscribed to the 'api/vX' endpoint.
     //
     // TODO(anand): Add support for filtering. Some subscribers
@@ -1930,7 +2046,15 @@ private:
           const Option<process::http::authentication::Principal> _principal)
         : master(_master),
           http(_http),
-          principal(_principal)
+          principal(_principal),
+          authorizeRole(AuthorizationAcceptor::create(
+              principal, master->authorizer, authorization::VIEW_ROLE)),
+          authorizeFramework(AuthorizationAcceptor::create(
+              principal, master->authorizer, authorization::VIEW_FRAMEWORK)),
+          authorizeTask(AuthorizationAcceptor::create(
+              principal, master->authorizer, authorization::VIEW_TASK)),
+          authorizeExecutor(AuthorizationAcceptor::create(
+              principal, master->authorizer, authorization::VIEW_EXECUTOR))
       {
         mesos::master::Event event;
         event.set_type(mesos::master::Event::HEARTBEAT);
@@ -1951,11 +2075,19 @@ private:
       Subscriber(const Subscriber&) = delete;
       Subscriber& operator=(const Subscriber&) = delete;
 
-      void send(const mesos::master::Event& event,
-          const process::Owned<AuthorizationAcceptor>& authorizeRole,
-          const process::Owned<AuthorizationAcceptor>& authorizeFramework,
-          const process::Owned<AuthorizationAcceptor>& authorizeTask,
-          const process::Owned<AuthorizationAcceptor>& authorizeExecutor);
+      // Returns true once the acceptors have been created, whether
+      // or not that succeeded.
+      bool authorized() const;
+
+      // Sends the pending events, once the acceptors are ready.
+      // Returns false if the acceptors could not be created, in which
+      // case the subscriber needs to be removed (it would not receive
+      // any events otherwise).
+      bool flush();
+
+      // Sends the event to the client, if the client is authorized
+      // to view it. The acceptors must be ready.
+      void send(const std::shared_ptr<SharedEvent>& event);
 
       ~Subscriber()
       {
@@ -1974,6 +2106,22 @@ private:
       process::Owned<Heartbeater<mesos::master::Event, v1::master::Event>>
         heartbeater;
       const Option<process::http::authentication::Principal> principal;
+
+      // The acceptors are created once per subscriber rather than for
+      // every event, which means that changes to the permissions of the
+      // principal take effect when the client subscribes again.
+      const process::Future<process::Owned<AuthorizationAcceptor>>
+        authorizeRole;
+      const process::Future<process::Owned<AuthorizationAcceptor>>
+        authorizeFramework;
+      const process::Future<process::Owned<AuthorizationAcceptor>>
+        authorizeTask;
+      const process::Future<process::Owned<AuthorizationAcceptor>>
+        authorizeExecutor;
+
+      // Events that are waiting for the acceptors, in order. This is
+      // bounded by `MAX_SUBSCRIBER_PENDING_EVENTS`.
+      std::deque<std::shared_ptr<SharedEvent>> pending;
     };
 
     // Sends the event to all subscribers connected to the 'api/vX' endpoint.
@@ -1985,7 +2133,19 @@ private:
   } subscribers;
 
   hashmap<OfferID, Offer*> offers;
-  hashmap<OfferID, process::Timer> offerTimers;
+
+  // The offers in the order in which they expire, which is the order
+  // in which they were created since `--offer_timeout` is the same for
+  // all offers. Offers that have been removed are skipped when they
+  // expire, so that only a single timer is needed for all offers, and
+  // dropped once they outnumber the outstanding offers, see
+  // `removeOffer()`.
+  std::deque<std::pair<process::Time, OfferID>> offerExpirations;
+  Option<process::Timer> offerExpirationTimer;
+
+  // Offers that have been removed, which are reused for new offers to
+  // avoid allocating the offer and its fields for every offer cycle.
+  std::vector<std::unique_ptr<Offer>> offerPool;
 
   hashmap<OfferID, InverseOffer*> inverseOffers;
   hashmap<OfferID, process::Timer> inverseOfferTimers;
@@ -2048,6 +2208,7 @@ private:
   double _slaves_active();
   double _slaves_inactive();
   double _slaves_unreachable();
+  double _slaves_reregistering();
 
   double _frameworks_connected();
   double _frameworks_disconnected();
@@ -2491,6 +2652,7 @@ struct Framework
     }
 
     tasks[task->task_id()] = task;
+    master->frameworks.tasks.add(task);
 
     if (!Master::isRemovable(task->state())) {
       totalUsedResources += task->resources();
@@ -2573,7 +2735,7 @@ struct Framework
     // means that there might be multiple completed tasks with the
     // same task ID. We should consider rejecting attempts to reuse
     // task IDs (MESOS-6779).
-    completedTasks.push_back(process::Owned<Task>(new Task(task)));
+    completedTasks.push_back(CompactTask(task, &master->frameworks.pool));
   }
 
   void addUnreachableTask(const Task& task)
@@ -2601,6 +2763,7 @@ struct Framework
       addCompletedTask(*task);
     }
 
+    master->frameworks.tasks.remove(task);
     tasks.erase(task->task_id());
   }
 
@@ -2953,18 +3116,47 @@ struct Framework
   // state and have had all their updates acknowledged. We only keep a
   // fixed-size cache to avoid consuming too much memory. We use
   // boost::circular_buffer rather than BoundedHashMap because there
-  // can be multiple completed tasks with the same task ID.
+  // can be multiple completed tasks with the same task ID. The tasks
+  // are kept in a compact representation, see `CompactTask`.
   //
   // NOTE: When an agent is marked unreachable, non-partition-aware
   // tasks are marked TASK_LOST and stored here; partition-aware tasks
   // are marked TASK_UNREACHABLE and stored in `unreachableTasks`.
-  boost::circular_buffer<process::Owned<Task>> completedTasks;
+  boost::circular_buffer<CompactTask> completedTasks;
 
   // Partition-aware tasks running on agents that have been marked
   // unreachable. We only keep a fixed-size cache to avoid consuming
   // too much memory.
   BoundedHashMap<TaskID, process::Owned<Task>> unreachableTasks;
 
+  // The task reconciliation that the master is answering in chunks.
+  struct Reconciliation
+  {
+    Reconciliation() : implicit(false), dispatched(false) {}
+
+    // Drops the reconciliation in progress, e.g., when the framework
+    // fails over and will reconcile again.
+    void reset()
+    {
+      implicit = false;
+      after = None();
+      statuses.clear();
+    }
+
+    // Whether an implicit reconciliation is in progress.
+    bool implicit;
+
+    // Whether the next chunk has been dispatched to the master.
+    bool dispatched;
+
+    // The last launched task answered by the implicit reconciliation.
+    Option<TaskIndex::Key> after;
+
+    // The tasks of the explicit reconciliations that have not been
+    // answered yet.
+    std::deque<TaskStatus> statuses;
+  } reconciliation;
+
   hashset<Offer*> offers; // Active offers for framework.
 
   hashset<InverseOffer*> inverseOffers; // Active inverse offers for framework.
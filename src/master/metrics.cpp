@@ -59,6 +59,9 @@ Metrics::Metrics(const Master& master)
     slaves_unreachable(
         "master/slaves_unreachable",
         defer(master, &Master::_slaves_unreachable)),
+    slaves_reregistering(
+        "master/slaves_reregistering",
+        defer(master, &Master::_slaves_reregistering)),
     frameworks_connected(
         "master/frameworks_connected",
         defer(master, &Master::_frameworks_connected)),
@@ -74,6 +77,12 @@ Metrics::Metrics(const Master& master)
     outstanding_offers(
         "master/outstanding_offers",
         defer(master, &Master::_outstanding_offers)),
+    offers_sent(
+        "master/offers_sent"),
+    offers_rescinded(
+        "master/offers_rescinded"),
+    offers_expired(
+        "master/offers_expired"),
     tasks_staging(
         "master/tasks_staging",
         defer(master, &Master::_tasks_staging)),
@@ -199,7 +208,9 @@ Metrics::Metrics(const Master& master)
     slave_unreachable_completed(
         "master/slave_unreachable_completed"),
     slave_unreachable_canceled(
-        "master/slave_unreachable_canceled")
+        "master/slave_unreachable_canceled"),
+    slave_reregistration_preparation(
+        "master/slave_reregistration_preparation")
 {
   // TODO(dhamon): Check return values of 'add'.
   process::metrics::add(uptime_secs);
@@ -210,6 +221,7 @@ Metrics::Metrics(const Master& master)
   process::metrics::add(slaves_active);
   process::metrics::add(slaves_inactive);
   process::metrics::add(slaves_unreachable);
+  process::metrics::add(slaves_reregistering);
 
   process::metrics::add(frameworks_connected);
   process::metrics::add(frameworks_disconnected);
@@ -217,6 +229,9 @@ Metrics::Metrics(const Master& master)
   process::metrics::add(frameworks_inactive);
 
   process::metrics::add(outstanding_offers);
+  process::metrics::add(offers_sent);
+  process::metrics::add(offers_rescinded);
+  process::metrics::add(offers_expired);
 
   process::metrics::add(tasks_staging);
   process::metrics::add(tasks_starting);
@@ -294,6 +309,8 @@ Metrics::Metrics(const Master& master)
   process::metrics::add(slave_unreachable_completed);
   process::metrics::add(slave_unreachable_canceled);
 
+  process::metrics::add(slave_reregistration_preparation);
+
   // Create resource gauges.
   // TODO(dhamon): Set these up dynamically when adding a slave based on the
   // resources the slave exposes.
@@ -356,6 +373,7 @@ Metrics::~Metrics()
   process::metrics::remove(slaves_active);
   process::metrics::remove(slaves_inactive);
   process::metrics::remove(slaves_unreachable);
+  process::metrics::remove(slaves_reregistering);
 
   process::metrics::remove(frameworks_connected);
   process::metrics::remove(frameworks_disconnected);
@@ -363,6 +381,9 @@ Metrics::~Metrics()
   process::metrics::remove(frameworks_inactive);
 
   process::metrics::remove(outstanding_offers);
+  process::metrics::remove(offers_sent);
+  process::metrics::remove(offers_rescinded);
+  process::metrics::remove(offers_expired);
 
   process::metrics::remove(tasks_staging);
   process::metrics::remove(tasks_starting);
@@ -440,6 +461,8 @@ Metrics::~Metrics()
   process::metrics::remove(slave_unreachable_completed);
   process::metrics::remove(slave_unreachable_canceled);
 
+  process::metrics::remove(slave_reregistration_preparation);
+
   foreach (const Gauge& gauge, resources_total) {
     process::metrics::remove(gauge);
   }
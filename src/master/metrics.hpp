@@ -23,7 +23,9 @@
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 
 #include "mesos/mesos.hpp"
@@ -49,6 +51,7 @@ struct Metrics
   process::metrics::Gauge slaves_active;
   process::metrics::Gauge slaves_inactive;
   process::metrics::Gauge slaves_unreachable;
+  process::metrics::Gauge slaves_reregistering;
 
   process::metrics::Gauge frameworks_connected;
   process::metrics::Gauge frameworks_disconnected;
@@ -57,6 +60,13 @@ struct Metrics
 
   process::metrics::Gauge outstanding_offers;
 
+  // Offer churn: the offers that have been sent to frameworks, and
+  // those that have been rescinded, including the ones that expired
+  // after `--offer_timeout`.
+  process::metrics::Counter offers_sent;
+  process::metrics::Counter offers_rescinded;
+  process::metrics::Counter offers_expired;
+
   // Task state metrics.
   process::metrics::Gauge tasks_staging;
   process::metrics::Gauge tasks_starting;
@@ -191,6 +201,10 @@ struct Metrics
   process::metrics::Counter slave_unreachable_completed;
   process::metrics::Counter slave_unreachable_canceled;
 
+  // Time spent off the master actor validating and preparing the
+  // message of a re-registering agent.
+  process::metrics::Timer<Milliseconds> slave_reregistration_preparation;
+
   // Non-revocable resources.
   std::vector<process::metrics::Gauge> resources_total;
   std::vector<process::metrics::Gauge> resources_used;
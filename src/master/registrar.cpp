@@ -16,6 +16,11 @@
 
 #include <deque>
 #include <string>
+#include <vector>
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+#include <google/protobuf/repeated_field.h>
 
 #include <mesos/type_utils.hpp>
 
@@ -34,6 +39,8 @@
 #include <process/metrics/metrics.hpp>
 #include <process/metrics/timer.hpp>
 
+#include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
@@ -72,6 +79,12 @@ using process::metrics::Timer;
 
 using std::deque;
 using std::string;
+using std::vector;
+
+using google::protobuf::Descriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Reflection;
+using google::protobuf::RepeatedPtrField;
 
 namespace mesos {
 namespace internal {
@@ -92,6 +105,7 @@ public:
     : ProcessBase(process::ID::generate("registrar")),
       metrics(*this),
       state(_state),
+      journalSize(0),
       updating(false),
       flags(_flags),
       authenticationRealm(_authenticationRealm) {}
@@ -200,7 +214,12 @@ private:
   void _recover(
       const MasterInfo& info,
       const Future<Variable>& recovery);
-  void __recover(const Future<bool>& recover);
+  void fetchJournal(const MasterInfo& info);
+  void __recover(
+      const MasterInfo& info,
+      const Future<Variable>& recovery);
+  void ___recover(const MasterInfo& info);
+  void ____recover(const Future<bool>& recover);
   Future<bool> _apply(Owned<Operation> operation);
 
   // Helper for updating state (performing store).
@@ -208,7 +227,8 @@ private:
   void _update(
       const Future<Option<Variable>>& store,
       const Owned<Registry>& updatedRegistry,
-      deque<Owned<Operation>> operations);
+      deque<Owned<Operation>> operations,
+      bool journaled);
 
   // Fails all pending operations and transitions the Registrar
   // into an error state in which all subsequent operations will fail.
@@ -230,6 +250,13 @@ private:
   Option<Variable> variable;
   Option<Registry> registry;
 
+  // The variables of the registry journal, the i-th of which holds
+  // the i-th delta since the registry was last stored in full (see
+  // `RegistryDelta`), and the number of those deltas. The journal is
+  // only fetched if it can be used or contain deltas.
+  vector<Variable> journal;
+  size_t journalSize;
+
   deque<Owned<Operation>> operations;
   bool updating; // Used to signify fetching (recovering) or storing.
 
@@ -262,6 +289,14 @@ Future<T> timeout(
 }
 
 
+// Returns the name of the variable that holds the `index`-th delta of
+// the registry journal, starting at 1.
+static string journalEntry(size_t index)
+{
+  return "registry_journal/" + stringify(index);
+}
+
+
 // Helper for failing a deque of operations.
 void fail(deque<Owned<Operation>>* operations, const string& message)
 {
@@ -272,6 +307,304 @@ void fail(deque<Owned<Operation>>* operations, const string& message)
 }
 
 
+// Helpers for accessing the lists of agents in the registry.
+static const SlaveID& id(const Registry::Slave& slave)
+{
+  return slave.info().id();
+}
+
+
+static const SlaveID& id(const Registry::UnreachableSlave& slave)
+{
+  return slave.id();
+}
+
+
+static const SlaveID& id(const Registry::GoneSlave& slave)
+{
+  return slave.id();
+}
+
+
+static const RepeatedPtrField<Registry::Slave>& admittedSlaves(
+    const Registry& registry)
+{
+  return registry.slaves().slaves();
+}
+
+
+static const RepeatedPtrField<Registry::UnreachableSlave>& unreachableSlaves(
+    const Registry& registry)
+{
+  return registry.unreachable().slaves();
+}
+
+
+static const RepeatedPtrField<Registry::GoneSlave>& goneSlaves(
+    const Registry& registry)
+{
+  return registry.gone().slaves();
+}
+
+
+// Records how a list of agents in the registry changes while a batch
+// of operations is applied, in order to describe the changes as the
+// agents that were removed from the original list and the agents that
+// were appended to it (see `RegistryDelta`).
+//
+// NOTE: This relies on operations never modifying agents in place and
+// appending agents to the end of a list. An operation may remove some
+// agents and append others, but it must not remove an agent and append
+// one with the same ID.
+template <typename T>
+class AgentListChanges
+{
+public:
+  typedef const RepeatedPtrField<T>& (*List)(const Registry&);
+
+  AgentListChanges(const Registry& _registry, List _list)
+    : registry(_registry),
+      list(_list),
+      present(ids(list(registry))),
+      removed(false) {}
+
+  // Must be called after each operation.
+  void update()
+  {
+    const RepeatedPtrField<T>& agents = list(registry);
+
+    // The agents that the operation appended are the ones at the end
+    // of the list that were not present before the operation.
+    int remaining = agents.size();
+    while (remaining > 0 &&
+           !present.contains(id(agents.Get(remaining - 1)))) {
+      remaining--;
+    }
+
+    // Fewer agents remain than were present if the operation removed
+    // agents as well, in which case we find out which by their IDs.
+    if (static_cast<size_t>(remaining) < present.size()) {
+      removed = true;
+      present = ids(agents);
+    }
+
+    for (int i = remaining; i < agents.size(); i++) {
+      appended.insert(id(agents.Get(i)));
+      present.insert(id(agents.Get(i)));
+    }
+  }
+
+  // Describes the changes to the list of agents in the `original`
+  // registry. Returns false if the list did not change.
+  template <typename Delta>
+  bool diff(const Registry& original, Delta* delta) const
+  {
+    const RepeatedPtrField<T>& before = list(original);
+    const RepeatedPtrField<T>& after = list(registry);
+
+    // The agents that remain from the original list keep their order
+    // and precede all appended agents. If no agents were removed, the
+    // original list is a prefix of the current one.
+    int i = before.size();
+
+    if (removed) {
+      int j = 0;
+
+      for (i = 0; i < after.size(); i++) {
+        const SlaveID& slaveId = id(after.Get(i));
+
+        if (appended.contains(slaveId)) {
+          break;
+        }
+
+        while (j < before.size() && id(before.Get(j)) != slaveId) {
+          delta->add_removed()->CopyFrom(id(before.Get(j++)));
+        }
+
+        CHECK_LT(j, before.size()) << "Agent " << slaveId << " not found";
+
+        j++;
+      }
+
+      while (j < before.size()) {
+        delta->add_removed()->CopyFrom(id(before.Get(j++)));
+      }
+    }
+
+    for (; i < after.size(); i++) {
+      delta->add_added()->CopyFrom(after.Get(i));
+    }
+
+    return delta->removed_size() > 0 || delta->added_size() > 0;
+  }
+
+private:
+  static hashset<SlaveID> ids(const RepeatedPtrField<T>& agents)
+  {
+    hashset<SlaveID> result;
+    foreach (const T& agent, agents) {
+      result.insert(id(agent));
+    }
+    return result;
+  }
+
+  const Registry& registry;
+  const List list;
+
+  // The IDs of the agents in the list after the last operation, and
+  // of the agents that operations have appended to the list.
+  hashset<SlaveID> present;
+  hashset<SlaveID> appended;
+
+  bool removed;
+};
+
+
+// Applies the changes to a list of agents in the registry.
+template <typename T, typename Delta>
+static void applyAgentListChanges(
+    const Delta& delta,
+    RepeatedPtrField<T>* agents)
+{
+  if (delta.removed_size() > 0) {
+    hashset<SlaveID> removed;
+    foreach (const SlaveID& slaveId, delta.removed()) {
+      removed.insert(slaveId);
+    }
+
+    RepeatedPtrField<T> remaining;
+    foreach (T& agent, *agents) {
+      if (!removed.contains(id(agent))) {
+        remaining.Add()->Swap(&agent);
+      }
+    }
+
+    agents->Swap(&remaining);
+  }
+
+  agents->MergeFrom(delta.added());
+}
+
+
+// Copies the fields of the registry other than the lists of agents
+// and the journal position, which a delta replaces as a whole.
+static void copyOtherFields(const Registry& from, Registry* to)
+{
+  const Descriptor* descriptor = Registry::descriptor();
+  const Reflection* reflection = Registry::default_instance().GetReflection();
+
+  for (int i = 0; i < descriptor->field_count(); i++) {
+    const FieldDescriptor* field = descriptor->field(i);
+
+    switch (field->number()) {
+      case Registry::kSlavesFieldNumber:
+      case Registry::kUnreachableFieldNumber:
+      case Registry::kGoneFieldNumber:
+      case Registry::kJournalPositionFieldNumber:
+        continue;
+    }
+
+    CHECK_EQ(FieldDescriptor::CPPTYPE_MESSAGE, field->cpp_type());
+
+    reflection->ClearField(to, field);
+
+    if (field->is_repeated()) {
+      for (int j = 0; j < reflection->FieldSize(from, field); j++) {
+        reflection->AddMessage(to, field)->CopyFrom(
+            reflection->GetRepeatedMessage(from, field, j));
+      }
+    } else if (reflection->HasField(from, field)) {
+      reflection->MutableMessage(to, field)->CopyFrom(
+          reflection->GetMessage(from, field));
+    }
+  }
+}
+
+
+// Records the changes that a batch of operations makes to a registry.
+class RegistryChanges
+{
+public:
+  explicit RegistryChanges(const Registry& registry)
+    : slaves(registry, &admittedSlaves),
+      unreachable(registry, &unreachableSlaves),
+      gone(registry, &goneSlaves) {}
+
+  // Must be called after each operation.
+  void update()
+  {
+    slaves.update();
+    unreachable.update();
+    gone.update();
+  }
+
+  // Describes the changes from the `original` to the `updated` registry.
+  void diff(
+      const Registry& original,
+      const Registry& updated,
+      RegistryDelta* delta) const
+  {
+    RegistryDelta::Slaves slavesDelta;
+    if (slaves.diff(original, &slavesDelta)) {
+      delta->mutable_slaves()->Swap(&slavesDelta);
+    }
+
+    RegistryDelta::UnreachableSlaves unreachableDelta;
+    if (unreachable.diff(original, &unreachableDelta)) {
+      delta->mutable_unreachable()->Swap(&unreachableDelta);
+    }
+
+    RegistryDelta::GoneSlaves goneDelta;
+    if (gone.diff(original, &goneDelta)) {
+      delta->mutable_gone()->Swap(&goneDelta);
+    }
+
+    // The other fields are small, so we simply compare them.
+    Registry before;
+    copyOtherFields(original, &before);
+
+    Registry after;
+    copyOtherFields(updated, &after);
+
+    if (before.SerializeAsString() != after.SerializeAsString()) {
+      delta->mutable_registry()->Swap(&after);
+    }
+  }
+
+private:
+  AgentListChanges<Registry::Slave> slaves;
+  AgentListChanges<Registry::UnreachableSlave> unreachable;
+  AgentListChanges<Registry::GoneSlave> gone;
+};
+
+
+// Applies a delta of the registry journal to the registry.
+static void applyDelta(const RegistryDelta& delta, Registry* registry)
+{
+  if (delta.has_slaves()) {
+    applyAgentListChanges(
+        delta.slaves(),
+        registry->mutable_slaves()->mutable_slaves());
+  }
+
+  if (delta.has_unreachable()) {
+    applyAgentListChanges(
+        delta.unreachable(),
+        registry->mutable_unreachable()->mutable_slaves());
+  }
+
+  if (delta.has_gone()) {
+    applyAgentListChanges(
+        delta.gone(),
+        registry->mutable_gone()->mutable_slaves());
+  }
+
+  if (delta.has_registry()) {
+    copyOtherFields(delta.registry(), registry);
+  }
+}
+
+
 Future<Response> RegistrarProcess::getRegistry(
     const Request& request,
     const Option<Principal>&)
@@ -386,12 +719,6 @@ void RegistrarProcess::_recover(
     return;
   }
 
-  Duration elapsed = metrics.state_fetch.stop();
-
-  LOG(INFO) << "Successfully fetched the registry"
-            << " (" << Bytes(deserialized->ByteSize()) << ")"
-            << " in " << elapsed;
-
   // Save the registry.
   variable = recovery.get();
 
@@ -399,17 +726,104 @@ void RegistrarProcess::_recover(
   registry = Option<Registry>(Registry());
   registry->Swap(&deserialized.get());
 
+  // The journal can only contain deltas if the registry has been
+  // stored with a journal position, see `update()`.
+  if (registry->has_journal_position() ||
+      flags.registry_max_journal_entries > 0) {
+    fetchJournal(info);
+    return;
+  }
+
+  ___recover(info);
+}
+
+
+void RegistrarProcess::fetchJournal(const MasterInfo& info)
+{
+  updating = true;
+
+  state->fetch(journalEntry(journal.size() + 1))
+    .after(flags.registry_fetch_timeout,
+           lambda::bind(
+               &timeout<Variable>,
+               "fetch",
+               flags.registry_fetch_timeout,
+               lambda::_1))
+    .onAny(defer(self(), &Self::__recover, info, lambda::_1));
+}
+
+
+void RegistrarProcess::__recover(
+    const MasterInfo& info,
+    const Future<Variable>& recovery)
+{
+  updating = false;
+
+  CHECK(!recovery.isPending());
+
+  if (!recovery.isReady()) {
+    recovered.get()->fail("Failed to recover registrar: " +
+        (recovery.isFailed() ? recovery.failure() : "discarded"));
+    return;
+  }
+
+  journal.push_back(recovery.get());
+
+  // Apply the delta unless the journal ended before it. A variable
+  // that follows the journal is empty or holds a delta that was
+  // stored before the journal was last compacted.
+  bool applied = false;
+
+  if (registry->has_journal_position() &&
+      journal.size() == journalSize + 1 &&
+      !recovery->value().empty()) {
+    Try<RegistryDelta> delta =
+      ::protobuf::deserialize<RegistryDelta>(recovery->value());
+    if (delta.isError()) {
+      recovered.get()->fail("Failed to recover registrar: " +
+                            delta.error());
+      return;
+    }
+
+    if (delta->position() ==
+        registry->journal_position() + journalSize + 1) {
+      applyDelta(delta.get(), &registry.get());
+      journalSize++;
+      applied = true;
+    }
+  }
+
+  // Fetch the variables until the end of the journal, and at least
+  // one for each delta that can be stored.
+  if (applied || journal.size() < flags.registry_max_journal_entries) {
+    fetchJournal(info);
+    return;
+  }
+
+  ___recover(info);
+}
+
+
+void RegistrarProcess::___recover(const MasterInfo& info)
+{
+  Duration elapsed = metrics.state_fetch.stop();
+
+  LOG(INFO) << "Successfully fetched the registry"
+            << " (" << Bytes(registry->ByteSize()) << ")"
+            << " and " << journalSize << " journal deltas"
+            << " in " << elapsed;
+
   // Perform the Recover operation to add the new MasterInfo.
   Owned<Operation> operation(new Recover(info));
   operations.push_back(operation);
   operation->future()
-    .onAny(defer(self(), &Self::__recover, lambda::_1));
+    .onAny(defer(self(), &Self::____recover, lambda::_1));
 
   update();
 }
 
 
-void RegistrarProcess::__recover(const Future<bool>& recover)
+void RegistrarProcess::____recover(const Future<bool>& recover)
 {
   CHECK(!recover.isPending());
 
@@ -487,9 +901,13 @@ void RegistrarProcess::update()
     slaveIDs.insert(slave.info().id());
   }
 
+  RegistryChanges changes(*updatedRegistry);
+
   foreach (Owned<Operation>& operation, operations) {
     // No need to process the result of the operation.
     (*operation)(updatedRegistry.get(), &slaveIDs);
+
+    changes.update();
   }
 
   LOG(INFO) << "Applied " << operations.size() << " operations in "
@@ -498,8 +916,41 @@ void RegistrarProcess::update()
   // Perform the store, and time the operation.
   metrics.state_store.start();
 
-  // Serialize updated registry.
-  Try<string> serialized = ::protobuf::serialize(*updatedRegistry);
+  // The position of the last delta in the journal.
+  const uint64_t position = registry->journal_position() + journalSize;
+
+  // We store the changes as a delta in the journal unless the journal
+  // is full, in which case we store the whole registry. Deltas can
+  // only be stored once the registry has been stored with a journal
+  // position, since the journal is only recovered in that case.
+  const bool journaled =
+    registry->has_journal_position() &&
+    journalSize < flags.registry_max_journal_entries;
+
+  Try<string> serialized = Error("Unreachable");
+  Variable store = variable.get();
+
+  if (journaled) {
+    CHECK_LT(journalSize, journal.size());
+
+    RegistryDelta delta;
+    delta.set_position(position + 1);
+    changes.diff(registry.get(), *updatedRegistry, &delta);
+
+    // Serialize the delta, which is stored in the next variable of
+    // the journal.
+    serialized = ::protobuf::serialize(delta);
+    store = journal[journalSize];
+  } else {
+    if (registry->has_journal_position() ||
+        flags.registry_max_journal_entries > 0) {
+      updatedRegistry->set_journal_position(position);
+    }
+
+    // Serialize updated registry.
+    serialized = ::protobuf::serialize(*updatedRegistry);
+  }
+
   if (serialized.isError()) {
     string message = "Failed to update registry: " + serialized.error();
     fail(&operations, message);
@@ -507,7 +958,7 @@ void RegistrarProcess::update()
     return;
   }
 
-  state->store(variable->mutate(serialized.get()))
+  state->store(store.mutate(serialized.get()))
     .after(flags.registry_store_timeout,
            lambda::bind(
                &timeout<Option<Variable>>,
@@ -515,7 +966,12 @@ void RegistrarProcess::update()
                flags.registry_store_timeout,
                lambda::_1))
     .onAny(defer(
-        self(), &Self::_update, lambda::_1, updatedRegistry, operations));
+        self(),
+        &Self::_update,
+        lambda::_1,
+        updatedRegistry,
+        operations,
+        journaled));
 
   // Clear the operations, _update will transition the Promises!
   operations.clear();
@@ -525,7 +981,8 @@ void RegistrarProcess::update()
 void RegistrarProcess::_update(
     const Future<Option<Variable>>& store,
     const Owned<Registry>& updatedRegistry,
-    deque<Owned<Operation>> applied)
+    deque<Owned<Operation>> applied,
+    bool journaled)
 {
   updating = false;
 
@@ -551,7 +1008,13 @@ void RegistrarProcess::_update(
 
   LOG(INFO) << "Successfully updated the registry in " << elapsed;
 
-  variable = store.get().get();
+  if (journaled) {
+    journal[journalSize++] = store.get().get();
+  } else {
+    variable = store.get().get();
+    journalSize = 0;
+  }
+
   registry->Swap(updatedRegistry.get());
 
   // Remove the operations.
@@ -0,0 +1,142 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "master/response_cache.hpp"
+
+#include <map>
+
+#include <process/clock.hpp>
+
+#include <process/metrics/metrics.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/stringify.hpp>
+
+using std::map;
+using std::string;
+
+using process::Clock;
+using process::Future;
+using process::Time;
+
+using process::http::Request;
+using process::http::Response;
+
+using process::http::authentication::Principal;
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+ResponseCache::ResponseCache(const Duration& _ttl)
+  : ttl(_ttl) {}
+
+
+ResponseCache::~ResponseCache() {}
+
+
+string ResponseCache::key(const Request& request)
+{
+  // The parameters are sorted, so that their order in the query
+  // string does not matter.
+  const map<string, string> query(
+      request.url.query.begin(), request.url.query.end());
+
+  string result = request.url.path + "?";
+
+  foreachpair (const string& name, const string& value, query) {
+    result += process::http::encode(name) + "=";
+    result += process::http::encode(value) + "&";
+  }
+
+  return result;
+}
+
+
+Future<Response> ResponseCache::get(
+    const string& key,
+    const Option<Principal>& principal,
+    const lambda::function<Future<Response>()>& f)
+{
+  // The responses are filtered according to the principal, so they
+  // can only be shared between requests by the same principal.
+  const string principalKey = principal.isSome()
+    ? "principal:" + stringify(principal.get())
+    : "anonymous";
+
+  const string entryKey = principalKey + " " + key;
+
+  const Time now = Clock::now();
+
+  if (entries.contains(entryKey) && fresh(entries.at(entryKey), now)) {
+    ++metrics.http_cache_hits;
+
+    // Each request gets its own future, so that a client that goes
+    // away does not discard the response of the other requests.
+    return undiscardable(entries.at(entryKey).response);
+  }
+
+  ++metrics.http_cache_misses;
+
+  // Drop the stale responses, so that requests with many distinct
+  // query strings do not accumulate.
+  auto it = entries.begin();
+  while (it != entries.end()) {
+    if (!fresh(it->second, now)) {
+      it = entries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  Entry entry;
+  entry.response = f();
+  entry.time = now;
+
+  entries[entryKey] = entry;
+
+  return undiscardable(entry.response);
+}
+
+
+bool ResponseCache::fresh(const Entry& entry, const Time& now) const
+{
+  if (entry.response.isPending()) {
+    return true;
+  }
+
+  return entry.response.isReady() && now - entry.time < ttl;
+}
+
+
+ResponseCache::Metrics::Metrics()
+  : http_cache_hits("master/http_cache_hits"),
+    http_cache_misses("master/http_cache_misses")
+{
+  process::metrics::add(http_cache_hits);
+  process::metrics::add(http_cache_misses);
+}
+
+
+ResponseCache::Metrics::~Metrics()
+{
+  process::metrics::remove(http_cache_hits);
+  process::metrics::remove(http_cache_misses);
+}
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
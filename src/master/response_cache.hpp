@@ -0,0 +1,91 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_RESPONSE_CACHE_HPP__
+#define __MASTER_RESPONSE_CACHE_HPP__
+
+#include <string>
+
+#include <process/authenticator.hpp>
+#include <process/future.hpp>
+#include <process/http.hpp>
+#include <process/time.hpp>
+
+#include <process/metrics/counter.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/lambda.hpp>
+#include <stout/option.hpp>
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// Shares the responses of read-only HTTP requests between identical
+// requests by the same principal. A request that arrives while the
+// response for its key is being computed waits for that computation,
+// and a computed response is reused until `ttl` has passed since the
+// computation started.
+//
+// NOTE: This is not thread-safe, the master only uses it from within
+// its own actor.
+class ResponseCache
+{
+public:
+  explicit ResponseCache(const Duration& ttl);
+  ~ResponseCache();
+
+  // Returns a key that identifies a request by its path and query.
+  static std::string key(const process::http::Request& request);
+
+  // Returns the response for `key` and `principal`, invoking `f` only
+  // if there is neither an in-flight nor a fresh response for them.
+  process::Future<process::http::Response> get(
+      const std::string& key,
+      const Option<process::http::authentication::Principal>& principal,
+      const lambda::function<process::Future<process::http::Response>()>& f);
+
+private:
+  struct Entry
+  {
+    process::Future<process::http::Response> response;
+
+    // When the computation of the response started.
+    process::Time time;
+  };
+
+  bool fresh(const Entry& entry, const process::Time& now) const;
+
+  const Duration ttl;
+
+  hashmap<std::string, Entry> entries;
+
+  struct Metrics
+  {
+    Metrics();
+    ~Metrics();
+
+    process::metrics::Counter http_cache_hits;
+    process::metrics::Counter http_cache_misses;
+  } metrics;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_RESPONSE_CACHE_HPP__
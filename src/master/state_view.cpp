@@ -0,0 +1,245 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "master/state_view.hpp"
+
+#include <memory>
+#include <vector>
+
+#include <process/clock.hpp>
+#include <process/defer.hpp>
+#include <process/dispatch.hpp>
+#include <process/id.hpp>
+#include <process/owned.hpp>
+#include <process/process.hpp>
+
+#include <process/metrics/gauge.hpp>
+#include <process/metrics/metrics.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/option.hpp>
+
+using std::shared_ptr;
+using std::vector;
+
+using google::protobuf::RepeatedPtrField;
+
+using process::Clock;
+using process::Failure;
+using process::Future;
+using process::Owned;
+using process::Process;
+using process::Promise;
+
+using process::http::Response;
+
+using process::metrics::Gauge;
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+class StateViewProcess : public Process<StateViewProcess>
+{
+public:
+  StateViewProcess(
+      const Duration& _interval,
+      const lambda::function<void()>& _capture)
+    : ProcessBase(process::ID::generate("state-view")),
+      interval(_interval),
+      capture(_capture),
+      capturing(false),
+      version(0),
+      metrics(*this) {}
+
+  virtual ~StateViewProcess()
+  {
+    foreach (const Owned<Promise<shared_ptr<const StateSnapshot>>>& promise,
+             promises) {
+      promise->discard();
+    }
+  }
+
+  void update(const shared_ptr<StateSnapshot>& _snapshot)
+  {
+    _snapshot->version = ++version;
+
+    _snapshot->frameworks.clear();
+    _snapshot->tasks.clear();
+
+    // Every framework gets an entry in `tasks`, even without tasks or
+    // executors, so that the endpoints can look them up.
+    auto add = [&_snapshot](
+        const RepeatedPtrField<
+            mesos::master::Response::GetFrameworks::Framework>& frameworks) {
+      foreach (const mesos::master::Response::GetFrameworks::Framework&
+                 framework,
+               frameworks) {
+        const FrameworkInfo& frameworkInfo = framework.framework_info();
+
+        _snapshot->frameworks.put(frameworkInfo.id(), frameworkInfo);
+        _snapshot->tasks[frameworkInfo.id()];
+      }
+    };
+
+    const mesos::master::Response::GetFrameworks& frameworks =
+      _snapshot->state.get_frameworks();
+
+    add(frameworks.frameworks());
+    add(frameworks.completed_frameworks());
+
+    auto index = [&_snapshot](
+        const RepeatedPtrField<Task>& tasks,
+        vector<const Task*> StateSnapshot::Tasks::*field) {
+      foreach (const Task& task, tasks) {
+        (_snapshot->tasks[task.framework_id()].*field).push_back(&task);
+      }
+    };
+
+    const mesos::master::Response::GetTasks& tasks =
+      _snapshot->state.get_tasks();
+
+    index(tasks.pending_tasks(), &StateSnapshot::Tasks::pending);
+    index(tasks.tasks(), &StateSnapshot::Tasks::active);
+    index(tasks.unreachable_tasks(), &StateSnapshot::Tasks::unreachable);
+    index(tasks.completed_tasks(), &StateSnapshot::Tasks::completed);
+
+    foreach (const mesos::master::Response::GetExecutors::Executor& executor,
+             _snapshot->state.get_executors().executors()) {
+      _snapshot->tasks[executor.executor_info().framework_id()]
+        .executors.push_back(&executor);
+    }
+
+    snapshot = shared_ptr<const StateSnapshot>(_snapshot);
+    capturing = false;
+
+    foreach (const Owned<Promise<shared_ptr<const StateSnapshot>>>& promise,
+             promises) {
+      promise->set(snapshot.get());
+    }
+
+    promises.clear();
+  }
+
+  Future<Response> read(
+      const lambda::function<Response(const StateSnapshot&)>& f)
+  {
+    Option<Duration> age = None();
+    if (snapshot.isSome()) {
+      age = Clock::now() - snapshot.get()->time;
+    }
+
+    // Ask for a new snapshot once the current one is outdated, unless
+    // one is already being captured.
+    if ((age.isNone() || age.get() >= interval) && !capturing) {
+      capturing = true;
+      capture();
+    }
+
+    if (age.isSome() && age.get() < interval * 2) {
+      return f(*snapshot.get());
+    }
+
+    Owned<Promise<shared_ptr<const StateSnapshot>>> promise(
+        new Promise<shared_ptr<const StateSnapshot>>());
+
+    promises.push_back(promise);
+
+    return promise->future()
+      .then(defer(
+          self(),
+          [f](const shared_ptr<const StateSnapshot>& _snapshot) {
+            return f(*_snapshot);
+          }));
+  }
+
+private:
+  struct Metrics
+  {
+    explicit Metrics(const StateViewProcess& process)
+      : state_snapshot_lag_secs(
+            "master/state_snapshot_lag_secs",
+            defer(process, &StateViewProcess::_state_snapshot_lag_secs))
+    {
+      process::metrics::add(state_snapshot_lag_secs);
+    }
+
+    ~Metrics()
+    {
+      process::metrics::remove(state_snapshot_lag_secs);
+    }
+
+    // How long ago the current snapshot was captured.
+    Gauge state_snapshot_lag_secs;
+  };
+
+  Future<double> _state_snapshot_lag_secs()
+  {
+    if (snapshot.isSome()) {
+      return (Clock::now() - snapshot.get()->time).secs();
+    }
+
+    return Failure("No snapshot captured yet");
+  }
+
+  const Duration interval;
+  const lambda::function<void()> capture;
+
+  // Whether a new snapshot has been asked for.
+  bool capturing;
+
+  uint64_t version;
+  Option<shared_ptr<const StateSnapshot>> snapshot;
+
+  // Requests that wait for the next snapshot.
+  vector<Owned<Promise<shared_ptr<const StateSnapshot>>>> promises;
+
+  Metrics metrics;
+};
+
+
+StateView::StateView(
+    const Duration& interval,
+    const lambda::function<void()>& capture)
+{
+  process = new StateViewProcess(interval, capture);
+  spawn(process);
+}
+
+
+StateView::~StateView()
+{
+  terminate(process);
+  wait(process);
+  delete process;
+}
+
+
+void StateView::update(const shared_ptr<StateSnapshot>& snapshot)
+{
+  dispatch(process, &StateViewProcess::update, snapshot);
+}
+
+
+Future<Response> StateView::read(
+    const lambda::function<Response(const StateSnapshot&)>& f) const
+{
+  return dispatch(process, &StateViewProcess::read, f);
+}
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,148 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_STATE_VIEW_HPP__
+#define __MASTER_STATE_VIEW_HPP__
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+#include <mesos/type_utils.hpp>
+
+#include <mesos/master/master.hpp>
+
+#include <process/future.hpp>
+#include <process/http.hpp>
+#include <process/time.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/lambda.hpp>
+#include <stout/option.hpp>
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// A versioned, immutable copy of the state of the master.
+//
+// NOTE: The indices below point into `state`, thus a snapshot must
+// not be copied.
+struct StateSnapshot
+{
+  StateSnapshot() : version(0), unreachableAgents(0) {}
+
+  StateSnapshot(const StateSnapshot&) = delete;
+  StateSnapshot& operator=(const StateSnapshot&) = delete;
+
+  // Assigned by the `StateView`, starting at 1.
+  uint64_t version;
+
+  // When the state was captured.
+  process::Time time;
+
+  // The unfiltered state of the master. Requests are served by
+  // filtering it according to the principal of each request.
+  mesos::master::Response::GetState state;
+
+  // The parts of the state of the master that are only rendered by
+  // the v0 endpoints (e.g., `/state`).
+  MasterInfo info;
+  std::string pid;
+  process::Time startTime;
+  Option<process::Time> electedTime;
+  Option<MasterInfo> leader;
+  size_t unreachableAgents;
+  Option<std::string> cluster;
+  Option<std::string> logDir;
+  Option<std::string> externalLogFile;
+  std::map<std::string, std::string> flags;
+
+  // The PIDs of the frameworks that are not HTTP frameworks.
+  hashmap<FrameworkID, std::string> frameworkPids;
+
+  // The following are indexed by the `StateView`.
+
+  // The `FrameworkInfo`s of all frameworks in `state`, which are
+  // needed to authorize tasks and executors.
+  hashmap<FrameworkID, FrameworkInfo> frameworks;
+
+  // The tasks and executors in `state` by framework, with an entry
+  // for every framework in `state`.
+  struct Tasks
+  {
+    std::vector<const Task*> pending;
+    std::vector<const Task*> active;
+    std::vector<const Task*> unreachable;
+    std::vector<const Task*> completed;
+    std::vector<const mesos::master::Response::GetExecutors::Executor*>
+      executors;
+  };
+
+  hashmap<FrameworkID, Tasks> tasks;
+};
+
+
+// Forward declaration.
+class StateViewProcess;
+
+
+// Holds the latest snapshot of the state of the master in a separate
+// actor, so that the read-only operator API calls can be served from
+// it without dispatching into the master.
+//
+// Snapshots are captured on demand: once a request finds the current
+// snapshot older than the interval, the view asks the master for a
+// new one via `capture`, at most one at a time. Until the new snapshot
+// arrives, requests are still served from the current one as long as
+// it is younger than twice the interval, and wait for the new one
+// otherwise. Thus the master captures at most one snapshot per
+// interval and none while nobody reads, and a response is stale by
+// less than twice the interval.
+class StateView
+{
+public:
+  StateView(
+      const Duration& interval,
+      const lambda::function<void()>& capture);
+
+  ~StateView();
+
+  // Replaces the current snapshot. The view assigns the version and
+  // indexes the frameworks, tasks and executors of the snapshot, which
+  // must not be modified afterwards.
+  void update(const std::shared_ptr<StateSnapshot>& snapshot);
+
+  // Serves a request from the current snapshot. The function is
+  // invoked within the actor of the view, so that it does not compete
+  // with the master. If there is no snapshot that is recent enough,
+  // the request is served from the next one.
+  process::Future<process::http::Response> read(
+      const lambda::function<
+          process::http::Response(const StateSnapshot&)>& f) const;
+
+private:
+  StateViewProcess* process;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_STATE_VIEW_HPP__
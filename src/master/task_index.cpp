@@ -0,0 +1,337 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "master/task_index.hpp"
+
+#include <glog/logging.h>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
+
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// Returns the role that the resources of the task are allocated to.
+static Option<string> role(const Task& task)
+{
+  if (task.resources().empty() ||
+      !task.resources(0).has_allocation_info()) {
+    return None();
+  }
+
+  return task.resources(0).allocation_info().role();
+}
+
+
+TaskFilter TaskFilter::create(const mesos::master::Call::GetTasks& getTasks)
+{
+  TaskFilter filter;
+
+  if (getTasks.has_framework_id()) {
+    filter.frameworkId = getTasks.framework_id();
+  }
+
+  if (getTasks.has_slave_id()) {
+    filter.slaveId = getTasks.slave_id();
+  }
+
+  if (getTasks.has_state()) {
+    filter.state = getTasks.state();
+  }
+
+  if (getTasks.has_role()) {
+    filter.role = getTasks.role();
+  }
+
+  if (getTasks.has_label()) {
+    filter.label = getTasks.label();
+  }
+
+  return filter;
+}
+
+
+bool TaskFilter::empty() const
+{
+  return frameworkId.isNone() &&
+         slaveId.isNone() &&
+         state.isNone() &&
+         role.isNone() &&
+         label.isNone();
+}
+
+
+bool TaskFilter::matches(const Task& task) const
+{
+  if (frameworkId.isSome() && frameworkId.get() != task.framework_id()) {
+    return false;
+  }
+
+  if (slaveId.isSome() && slaveId.get() != task.slave_id()) {
+    return false;
+  }
+
+  if (state.isSome() && state.get() != task.state()) {
+    return false;
+  }
+
+  if (role.isSome() && role != master::role(task)) {
+    return false;
+  }
+
+  if (label.isSome()) {
+    bool found = false;
+
+    foreach (const Label& _label, task.labels().labels()) {
+      if (_label.key() == label->key() &&
+          (!label->has_value() || _label.value() == label->value())) {
+        found = true;
+        break;
+      }
+    }
+
+    if (!found) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+TaskIndex::Key TaskIndex::key(const Task& task)
+{
+  return Key(task.framework_id().value(), task.task_id().value());
+}
+
+
+string TaskIndex::cursor(const Key& key)
+{
+  // Framework IDs are generated by the master and task IDs are
+  // validated, neither of them contains a slash.
+  return key.first + "/" + key.second;
+}
+
+
+Try<TaskIndex::Key> TaskIndex::parse(const string& cursor)
+{
+  const size_t separator = cursor.find('/');
+
+  if (separator == string::npos ||
+      separator == 0 ||
+      separator == cursor.size() - 1) {
+    return Error("Invalid cursor '" + cursor + "'");
+  }
+
+  return Key(cursor.substr(0, separator), cursor.substr(separator + 1));
+}
+
+
+void TaskIndex::add(const Task* task)
+{
+  const Key key = TaskIndex::key(*task);
+
+  std::pair<Tasks::iterator, bool> inserted =
+    tasks.insert(std::make_pair(key, task));
+
+  CHECK(inserted.second)
+    << "Duplicate task " << key.second << " of framework " << key.first;
+
+  const Key* _key = &inserted.first->first;
+
+  insert(&frameworks[task->framework_id()], _key, task);
+  insert(&slaves[task->slave_id()], _key, task);
+  insert(&states[task->state()], _key, task);
+
+  Option<string> role = master::role(*task);
+  if (role.isSome()) {
+    insert(&roles[role.get()], _key, task);
+  }
+
+  foreach (const Label& label, task->labels().labels()) {
+    // A task may have several labels with the same key.
+    labels[label.key()][_key] = task;
+  }
+}
+
+
+void TaskIndex::remove(const Task* task)
+{
+  Tasks::iterator it = tasks.find(TaskIndex::key(*task));
+
+  CHECK(it != tasks.end())
+    << "Unknown task " << task->task_id()
+    << " of framework " << task->framework_id();
+
+  const Key* key = &it->first;
+
+  erase(&frameworks, task->framework_id(), key);
+  erase(&slaves, task->slave_id(), key);
+  erase(&states, static_cast<int>(task->state()), key);
+
+  Option<string> role = master::role(*task);
+  if (role.isSome()) {
+    erase(&roles, role.get(), key);
+  }
+
+  // A task may have several labels with the same key.
+  hashset<string> keys;
+  foreach (const Label& label, task->labels().labels()) {
+    keys.insert(label.key());
+  }
+
+  foreach (const string& _key, keys) {
+    erase(&labels, _key, key);
+  }
+
+  tasks.erase(it);
+}
+
+
+void TaskIndex::update(const Task* task, const TaskState& state)
+{
+  // Tasks that are not known to their framework are not indexed.
+  Tasks::const_iterator it = tasks.find(TaskIndex::key(*task));
+  if (it == tasks.end() || it->second != task) {
+    return;
+  }
+
+  if (state == task->state()) {
+    return;
+  }
+
+  erase(&states, static_cast<int>(task->state()), &it->first);
+  insert(&states[state], &it->first, task);
+}
+
+
+void TaskIndex::visit(
+    const TaskFilter& filter,
+    const Option<Key>& after,
+    const lambda::function<bool(const Task*)>& f) const
+{
+  // Visit the smallest of the indexes that cover one of the criteria,
+  // and check the remaining criteria for each of its tasks. If none of
+  // the indexes is smaller than `tasks`, all the tasks are visited.
+  const Index* candidates = nullptr;
+
+  auto narrow = [this, &candidates](const Index* index) {
+    if (index->size() < (candidates != nullptr
+                           ? candidates->size()
+                           : tasks.size())) {
+      candidates = index;
+    }
+  };
+
+  if (filter.frameworkId.isSome()) {
+    narrow(find(frameworks, filter.frameworkId.get()));
+  }
+
+  if (filter.slaveId.isSome()) {
+    narrow(find(slaves, filter.slaveId.get()));
+  }
+
+  if (filter.state.isSome()) {
+    narrow(find(states, static_cast<int>(filter.state.get())));
+  }
+
+  if (filter.role.isSome()) {
+    narrow(find(roles, filter.role.get()));
+  }
+
+  if (filter.label.isSome()) {
+    narrow(find(labels, filter.label->key()));
+  }
+
+  if (candidates == nullptr) {
+    visit(
+        after.isSome() ? tasks.upper_bound(after.get()) : tasks.begin(),
+        tasks.end(),
+        filter,
+        f);
+  } else {
+    visit(
+        after.isSome()
+          ? candidates->upper_bound(&after.get())
+          : candidates->begin(),
+        candidates->end(),
+        filter,
+        f);
+  }
+}
+
+
+void TaskIndex::insert(Index* index, const Key* key, const Task* task)
+{
+  CHECK(index->insert(std::make_pair(key, task)).second)
+    << "Duplicate task " << key->second << " of framework " << key->first;
+}
+
+
+template <typename T>
+const TaskIndex::Index* TaskIndex::find(
+    const hashmap<T, Index>& indexes,
+    const T& value)
+{
+  static const Index* none = new Index();
+
+  typename hashmap<T, Index>::const_iterator it = indexes.find(value);
+  if (it == indexes.end()) {
+    return none;
+  }
+
+  return &it->second;
+}
+
+
+template <typename T>
+void TaskIndex::erase(
+    hashmap<T, Index>* indexes,
+    const T& value,
+    const Key* key)
+{
+  CHECK(indexes->contains(value));
+
+  Index& index = indexes->at(value);
+  CHECK_EQ(1u, index.erase(key));
+
+  if (index.empty()) {
+    indexes->erase(value);
+  }
+}
+
+
+template <typename Iterator>
+void TaskIndex::visit(
+    Iterator begin,
+    Iterator end,
+    const TaskFilter& filter,
+    const lambda::function<bool(const Task*)>& f)
+{
+  for (Iterator it = begin; it != end; ++it) {
+    if (filter.matches(*it->second) && !f(it->second)) {
+      return;
+    }
+  }
+}
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,150 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_TASK_INDEX_HPP__
+#define __MASTER_TASK_INDEX_HPP__
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include <mesos/mesos.hpp>
+#include <mesos/type_utils.hpp>
+
+#include <mesos/master/master.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/lambda.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// Selects tasks by the criteria of the operator API. A task matches
+// if it matches all the criteria that are set.
+struct TaskFilter
+{
+  static TaskFilter create(const mesos::master::Call::GetTasks& getTasks);
+
+  bool empty() const;
+
+  bool matches(const Task& task) const;
+
+  Option<FrameworkID> frameworkId;
+  Option<SlaveID> slaveId;
+  Option<TaskState> state;
+  Option<std::string> role;
+
+  // Matches the tasks with a label with the same key and, if the
+  // label has a value, the same value.
+  Option<Label> label;
+};
+
+
+// Secondary indexes over the tasks that have been launched on agents
+// (i.e., the tasks in `Framework::tasks`), so that selecting the tasks
+// by framework, agent, state, role or label costs time proportional to
+// the number of tasks that match, rather than the number of all tasks.
+//
+// The tasks are ordered by framework ID and task ID, which is the
+// order in which the operator API paginates them.
+class TaskIndex
+{
+public:
+  // Identifies a task by its framework ID and task ID.
+  typedef std::pair<std::string, std::string> Key;
+
+  static Key key(const Task& task);
+
+  // The cursor of the operator API refers to the key of the last task
+  // of the previous page.
+  static std::string cursor(const Key& key);
+  static Try<Key> parse(const std::string& cursor);
+
+  void add(const Task* task);
+  void remove(const Task* task);
+
+  // Must be called before changing the state of an indexed task.
+  void update(const Task* task, const TaskState& state);
+
+  // Invokes `f` for the tasks that match `filter`, in the order of
+  // their keys and starting after `after`, until `f` returns false.
+  void visit(
+      const TaskFilter& filter,
+      const Option<Key>& after,
+      const lambda::function<bool(const Task*)>& f) const;
+
+  size_t size() const { return tasks.size(); }
+
+private:
+  typedef std::map<Key, const Task*> Tasks;
+
+  // Orders the keys that the secondary indexes point to like `Tasks`.
+  struct KeyLess
+  {
+    bool operator()(const Key* left, const Key* right) const
+    {
+      return *left < *right;
+    }
+  };
+
+  // The secondary indexes refer to the keys in `tasks` rather than
+  // copying them, so a key must be removed from the secondary indexes
+  // before it is removed from `tasks`.
+  typedef std::map<const Key*, const Task*, KeyLess> Index;
+
+  static void insert(Index* index, const Key* key, const Task* task);
+
+  // Returns the tasks with the given value, which may be none.
+  template <typename T>
+  static const Index* find(const hashmap<T, Index>& indexes, const T& value);
+
+  template <typename T>
+  static void erase(
+      hashmap<T, Index>* indexes,
+      const T& value,
+      const Key* key);
+
+  // Invokes `f` for the tasks in [begin, end) that match `filter`,
+  // until `f` returns false.
+  template <typename Iterator>
+  static void visit(
+      Iterator begin,
+      Iterator end,
+      const TaskFilter& filter,
+      const lambda::function<bool(const Task*)>& f);
+
+  Tasks tasks;
+
+  hashmap<FrameworkID, Index> frameworks;
+  hashmap<SlaveID, Index> slaves;
+  hashmap<std::string, Index> roles;
+
+  // Indexed by the label key.
+  hashmap<std::string, Index> labels;
+
+  // NOTE: This is keyed by the numeric value of the state, since
+  // `std::hash` is not defined for enums in C++11.
+  hashmap<int, Index> states;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_TASK_INDEX_HPP__
@@ -0,0 +1,177 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "state/delta.hpp"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/stringify.hpp>
+
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace state {
+namespace delta {
+
+// Size of the blocks of the old value that are indexed. A copy is
+// only worth encoding if it is a good deal longer than the (varint
+// encoded) offset and length of the instruction.
+static const size_t BLOCK_SIZE = 32;
+
+// Multiplier of the polynomial rolling hash (mod 2^32).
+static const uint32_t PRIME = 16777619;
+
+
+static uint32_t hash(const char* data)
+{
+  uint32_t hash = 0;
+  for (size_t i = 0; i < BLOCK_SIZE; i++) {
+    hash = hash * PRIME + static_cast<unsigned char>(data[i]);
+  }
+  return hash;
+}
+
+
+static void insert(Delta* delta, const string& to, size_t begin, size_t end)
+{
+  if (begin < end) {
+    delta->add_instructions()->set_data(to.data() + begin, end - begin);
+  }
+}
+
+
+Delta diff(const string& from, const string& to)
+{
+  Delta delta;
+
+  if (from.size() < BLOCK_SIZE || to.size() < BLOCK_SIZE) {
+    insert(&delta, to, 0, to.size());
+    return delta;
+  }
+
+  // PRIME^(BLOCK_SIZE - 1), for removing the first byte of a block
+  // from its hash.
+  uint32_t power = 1;
+  for (size_t i = 1; i < BLOCK_SIZE; i++) {
+    power *= PRIME;
+  }
+
+  // Offsets of the (non-overlapping) blocks of 'from' by their hash.
+  // If blocks collide we keep the first one.
+  hashmap<uint32_t, size_t> blocks;
+  blocks.reserve(from.size() / BLOCK_SIZE);
+
+  for (size_t offset = 0; offset + BLOCK_SIZE <= from.size();
+       offset += BLOCK_SIZE) {
+    blocks.emplace(hash(from.data() + offset), offset);
+  }
+
+  // Start of the data of 'to' that has not been encoded yet.
+  size_t pending = 0;
+
+  size_t position = 0;
+  uint32_t rolling = hash(to.data());
+
+  while (position + BLOCK_SIZE <= to.size()) {
+    auto block = blocks.find(rolling);
+
+    if (block != blocks.end() &&
+        memcmp(from.data() + block->second,
+               to.data() + position,
+               BLOCK_SIZE) == 0) {
+      size_t offset = block->second;
+      size_t begin = position;
+
+      // Extend the match backwards into the pending data ...
+      while (begin > pending &&
+             offset > 0 &&
+             from[offset - 1] == to[begin - 1]) {
+        offset--;
+        begin--;
+      }
+
+      // ... and forwards as far as the values agree.
+      size_t length = position + BLOCK_SIZE - begin;
+      while (begin + length < to.size() &&
+             offset + length < from.size() &&
+             from[offset + length] == to[begin + length]) {
+        length++;
+      }
+
+      insert(&delta, to, pending, begin);
+
+      Delta::Instruction* instruction = delta.add_instructions();
+      instruction->set_offset(offset);
+      instruction->set_length(length);
+
+      pending = position = begin + length;
+
+      if (position + BLOCK_SIZE <= to.size()) {
+        rolling = hash(to.data() + position);
+      }
+
+      continue;
+    }
+
+    if (position + BLOCK_SIZE < to.size()) {
+      rolling -= power * static_cast<unsigned char>(to[position]);
+      rolling = rolling * PRIME +
+        static_cast<unsigned char>(to[position + BLOCK_SIZE]);
+    }
+
+    position++;
+  }
+
+  insert(&delta, to, pending, to.size());
+
+  return delta;
+}
+
+
+Try<string> patch(const string& from, const Delta& delta)
+{
+  string to;
+
+  foreach (const Delta::Instruction& instruction, delta.instructions()) {
+    if (instruction.has_data()) {
+      to.append(instruction.data());
+    } else if (instruction.has_length()) {
+      if (instruction.offset() > from.size() ||
+          instruction.length() > from.size() - instruction.offset()) {
+        return Error(
+            "Copy of " + stringify(instruction.length()) + " bytes at " +
+            stringify(instruction.offset()) + " is out of bounds of a"
+            " value of " + stringify(from.size()) + " bytes");
+      }
+
+      to.append(from, instruction.offset(), instruction.length());
+    } else {
+      return Error("Instruction has neither data nor length");
+    }
+  }
+
+  return to;
+}
+
+} // namespace delta {
+} // namespace state {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,48 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __STATE_DELTA_HPP__
+#define __STATE_DELTA_HPP__
+
+#include <string>
+
+#include <stout/try.hpp>
+
+#include "messages/state.hpp"
+
+namespace mesos {
+namespace internal {
+namespace state {
+namespace delta {
+
+// Returns a binary delta that transforms 'from' into 'to'. The blocks
+// of 'from' are indexed by a rolling hash so that the ranges of 'to'
+// that are also in 'from' get found in a single pass over 'to'. This
+// takes time linear in the size of the values (as opposed to an SVN
+// diff) and the delta is small if the values mostly share data, e.g.,
+// consecutive versions of a serialized protobuf.
+Delta diff(const std::string& from, const std::string& to);
+
+
+// Returns the result of applying the delta to 'from'.
+Try<std::string> patch(const std::string& from, const Delta& delta);
+
+} // namespace delta {
+} // namespace state {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __STATE_DELTA_HPP__
@@ -48,6 +48,8 @@
 
 #include "messages/state.hpp"
 
+#include "state/delta.hpp"
+
 using namespace mesos::internal::log;
 
 using namespace process;
@@ -59,6 +61,7 @@ using std::string;
 
 using mesos::log::Log;
 
+using mesos::internal::state::Delta;
 using mesos::internal::state::Entry;
 using mesos::internal::state::Operation;
 
@@ -84,7 +87,10 @@ namespace state {
 class LogStorageProcess : public Process<LogStorageProcess>
 {
 public:
-  LogStorageProcess(Log* log, size_t diffsBetweenSnapshots);
+  LogStorageProcess(
+      Log* log,
+      size_t diffsBetweenSnapshots,
+      LogStorage::DiffFormat diffFormat);
 
   virtual ~LogStorageProcess();
 
@@ -136,6 +142,7 @@ private:
   Log::Writer writer;
 
   const size_t diffsBetweenSnapshots;
+  const LogStorage::DiffFormat diffFormat;
 
   // Used to serialize Log::Writer::append/truncate operations.
   Mutex mutex;
@@ -169,9 +176,9 @@ private:
         return Error("Attempted to patch the wrong snapshot");
       }
 
-      Try<string> patch = svn::patch(
-          entry.value(),
-          svn::Diff(diff.entry().value()));
+      Try<string> patch = diff.has_delta()
+        ? internal::state::delta::patch(entry.value(), diff.delta())
+        : svn::patch(entry.value(), svn::Diff(diff.entry().value()));
 
       if (patch.isError()) {
         return Error(patch.error());
@@ -222,11 +229,15 @@ private:
 };
 
 
-LogStorageProcess::LogStorageProcess(Log* log, size_t diffsBetweenSnapshots)
+LogStorageProcess::LogStorageProcess(
+    Log* log,
+    size_t diffsBetweenSnapshots,
+    LogStorage::DiffFormat diffFormat)
   : ProcessBase(process::ID::generate("log-storage")),
     reader(log),
     writer(log),
-    diffsBetweenSnapshots(diffsBetweenSnapshots) {}
+    diffsBetweenSnapshots(diffsBetweenSnapshots),
+    diffFormat(diffFormat) {}
 
 
 LogStorageProcess::~LogStorageProcess() {}
@@ -496,30 +507,56 @@ Future<bool> LogStorageProcess::__set(
     metrics.diff.start();
 
     // Construct the diff of the last snapshot.
-    Try<svn::Diff> diff = svn::diff(
-        snapshot.get().entry.value(),
-        entry.value());
+    Operation operation;
+    operation.set_type(Operation::DIFF);
 
-    Duration elapsed = metrics.diff.stop();
+    Entry* diff = operation.mutable_diff()->mutable_entry();
+    diff->set_name(entry.name());
+    diff->set_uuid(entry.uuid());
+
+    switch (diffFormat) {
+      case LogStorage::SVN: {
+        Try<svn::Diff> svn = svn::diff(
+            snapshot.get().entry.value(),
+            entry.value());
+
+        if (svn.isError()) {
+          metrics.diff.stop();
+
+          // TODO(benh): Fallback and try and write a whole snapshot?
+          return Failure("Failed to construct diff: " + svn.error());
+        }
+
+        diff->set_value(svn.get().data);
+        break;
+      }
 
-    if (diff.isError()) {
-      // TODO(benh): Fallback and try and write a whole snapshot?
-      return Failure("Failed to construct diff: " + diff.error());
+      case LogStorage::DELTA: {
+        Delta delta = internal::state::delta::diff(
+            snapshot.get().entry.value(),
+            entry.value());
+
+        diff->set_value("");
+        operation.mutable_diff()->mutable_delta()->Swap(&delta);
+        break;
+      }
     }
 
-    VLOG(1) << "Created an SVN diff in " << elapsed
-            << " of size " << Bytes(diff.get().data.size()) << " which is "
-            << (diff.get().data.size() / (double) entry.value().size()) * 100.0
+    Duration elapsed = metrics.diff.stop();
+
+    size_t size = operation.diff().has_delta()
+      ? operation.diff().delta().ByteSize()
+      : diff->value().size();
+
+    VLOG(1) << "Created a diff ("
+            << (diffFormat == LogStorage::SVN ? "SVN" : "delta")
+            << ") in " << elapsed
+            << " of size " << Bytes(size) << " which is "
+            << (size / (double) entry.value().size()) * 100.0
             << "% the original size (" << Bytes(entry.value().size()) << ")";
 
     // Only write the diff if it provides a reduction in size.
-    if (diff.get().data.size() < entry.value().size()) {
-      // Append a diff operation.
-      Operation operation;
-      operation.set_type(Operation::DIFF);
-      operation.mutable_diff()->mutable_entry()->CopyFrom(entry);
-      operation.mutable_diff()->mutable_entry()->set_value(diff.get().data);
-
+    if (size < entry.value().size()) {
       string value;
       if (!operation.SerializeToString(&value)) {
         return Failure("Failed to serialize DIFF Operation");
@@ -658,9 +695,12 @@ Future<std::set<string>> LogStorageProcess::_names()
 }
 
 
-LogStorage::LogStorage(Log* log, size_t diffsBetweenSnapshots)
+LogStorage::LogStorage(
+    Log* log,
+    size_t diffsBetweenSnapshots,
+    DiffFormat diffFormat)
 {
-  process = new LogStorageProcess(log, diffsBetweenSnapshots);
+  process = new LogStorageProcess(log, diffsBetweenSnapshots, diffFormat);
   spawn(process);
 }
 
@@ -45,7 +45,7 @@ namespace tests {
 
 ACTION_P(InvokeInitialize, allocator)
 {
-  allocator->real->initialize(arg0, arg1, arg2, arg3, arg4);
+  allocator->real->initialize(arg0, arg1, arg2);
 }
 
 
@@ -229,9 +229,9 @@ public:
     // to get the best of both worlds: the ability to use 'DoDefault'
     // and no warnings when expectations are not explicit.
 
-    ON_CALL(*this, initialize(_, _, _, _, _, _))
+    ON_CALL(*this, initialize(_, _, _))
       .WillByDefault(InvokeInitialize(this));
-    EXPECT_CALL(*this, initialize(_, _, _, _, _, _))
+    EXPECT_CALL(*this, initialize(_, _, _))
       .WillRepeatedly(DoDefault());
 
     ON_CALL(*this, recover(_, _))
@@ -357,17 +357,39 @@ public:
 
   virtual ~TestAllocator() {}
 
-  MOCK_METHOD6(initialize, void(
-      const Duration&,
+  MOCK_METHOD3(initialize, void(
+      const mesos::allocator::Options&,
       const lambda::function<
           void(const FrameworkID&,
                const hashmap<std::string, hashmap<SlaveID, Resources>>&)>&,
       const lambda::function<
           void(const FrameworkID&,
-               const hashmap<SlaveID, UnavailableResources>&)>&,
-      const Option<std::set<std::string>>&,
-      bool,
-      const Option<DomainInfo>&));
+               const hashmap<SlaveID, UnavailableResources>&)>&));
+
+  // The positional overload is not mocked, it funnels into the
+  // `Options` overload above so tests only need one expectation.
+  virtual void initialize(
+      const Duration& allocationInterval,
+      const lambda::function<
+          void(const FrameworkID&,
+               const hashmap<std::string, hashmap<SlaveID, Resources>>&)>&
+        offerCallback,
+      const lambda::function<
+          void(const FrameworkID&,
+               const hashmap<SlaveID, UnavailableResources>&)>&
+        inverseOfferCallback,
+      const Option<std::set<std::string>>& fairnessExcludeResourceNames,
+      bool filterGpuResources,
+      const Option<DomainInfo>& domain)
+  {
+    mesos::allocator::Options options;
+    options.allocationInterval = allocationInterval;
+    options.fairnessExcludeResourceNames = fairnessExcludeResourceNames;
+    options.filterGpuResources = filterGpuResources;
+    options.domain = domain;
+
+    initialize(options, offerCallback, inverseOfferCallback);
+  }
 
   MOCK_METHOD2(recover, void(
       const int expectedAgentCount,
@@ -204,6 +204,90 @@ TEST_P(MasterAPITest, GetAgents)
 }
 
 
+// This test verifies that when `--state_snapshot_interval` is set, the
+// GetAgents v1 API call is served from the latest snapshot of the
+// master, which only reflects a newly registered agent once a request
+// has found the snapshot outdated and the next one has been captured.
+TEST_P(MasterAPITest, GetAgentsFromStateSnapshot)
+{
+  Clock::pause();
+
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.state_snapshot_interval = Minutes(1);
+
+  Try<Owned<cluster::Master>> master = this->StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  v1::master::Call v1Call;
+  v1Call.set_type(v1::master::Call::GET_AGENTS);
+
+  ContentType contentType = GetParam();
+
+  {
+    Future<v1::master::Response> v1Response =
+      post(master.get()->pid, v1Call, contentType);
+
+    AWAIT_READY(v1Response);
+    ASSERT_TRUE(v1Response->IsInitialized());
+    ASSERT_EQ(v1::master::Response::GET_AGENTS, v1Response->type());
+    ASSERT_EQ(0, v1Response->get_agents().agents_size());
+  }
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+
+  Future<SlaveRegisteredMessage> agentRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get()->pid, _);
+
+  slave::Flags slaveFlags = CreateSlaveFlags();
+
+  Try<Owned<cluster::Slave>> agent = StartSlave(detector.get(), slaveFlags);
+  ASSERT_SOME(agent);
+
+  // Trigger authentication and registration for the agent.
+  Clock::advance(slaveFlags.authentication_backoff_factor);
+  Clock::advance(slaveFlags.registration_backoff_factor);
+
+  AWAIT_READY(agentRegisteredMessage);
+
+  // The agent is not part of the snapshot yet.
+  {
+    Future<v1::master::Response> v1Response =
+      post(master.get()->pid, v1Call, contentType);
+
+    AWAIT_READY(v1Response);
+    ASSERT_EQ(v1::master::Response::GET_AGENTS, v1Response->type());
+    ASSERT_EQ(0, v1Response->get_agents().agents_size());
+  }
+
+  Clock::advance(masterFlags.state_snapshot_interval.get());
+
+  // The snapshot is outdated now, but still served from while the next
+  // one is being captured.
+  {
+    Future<v1::master::Response> v1Response =
+      post(master.get()->pid, v1Call, contentType);
+
+    AWAIT_READY(v1Response);
+    ASSERT_EQ(v1::master::Response::GET_AGENTS, v1Response->type());
+    ASSERT_EQ(0, v1Response->get_agents().agents_size());
+  }
+
+  Clock::settle();
+
+  {
+    Future<v1::master::Response> v1Response =
+      post(master.get()->pid, v1Call, contentType);
+
+    AWAIT_READY(v1Response);
+    ASSERT_EQ(v1::master::Response::GET_AGENTS, v1Response->type());
+    ASSERT_EQ(1, v1Response->get_agents().agents_size());
+    ASSERT_EQ(
+        agent.get()->pid,
+        v1Response->get_agents().agents(0).pid());
+  }
+}
+
+
 TEST_P(MasterAPITest, GetFlags)
 {
   Try<Owned<cluster::Master>> master = this->StartMaster();
@@ -727,6 +811,153 @@ TEST_P(MasterAPITest, GetTasks)
 }
 
 
+// This test verifies that the GetTasks v1 API call selects the tasks
+// that match the given criteria and paginates them.
+TEST_P(MasterAPITest, GetTasksFilteringAndPagination)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get(), &containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  ASSERT_FALSE(offers->empty());
+
+  Resources resources = Resources::parse("cpus:0.1;mem:32").get();
+
+  vector<TaskInfo> tasks;
+  for (int i = 1; i <= 3; i++) {
+    TaskInfo task = createTask(
+        offers.get()[0].slave_id(),
+        resources,
+        "",
+        DEFAULT_EXECUTOR_ID,
+        "test",
+        stringify(i));
+
+    Label* label = task.mutable_labels()->add_labels();
+    label->set_key("team");
+    label->set_value(i == 1 ? "a" : "b");
+
+    tasks.push_back(task);
+  }
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  Future<TaskStatus> status3;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2))
+    .WillOnce(FutureArg<1>(&status3));
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(status1);
+  EXPECT_EQ(TASK_RUNNING, status1->state());
+  AWAIT_READY(status2);
+  EXPECT_EQ(TASK_RUNNING, status2->state());
+  AWAIT_READY(status3);
+  EXPECT_EQ(TASK_RUNNING, status3->state());
+
+  ContentType contentType = GetParam();
+
+  v1::master::Call v1Call;
+  v1Call.set_type(v1::master::Call::GET_TASKS);
+  v1Call.mutable_get_tasks()->set_state(v1::TASK_RUNNING);
+  v1Call.mutable_get_tasks()->set_limit(2);
+
+  // The tasks are paginated in the order of their IDs.
+  string cursor;
+
+  {
+    Future<v1::master::Response> v1Response =
+      post(master.get()->pid, v1Call, contentType);
+
+    AWAIT_READY(v1Response);
+    ASSERT_TRUE(v1Response->IsInitialized());
+    ASSERT_EQ(v1::master::Response::GET_TASKS, v1Response->type());
+    ASSERT_EQ(2, v1Response->get_tasks().tasks().size());
+    EXPECT_EQ("1", v1Response->get_tasks().tasks(0).task_id().value());
+    EXPECT_EQ("2", v1Response->get_tasks().tasks(1).task_id().value());
+    ASSERT_TRUE(v1Response->get_tasks().has_next_cursor());
+
+    cursor = v1Response->get_tasks().next_cursor();
+  }
+
+  v1Call.mutable_get_tasks()->set_cursor(cursor);
+
+  {
+    Future<v1::master::Response> v1Response =
+      post(master.get()->pid, v1Call, contentType);
+
+    AWAIT_READY(v1Response);
+    ASSERT_EQ(v1::master::Response::GET_TASKS, v1Response->type());
+    ASSERT_EQ(1, v1Response->get_tasks().tasks().size());
+    EXPECT_EQ("3", v1Response->get_tasks().tasks(0).task_id().value());
+    EXPECT_FALSE(v1Response->get_tasks().has_next_cursor());
+  }
+
+  // Select the tasks by label.
+  v1Call.mutable_get_tasks()->Clear();
+
+  mesos::v1::Label* label = v1Call.mutable_get_tasks()->mutable_label();
+  label->set_key("team");
+  label->set_value("a");
+
+  {
+    Future<v1::master::Response> v1Response =
+      post(master.get()->pid, v1Call, contentType);
+
+    AWAIT_READY(v1Response);
+    ASSERT_EQ(v1::master::Response::GET_TASKS, v1Response->type());
+    ASSERT_EQ(1, v1Response->get_tasks().tasks().size());
+    EXPECT_EQ("1", v1Response->get_tasks().tasks(0).task_id().value());
+  }
+
+  // Select the tasks of an unknown agent.
+  v1Call.mutable_get_tasks()->Clear();
+  v1Call.mutable_get_tasks()->mutable_agent_id()->set_value("unknown");
+
+  {
+    Future<v1::master::Response> v1Response =
+      post(master.get()->pid, v1Call, contentType);
+
+    AWAIT_READY(v1Response);
+    ASSERT_EQ(v1::master::Response::GET_TASKS, v1Response->type());
+    EXPECT_TRUE(v1Response->get_tasks().tasks().empty());
+  }
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+}
+
+
 TEST_P(MasterAPITest, GetLoggingLevel)
 {
   Try<Owned<cluster::Master>> master = this->StartMaster();
@@ -980,7 +1211,7 @@ TEST_P(MasterAPITest, ReserveResources)
 {
   TestAllocator<> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _));
 
   Try<Owned<cluster::Master>> master = StartMaster(&allocator);
   ASSERT_SOME(master);
@@ -1071,7 +1302,7 @@ TEST_P(MasterAPITest, UnreserveResources)
 {
   TestAllocator<> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _));
 
   Try<Owned<cluster::Master>> master = StartMaster(&allocator);
   ASSERT_SOME(master);
@@ -2699,6 +2930,205 @@ TEST_P(MasterAPITest, FrameworksEvent)
 }
 
 
+// Verifies that an event is delivered to subscribers that use
+// different content types, since the master encodes each event once
+// per content type and shares the encoding between the subscribers.
+TEST_P(MasterAPITest, SubscribersWithDifferentContentTypes)
+{
+  ContentType contentType = GetParam();
+
+  Try<Owned<cluster::Master>> master = this->StartMaster();
+  ASSERT_SOME(master);
+
+  auto subscribeToEvents = [&master](ContentType contentType) {
+    v1::master::Call v1Call;
+    v1Call.set_type(v1::master::Call::SUBSCRIBE);
+
+    http::Headers headers = createBasicAuthHeaders(DEFAULT_CREDENTIAL);
+
+    headers["Accept"] = stringify(contentType);
+
+    return http::streaming::post(
+        master.get()->pid,
+        "api/v1",
+        headers,
+        serialize(contentType, v1Call),
+        stringify(contentType));
+  };
+
+  // Subscribe a second and a third client, one with each content type.
+  vector<ContentType> contentTypes =
+    {contentType, ContentType::JSON, ContentType::PROTOBUF};
+
+  vector<Owned<Reader<v1::master::Event>>> decoders;
+
+  foreach (ContentType contentType_, contentTypes) {
+    Future<http::Response> response = subscribeToEvents(contentType_);
+
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+    ASSERT_EQ(http::Response::PIPE, response->type);
+    ASSERT_SOME(response->reader);
+
+    auto deserializer =
+      lambda::bind(deserialize<v1::master::Event>, contentType_, lambda::_1);
+
+    Owned<Reader<v1::master::Event>> decoder(new Reader<v1::master::Event>(
+        Decoder<v1::master::Event>(deserializer), response->reader.get()));
+
+    Future<Result<v1::master::Event>> event = decoder->read();
+    AWAIT_READY(event);
+    EXPECT_EQ(v1::master::Event::SUBSCRIBED, event->get().type());
+
+    event = decoder->read();
+    AWAIT_READY(event);
+    EXPECT_EQ(v1::master::Event::HEARTBEAT, event->get().type());
+
+    decoders.push_back(decoder);
+  }
+
+  vector<Future<Result<v1::master::Event>>> events;
+  foreach (const Owned<Reader<v1::master::Event>>& decoder, decoders) {
+    events.push_back(decoder->read());
+  }
+
+  // Start a scheduler, which results in a 'FRAMEWORK_ADDED' event.
+  auto scheduler = std::make_shared<v1::MockHTTPScheduler>();
+
+  Future<Nothing> connected;
+  EXPECT_CALL(*scheduler, connected(_))
+    .WillOnce(FutureSatisfy(&connected));
+
+  v1::scheduler::TestMesos mesos(
+      master.get()->pid,
+      contentType,
+      scheduler);
+
+  AWAIT_READY(connected);
+
+  Future<v1::scheduler::Event::Subscribed> subscribed;
+  EXPECT_CALL(*scheduler, subscribed(_, _))
+    .WillOnce(FutureArg<1>(&subscribed));
+
+  EXPECT_CALL(*scheduler, heartbeat(_))
+    .WillRepeatedly(Return()); // Ignore heartbeats.
+
+  EXPECT_CALL(*scheduler, disconnected(_))
+    .WillRepeatedly(Return());
+
+  {
+    v1::scheduler::Call call;
+    call.set_type(v1::scheduler::Call::SUBSCRIBE);
+
+    v1::scheduler::Call::Subscribe* subscribe = call.mutable_subscribe();
+    subscribe->mutable_framework_info()->CopyFrom(v1::DEFAULT_FRAMEWORK_INFO);
+
+    mesos.send(call);
+  }
+
+  AWAIT_READY(subscribed);
+
+  v1::FrameworkID frameworkId = subscribed->framework_id();
+
+  foreach (const Future<Result<v1::master::Event>>& event, events) {
+    AWAIT_READY(event);
+    ASSERT_SOME(event.get());
+    EXPECT_EQ(v1::master::Event::FRAMEWORK_ADDED, event->get().type());
+  }
+
+  events.clear();
+  foreach (const Owned<Reader<v1::master::Event>>& decoder, decoders) {
+    events.push_back(decoder->read());
+  }
+
+  // Tear down the framework, which results in a 'FRAMEWORK_REMOVED'
+  // event that is sent unmodified to all subscribers.
+  {
+    Future<http::Response> response = process::http::post(
+        master.get()->pid,
+        "teardown",
+        createBasicAuthHeaders(DEFAULT_CREDENTIAL),
+        "frameworkId=" + frameworkId.value());
+
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  }
+
+  foreach (const Future<Result<v1::master::Event>>& event, events) {
+    AWAIT_READY(event);
+    ASSERT_SOME(event.get());
+    EXPECT_EQ(v1::master::Event::FRAMEWORK_REMOVED, event->get().type());
+    EXPECT_EQ(
+        frameworkId,
+        event->get().framework_removed().framework_info().id());
+  }
+}
+
+
+// Verifies that a subscriber is disconnected if the authorizer fails
+// to create its acceptors, rather than staying subscribed without
+// receiving any events.
+TEST_P(MasterAPITest, SubscribeAuthorizationFailure)
+{
+  ContentType contentType = GetParam();
+
+  MockAuthorizer authorizer;
+
+  Try<Owned<cluster::Master>> master = StartMaster(&authorizer);
+  ASSERT_SOME(master);
+
+  // The first four object approvers are used for the 'SUBSCRIBED'
+  // event, the acceptors of the subscriber are created after that.
+  Owned<ObjectApprover> approver(new AcceptingObjectApprover());
+
+  EXPECT_CALL(authorizer, getObjectApprover(_, _))
+    .WillOnce(Return(approver))
+    .WillOnce(Return(approver))
+    .WillOnce(Return(approver))
+    .WillOnce(Return(approver))
+    .WillRepeatedly(Return(Failure("Authorizer failure")));
+
+  v1::master::Call v1Call;
+  v1Call.set_type(v1::master::Call::SUBSCRIBE);
+
+  http::Headers headers = createBasicAuthHeaders(DEFAULT_CREDENTIAL);
+  headers["Accept"] = stringify(contentType);
+
+  Future<http::Response> response = http::streaming::post(
+      master.get()->pid,
+      "api/v1",
+      headers,
+      serialize(contentType, v1Call),
+      stringify(contentType));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  ASSERT_EQ(http::Response::PIPE, response->type);
+  ASSERT_SOME(response->reader);
+
+  auto deserializer =
+    lambda::bind(deserialize<v1::master::Event>, contentType, lambda::_1);
+
+  Reader<v1::master::Event> decoder(
+      Decoder<v1::master::Event>(deserializer), response->reader.get());
+
+  Future<Result<v1::master::Event>> event = decoder.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+  EXPECT_EQ(v1::master::Event::SUBSCRIBED, event->get().type());
+
+  // The connection is closed, possibly after a heartbeat was sent.
+  event = decoder.read();
+  AWAIT_READY(event);
+
+  if (event->isSome()) {
+    EXPECT_EQ(v1::master::Event::HEARTBEAT, event->get().type());
+
+    event = decoder.read();
+    AWAIT_READY(event);
+  }
+
+  EXPECT_NONE(event.get());
+}
+
+
 // Verifies that 'HEARTBEAT' events are sent at the correct times.
 TEST_P(MasterAPITest, Heartbeat)
 {
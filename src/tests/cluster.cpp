@@ -243,7 +243,12 @@ Try<process::Owned<Master>> Master::start(
     master->storage.reset(new mesos::state::InMemoryStorage());
   } else if (flags.registry == "replicated_log") {
 #ifndef __WINDOWS__
-    master->storage.reset(new mesos::state::LogStorage(master->log.get()));
+    master->storage.reset(new mesos::state::LogStorage(
+        master->log.get(),
+        flags.registry_log_max_diffs,
+        flags.registry_log_diff_format == "delta"
+          ? mesos::state::LogStorage::DELTA
+          : mesos::state::LogStorage::SVN));
 #else
     return Error("Windows does not support replicated log");
 #endif // __WINDOWS__
@@ -681,6 +681,47 @@ TEST_F(DynamicWeightsTest, RecoveredWeightsFromRegistry)
   }
 }
 
+
+// Checks that the weights can be recovered from a registry that is
+// stored as deltas between snapshots in the replicated log.
+TEST_F(DynamicWeightsTest, RecoveredWeightsFromRegistryLogDeltas)
+{
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.registry = "replicated_log";
+  masterFlags.registry_log_max_diffs = 10;
+  masterFlags.registry_log_diff_format = "delta";
+  masterFlags.weights = UPDATED_WEIGHTS1;
+
+  Try<Owned<cluster::Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  // Update the weights, which stores a delta of the registry.
+  RepeatedPtrField<WeightInfo> infos = createWeightInfos(UPDATED_WEIGHTS2);
+  Future<Response> response = process::http::request(
+      process::http::createRequest(
+          master.get()->pid,
+          "PUT",
+          false,
+          "weights",
+          createBasicAuthHeaders(DEFAULT_CREDENTIAL),
+          strings::format("%s", JSON::protobuf(infos)).get()));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  // Stop the master
+  master->reset();
+
+  // Restart the master without `--weights` flag.
+  masterFlags.weights = None();
+  master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  checkWithGetRequest(
+      master.get()->pid,
+      DEFAULT_CREDENTIAL,
+      UPDATED_WEIGHTS2);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
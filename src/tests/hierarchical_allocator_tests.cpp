@@ -14,6 +14,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <atomic>
 #include <iostream>
 #include <set>
@@ -23,11 +24,16 @@
 
 #include <gmock/gmock.h>
 
+#include <mesos/attributes.hpp>
+
 #include <mesos/allocator/allocator.hpp>
 
 #include <process/clock.hpp>
 #include <process/future.hpp>
 #include <process/gtest.hpp>
+#include <process/http.hpp>
+#include <process/owned.hpp>
+#include <process/pid.hpp>
 #include <process/queue.hpp>
 
 #include <stout/duration.hpp>
@@ -65,6 +71,12 @@ using mesos::allocator::Allocator;
 
 using process::Clock;
 using process::Future;
+using process::Owned;
+using process::Promise;
+using process::UPID;
+
+using process::http::OK;
+using process::http::Response;
 
 using std::atomic;
 using std::cout;
@@ -176,11 +188,34 @@ protected:
         };
     }
 
+    mesos::allocator::Options options;
+    options.allocationInterval = flags.allocation_interval;
+    options.fairnessExcludeResourceNames =
+      flags.fair_sharing_excluded_resource_names;
+    options.filterGpuResources = flags.filter_gpu_resources;
+    options.domain = flags.domain;
+    options.maxOffersPerFramework = flags.max_offers_per_framework;
+
+    Try<mesos::allocator::Options::OfferPackingPolicy> offerPackingPolicy =
+      mesos::allocator::Options::parseOfferPackingPolicy(
+          flags.offer_packing_policy);
+
+    ASSERT_SOME(offerPackingPolicy);
+    options.offerPackingPolicy = offerPackingPolicy.get();
+
+    if (flags.offer_packing_attribute_weights.isSome()) {
+      Try<vector<mesos::allocator::Options::AttributeWeight>> weights =
+        mesos::allocator::Options::parseAttributeWeights(
+            flags.offer_packing_attribute_weights.get());
+
+      ASSERT_SOME(weights);
+      options.offerPackingAttributeWeights = weights.get();
+    }
+
     allocator->initialize(
-        flags.allocation_interval,
+        options,
         offerCallback.get(),
-        inverseOfferCallback.get(),
-        flags.fair_sharing_excluded_resource_names);
+        inverseOfferCallback.get());
   }
 
   SlaveInfo createSlaveInfo(const Resources& resources)
@@ -3843,6 +3878,144 @@ TEST_F_TEMP_DISABLED_ON_WINDOWS(
 }
 
 
+// This test checks that the time spent in the individual stages
+// of an allocation run is reported in the metrics endpoint.
+TEST_F_TEMP_DISABLED_ON_WINDOWS(
+    HierarchicalAllocatorTest,
+    AllocationRunStageMetrics)
+{
+  Clock::pause();
+
+  initialize();
+
+  auto stages = {
+    "allocator/mesos/allocation_run/quota_stage_ms",
+    "allocator/mesos/allocation_run/headroom_ms",
+    "allocator/mesos/allocation_run/fair_share_stage_ms",
+    "allocator/mesos/allocation_run/deallocation_ms",
+    "allocator/mesos/allocation_run/offer_callbacks_ms",
+  };
+
+  JSON::Object metrics = Metrics();
+
+  // No stage should have been timed before the first allocation run.
+  foreach (const string& stage, stages) {
+    EXPECT_EQ(0u, metrics.values.count(stage))
+      << "Expected " << stage << " to be absent";
+  }
+
+  SlaveInfo agent = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(
+      agent.id(),
+      agent,
+      AGENT_CAPABILITIES(),
+      None(),
+      agent.resources(),
+      {});
+
+  FrameworkInfo framework = createFrameworkInfo({"role1"});
+  allocator->addFramework(framework.id(), framework, {}, true, {});
+
+  Clock::settle();
+
+  AWAIT_READY(allocations.get());
+
+  metrics = Metrics();
+
+  foreach (const string& stage, stages) {
+    ASSERT_EQ(1u, metrics.values.count(stage))
+      << "Expected " << stage << " to be present";
+
+    JSON::Value value = metrics.values[stage];
+    ASSERT_TRUE(value.is<JSON::Number>()) << value.which();
+    EXPECT_GE(value.as<JSON::Number>().as<double>(), 0.0);
+  }
+}
+
+
+// This test checks the JSON output of the `/debug` endpoint, which
+// reports the slowest of the recent allocation runs.
+TEST_F(HierarchicalAllocatorTest, DebugEndpoint)
+{
+  Clock::pause();
+
+  // The offer callback is invoked by the allocator process, which
+  // tells the PID to query the endpoint of.
+  Owned<Promise<UPID>> allocatorPid(new Promise<UPID>());
+
+  initialize(
+      master::Flags(),
+      [allocatorPid](
+          const FrameworkID&,
+          const hashmap<string, hashmap<SlaveID, Resources>>&) {
+        allocatorPid->set(process::__process__->self());
+      });
+
+  SlaveInfo agent = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(
+      agent.id(),
+      agent,
+      AGENT_CAPABILITIES(),
+      None(),
+      agent.resources(),
+      {});
+
+  FrameworkInfo framework = createFrameworkInfo({"role1"});
+  allocator->addFramework(framework.id(), framework, {}, true, {});
+
+  Clock::settle();
+
+  Future<UPID> pid = allocatorPid->future();
+  AWAIT_READY(pid);
+
+  Future<Response> response = process::http::get(pid.get(), "debug", "limit=1");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Number> recentCycles =
+    parse->find<JSON::Number>("recent_cycles");
+
+  ASSERT_SOME(recentCycles);
+  EXPECT_GE(recentCycles->as<uint64_t>(), 1u);
+
+  Result<JSON::Array> slowestCycles =
+    parse->find<JSON::Array>("slowest_cycles");
+
+  ASSERT_SOME(slowestCycles);
+  ASSERT_EQ(1u, slowestCycles->values.size());
+  ASSERT_TRUE(slowestCycles->values[0].is<JSON::Object>());
+
+  const JSON::Object& cycle = slowestCycles->values[0].as<JSON::Object>();
+
+  auto fields = {
+    "timestamp",
+    "duration_ms",
+    "quota_stage_ms",
+    "headroom_ms",
+    "fair_share_stage_ms",
+    "deallocation_ms",
+    "offer_callbacks_ms",
+    "candidate_agents",
+    "eligible_agents",
+    "roles",
+    "frameworks",
+    "allocations",
+    "offered_frameworks",
+  };
+
+  foreach (const string& field, fields) {
+    Result<JSON::Number> value = cycle.find<JSON::Number>(field);
+    ASSERT_SOME(value) << "Expected " << field << " to be present";
+    EXPECT_GE(value->as<double>(), 0.0);
+  }
+
+  EXPECT_EQ(fields.size(), cycle.values.size());
+}
+
+
 // This test checks that per-role active offer filter metrics
 // are correctly reported in the metrics endpoint.
 TEST_F_TEMP_DISABLED_ON_WINDOWS(
@@ -4410,6 +4583,254 @@ TEST_F(HierarchicalAllocatorTest, ReviveOffers)
 }
 
 
+// This test ensures that a framework is offered resources on at most
+// `--max_offers_per_framework` agents per allocation cycle, and that
+// the `spread` packing policy offers the agent with the most free
+// resources first.
+TEST_F(HierarchicalAllocatorTest, MaxOffersPerFrameworkSpread)
+{
+  // Pausing the clock is not necessary, but ensures that the test
+  // doesn't rely on the batch allocation in the allocator, which
+  // would slow down the test.
+  Clock::pause();
+
+  master::Flags flags_;
+  flags_.offer_packing_policy = "spread";
+  flags_.max_offers_per_framework = 1;
+
+  initialize(flags_);
+
+  SlaveInfo agent1 = createSlaveInfo("cpus:1;mem:512;disk:0");
+  allocator->addSlave(
+      agent1.id(),
+      agent1,
+      AGENT_CAPABILITIES(),
+      None(),
+      agent1.resources(),
+      {});
+
+  SlaveInfo agent2 = createSlaveInfo("cpus:4;mem:2048;disk:0");
+  allocator->addSlave(
+      agent2.id(),
+      agent2,
+      AGENT_CAPABILITIES(),
+      None(),
+      agent2.resources(),
+      {});
+
+  // The framework is only offered the larger agent.
+  FrameworkInfo framework = createFrameworkInfo({"role1"});
+  allocator->addFramework(framework.id(), framework, {}, true, {});
+
+  Allocation expected = Allocation(
+      framework.id(),
+      {{"role1", {{agent2.id(), agent2.resources()}}}});
+
+  AWAIT_EXPECT_EQ(expected, allocations.get());
+
+  // The remaining agent is offered in the next allocation cycle.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  expected = Allocation(
+      framework.id(),
+      {{"role1", {{agent1.id(), agent1.resources()}}}});
+
+  AWAIT_EXPECT_EQ(expected, allocations.get());
+}
+
+
+// This test ensures that the `binpack` packing policy offers the most
+// utilized agent first.
+TEST_F(HierarchicalAllocatorTest, MaxOffersPerFrameworkBinpack)
+{
+  // Pausing the clock is not necessary, but ensures that the test
+  // doesn't rely on the batch allocation in the allocator, which
+  // would slow down the test.
+  Clock::pause();
+
+  master::Flags flags_;
+  flags_.offer_packing_policy = "binpack";
+  flags_.max_offers_per_framework = 1;
+
+  initialize(flags_);
+
+  // `framework1` is suppressed so that it only uses resources.
+  FrameworkInfo framework1 = createFrameworkInfo({"role1"});
+  allocator->addFramework(
+      framework1.id(), framework1, {}, true, {"role1"});
+
+  const Resources used = Resources::parse("cpus:1;mem:512").get();
+
+  SlaveInfo agent1 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(
+      agent1.id(),
+      agent1,
+      AGENT_CAPABILITIES(),
+      None(),
+      agent1.resources(),
+      {{framework1.id(), allocatedResources(used, "role1")}});
+
+  SlaveInfo agent2 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(
+      agent2.id(),
+      agent2,
+      AGENT_CAPABILITIES(),
+      None(),
+      agent2.resources(),
+      {});
+
+  // `framework2` is first offered the remaining resources of the
+  // partially used agent.
+  FrameworkInfo framework2 = createFrameworkInfo({"role2"});
+  allocator->addFramework(framework2.id(), framework2, {}, true, {});
+
+  Allocation expected = Allocation(
+      framework2.id(),
+      {{"role2", {{agent1.id(), agent1.resources() - used}}}});
+
+  AWAIT_EXPECT_EQ(expected, allocations.get());
+
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  expected = Allocation(
+      framework2.id(),
+      {{"role2", {{agent2.id(), agent2.resources()}}}});
+
+  AWAIT_EXPECT_EQ(expected, allocations.get());
+}
+
+
+// This test ensures that the `binpack` packing policy does not count a
+// shared persistent volume as utilized, so that an unused agent whose
+// disk is a shared volume is not offered before a partially used one.
+TEST_F(HierarchicalAllocatorTest, MaxOffersPerFrameworkBinpackSharedVolume)
+{
+  // Pausing the clock is not necessary, but ensures that the test
+  // doesn't rely on the batch allocation in the allocator, which
+  // would slow down the test.
+  Clock::pause();
+
+  master::Flags flags_;
+  flags_.offer_packing_policy = "binpack";
+  flags_.max_offers_per_framework = 1;
+
+  initialize(flags_);
+
+  // `framework1` is suppressed so that it only uses resources.
+  FrameworkInfo framework1 = createFrameworkInfo({"role1"});
+  allocator->addFramework(
+      framework1.id(), framework1, {}, true, {"role1"});
+
+  // All the disk of `agent1` is a shared volume, which is never
+  // available but must not make the agent look utilized either.
+  Resource volume = createDiskResource(
+      "100", "role1", "id1", None(), None(), true);
+
+  SlaveInfo agent1 = createSlaveInfo(
+      Resources::parse("cpus:2;mem:1024").get() + volume);
+
+  allocator->addSlave(
+      agent1.id(),
+      agent1,
+      AGENT_CAPABILITIES(),
+      None(),
+      agent1.resources(),
+      {});
+
+  const Resources used = Resources::parse("cpus:1;mem:512").get();
+
+  SlaveInfo agent2 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(
+      agent2.id(),
+      agent2,
+      AGENT_CAPABILITIES(),
+      None(),
+      agent2.resources(),
+      {{framework1.id(), allocatedResources(used, "role1")}});
+
+  // `framework2` is first offered the remaining resources of the
+  // partially used agent. It can not use the volume reserved for
+  // `role1`, so it is offered the rest of `agent1` afterwards.
+  FrameworkInfo framework2 = createFrameworkInfo({"role2"});
+  allocator->addFramework(framework2.id(), framework2, {}, true, {});
+
+  Allocation expected = Allocation(
+      framework2.id(),
+      {{"role2", {{agent2.id(), agent2.resources() - used}}}});
+
+  AWAIT_EXPECT_EQ(expected, allocations.get());
+
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  expected = Allocation(
+      framework2.id(),
+      {{"role2", {{agent1.id(), Resources(agent1.resources()) - volume}}}});
+
+  AWAIT_EXPECT_EQ(expected, allocations.get());
+}
+
+
+// This test ensures that the `attribute_weighted` packing policy offers
+// the agent with the highest sum of attribute weights first.
+TEST_F(HierarchicalAllocatorTest, MaxOffersPerFrameworkAttributeWeighted)
+{
+  // Pausing the clock is not necessary, but ensures that the test
+  // doesn't rely on the batch allocation in the allocator, which
+  // would slow down the test.
+  Clock::pause();
+
+  master::Flags flags_;
+  flags_.offer_packing_policy = "attribute_weighted";
+  flags_.offer_packing_attribute_weights = "rack:r2=2,ssd=1";
+  flags_.max_offers_per_framework = 1;
+
+  initialize(flags_);
+
+  // `agent1` is the largest agent but has no weighted attributes.
+  SlaveInfo agent1 = createSlaveInfo("cpus:8;mem:4096;disk:0");
+  agent1.add_attributes()->CopyFrom(Attributes::parse("rack", "r1"));
+
+  SlaveInfo agent2 = createSlaveInfo("cpus:1;mem:512;disk:0");
+  agent2.add_attributes()->CopyFrom(Attributes::parse("rack", "r2"));
+
+  SlaveInfo agent3 = createSlaveInfo("cpus:1;mem:512;disk:0");
+  agent3.add_attributes()->CopyFrom(Attributes::parse("rack", "r1"));
+  agent3.add_attributes()->CopyFrom(Attributes::parse("ssd", "true"));
+
+  const vector<SlaveInfo> agents = {agent1, agent2, agent3};
+
+  foreach (const SlaveInfo& agent, agents) {
+    allocator->addSlave(
+        agent.id(),
+        agent,
+        AGENT_CAPABILITIES(),
+        None(),
+        agent.resources(),
+        {});
+  }
+
+  FrameworkInfo framework = createFrameworkInfo({"role1"});
+  allocator->addFramework(framework.id(), framework, {}, true, {});
+
+  // The agents are offered in the order of their weights.
+  const vector<SlaveInfo> expectedOrder = {agent2, agent3, agent1};
+
+  foreach (const SlaveInfo& agent, expectedOrder) {
+    Allocation expected = Allocation(
+        framework.id(),
+        {{"role1", {{agent.id(), agent.resources()}}}});
+
+    AWAIT_EXPECT_EQ(expected, allocations.get());
+
+    Clock::advance(flags.allocation_interval);
+    Clock::settle();
+  }
+}
+
+
 // This test checks that if a multi-role framework declines resources
 // for one role with a long filter, it will be offered filtered resources
 // again to another role with some suppress and revive logic.
@@ -6228,6 +6649,207 @@ TEST_P(HierarchicalAllocator_BENCHMARK_Test, AllocatorBacklog)
        << " allocation runs" << endl;
 }
 
+
+class HierarchicalAllocatorPacking_BENCHMARK_Test
+  : public HierarchicalAllocatorTestBase,
+    public WithParamInterface<std::tuple<size_t, string>> {};
+
+
+// The packing benchmark is parameterized by the number of agents and
+// the offer packing policy.
+INSTANTIATE_TEST_CASE_P(
+    AgentCountAndPolicy,
+    HierarchicalAllocatorPacking_BENCHMARK_Test,
+    ::testing::Combine(
+      ::testing::Values(1000U, 5000U, 10000U),
+      ::testing::Values(
+          "random", "binpack", "spread", "attribute_weighted")));
+
+
+// This benchmark simulates a churning workload of uniform tasks in
+// order to compare the fragmentation left behind by, and the duration
+// of the allocation cycles of, the different offer packing policies.
+// In every round a random fraction of the running tasks completes and
+// every offer is used to launch a single task.
+TEST_P(HierarchicalAllocatorPacking_BENCHMARK_Test, Fragmentation)
+{
+  const size_t agentCount = std::get<0>(GetParam());
+  const string policy = std::get<1>(GetParam());
+
+  const size_t frameworkCount = 100;
+  const size_t roundCount = 20;
+
+  // Pause the clock because we want to manually drive the allocations.
+  Clock::pause();
+
+  struct OfferedResources
+  {
+    FrameworkID   frameworkId;
+    SlaveID       slaveId;
+    Resources     resources;
+  };
+
+  vector<OfferedResources> offers;
+
+  auto offerCallback = [&offers](
+      const FrameworkID& frameworkId,
+      const hashmap<string, hashmap<SlaveID, Resources>>& resources_)
+  {
+    foreachkey (const string& role, resources_) {
+      foreachpair (const SlaveID& slaveId,
+                   const Resources& resources,
+                   resources_.at(role)) {
+        offers.push_back(OfferedResources{frameworkId, slaveId, resources});
+      }
+    }
+  };
+
+  cout << "Using " << agentCount << " agents, " << frameworkCount
+       << " frameworks and the `" << policy << "` packing policy" << endl;
+
+  master::Flags flags_;
+  flags_.offer_packing_policy = policy;
+  flags_.max_offers_per_framework = 1;
+
+  // The agents are spread across 10 racks, two of which are preferred
+  // by the `attribute_weighted` policy.
+  const size_t rackCount = 10;
+
+  if (policy == "attribute_weighted") {
+    flags_.offer_packing_attribute_weights = "rack:r0=2,rack:r1=1";
+  }
+
+  initialize(flags_, offerCallback);
+
+  for (size_t i = 0; i < frameworkCount; i++) {
+    FrameworkInfo framework = createFrameworkInfo({"*"});
+    allocator->addFramework(framework.id(), framework, {}, true, {});
+  }
+
+  const Resources agentResources =
+    Resources::parse("cpus:16;mem:16384;disk:0").get();
+
+  for (size_t i = 0; i < agentCount; i++) {
+    SlaveInfo agent = createSlaveInfo(agentResources);
+    agent.add_attributes()->CopyFrom(
+        Attributes::parse("rack", "r" + stringify(i % rackCount)));
+
+    allocator->addSlave(
+        agent.id(),
+        agent,
+        AGENT_CAPABILITIES(),
+        None(),
+        agent.resources(),
+        {});
+  }
+
+  // Wait for all the `addFramework` and `addSlave` operations to be
+  // processed, and decline the resulting offers.
+  Clock::settle();
+
+  Filters filters;
+  filters.set_refuse_seconds(0);
+
+  foreach (const OfferedResources& offer, offers) {
+    allocator->recoverResources(
+        offer.frameworkId, offer.slaveId, offer.resources, filters);
+  }
+
+  offers.clear();
+
+  Resources task = Resources::parse("cpus:2;mem:2048").get();
+  task.allocate("*");
+
+  vector<OfferedResources> tasks;
+  hashmap<SlaveID, size_t> taskCounts;
+
+  Duration total = Duration::zero();
+
+  for (size_t round = 0; round < roundCount; round++) {
+    // Complete a random 10% of the running tasks.
+    std::random_shuffle(tasks.begin(), tasks.end());
+
+    const size_t completed = tasks.size() / 10;
+    for (size_t i = 0; i < completed; i++) {
+      const OfferedResources& completedTask = tasks.back();
+
+      allocator->recoverResources(
+          completedTask.frameworkId,
+          completedTask.slaveId,
+          completedTask.resources,
+          None());
+
+      --taskCounts[completedTask.slaveId];
+      tasks.pop_back();
+    }
+
+    Clock::settle();
+
+    Stopwatch watch;
+    watch.start();
+
+    // Advance the clock and trigger a background allocation cycle.
+    Clock::advance(flags.allocation_interval);
+    Clock::settle();
+
+    watch.stop();
+    total += watch.elapsed();
+
+    const size_t offerCount = offers.size();
+
+    // Launch a single task per offer and decline the remainder.
+    foreach (const OfferedResources& offer, offers) {
+      Resources remaining = offer.resources;
+
+      if (remaining.contains(task)) {
+        tasks.push_back(
+            OfferedResources{offer.frameworkId, offer.slaveId, task});
+
+        ++taskCounts[offer.slaveId];
+        remaining -= task;
+      }
+
+      allocator->recoverResources(
+          offer.frameworkId, offer.slaveId, remaining, filters);
+    }
+
+    offers.clear();
+    Clock::settle();
+
+    cout << "round " << round << " allocate() took " << watch.elapsed()
+         << " to make " << offerCount << " offers" << endl;
+  }
+
+  // An agent is partially used if it runs tasks but could run more;
+  // the cpus left on such agents are stranded for tasks that need a
+  // whole agent.
+  const size_t tasksPerAgent = 8;
+
+  size_t freeAgents = agentCount;
+  size_t fullAgents = 0;
+  size_t strandedCpus = 0;
+
+  foreachvalue (size_t count, taskCounts) {
+    if (count > 0) {
+      --freeAgents;
+    }
+
+    if (count == tasksPerAgent) {
+      ++fullAgents;
+    } else if (count > 0) {
+      strandedCpus += 2 * (tasksPerAgent - count);
+    }
+  }
+
+  cout << "Ran " << roundCount << " allocation cycles in " << total
+       << " leaving " << tasks.size() << " running tasks on "
+       << agentCount - freeAgents << " agents (" << fullAgents << " full, "
+       << freeAgents << " free) with " << strandedCpus
+       << " stranded cpus" << endl;
+
+  Clock::resume();
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
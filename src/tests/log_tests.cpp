@@ -19,12 +19,14 @@
 #include <list>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 
 #include <mesos/log/log.hpp>
 
 #include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
@@ -67,7 +69,10 @@ using namespace process;
 
 using std::list;
 using std::set;
+using std::cout;
+using std::endl;
 using std::string;
+using std::vector;
 
 using testing::_;
 using testing::Eq;
@@ -321,6 +326,217 @@ TYPED_TEST(LogStorageTest, TruncateWithManyHoles)
 }
 
 
+TYPED_TEST(LogStorageTest, Restore)
+{
+  const string path = os::getcwd() + "/.log";
+
+  {
+    TypeParam storage;
+
+    Try<Storage::State> state = storage.restore(path);
+    ASSERT_SOME(state);
+
+    Metadata metadata;
+    metadata.set_status(Metadata::VOTING);
+    metadata.set_promised(1);
+
+    ASSERT_SOME(storage.persist(metadata));
+
+    // Append from position 1 to position 2500, leaving a hole at
+    // position 100 and positions 200 and 300 unlearned. Enough
+    // actions are persisted for the storage to write snapshots.
+    vector<Action> actions;
+
+    for (uint64_t i = 1; i <= 2500; i++) {
+      if (i == 100) {
+        continue;
+      }
+
+      Action action;
+      action.set_position(i);
+      action.set_promised(1);
+      action.set_performed(1);
+      action.set_learned(i != 200 && i != 300);
+      action.set_type(Action::APPEND);
+      action.mutable_append()->set_bytes(stringify(i));
+
+      actions.push_back(action);
+
+      if (actions.size() == 100) {
+        ASSERT_SOME(storage.persist(actions));
+        actions.clear();
+      }
+    }
+
+    ASSERT_SOME(storage.persist(actions));
+
+    // Learn position 200 and truncate to position 50 (at position
+    // 2501) after the last snapshot.
+    Action action;
+    action.set_position(200);
+    action.set_promised(1);
+    action.set_performed(1);
+    action.set_learned(true);
+    action.set_type(Action::APPEND);
+    action.mutable_append()->set_bytes(stringify(200));
+
+    ASSERT_SOME(storage.persist(action));
+
+    Action truncate;
+    truncate.set_position(2501);
+    truncate.set_promised(1);
+    truncate.set_performed(1);
+    truncate.set_learned(true);
+    truncate.set_type(Action::TRUNCATE);
+    truncate.mutable_truncate()->set_to(50);
+
+    ASSERT_SOME(storage.persist(truncate));
+  }
+
+  TypeParam storage;
+
+  Try<Storage::State> state = storage.restore(path);
+  ASSERT_SOME(state);
+
+  EXPECT_EQ(Metadata::VOTING, state->metadata.status());
+  EXPECT_EQ(1u, state->metadata.promised());
+  EXPECT_EQ(50u, state->begin);
+  EXPECT_EQ(2501u, state->end);
+
+  EXPECT_TRUE(state->learned.contains(50));
+  EXPECT_FALSE(state->learned.contains(100));
+  EXPECT_TRUE(state->learned.contains(200));
+  EXPECT_FALSE(state->learned.contains(300));
+  EXPECT_TRUE(state->learned.contains(2501));
+
+  EXPECT_EQ(IntervalSet<uint64_t>(300), state->unlearned);
+
+  EXPECT_ERROR(storage.read(49));
+
+  Try<Action> action = storage.read(200);
+  ASSERT_SOME(action);
+  EXPECT_TRUE(action->learned());
+}
+
+
+// Tests that a storage that has not persisted any metadata does not
+// attempt to write a snapshot (which is stored with the metadata).
+TYPED_TEST(LogStorageTest, RestoreWithoutMetadata)
+{
+  const string path = os::getcwd() + "/.log";
+
+  {
+    TypeParam storage;
+
+    Try<Storage::State> state = storage.restore(path);
+    ASSERT_SOME(state);
+
+    // Persist enough actions for the storage to write a snapshot.
+    for (uint64_t i = 1; i <= 1500; i++) {
+      Action action;
+      action.set_position(i);
+      action.set_promised(1);
+      action.set_performed(1);
+      action.set_learned(true);
+      action.set_type(Action::APPEND);
+      action.mutable_append()->set_bytes(stringify(i));
+
+      ASSERT_SOME(storage.persist(action));
+    }
+  }
+
+  TypeParam storage;
+
+  Try<Storage::State> state = storage.restore(path);
+  ASSERT_SOME(state);
+
+  EXPECT_EQ(0u, state->begin);
+  EXPECT_EQ(1500u, state->end);
+  EXPECT_TRUE(state->learned.contains(1500));
+
+  Metadata metadata;
+  metadata.set_status(Metadata::VOTING);
+  metadata.set_promised(1);
+
+  ASSERT_SOME(storage.persist(metadata));
+
+  Action action;
+  action.set_position(1501);
+  action.set_promised(1);
+  action.set_performed(1);
+  action.set_learned(true);
+  action.set_type(Action::NOP);
+  action.mutable_nop();
+
+  ASSERT_SOME(storage.persist(action));
+}
+
+
+// Measures the time it takes to restore a replica's storage, given
+// the number of actions in the log.
+class LogStorage_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public ::testing::WithParamInterface<size_t> {};
+
+
+INSTANTIATE_TEST_CASE_P(
+    Actions,
+    LogStorage_BENCHMARK_Test,
+    ::testing::Values(1000U, 10000U, 100000U));
+
+
+TEST_P(LogStorage_BENCHMARK_Test, Restore)
+{
+  const size_t count = GetParam();
+  const string path = os::getcwd() + "/.log";
+
+  {
+    LevelDBStorage storage;
+
+    Try<Storage::State> state = storage.restore(path);
+    ASSERT_SOME(state);
+
+    vector<Action> actions;
+
+    for (uint64_t i = 1; i <= count; i++) {
+      Action action;
+      action.set_position(i);
+      action.set_promised(1);
+      action.set_performed(1);
+      action.set_learned(true);
+      action.set_type(Action::APPEND);
+      action.mutable_append()->set_bytes(string(1024, 'x'));
+
+      actions.push_back(action);
+
+      if (actions.size() == 100) {
+        ASSERT_SOME(storage.persist(actions));
+        actions.clear();
+      }
+    }
+
+    if (!actions.empty()) {
+      ASSERT_SOME(storage.persist(actions));
+    }
+  }
+
+  LevelDBStorage storage;
+
+  Stopwatch watch;
+  watch.start();
+
+  Try<Storage::State> state = storage.restore(path);
+  ASSERT_SOME(state);
+
+  watch.stop();
+
+  EXPECT_EQ(count, state->end);
+
+  cout << "Restored a log of " << count << " actions in "
+       << watch.elapsed() << endl;
+}
+
+
 class ReplicaTest : public TemporaryDirectoryTest
 {
 protected:
@@ -1205,7 +1421,7 @@ TEST_F(CoordinatorTest, MultipleAppends)
 }
 
 
-TEST_F(CoordinatorTest, MultipleAppendsNotLearnedFill)
+TEST_F(CoordinatorTest, ConcurrentAppends)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -1215,74 +1431,53 @@ TEST_F(CoordinatorTest, MultipleAppendsNotLearnedFill)
   initializer.flags.path = path2;
   ASSERT_SOME(initializer.execute());
 
-  const string path3 = os::getcwd() + "/.log3";
-  initializer.flags.path = path3;
-  ASSERT_SOME(initializer.execute());
-
   Shared<Replica> replica1(new Replica(path1));
   Shared<Replica> replica2(new Replica(path2));
 
-  // Drop messages here in order to obtain the pid of replica2. We
-  // only want to drop learned message sent to replica2.
-  DROP_PROTOBUFS(LearnedMessage(), _, Eq(replica2->pid()));
-
   set<UPID> pids;
   pids.insert(replica1->pid());
   pids.insert(replica2->pid());
 
-  Shared<Network> network1(new Network(pids));
+  Shared<Network> network(new Network(pids));
 
-  Coordinator coord1(2, replica1, network1);
+  Coordinator coord(2, replica1, network, 1, true);
 
   {
-    Future<Option<uint64_t>> electing = coord1.elect();
+    Future<Option<uint64_t>> electing = coord.elect();
     AWAIT_READY(electing);
     EXPECT_SOME_EQ(0u, electing.get());
   }
 
-  for (uint64_t position = 1; position <= 10; position++) {
-    Future<Option<uint64_t>> appending = coord1.append(stringify(position));
-    AWAIT_READY(appending);
-    EXPECT_SOME_EQ(position, appending.get());
+  // Issue the appends without waiting for the previous ones, so that
+  // the ones queued behind the first append get committed in batches.
+  vector<Future<Option<uint64_t>>> appendings;
+  for (uint64_t position = 1; position <= 100; position++) {
+    appendings.push_back(coord.append(stringify(position)));
   }
 
-  Shared<Replica> replica3(new Replica(path3));
-
-  pids.clear();
-  pids.insert(replica2->pid());
-  pids.insert(replica3->pid());
-
-  Shared<Network> network2(new Network(pids));
-
-  Coordinator coord2(2, replica3, network2);
-
-  {
-    // Note that the first election should fail because 'coord2' gets
-    // its proposal number from 'replica3' which has an empty log and
-    // thus a second attempt will need to be made.
-    Future<Option<uint64_t>> electing = coord2.elect();
-    AWAIT_READY(electing);
-    ASSERT_NONE(electing.get());
-
-    electing = coord2.elect();
-    AWAIT_READY(electing);
-    EXPECT_SOME_EQ(10u, electing.get());
+  for (uint64_t position = 1; position <= 100; position++) {
+    AWAIT_READY(appendings[position - 1]);
+    EXPECT_SOME_EQ(position, appendings[position - 1].get());
   }
 
   {
-    Future<list<Action>> actions = replica3->read(1, 10);
+    Future<list<Action>> actions = replica1->read(1, 100);
     AWAIT_READY(actions);
-    EXPECT_EQ(10u, actions->size());
+    EXPECT_EQ(100u, actions->size());
     foreach (const Action& action, actions.get()) {
       ASSERT_TRUE(action.has_type());
       ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_TRUE(action.learned());
       EXPECT_EQ(stringify(action.position()), action.append().bytes());
     }
   }
 }
 
 
-TEST_F(CoordinatorTest, Truncate)
+// This test verifies that concurrent appends are written one position
+// per round unless batches are enabled, so that replicas of older
+// versions, which drop the messages of a batch, can still vote on them.
+TEST_F(CoordinatorTest, ConcurrentAppendsWithoutBatches)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -1309,28 +1504,23 @@ TEST_F(CoordinatorTest, Truncate)
     EXPECT_SOME_EQ(0u, electing.get());
   }
 
-  for (uint64_t position = 1; position <= 10; position++) {
-    Future<Option<uint64_t>> appending = coord.append(stringify(position));
-    AWAIT_READY(appending);
-    EXPECT_SOME_EQ(position, appending.get());
-  }
+  EXPECT_NO_FUTURE_MESSAGES(Eq(BatchWriteRequest().GetTypeName()), _, _);
+  EXPECT_NO_FUTURE_MESSAGES(Eq(BatchLearnedMessage().GetTypeName()), _, _);
 
-  {
-    Future<Option<uint64_t>> truncating = coord.truncate(7);
-    AWAIT_READY(truncating);
-    EXPECT_SOME_EQ(11u, truncating.get());
+  vector<Future<Option<uint64_t>>> appendings;
+  for (uint64_t position = 1; position <= 10; position++) {
+    appendings.push_back(coord.append(stringify(position)));
   }
 
-  {
-    Future<list<Action>> actions = replica1->read(6, 10);
-    AWAIT_FAILED(actions);
-    EXPECT_EQ("Bad read range (truncated position)", actions.failure());
+  for (uint64_t position = 1; position <= 10; position++) {
+    AWAIT_READY(appendings[position - 1]);
+    EXPECT_SOME_EQ(position, appendings[position - 1].get());
   }
 
   {
-    Future<list<Action>> actions = replica1->read(7, 10);
+    Future<list<Action>> actions = replica2->read(1, 10);
     AWAIT_READY(actions);
-    EXPECT_EQ(4u, actions->size());
+    EXPECT_EQ(10u, actions->size());
     foreach (const Action& action, actions.get()) {
       ASSERT_TRUE(action.has_type());
       ASSERT_EQ(Action::APPEND, action.type());
@@ -1340,7 +1530,10 @@ TEST_F(CoordinatorTest, Truncate)
 }
 
 
-TEST_F(CoordinatorTest, TruncateNotLearnedFill)
+// This test verifies that discarding one of the appends that are
+// written in the same batch neither aborts the other appends of the
+// batch nor demotes the coordinator.
+TEST_F(CoordinatorTest, ConcurrentAppendsOneDiscarded)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -1350,86 +1543,140 @@ TEST_F(CoordinatorTest, TruncateNotLearnedFill)
   initializer.flags.path = path2;
   ASSERT_SOME(initializer.execute());
 
-  const string path3 = os::getcwd() + "/.log3";
-  initializer.flags.path = path3;
-  ASSERT_SOME(initializer.execute());
-
   Shared<Replica> replica1(new Replica(path1));
   Shared<Replica> replica2(new Replica(path2));
 
-  // Drop messages here in order to obtain the pid of replica2. We
-  // only want to drop learned message sent to replica2.
-  DROP_PROTOBUFS(LearnedMessage(), _, Eq(replica2->pid()));
-
   set<UPID> pids;
   pids.insert(replica1->pid());
   pids.insert(replica2->pid());
 
-  Shared<Network> network1(new Network(pids));
+  Shared<Network> network(new Network(pids));
 
-  Coordinator coord1(2, replica1, network1);
+  Coordinator coord(2, replica1, network, 1, true);
 
   {
-    Future<Option<uint64_t>> electing = coord1.elect();
+    Future<Option<uint64_t>> electing = coord.elect();
     AWAIT_READY(electing);
     EXPECT_SOME_EQ(0u, electing.get());
   }
 
-  for (uint64_t position = 1; position <= 10; position++) {
-    Future<Option<uint64_t>> appending = coord1.append(stringify(position));
+  // Hold back the first write request to the second replica, so that
+  // the appends after the first one are written in a single batch.
+  Future<Message> writeRequest1 =
+    DROP_MESSAGE(Eq(WriteRequest().GetTypeName()), _, replica2->pid());
+
+  Future<Option<uint64_t>> appending1 = coord.append("hello world");
+  Future<Option<uint64_t>> appending2 = coord.append("hello moto");
+  Future<Option<uint64_t>> appending3 = coord.append("hello mesos");
+
+  AWAIT_READY(writeRequest1);
+
+  // Hold back the write request of the batch as well, so that the
+  // batch is being written when the second append is discarded.
+  Future<Message> writeRequest2 =
+    DROP_MESSAGE(Eq(BatchWriteRequest().GetTypeName()), _, replica2->pid());
+
+  WriteRequest request1;
+  ASSERT_TRUE(request1.ParseFromString(writeRequest1->body));
+  process::post(writeRequest1->from, replica2->pid(), request1);
+
+  AWAIT_READY(appending1);
+  EXPECT_SOME_EQ(1u, appending1.get());
+
+  AWAIT_READY(writeRequest2);
+
+  BatchWriteRequest request2;
+  ASSERT_TRUE(request2.ParseFromString(writeRequest2->body));
+  ASSERT_EQ(2, request2.requests_size());
+
+  appending2.discard();
+  AWAIT_DISCARDED(appending2);
+
+  EXPECT_TRUE(appending3.isPending());
+
+  process::post(writeRequest2->from, replica2->pid(), request2);
+
+  AWAIT_READY(appending3);
+  EXPECT_SOME_EQ(3u, appending3.get());
+
+  // The coordinator is still elected, and the discarded append has
+  // been written nonetheless.
+  {
+    Future<Option<uint64_t>> appending = coord.append("hello");
     AWAIT_READY(appending);
-    EXPECT_SOME_EQ(position, appending.get());
+    EXPECT_SOME_EQ(4u, appending.get());
   }
 
   {
-    Future<Option<uint64_t>> truncating = coord1.truncate(7);
-    AWAIT_READY(truncating);
-    EXPECT_SOME_EQ(11u, truncating.get());
+    Future<list<Action>> actions = replica1->read(2, 2);
+    AWAIT_READY(actions);
+    ASSERT_EQ(1u, actions->size());
+    ASSERT_TRUE(actions->front().has_type());
+    ASSERT_EQ(Action::APPEND, actions->front().type());
+    EXPECT_TRUE(actions->front().learned());
+    EXPECT_EQ("hello moto", actions->front().append().bytes());
   }
+}
 
-  Shared<Replica> replica3(new Replica(path3));
 
-  pids.clear();
+TEST_F(CoordinatorTest, PipelinedAppends)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
   pids.insert(replica2->pid());
-  pids.insert(replica3->pid());
 
-  Shared<Network> network2(new Network(pids));
+  Shared<Network> network(new Network(pids));
 
-  Coordinator coord2(2, replica3, network2);
+  Coordinator coord(2, replica1, network, 4, true);
 
   {
-    // Note that the first election should fail because 'coord2' gets
-    // its proposal number from 'replica3' which has an empty log and
-    // thus a second attempt will need to be made.
-    Future<Option<uint64_t>> electing = coord2.elect();
+    Future<Option<uint64_t>> electing = coord.elect();
     AWAIT_READY(electing);
-    ASSERT_NONE(electing.get());
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
 
-    electing = coord2.elect();
-    AWAIT_READY(electing);
-    EXPECT_SOME_EQ(11u, electing.get());
+  // The first appends are written in separate rounds that are in
+  // progress at the same time, the rest of them in batches.
+  vector<Future<Option<uint64_t>>> appendings;
+  for (uint64_t position = 1; position <= 100; position++) {
+    appendings.push_back(coord.append(stringify(position)));
   }
 
-  {
-    Future<list<Action>> actions = replica3->read(6, 10);
-    AWAIT_FAILED(actions);
-    EXPECT_EQ("Bad read range (truncated position)", actions.failure());
+  for (uint64_t position = 1; position <= 100; position++) {
+    AWAIT_READY(appendings[position - 1]);
+    EXPECT_SOME_EQ(position, appendings[position - 1].get());
   }
 
   {
-    Future<list<Action>> actions = replica3->read(7, 10);
+    Future<list<Action>> actions = replica1->read(1, 100);
     AWAIT_READY(actions);
-    EXPECT_EQ(4u, actions->size());
+    EXPECT_EQ(100u, actions->size());
     foreach (const Action& action, actions.get()) {
       ASSERT_TRUE(action.has_type());
       ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_TRUE(action.learned());
       EXPECT_EQ(stringify(action.position()), action.append().bytes());
     }
   }
 }
 
 
-TEST_F(CoordinatorTest, TruncateLearnedFill)
+// This test verifies that the write requests of the batches that are
+// in progress at the same time reach each replica in the order of
+// their positions, even if they are held back until there is a
+// quorum of replicas in the network.
+TEST_F(CoordinatorTest, PipelinedAppendsInOrder)
 {
   const string path1 = os::getcwd() + "/.log1";
   initializer.flags.path = path1;
@@ -1439,10 +1686,6 @@ TEST_F(CoordinatorTest, TruncateLearnedFill)
   initializer.flags.path = path2;
   ASSERT_SOME(initializer.execute());
 
-  const string path3 = os::getcwd() + "/.log3";
-  initializer.flags.path = path3;
-  ASSERT_SOME(initializer.execute());
-
   Shared<Replica> replica1(new Replica(path1));
   Shared<Replica> replica2(new Replica(path2));
 
@@ -1450,45 +1693,398 @@ TEST_F(CoordinatorTest, TruncateLearnedFill)
   pids.insert(replica1->pid());
   pids.insert(replica2->pid());
 
-  Shared<Network> network1(new Network(pids));
+  Shared<Network> network(new Network(pids));
 
-  Coordinator coord1(2, replica1, network1);
+  Coordinator coord(2, replica1, network, 4);
 
   {
-    Future<Option<uint64_t>> electing = coord1.elect();
+    Future<Option<uint64_t>> electing = coord.elect();
     AWAIT_READY(electing);
     EXPECT_SOME_EQ(0u, electing.get());
   }
 
-  for (uint64_t position = 1; position <= 10; position++) {
-    Future<Option<uint64_t>> appending = coord1.append(stringify(position));
-    AWAIT_READY(appending);
-    EXPECT_SOME_EQ(position, appending.get());
-  }
+  // Hold back the batches by leaving the network without a quorum.
+  network->remove(replica2->pid());
 
-  {
-    Future<Option<uint64_t>> truncating = coord1.truncate(7);
-    AWAIT_READY(truncating);
-    EXPECT_SOME_EQ(11u, truncating.get());
+  vector<Future<Option<uint64_t>>> appendings;
+  for (uint64_t position = 1; position <= 4; position++) {
+    appendings.push_back(coord.append(stringify(position)));
   }
 
-  Shared<Replica> replica3(new Replica(path3));
+  // NOTE: The expectations are matched in the reverse order in which
+  // they are set up, thus the last one catches the first request.
+  vector<Future<WriteRequest>> requests(4);
+  for (size_t i = requests.size(); i > 0; i--) {
+    requests[i - 1] =
+      FUTURE_PROTOBUF(WriteRequest(), _, Eq(replica2->pid()));
+  }
 
-  pids.clear();
-  pids.insert(replica2->pid());
-  pids.insert(replica3->pid());
+  network->add(replica2->pid());
 
-  Shared<Network> network2(new Network(pids));
+  for (uint64_t position = 1; position <= 4; position++) {
+    AWAIT_READY(requests[position - 1]);
+    EXPECT_EQ(position, requests[position - 1]->position());
+  }
 
-  Coordinator coord2(2, replica3, network2);
+  for (uint64_t position = 1; position <= 4; position++) {
+    AWAIT_READY(appendings[position - 1]);
+    EXPECT_SOME_EQ(position, appendings[position - 1].get());
+  }
 
   {
-    // Note that the first election should fail because 'coord2' gets
-    // its proposal number from 'replica3' which has an empty log and
-    // thus a second attempt will need to be made.
-    Future<Option<uint64_t>> electing = coord2.elect();
-    AWAIT_READY(electing);
-    ASSERT_NONE(electing.get());
+    Future<list<Action>> actions = replica2->read(1, 4);
+    AWAIT_READY(actions);
+    EXPECT_EQ(4u, actions->size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
+  }
+}
+
+
+TEST_F(CoordinatorTest, PipelinedAppendsDemoted)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord1(2, replica1, network1, 4);
+
+  {
+    Future<Option<uint64_t>> electing = coord1.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  Shared<Network> network2(new Network(pids));
+
+  Coordinator coord2(2, replica2, network2);
+
+  {
+    Future<Option<uint64_t>> electing = coord2.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  // All the appends that are in progress or queued when the first
+  // of them is rejected are completed with none.
+  vector<Future<Option<uint64_t>>> appendings;
+  for (int i = 0; i < 10; i++) {
+    appendings.push_back(coord1.append("hello moto"));
+  }
+
+  foreach (const Future<Option<uint64_t>>& appending, appendings) {
+    AWAIT_READY(appending);
+    EXPECT_NONE(appending.get());
+  }
+
+  {
+    Future<Option<uint64_t>> appending = coord2.append("hello hello");
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(1u, appending.get());
+  }
+}
+
+
+TEST_F(CoordinatorTest, MultipleAppendsNotLearnedFill)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  const string path3 = os::getcwd() + "/.log3";
+  initializer.flags.path = path3;
+  ASSERT_SOME(initializer.execute());
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  // Drop messages here in order to obtain the pid of replica2. We
+  // only want to drop learned message sent to replica2.
+  DROP_PROTOBUFS(LearnedMessage(), _, Eq(replica2->pid()));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord1(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t>> electing = coord1.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    Future<Option<uint64_t>> appending = coord1.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+  }
+
+  Shared<Replica> replica3(new Replica(path3));
+
+  pids.clear();
+  pids.insert(replica2->pid());
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  Coordinator coord2(2, replica3, network2);
+
+  {
+    // Note that the first election should fail because 'coord2' gets
+    // its proposal number from 'replica3' which has an empty log and
+    // thus a second attempt will need to be made.
+    Future<Option<uint64_t>> electing = coord2.elect();
+    AWAIT_READY(electing);
+    ASSERT_NONE(electing.get());
+
+    electing = coord2.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(10u, electing.get());
+  }
+
+  {
+    Future<list<Action>> actions = replica3->read(1, 10);
+    AWAIT_READY(actions);
+    EXPECT_EQ(10u, actions->size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
+  }
+}
+
+
+TEST_F(CoordinatorTest, Truncate)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replica1, network);
+
+  {
+    Future<Option<uint64_t>> electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    Future<Option<uint64_t>> appending = coord.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+  }
+
+  {
+    Future<Option<uint64_t>> truncating = coord.truncate(7);
+    AWAIT_READY(truncating);
+    EXPECT_SOME_EQ(11u, truncating.get());
+  }
+
+  {
+    Future<list<Action>> actions = replica1->read(6, 10);
+    AWAIT_FAILED(actions);
+    EXPECT_EQ("Bad read range (truncated position)", actions.failure());
+  }
+
+  {
+    Future<list<Action>> actions = replica1->read(7, 10);
+    AWAIT_READY(actions);
+    EXPECT_EQ(4u, actions->size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
+  }
+}
+
+
+TEST_F(CoordinatorTest, TruncateNotLearnedFill)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  const string path3 = os::getcwd() + "/.log3";
+  initializer.flags.path = path3;
+  ASSERT_SOME(initializer.execute());
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  // Drop messages here in order to obtain the pid of replica2. We
+  // only want to drop learned message sent to replica2.
+  DROP_PROTOBUFS(LearnedMessage(), _, Eq(replica2->pid()));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord1(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t>> electing = coord1.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    Future<Option<uint64_t>> appending = coord1.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+  }
+
+  {
+    Future<Option<uint64_t>> truncating = coord1.truncate(7);
+    AWAIT_READY(truncating);
+    EXPECT_SOME_EQ(11u, truncating.get());
+  }
+
+  Shared<Replica> replica3(new Replica(path3));
+
+  pids.clear();
+  pids.insert(replica2->pid());
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  Coordinator coord2(2, replica3, network2);
+
+  {
+    // Note that the first election should fail because 'coord2' gets
+    // its proposal number from 'replica3' which has an empty log and
+    // thus a second attempt will need to be made.
+    Future<Option<uint64_t>> electing = coord2.elect();
+    AWAIT_READY(electing);
+    ASSERT_NONE(electing.get());
+
+    electing = coord2.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(11u, electing.get());
+  }
+
+  {
+    Future<list<Action>> actions = replica3->read(6, 10);
+    AWAIT_FAILED(actions);
+    EXPECT_EQ("Bad read range (truncated position)", actions.failure());
+  }
+
+  {
+    Future<list<Action>> actions = replica3->read(7, 10);
+    AWAIT_READY(actions);
+    EXPECT_EQ(4u, actions->size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
+  }
+}
+
+
+TEST_F(CoordinatorTest, TruncateLearnedFill)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  const string path3 = os::getcwd() + "/.log3";
+  initializer.flags.path = path3;
+  ASSERT_SOME(initializer.execute());
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord1(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t>> electing = coord1.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    Future<Option<uint64_t>> appending = coord1.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+  }
+
+  {
+    Future<Option<uint64_t>> truncating = coord1.truncate(7);
+    AWAIT_READY(truncating);
+    EXPECT_SOME_EQ(11u, truncating.get());
+  }
+
+  Shared<Replica> replica3(new Replica(path3));
+
+  pids.clear();
+  pids.insert(replica2->pid());
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  Coordinator coord2(2, replica3, network2);
+
+  {
+    // Note that the first election should fail because 'coord2' gets
+    // its proposal number from 'replica3' which has an empty log and
+    // thus a second attempt will need to be made.
+    Future<Option<uint64_t>> electing = coord2.elect();
+    AWAIT_READY(electing);
+    ASSERT_NONE(electing.get());
 
     electing = coord2.elect();
     AWAIT_READY(electing);
@@ -1844,6 +2440,161 @@ TEST_F(RecoverTest, CatchupRetry)
 }
 
 
+// Tests that a lagging replica catches up the learned positions by
+// fetching them from the other replicas, without running Paxos for
+// each missing position.
+TEST_F(RecoverTest, CatchupFetch)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  const string path3 = os::getcwd() + "/.log3";
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t>> electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  IntervalSet<uint64_t> positions;
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    Future<Option<uint64_t>> appending = coord.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+    positions += position;
+  }
+
+  Shared<Replica> replica3(new Replica(path3));
+
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  Future<FetchResponse> fetchResponse =
+    FUTURE_PROTOBUF(FetchResponse(), _, Eq(replica3->pid()));
+
+  // The learned positions do not need a quorum of promises.
+  EXPECT_NO_FUTURE_PROTOBUFS(PromiseRequest(), _, _);
+
+  Future<Nothing> catching =
+    catchup(2, replica3, network2, None(), positions, Seconds(10));
+
+  AWAIT_READY(fetchResponse);
+  AWAIT_READY(catching);
+
+  Future<list<Action>> actions = replica3->read(1, 10);
+  AWAIT_READY(actions);
+  ASSERT_EQ(10u, actions.get().size());
+
+  uint64_t position = 1;
+  foreach (const Action& action, actions.get()) {
+    EXPECT_EQ(position, action.position());
+    EXPECT_TRUE(action.learned());
+    ASSERT_TRUE(action.has_append());
+    EXPECT_EQ(stringify(position), action.append().bytes());
+    position++;
+  }
+}
+
+
+// Tests that the positions that a replica replying to a fetch request
+// has not learned are fetched from the other replicas rather than
+// filled, when the replicas have learned different positions.
+TEST_F(RecoverTest, CatchupFetchFromRemainingReplicas)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  const string path3 = os::getcwd() + "/.log3";
+  const string path4 = os::getcwd() + "/.log4";
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t>> electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  IntervalSet<uint64_t> positions;
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    Future<Option<uint64_t>> appending = coord.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+    positions += position;
+  }
+
+  // The lagging replica only learns the first half of the positions.
+  Shared<Replica> replica3(new Replica(path3));
+
+  IntervalSet<uint64_t> half;
+  half += (Bound<uint64_t>::closed(1), Bound<uint64_t>::closed(5));
+
+  AWAIT_READY(catchup(2, replica3, network1, None(), half, Seconds(10)));
+
+  Shared<Replica> replica4(new Replica(path4));
+
+  pids.insert(replica3->pid());
+  pids.insert(replica4->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  // The positions that the lagging replica has not learned do not
+  // need a quorum of promises either, whichever replica replies first.
+  EXPECT_NO_FUTURE_PROTOBUFS(PromiseRequest(), _, _);
+
+  Future<Nothing> catching =
+    catchup(2, replica4, network2, None(), positions, Seconds(10));
+
+  AWAIT_READY(catching);
+
+  Future<list<Action>> actions = replica4->read(1, 10);
+  AWAIT_READY(actions);
+  ASSERT_EQ(10u, actions.get().size());
+
+  uint64_t position = 1;
+  foreach (const Action& action, actions.get()) {
+    EXPECT_EQ(position, action.position());
+    EXPECT_TRUE(action.learned());
+    ASSERT_TRUE(action.has_append());
+    EXPECT_EQ(stringify(position), action.append().bytes());
+    position++;
+  }
+}
+
+
 TEST_F(RecoverTest, AutoInitialization)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -2105,6 +2856,111 @@ TEST_F(LogTest, Metrics)
 
   ASSERT_EQ(1u, snapshot.values.count("prefix/log/ensemble_size"));
   EXPECT_EQ(1, snapshot.values["prefix/log/ensemble_size"]);
+
+  ASSERT_EQ(1u, snapshot.values.count("prefix/log/pipeline_depth"));
+  EXPECT_EQ(0, snapshot.values["prefix/log/pipeline_depth"]);
+
+  // The metrics of the writes are owned by the log, thus they outlive
+  // the coordinator of a writer, which is replaced when the writer is
+  // restarted, and the other writers of the log.
+  {
+    Log::Writer other(&log);
+  }
+
+  start = writer.start();
+
+  AWAIT_READY(start);
+  ASSERT_SOME(start.get());
+
+  Future<Option<Log::Position>> position = writer.append("hello world");
+
+  AWAIT_READY(position);
+  ASSERT_SOME(position.get());
+
+  snapshot = Metrics();
+
+  ASSERT_EQ(1u, snapshot.values.count("prefix/log/pipeline_depth"));
+  EXPECT_EQ(0, snapshot.values["prefix/log/pipeline_depth"]);
+
+  EXPECT_EQ(1u, snapshot.values.count("prefix/log/commit_latency_ms"));
+}
+
+
+// Measures the throughput of the appends to a replicated log of three
+// replicas when the given number of appends are outstanding at a time.
+class LogAppend_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public ::testing::WithParamInterface<size_t>
+{
+protected:
+  // Used to change the status of a replicated log from `EMPTY` to `VOTING`.
+  tool::Initialize initializer;
+};
+
+
+INSTANTIATE_TEST_CASE_P(
+    Concurrency,
+    LogAppend_BENCHMARK_Test,
+    ::testing::Values(1U, 8U, 64U));
+
+
+TEST_P(LogAppend_BENCHMARK_Test, Appends)
+{
+  const size_t concurrency = GetParam();
+  const size_t appends = 1024;
+
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  const string path3 = os::getcwd() + "/.log3";
+  initializer.flags.path = path3;
+  ASSERT_SOME(initializer.execute());
+
+  Replica replica1(path1);
+  Replica replica2(path2);
+
+  set<UPID> pids;
+  pids.insert(replica1.pid());
+  pids.insert(replica2.pid());
+
+  Log log(2, path3, pids);
+
+  Log::Writer writer(&log, 1, true);
+
+  Future<Option<Log::Position>> start = writer.start();
+  AWAIT_READY(start);
+  ASSERT_SOME(start.get());
+
+  const string data(1024, 'x');
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t appended = 0; appended < appends; appended += concurrency) {
+    list<Future<Option<Log::Position>>> appendings;
+    for (size_t i = 0; i < concurrency; i++) {
+      appendings.push_back(writer.append(data));
+    }
+
+    Future<list<Option<Log::Position>>> positions = collect(appendings);
+    AWAIT_READY(positions);
+
+    foreach (const Option<Log::Position>& position, positions.get()) {
+      ASSERT_SOME(position);
+    }
+  }
+
+  watch.stop();
+
+  cout << "Appended " << appends << " entries with " << concurrency
+       << " outstanding at a time in " << watch.elapsed() << " ("
+       << appends / watch.elapsed().secs() << " appends per second)"
+       << endl;
 }
 
 
@@ -30,6 +30,7 @@
 #include <mesos/scheduler/scheduler.hpp>
 
 #include <process/clock.hpp>
+#include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/owned.hpp>
@@ -39,6 +40,8 @@
 #include <stout/some.hpp>
 #include <stout/strings.hpp>
 
+#include "common/protobuf_utils.hpp"
+
 #include "master/constants.hpp"
 #include "master/master.hpp"
 
@@ -66,9 +69,11 @@ using mesos::master::detector::StandaloneMasterDetector;
 
 using process::Clock;
 using process::Future;
+using process::Message;
 using process::Owned;
 using process::PID;
 using process::Queue;
+using process::UPID;
 
 using process::http::OK;
 using process::http::Response;
@@ -82,6 +87,8 @@ using testing::AtMost;
 using testing::DoAll;
 using testing::DoDefault;
 using testing::Eq;
+using testing::InSequence;
+using testing::Return;
 using testing::SaveArg;
 
 namespace mesos {
@@ -164,7 +171,7 @@ TYPED_TEST(MasterAllocatorTest, SingleFramework)
 {
   TestAllocator<TypeParam> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _));
 
   Try<Owned<cluster::Master>> master = this->StartMaster(&allocator);
   ASSERT_SOME(master);
@@ -212,7 +219,7 @@ TYPED_TEST(MasterAllocatorTest, ResourcesUnused)
 
   TestAllocator<TypeParam> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _));
 
   Try<Owned<cluster::Master>> master = this->StartMaster(&allocator);
   ASSERT_SOME(master);
@@ -321,7 +328,7 @@ TYPED_TEST(MasterAllocatorTest, OutOfOrderDispatch)
 {
   TestAllocator<TypeParam> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _));
 
   Try<Owned<cluster::Master>> master = this->StartMaster(&allocator);
   ASSERT_SOME(master);
@@ -450,7 +457,7 @@ TYPED_TEST(MasterAllocatorTest, SchedulerFailover)
 {
   TestAllocator<TypeParam> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _));
 
   Try<Owned<cluster::Master>> master = this->StartMaster(&allocator);
   ASSERT_SOME(master);
@@ -576,7 +583,7 @@ TYPED_TEST(MasterAllocatorTest, FrameworkExited)
 
   TestAllocator<TypeParam> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _));
 
   master::Flags masterFlags = this->CreateMasterFlags();
   masterFlags.allocation_interval = Milliseconds(50);
@@ -736,7 +743,7 @@ TYPED_TEST(MasterAllocatorTest, SlaveLost)
 {
   TestAllocator<TypeParam> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _));
 
   Try<Owned<cluster::Master>> master = this->StartMaster(&allocator);
   ASSERT_SOME(master);
@@ -860,7 +867,7 @@ TYPED_TEST(MasterAllocatorTest, SlaveAdded)
 {
   TestAllocator<TypeParam> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _));
 
   master::Flags masterFlags = this->CreateMasterFlags();
   masterFlags.allocation_interval = Milliseconds(50);
@@ -956,7 +963,7 @@ TYPED_TEST(MasterAllocatorTest, TaskFinished)
 {
   TestAllocator<TypeParam> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _));
 
   master::Flags masterFlags = this->CreateMasterFlags();
   masterFlags.allocation_interval = Milliseconds(50);
@@ -1054,13 +1061,273 @@ TYPED_TEST(MasterAllocatorTest, TaskFinished)
 }
 
 
+// Checks that the master recovers the resources of the tasks that
+// become terminal in a burst of status updates with a single call to
+// the allocator, and that it does so before it removes the framework
+// from the allocator.
+TYPED_TEST(MasterAllocatorTest, TerminalTasksRecoveredTogether)
+{
+  TestAllocator<TypeParam> allocator;
+
+  EXPECT_CALL(allocator, initialize(_, _, _));
+
+  Try<Owned<cluster::Master>> master = this->StartMaster(&allocator);
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  slave::Flags flags = this->CreateSlaveFlags();
+  flags.resources = Some("cpus:3;mem:1024");
+
+  EXPECT_CALL(allocator, addSlave(_, _, _, _, _, _));
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+
+  Try<Owned<cluster::Slave>> slave =
+    this->StartSlave(detector.get(), &containerizer, flags);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(allocator, addFramework(_, _, _, _, _));
+
+  Future<Message> registerFrameworkMessage =
+    FUTURE_MESSAGE(Eq(RegisterFrameworkMessage().GetTypeName()), _, _);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(_, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  EXPECT_CALL(sched, resourceOffers(_, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 3, 1, 256, "*"))
+    .WillRepeatedly(DeclineOffers());
+
+  // The resources of the offer that are not used, and of the
+  // declined offers.
+  EXPECT_CALL(allocator, recoverResources(_, _, _, _))
+    .WillRepeatedly(DoDefault());
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  Future<TaskStatus> status3;
+  EXPECT_CALL(sched, statusUpdate(_, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2))
+    .WillOnce(FutureArg<1>(&status3))
+    .WillRepeatedly(Return());
+
+  driver.start();
+
+  AWAIT_READY(registerFrameworkMessage);
+  AWAIT_READY(frameworkId);
+
+  AWAIT_READY(status1);
+  EXPECT_EQ(TASK_RUNNING, status1->state());
+
+  AWAIT_READY(status2);
+  EXPECT_EQ(TASK_RUNNING, status2->state());
+
+  AWAIT_READY(status3);
+  EXPECT_EQ(TASK_RUNNING, status3->state());
+
+  const Resources resources = allocatedResources(
+      Resources::parse("cpus:3;mem:768").get(),
+      DEFAULT_FRAMEWORK_INFO.role());
+
+  Future<Nothing> removeFramework;
+
+  {
+    InSequence sequence;
+
+    EXPECT_CALL(allocator, recoverResources(_, _, resources, _))
+      .WillOnce(DoDefault());
+
+    EXPECT_CALL(allocator, removeFramework(_))
+      .WillOnce(DoAll(InvokeRemoveFramework(&allocator),
+                      FutureSatisfy(&removeFramework)));
+  }
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  // Enqueue the terminal status updates and the unregistration of the
+  // framework from within the master, so that the master processes
+  // all of them before the resources of the tasks are recovered.
+  const PID<Master> masterPid = master.get()->pid;
+  const UPID slavePid = slave.get()->pid;
+  const UPID schedulerPid = registerFrameworkMessage->from;
+  const vector<TaskStatus> statuses =
+    {status1.get(), status2.get(), status3.get()};
+
+  process::dispatch(masterPid, [=]() {
+    foreach (const TaskStatus& status, statuses) {
+      const StatusUpdate update = protobuf::createStatusUpdate(
+          frameworkId.get(),
+          status.slave_id(),
+          status.task_id(),
+          TASK_FINISHED,
+          TaskStatus::SOURCE_EXECUTOR,
+          UUID::random());
+
+      process::dispatch(masterPid, &Master::statusUpdate, update, slavePid);
+    }
+
+    process::dispatch(
+        masterPid,
+        &Master::unregisterFramework,
+        schedulerPid,
+        frameworkId.get());
+  });
+
+  AWAIT_READY(removeFramework);
+
+  driver.stop();
+  driver.join();
+}
+
+
+// Checks that the master recovers the resources of the tasks that
+// become terminal in a burst of status updates before it removes the
+// agent of the tasks from the allocator.
+TYPED_TEST(MasterAllocatorTest, TerminalTasksRecoveredBeforeSlaveRemoved)
+{
+  TestAllocator<TypeParam> allocator;
+
+  EXPECT_CALL(allocator, initialize(_, _, _));
+
+  Try<Owned<cluster::Master>> master = this->StartMaster(&allocator);
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  slave::Flags flags = this->CreateSlaveFlags();
+  flags.resources = Some("cpus:3;mem:1024");
+
+  EXPECT_CALL(allocator, addSlave(_, _, _, _, _, _));
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+
+  Try<Owned<cluster::Slave>> slave =
+    this->StartSlave(detector.get(), &containerizer, flags);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(allocator, addFramework(_, _, _, _, _));
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(_, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  EXPECT_CALL(sched, resourceOffers(_, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 3, 1, 256, "*"))
+    .WillRepeatedly(DeclineOffers());
+
+  // The resources of the offer that are not used, and of the
+  // declined offers.
+  EXPECT_CALL(allocator, recoverResources(_, _, _, _))
+    .WillRepeatedly(DoDefault());
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  Future<TaskStatus> status3;
+  EXPECT_CALL(sched, statusUpdate(_, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2))
+    .WillOnce(FutureArg<1>(&status3))
+    .WillRepeatedly(Return());
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+
+  AWAIT_READY(status1);
+  EXPECT_EQ(TASK_RUNNING, status1->state());
+
+  AWAIT_READY(status2);
+  EXPECT_EQ(TASK_RUNNING, status2->state());
+
+  AWAIT_READY(status3);
+  EXPECT_EQ(TASK_RUNNING, status3->state());
+
+  const Resources resources = allocatedResources(
+      Resources::parse("cpus:3;mem:768").get(),
+      DEFAULT_FRAMEWORK_INFO.role());
+
+  Future<Nothing> removeSlave;
+
+  {
+    InSequence sequence;
+
+    EXPECT_CALL(allocator, recoverResources(_, _, resources, _))
+      .WillOnce(DoDefault());
+
+    EXPECT_CALL(allocator, removeSlave(_))
+      .WillOnce(DoAll(InvokeRemoveSlave(&allocator),
+                      FutureSatisfy(&removeSlave)));
+  }
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  // Enqueue the terminal status updates and the unregistration of the
+  // agent from within the master, so that the master processes all of
+  // them before the resources of the tasks are recovered.
+  const PID<Master> masterPid = master.get()->pid;
+  const UPID slavePid = slave.get()->pid;
+  const vector<TaskStatus> statuses =
+    {status1.get(), status2.get(), status3.get()};
+
+  process::dispatch(masterPid, [=]() {
+    foreach (const TaskStatus& status, statuses) {
+      const StatusUpdate update = protobuf::createStatusUpdate(
+          frameworkId.get(),
+          status.slave_id(),
+          status.task_id(),
+          TASK_FINISHED,
+          TaskStatus::SOURCE_EXECUTOR,
+          UUID::random());
+
+      process::dispatch(masterPid, &Master::statusUpdate, update, slavePid);
+    }
+
+    process::dispatch(
+        masterPid,
+        &Master::unregisterSlave,
+        slavePid,
+        statuses.front().slave_id());
+  });
+
+  AWAIT_READY(removeSlave);
+
+  driver.stop();
+  driver.join();
+}
+
+
 // Checks that cpus only resources are offered
 // and tasks using only cpus are launched.
 TYPED_TEST(MasterAllocatorTest, CpusOnlyOfferedAndTaskLaunched)
 {
   TestAllocator<TypeParam> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _));
 
   master::Flags masterFlags = this->CreateMasterFlags();
   masterFlags.allocation_interval = Milliseconds(50);
@@ -1141,7 +1408,7 @@ TYPED_TEST(MasterAllocatorTest, MemoryOnlyOfferedAndTaskLaunched)
 {
   TestAllocator<TypeParam> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _));
 
   master::Flags masterFlags = this->CreateMasterFlags();
   masterFlags.allocation_interval = Milliseconds(50);
@@ -1235,7 +1502,7 @@ TYPED_TEST(MasterAllocatorTest, Whitelist)
 
   TestAllocator<TypeParam> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _));
 
   Future<Nothing> updateWhitelist1;
   EXPECT_CALL(allocator, updateWhitelist(Option<hashset<string>>(hosts)))
@@ -1274,7 +1541,7 @@ TYPED_TEST(MasterAllocatorTest, RoleTest)
 {
   TestAllocator<TypeParam> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _));
 
   master::Flags masterFlags = this->CreateMasterFlags();
   masterFlags.roles = Some("role2");
@@ -1367,7 +1634,7 @@ TYPED_TEST(MasterAllocatorTest, FrameworkReregistersFirst)
   {
     TestAllocator<TypeParam> allocator;
 
-    EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+    EXPECT_CALL(allocator, initialize(_, _, _));
 
     Try<Owned<cluster::Master>> master = this->StartMaster(&allocator);
     ASSERT_SOME(master);
@@ -1424,7 +1691,7 @@ TYPED_TEST(MasterAllocatorTest, FrameworkReregistersFirst)
   {
     TestAllocator<TypeParam> allocator2;
 
-    EXPECT_CALL(allocator2, initialize(_, _, _, _, _, _));
+    EXPECT_CALL(allocator2, initialize(_, _, _));
 
     Future<Nothing> addFramework;
     EXPECT_CALL(allocator2, addFramework(_, _, _, _, _))
@@ -1491,7 +1758,7 @@ TYPED_TEST(MasterAllocatorTest, SlaveReregistersFirst)
   {
     TestAllocator<TypeParam> allocator;
 
-    EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+    EXPECT_CALL(allocator, initialize(_, _, _));
 
     Try<Owned<cluster::Master>> master = this->StartMaster(&allocator);
     ASSERT_SOME(master);
@@ -1547,7 +1814,7 @@ TYPED_TEST(MasterAllocatorTest, SlaveReregistersFirst)
   {
     TestAllocator<TypeParam> allocator2;
 
-    EXPECT_CALL(allocator2, initialize(_, _, _, _, _, _));
+    EXPECT_CALL(allocator2, initialize(_, _, _));
 
     Future<Nothing> addSlave;
     EXPECT_CALL(allocator2, addSlave(_, _, _, _, _, _))
@@ -1614,7 +1881,7 @@ TYPED_TEST(MasterAllocatorTest, RebalancedForUpdatedWeights)
 
   TestAllocator<TypeParam> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _));
 
   // Start Mesos master.
   master::Flags masterFlags = this->CreateMasterFlags();
@@ -1807,7 +2074,7 @@ TYPED_TEST(MasterAllocatorTest, NestedRoles)
 
   TestAllocator<TypeParam> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _));
 
   master::Flags masterFlags = this->CreateMasterFlags();
   Try<Owned<cluster::Master>> master =
@@ -16,7 +16,9 @@
 
 #include <unistd.h>
 
+#include <iostream>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -39,16 +41,19 @@
 #include <process/metrics/counter.hpp>
 #include <process/metrics/metrics.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/json.hpp>
 #include <stout/net.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 
 #include "common/build.hpp"
 #include "common/protobuf_utils.hpp"
 
+#include "master/compact_task.hpp"
 #include "master/flags.hpp"
 #include "master/master.hpp"
 
@@ -76,6 +81,7 @@
 
 using google::protobuf::RepeatedPtrField;
 
+using mesos::internal::master::CompactTask;
 using mesos::internal::master::Master;
 
 using mesos::internal::master::allocator::MesosAllocatorProcess;
@@ -108,6 +114,9 @@ using process::http::OK;
 using process::http::Response;
 using process::http::Unauthorized;
 
+using std::cout;
+using std::endl;
+using std::set;
 using std::shared_ptr;
 using std::string;
 using std::vector;
@@ -116,6 +125,7 @@ using testing::_;
 using testing::AtMost;
 using testing::DoAll;
 using testing::Eq;
+using testing::ExitedWithCode;
 using testing::Not;
 using testing::Return;
 using testing::SaveArg;
@@ -1281,6 +1291,29 @@ TEST_F(MasterTest, MasterInfo)
 }
 
 
+// The `attribute_weighted` offer packing policy can not order agents
+// without attribute weights, so the master must refuse to start with
+// it rather than crash once the allocator is initialized.
+TEST_F(MasterTest, OfferPackingPolicyRequiresAttributeWeights)
+{
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.offer_packing_policy = "attribute_weighted";
+
+  EXPECT_EXIT(
+      StartMaster(masterFlags),
+      ExitedWithCode(EXIT_FAILURE),
+      "--offer_packing_attribute_weights");
+
+  // Weights that do not contain a single weight are not enough.
+  masterFlags.offer_packing_attribute_weights = ",";
+
+  EXPECT_EXIT(
+      StartMaster(masterFlags),
+      ExitedWithCode(EXIT_FAILURE),
+      "--offer_packing_attribute_weights");
+}
+
+
 TEST_F(MasterTest, MasterInfoOnReElection)
 {
   master::Flags masterFlags = CreateMasterFlags();
@@ -2233,6 +2266,7 @@ TEST_F(MasterTest, MetricsInMetricsEndpoint)
   EXPECT_EQ(1u, snapshot.values.count("master/slaves_active"));
   EXPECT_EQ(1u, snapshot.values.count("master/slaves_inactive"));
   EXPECT_EQ(1u, snapshot.values.count("master/slaves_unreachable"));
+  EXPECT_EQ(1u, snapshot.values.count("master/slaves_reregistering"));
 
   EXPECT_EQ(1u, snapshot.values.count("master/frameworks_connected"));
   EXPECT_EQ(1u, snapshot.values.count("master/frameworks_disconnected"));
@@ -2240,6 +2274,9 @@ TEST_F(MasterTest, MetricsInMetricsEndpoint)
   EXPECT_EQ(1u, snapshot.values.count("master/frameworks_inactive"));
 
   EXPECT_EQ(1u, snapshot.values.count("master/outstanding_offers"));
+  EXPECT_EQ(1u, snapshot.values.count("master/offers_sent"));
+  EXPECT_EQ(1u, snapshot.values.count("master/offers_rescinded"));
+  EXPECT_EQ(1u, snapshot.values.count("master/offers_expired"));
 
   EXPECT_EQ(1u, snapshot.values.count("master/tasks_staging"));
   EXPECT_EQ(1u, snapshot.values.count("master/tasks_starting"));
@@ -3145,6 +3182,13 @@ TEST_F(MasterTest, RecoveredSlaveReregisters)
 
   ASSERT_TRUE(slaveLost.isPending());
 
+  // The re-registration message was prepared off the master actor,
+  // and no re-registration is in progress anymore.
+  JSON::Object stats = Metrics();
+  EXPECT_EQ(
+      1u, stats.values.count("master/slave_reregistration_preparation_ms"));
+  EXPECT_EQ(0, stats.values["master/slaves_reregistering"]);
+
   driver.stop();
   driver.join();
 }
@@ -4130,6 +4174,11 @@ TEST_F(MasterTest, OfferTimeout)
 
   EXPECT_EQ(offers1.get()[0].resources(), offers2.get()[0].resources());
 
+  JSON::Object stats = Metrics();
+  EXPECT_EQ(2, stats.values["master/offers_sent"]);
+  EXPECT_EQ(1, stats.values["master/offers_rescinded"]);
+  EXPECT_EQ(1, stats.values["master/offers_expired"]);
+
   driver.stop();
   driver.join();
 }
@@ -4778,6 +4827,321 @@ TEST_F(MasterTest, StateEndpointAgentCapabilities)
 }
 
 
+// This ensures that when `--http_response_cache_ttl` is set, identical
+// requests to the /state endpoint by the same principal share their
+// response until the TTL has passed.
+TEST_F(MasterTest, StateEndpointResponseCache)
+{
+  master::Flags flags = CreateMasterFlags();
+  flags.http_response_cache_ttl = Minutes(1);
+
+  Clock::pause();
+
+  Try<Owned<cluster::Master>> master = StartMaster(flags);
+  ASSERT_SOME(master);
+
+  Future<Response> response1 = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  Future<Response> response2 = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response1);
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response2);
+  EXPECT_EQ(response1->body, response2->body);
+
+  // Requests by another principal are not served from the cache.
+  Future<Response> response3 = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL_2));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response3);
+
+  JSON::Object stats = Metrics();
+  EXPECT_EQ(1, stats.values["master/http_cache_hits"]);
+  EXPECT_EQ(2, stats.values["master/http_cache_misses"]);
+
+  // Once the TTL has passed, the response is computed again.
+  Clock::advance(flags.http_response_cache_ttl.get());
+
+  Future<Response> response4 = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response4);
+
+  stats = Metrics();
+  EXPECT_EQ(1, stats.values["master/http_cache_hits"]);
+  EXPECT_EQ(3, stats.values["master/http_cache_misses"]);
+}
+
+
+// This ensures that when `--state_snapshot_interval` is set, the
+// /state and /state-summary endpoints are served from the latest
+// snapshot, which only reflects a newly registered agent once a request
+// has found the snapshot outdated and the next one has been captured.
+TEST_F(MasterTest, StateEndpointFromStateSnapshot)
+{
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.state_snapshot_interval = Minutes(1);
+
+  Clock::pause();
+
+  Try<Owned<cluster::Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  // Returns the number of agents listed by an endpoint.
+  auto slaves = [&master](const string& endpoint) -> Option<size_t> {
+    Future<Response> response = process::http::get(
+        master.get()->pid,
+        endpoint,
+        None(),
+        createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+    Try<JSON::Object> parse = JSON::parse<JSON::Object>(response->body);
+    if (parse.isError()) {
+      return None();
+    }
+
+    Result<JSON::Array> array = parse->find<JSON::Array>("slaves");
+    if (!array.isSome()) {
+      return None();
+    }
+
+    return array->values.size();
+  };
+
+  EXPECT_SOME_EQ(0u, slaves("state"));
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get()->pid, _);
+
+  slave::Flags slaveFlags = CreateSlaveFlags();
+
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get(), slaveFlags);
+  ASSERT_SOME(slave);
+
+  // Trigger authentication and registration for the agent.
+  Clock::advance(slaveFlags.authentication_backoff_factor);
+  Clock::advance(slaveFlags.registration_backoff_factor);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  // The agent is not part of the snapshot yet.
+  EXPECT_SOME_EQ(0u, slaves("state"));
+  EXPECT_SOME_EQ(0u, slaves("state-summary"));
+
+  // The snapshot is outdated now, but still served from while the next
+  // one is being captured.
+  Clock::advance(masterFlags.state_snapshot_interval.get());
+
+  EXPECT_SOME_EQ(0u, slaves("state"));
+
+  Clock::settle();
+
+  EXPECT_SOME_EQ(1u, slaves("state"));
+  EXPECT_SOME_EQ(1u, slaves("state-summary"));
+  EXPECT_SOME_EQ(1u, slaves("slaves"));
+}
+
+
+// Expects two renderings of an endpoint to have the same fields with
+// the same values, except for the values of the fields that identify
+// the master, agents, frameworks and their PIDs and sandboxes, or
+// that depend on when something happened.
+static void expectSameFields(
+    const JSON::Value& expected,
+    const JSON::Value& actual,
+    const string& path)
+{
+  static const set<string> ignored = {
+    "id",
+    "pid",
+    "framework_id",
+    "slave_id",
+    "framework_ids",
+    "slave_ids",
+    "leader",
+    "leader_info",
+    "flags",
+    "start_time",
+    "elected_time",
+    "registered_time",
+    "reregistered_time",
+    "unregistered_time",
+    "directory",
+    "statuses"
+  };
+
+  if (expected.is<JSON::Object>() && actual.is<JSON::Object>()) {
+    const JSON::Object& expectedObject = expected.as<JSON::Object>();
+    const JSON::Object& actualObject = actual.as<JSON::Object>();
+
+    foreachkey (const string& key, expectedObject.values) {
+      EXPECT_EQ(1u, actualObject.values.count(key))
+        << "Missing field " << path << "." << key;
+    }
+
+    foreachpair (const string& key,
+                 const JSON::Value& value,
+                 actualObject.values) {
+      auto it = expectedObject.values.find(key);
+      if (it == expectedObject.values.end()) {
+        ADD_FAILURE() << "Unexpected field " << path << "." << key;
+      } else if (ignored.count(key) == 0) {
+        expectSameFields(it->second, value, path + "." + key);
+      }
+    }
+  } else if (expected.is<JSON::Array>() && actual.is<JSON::Array>()) {
+    const vector<JSON::Value>& expectedValues =
+      expected.as<JSON::Array>().values;
+    const vector<JSON::Value>& actualValues = actual.as<JSON::Array>().values;
+
+    ASSERT_EQ(expectedValues.size(), actualValues.size()) << path;
+
+    for (size_t i = 0; i < expectedValues.size(); i++) {
+      expectSameFields(
+          expectedValues[i],
+          actualValues[i],
+          path + "[" + stringify(i) + "]");
+    }
+  } else {
+    EXPECT_TRUE(expected == actual)
+      << path << ": " << jsonify(expected) << " != " << jsonify(actual);
+  }
+}
+
+
+// This ensures that the v0 endpoints render the same fields with the
+// same values whether they are served from the state of the master or
+// from a state snapshot (see `--state_snapshot_interval`). The same
+// cluster is set up twice, once for each.
+TEST_F(MasterTest, StateSnapshotEndpointsMatchMaster)
+{
+  const vector<string> endpoints =
+    {"state", "state-summary", "frameworks", "slaves"};
+
+  // Runs a framework with a task on a single agent and collects the
+  // responses of the endpoints.
+  auto render = [&endpoints, this](
+      const master::Flags& masterFlags,
+      vector<JSON::Value>* responses) {
+    Try<Owned<cluster::Master>> master = StartMaster(masterFlags);
+    ASSERT_SOME(master);
+
+    MockExecutor exec(DEFAULT_EXECUTOR_ID);
+    TestContainerizer containerizer(&exec);
+
+    Owned<MasterDetector> detector = master.get()->createDetector();
+    Try<Owned<cluster::Slave>> slave =
+      StartSlave(detector.get(), &containerizer);
+    ASSERT_SOME(slave);
+
+    FrameworkInfo frameworkInfo = DEFAULT_FRAMEWORK_INFO;
+    frameworkInfo.set_role("foo");
+
+    MockScheduler sched;
+    MesosSchedulerDriver driver(
+        &sched, frameworkInfo, master.get()->pid, DEFAULT_CREDENTIAL);
+
+    EXPECT_CALL(sched, registered(&driver, _, _));
+
+    Future<vector<Offer>> offers;
+    EXPECT_CALL(sched, resourceOffers(&driver, _))
+      .WillOnce(FutureArg<1>(&offers))
+      .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+    driver.start();
+
+    AWAIT_READY(offers);
+    ASSERT_FALSE(offers->empty());
+
+    // The task and its executor use all the offered resources, so
+    // that the framework does not hold any offers.
+    Resources executorResources = Resources::parse("cpus:0.1;mem:32").get();
+    executorResources.allocate("foo");
+
+    TaskInfo taskInfo;
+    taskInfo.set_name("task");
+    taskInfo.mutable_task_id()->set_value("1");
+    taskInfo.mutable_slave_id()->MergeFrom(offers.get()[0].slave_id());
+    taskInfo.mutable_resources()->MergeFrom(
+        Resources(offers.get()[0].resources()) - executorResources);
+
+    taskInfo.mutable_executor()->MergeFrom(DEFAULT_EXECUTOR_INFO);
+    taskInfo.mutable_executor()->mutable_resources()->CopyFrom(
+        executorResources);
+
+    EXPECT_CALL(exec, registered(_, _, _, _));
+
+    EXPECT_CALL(exec, launchTask(_, _))
+      .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+    Future<TaskStatus> status;
+    EXPECT_CALL(sched, statusUpdate(&driver, _))
+      .WillOnce(FutureArg<1>(&status));
+
+    driver.launchTasks(offers.get()[0].id(), {taskInfo});
+
+    AWAIT_READY(status);
+    EXPECT_EQ(TASK_RUNNING, status->state());
+
+    // The first request to a master with a state snapshot interval
+    // captures the snapshot, which is current at this point.
+    foreach (const string& endpoint, endpoints) {
+      Future<Response> response = process::http::get(
+          master.get()->pid,
+          endpoint,
+          None(),
+          createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+      AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+      Try<JSON::Value> parse = JSON::parse(response->body);
+      ASSERT_SOME(parse);
+
+      responses->push_back(parse.get());
+    }
+
+    EXPECT_CALL(exec, shutdown(_))
+      .Times(AtMost(1));
+
+    driver.stop();
+    driver.join();
+  };
+
+  vector<JSON::Value> live;
+  render(CreateMasterFlags(), &live);
+
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.state_snapshot_interval = Minutes(1);
+
+  vector<JSON::Value> snapshot;
+  render(masterFlags, &snapshot);
+
+  ASSERT_EQ(endpoints.size(), live.size());
+  ASSERT_EQ(endpoints.size(), snapshot.size());
+
+  for (size_t i = 0; i < endpoints.size(); i++) {
+    expectSameFields(live[i], snapshot[i], endpoints[i]);
+  }
+}
+
+
 // This ensures allocation role of task and its executor is exposed
 // in master's /state endpoint.
 TEST_F(MasterTest, StateEndpointAllocationRole)
@@ -8899,6 +9263,264 @@ TEST_P(MasterTestPrePostReservationRefinement, CreateAndDestroyVolumesV1)
   AWAIT_EXPECT_RESPONSE_STATUS_EQ(Accepted().status, v1DestroyVolumesResponse);
 }
 
+
+// Returns a completed task, as the master would keep it.
+static Task createCompletedTask(
+    const FrameworkID& frameworkId,
+    const SlaveID& slaveId,
+    const string& taskId)
+{
+  Task task;
+  task.set_name("task-" + taskId);
+  task.mutable_task_id()->set_value(taskId);
+  task.mutable_framework_id()->CopyFrom(frameworkId);
+  task.mutable_slave_id()->CopyFrom(slaveId);
+  task.mutable_executor_id()->set_value("default");
+  task.mutable_resources()->CopyFrom(
+      Resources::parse("cpus:0.1;mem:32;disk:32;ports:[31000-31001]").get());
+  task.set_state(TASK_FINISHED);
+  task.mutable_labels()->add_labels()->CopyFrom(createLabel("key", taskId));
+
+  const TaskState states[] = {TASK_STARTING, TASK_RUNNING, TASK_FINISHED};
+  foreach (const TaskState& state, states) {
+    TaskStatus* status = task.add_statuses();
+    status->mutable_task_id()->CopyFrom(task.task_id());
+    status->set_state(state);
+    status->set_source(TaskStatus::SOURCE_EXECUTOR);
+    status->set_timestamp(1490000000.0);
+    status->mutable_slave_id()->CopyFrom(slaveId);
+  }
+
+  task.set_status_update_state(TASK_FINISHED);
+  task.set_status_update_uuid(UUID::random().toBytes());
+
+  return task;
+}
+
+
+// Verifies that a compact task materializes to the task it was
+// created from, with and without an executor ID.
+TEST(CompactTaskTest, Materialize)
+{
+  FrameworkID frameworkId;
+  frameworkId.set_value("framework");
+
+  SlaveID slaveId;
+  slaveId.set_value("agent");
+
+  CompactTask::Pool pool;
+
+  Task task = createCompletedTask(frameworkId, slaveId, "1");
+  CompactTask compact(task, &pool);
+
+  EXPECT_EQ(
+      task.SerializeAsString(),
+      compact.materialize().SerializeAsString());
+  EXPECT_EQ(slaveId, compact.slaveId());
+  EXPECT_EQ(TASK_FINISHED, compact.state());
+
+  task.clear_executor_id();
+  CompactTask compact2(task, &pool);
+
+  Task materialized = compact2.materialize();
+  EXPECT_FALSE(materialized.has_executor_id());
+  EXPECT_EQ(task.SerializeAsString(), materialized.SerializeAsString());
+}
+
+
+class MasterCompactTask_BENCHMARK_Test
+  : public WithParamInterface<size_t>,
+    public ::testing::Test {};
+
+
+// The compact task benchmark is parameterized by the number of tasks.
+INSTANTIATE_TEST_CASE_P(
+    TaskCount,
+    MasterCompactTask_BENCHMARK_Test,
+    ::testing::Values(10000U, 100000U, 1000000U));
+
+
+// Compares the memory used by completed tasks in their compact
+// representation with the memory used by the full tasks.
+TEST_P(MasterCompactTask_BENCHMARK_Test, Memory)
+{
+  const size_t taskCount = GetParam();
+
+  // The tasks are spread over a few frameworks and many agents.
+  const size_t frameworkCount = 10;
+  const size_t slaveCount = 1000;
+
+  vector<FrameworkID> frameworkIds;
+  for (size_t i = 0; i < frameworkCount; ++i) {
+    FrameworkID frameworkId;
+    frameworkId.set_value(
+        "6b2c3fb4-1f8c-4d8e-9b1a-6f8e2d1c7a51-" + stringify(i));
+    frameworkIds.push_back(frameworkId);
+  }
+
+  vector<SlaveID> slaveIds;
+  for (size_t i = 0; i < slaveCount; ++i) {
+    SlaveID slaveId;
+    slaveId.set_value("201310101658-2280333834-5050-48574-S" + stringify(i));
+    slaveIds.push_back(slaveId);
+  }
+
+  size_t taskBytes = 0;
+
+  CompactTask::Pool pool;
+  vector<CompactTask> compactTasks;
+  compactTasks.reserve(taskCount);
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < taskCount; ++i) {
+    const Task task = createCompletedTask(
+        frameworkIds[i % frameworkCount],
+        slaveIds[i % slaveCount],
+        UUID::random().toString());
+
+    // Account for the `Owned<Task>` that the master used to keep.
+    taskBytes += task.SpaceUsed() + sizeof(Owned<Task>);
+
+    compactTasks.push_back(CompactTask(task, &pool));
+  }
+
+  cout << "Compacted " << taskCount << " tasks in " << watch.elapsed() << endl;
+
+  size_t compactBytes = pool.bytes();
+  foreach (const CompactTask& task, compactTasks) {
+    compactBytes += task.bytes();
+  }
+
+  cout << "Full tasks use " << Bytes(taskBytes) << ", compact tasks use "
+       << Bytes(compactBytes) << " (" << Bytes(pool.bytes())
+       << " in the pool)" << endl;
+
+  watch.start();
+
+  size_t materialized = 0;
+  foreach (const CompactTask& task, compactTasks) {
+    materialized += task.materialize().statuses_size();
+  }
+
+  EXPECT_EQ(taskCount * 3, materialized);
+
+  cout << "Materialized " << taskCount << " tasks in " << watch.elapsed()
+       << endl;
+}
+
+
+class MasterStatusUpdate_BENCHMARK_Test
+  : public MesosTest,
+    public WithParamInterface<size_t> {};
+
+
+// The status update benchmark is parameterized by the number of tasks.
+INSTANTIATE_TEST_CASE_P(
+    Tasks,
+    MasterStatusUpdate_BENCHMARK_Test,
+    ::testing::Values(1000U, 5000U, 10000U));
+
+
+// This benchmark launches many tasks on a single agent and then
+// terminates all of them at once, as happens when a framework is torn
+// down. It measures the time until the master has processed the burst
+// of terminal status updates and the scheduler has received them.
+TEST_P(MasterStatusUpdate_BENCHMARK_Test, TerminalUpdates)
+{
+  const size_t tasks = GetParam();
+
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  slave::Flags slaveFlags = CreateSlaveFlags();
+  slaveFlags.resources =
+    "cpus:" + stringify(tasks) + ";mem:" + stringify(tasks * 32);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave =
+    StartSlave(detector.get(), &containerizer, slaveFlags);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  ASSERT_FALSE(offers->empty());
+
+  const Resources taskResources = allocatedResources(
+      Resources::parse("cpus:1;mem:32").get(),
+      DEFAULT_FRAMEWORK_INFO.role());
+
+  vector<TaskInfo> taskInfos;
+  for (size_t i = 0; i < tasks; ++i) {
+    TaskInfo task;
+    task.set_name("");
+    task.mutable_task_id()->set_value(stringify(i));
+    task.mutable_slave_id()->CopyFrom(offers->front().slave_id());
+    task.mutable_resources()->CopyFrom(taskResources);
+    task.mutable_executor()->CopyFrom(DEFAULT_EXECUTOR_INFO);
+
+    taskInfos.push_back(task);
+  }
+
+  ExecutorDriver* execDriver;
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .WillOnce(SaveArg<0>(&execDriver));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillRepeatedly(Return());
+
+  driver.launchTasks(offers->front().id(), taskInfos);
+
+  // Wait until all the tasks are running.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  Stopwatch watch;
+  watch.start();
+
+  foreach (const TaskInfo& task, taskInfos) {
+    TaskStatus status;
+    status.mutable_task_id()->CopyFrom(task.task_id());
+    status.set_state(TASK_FINISHED);
+
+    execDriver->sendStatusUpdate(status);
+  }
+
+  Clock::pause();
+  Clock::settle();
+
+  cout << "Processed the terminal status updates of " << tasks
+       << " tasks in " << watch.elapsed() << endl;
+
+  Clock::resume();
+
+  driver.stop();
+  driver.join();
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
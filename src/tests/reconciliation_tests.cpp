@@ -30,6 +30,7 @@
 #include <process/pid.hpp>
 #include <process/process.hpp>
 
+#include <stout/hashmap.hpp>
 #include <stout/uuid.hpp>
 
 #include "common/protobuf_utils.hpp"
@@ -65,6 +66,7 @@ using testing::An;
 using testing::AtMost;
 using testing::DoAll;
 using testing::Eq;
+using testing::Invoke;
 using testing::Return;
 using testing::SaveArg;
 
@@ -436,6 +438,61 @@ TEST_F(ReconciliationTest, UnknownKillTask)
 }
 
 
+// This test verifies that an explicit reconciliation of more tasks
+// than the master answers at once is answered completely and in order.
+TEST_F(ReconciliationTest, ExplicitReconciliationInChunks)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+    &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  driver.start();
+
+  // Wait until the framework is registered.
+  AWAIT_READY(frameworkId);
+
+  // Reconcile unknown tasks that span three chunks.
+  const size_t tasks = 2 * master::RECONCILIATION_CHUNK_SIZE + 1;
+
+  vector<TaskStatus> statuses;
+  for (size_t i = 0; i < tasks; i++) {
+    TaskStatus status;
+    status.mutable_task_id()->set_value(stringify(i));
+    status.set_state(TASK_STAGING); // Dummy value.
+
+    statuses.push_back(status);
+  }
+
+  // The expectation for the last update is declared first, since the
+  // expectations declared later are matched first.
+  Future<TaskStatus> update;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&update));
+
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .Times(tasks - 1)
+    .RetiresOnSaturation();
+
+  driver.reconcileTasks(statuses);
+
+  // Framework should receive TASK_LOST for the last unknown task last.
+  AWAIT_READY(update);
+  EXPECT_EQ(statuses.back().task_id(), update->task_id());
+  EXPECT_EQ(TASK_LOST, update->state());
+  EXPECT_EQ(TaskStatus::REASON_RECONCILIATION, update->reason());
+
+  driver.stop();
+  driver.join();
+}
+
+
 // This test verifies that explicit reconciliation does not return any
 // results for tasks running on an agent that has been recovered from
 // the registry after master failover but has not yet reregistered.
@@ -770,6 +827,107 @@ TEST_F(ReconciliationTest, ImplicitNonTerminalTask)
 }
 
 
+// This test ensures that a repeated implicit reconciliation request
+// joins the reconciliation in progress when the framework has more
+// tasks than the master answers at once, rather than restarting it
+// before the tasks beyond the first chunk have been answered.
+TEST_F(ReconciliationTest, ImplicitReconciliationInChunks)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  slave::Flags slaveFlags = CreateSlaveFlags();
+  slaveFlags.resources = "cpus:2;mem:2048";
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave =
+    StartSlave(detector.get(), &containerizer, slaveFlags);
+  ASSERT_SOME(slave);
+
+  // Launch tasks that span two chunks.
+  const size_t tasks = master::RECONCILIATION_CHUNK_SIZE + 1;
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+    &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, tasks, 0.001, 1, "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  // The expectation for the last update is declared first, since the
+  // expectations declared later are matched first.
+  Future<TaskStatus> update;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&update));
+
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .Times(tasks - 1)
+    .RetiresOnSaturation();
+
+  driver.start();
+
+  // Wait until the framework is registered.
+  AWAIT_READY(frameworkId);
+
+  AWAIT_READY(update);
+  EXPECT_EQ(TASK_RUNNING, update->state());
+
+  // Count the reconciliation updates of each task.
+  hashmap<TaskID, size_t> updates;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillRepeatedly(Invoke([&](SchedulerDriver*, const TaskStatus& status) {
+      EXPECT_EQ(TASK_RUNNING, status.state());
+      EXPECT_EQ(TaskStatus::REASON_RECONCILIATION, status.reason());
+
+      updates[status.task_id()]++;
+    }));
+
+  Clock::pause();
+
+  driver.reconcileTasks({});
+  driver.reconcileTasks({});
+
+  // The Clock::settle() will ensure that the framework receives all
+  // the updates of both reconciliation requests.
+  Clock::settle();
+
+  // Each task is answered once if the second request joined the
+  // reconciliation of the first one, or twice if it was processed
+  // after the first reconciliation completed. Restarting the first
+  // reconciliation would answer the first chunk twice but the last
+  // task only once.
+  ASSERT_EQ(tasks, updates.size());
+
+  const size_t answers = updates.begin()->second;
+  EXPECT_TRUE(answers == 1 || answers == 2);
+
+  foreachvalue (size_t count, updates) {
+    EXPECT_EQ(answers, count);
+  }
+
+  Clock::resume();
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+}
+
+
 // This test ensures that the master does not send updates for
 // terminal tasks during an implicit reconciliation request.
 // TODO(bmahler): Soon the master will keep non-acknowledged
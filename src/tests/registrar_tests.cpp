@@ -115,6 +115,7 @@ using mesos::http::authentication::BasicAuthenticatorFactory;
 using mesos::state::LogStorage;
 using mesos::state::State;
 using mesos::state::Storage;
+using mesos::state::Variable;
 
 using state::Entry;
 
@@ -1158,6 +1159,122 @@ TEST_F(RegistrarTest, Bootstrap)
 }
 
 
+// Tests that the registry is recovered from the deltas in the
+// registry journal and that the journal is compacted once it is full.
+TEST_F(RegistrarTest, Journal)
+{
+  flags.registry_max_journal_entries = 2;
+
+  SlaveInfo info2 = slave;
+  info2.mutable_id()->set_value("2");
+
+  // Run 1 journals the admissions and the changes that follow the
+  // compaction once the journal is full.
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(slave))));
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(info2))));
+
+    // The admitted agents are only stored in the journal.
+    Future<Variable> variable = state->fetch("registry");
+    AWAIT_READY(variable);
+
+    Try<Registry> stored =
+      ::protobuf::deserialize<Registry>(variable->value());
+
+    ASSERT_SOME(stored);
+    EXPECT_EQ(0, stored->slaves().slaves().size());
+
+    // The journal is full, so this stores the whole registry.
+    AWAIT_TRUE(registrar.apply(
+        Owned<Operation>(
+            new MarkSlaveUnreachable(slave, protobuf::getCurrentTime()))));
+
+    AWAIT_TRUE(
+        registrar.apply(Owned<Operation>(new MarkSlaveReachable(slave))));
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new RemoveSlave(info2))));
+  }
+
+  // Run 2 should see the changes that were journaled.
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    ASSERT_EQ(1, registry->slaves().slaves().size());
+    EXPECT_EQ(slave, registry->slaves().slaves(0).info());
+    EXPECT_EQ(0, registry->unreachable().slaves().size());
+
+    AWAIT_TRUE(registrar.apply(
+        Owned<Operation>(
+            new MarkSlaveGone(slave.id(), protobuf::getCurrentTime()))));
+  }
+
+  // Run 3 should see the changes when the journal is disabled.
+  flags.registry_max_journal_entries = 0;
+
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    EXPECT_EQ(0, registry->slaves().slaves().size());
+    ASSERT_EQ(1, registry->gone().slaves().size());
+    EXPECT_EQ(slave.id(), registry->gone().slaves(0).id());
+  }
+}
+
+
+// Tests that the journal records both the removed and the admitted
+// agents when they are updated in the same batch of operations.
+TEST_F(RegistrarTest, JournalRemoveAndAdmit)
+{
+  flags.registry_max_journal_entries = 10;
+
+  SlaveInfo info2 = slave;
+  info2.mutable_id()->set_value("2");
+
+  SlaveInfo info3 = slave;
+  info3.mutable_id()->set_value("3");
+
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(slave))));
+
+    // Don't wait between the operations so that the latter ones are
+    // applied in the same batch, which keeps the size of the agent
+    // list unchanged.
+    Future<bool> admit3 =
+      registrar.apply(Owned<Operation>(new AdmitSlave(info3)));
+    Future<bool> remove =
+      registrar.apply(Owned<Operation>(new RemoveSlave(slave)));
+    Future<bool> admit2 =
+      registrar.apply(Owned<Operation>(new AdmitSlave(info2)));
+
+    AWAIT_TRUE(admit3);
+    AWAIT_TRUE(remove);
+    AWAIT_TRUE(admit2);
+  }
+
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    ASSERT_EQ(2, registry->slaves().slaves().size());
+    EXPECT_EQ(info3, registry->slaves().slaves(0).info());
+    EXPECT_EQ(info2, registry->slaves().slaves(1).info());
+  }
+}
+
+
 class MockStorage : public Storage
 {
 public:
@@ -1389,6 +1506,104 @@ TEST_P(Registrar_BENCHMARK_Test, Performance)
 }
 
 
+// Forwards to another storage and counts the bytes that are stored.
+class CountingStorage : public Storage
+{
+public:
+  explicit CountingStorage(Storage* _storage)
+    : storage(_storage), bytes(0) {}
+
+  virtual Future<Option<Entry>> get(const string& name)
+  {
+    return storage->get(name);
+  }
+
+  virtual Future<bool> set(const Entry& entry, const UUID& uuid)
+  {
+    bytes += entry.value().size();
+    return storage->set(entry, uuid);
+  }
+
+  virtual Future<bool> expunge(const Entry& entry)
+  {
+    return storage->expunge(entry);
+  }
+
+  virtual Future<std::set<string>> names()
+  {
+    return storage->names();
+  }
+
+  Storage* storage;
+  size_t bytes;
+};
+
+
+class RegistrarJournal_BENCHMARK_Test
+  : public RegistrarTestBase,
+    public WithParamInterface<std::tr1::tuple<size_t, size_t>> {};
+
+
+// The benchmark is parameterized by the number of agents and the
+// maximum number of journal entries, where 0 disables the journal.
+INSTANTIATE_TEST_CASE_P(
+    SlaveCount,
+    RegistrarJournal_BENCHMARK_Test,
+    ::testing::Combine(
+      ::testing::Values(10000U, 20000U, 30000U, 50000U),
+      ::testing::Values(0U, 100U, 1000U)));
+
+
+// Measures the time to admit agents one at a time, the number of bytes
+// that are stored for them (i.e., the write amplification), and the
+// time to recover the registry afterwards.
+TEST_P(RegistrarJournal_BENCHMARK_Test, AdmitAndRecover)
+{
+  size_t slaveCount = std::tr1::get<0>(GetParam());
+  flags.registry_max_journal_entries = std::tr1::get<1>(GetParam());
+
+  CountingStorage counting(storage);
+  State state(&counting);
+
+  Registrar registrar(flags, &state);
+  AWAIT_READY(registrar.recover(master));
+
+  Attributes attributes = Attributes::parse("foo:bar;baz:quux");
+  Resources resources =
+    Resources::parse("cpus(*):1.0;mem(*):512;disk(*):2048").get();
+
+  vector<SlaveInfo> infos;
+  for (size_t i = 0; i < slaveCount; ++i) {
+    SlaveInfo info;
+    info.set_hostname("localhost");
+    info.mutable_id()->set_value(
+        string("201310101658-2280333834-5050-48574-") + stringify(i));
+    info.mutable_resources()->MergeFrom(resources);
+    info.mutable_attributes()->MergeFrom(attributes);
+    infos.push_back(info);
+  }
+
+  // Admit the agents, waiting for each admission so that every agent
+  // is stored separately, as when agents register over time.
+  size_t bytes = counting.bytes;
+
+  Stopwatch watch;
+  watch.start();
+  foreach (const SlaveInfo& info, infos) {
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(info))));
+  }
+  cout << "Admitted " << slaveCount << " agents in " << watch.elapsed()
+       << ", storing " << Bytes(counting.bytes - bytes) << endl;
+
+  Registrar registrar2(flags, &state);
+  watch.start();
+  Future<Registry> registry = registrar2.recover(master);
+  AWAIT_READY(registry);
+  cout << "Recovered " << slaveCount << " agents ("
+       << Bytes(registry->ByteSize()) << ") in " << watch.elapsed() << endl;
+}
+
+
 // Test the performance of marking all registered slaves unreachable,
 // then marking them reachable again. This might occur if there is a
 // network partition and then the partition heals.
@@ -2758,6 +2758,67 @@ TEST(ResourcesOperationTest, DestroySharedPersistentVolumeMultipleCopies)
 }
 
 
+TEST(ResourcesOperationTest, TransformInPlace)
+{
+  Resources total = Resources::parse("cpus:1;mem:512;disk(role):1000").get();
+
+  Resource volume1 = createDiskResource("200", "role", "1", "path1");
+  Resource volume2 = createDiskResource("900", "role", "2", "path2");
+
+  // The second volume cannot be created after the first, so the
+  // partially applied operation must be reverted.
+  Offer::Operation create;
+  create.set_type(Offer::Operation::CREATE);
+  create.mutable_create()->add_volumes()->CopyFrom(volume1);
+  create.mutable_create()->add_volumes()->CopyFrom(volume2);
+
+  Resources original = total;
+
+  EXPECT_ERROR(total.transform(create));
+  EXPECT_EQ(original, total);
+
+  create.mutable_create()->mutable_volumes()->RemoveLast();
+
+  EXPECT_SOME(total.transform(create));
+  EXPECT_EQ(
+      Resources::parse("cpus:1;mem:512;disk(role):800").get() + volume1,
+      total);
+
+  // The copy taken before the operation is not modified.
+  EXPECT_EQ(
+      Resources::parse("cpus:1;mem:512;disk(role):1000").get(), original);
+
+  // Applying a sequence of operations yields the same result.
+  Resources reservedCpus = Resources::parse("cpus:1").get().pushReservation(
+      createDynamicReservationInfo("role", "principal"));
+
+  vector<Offer::Operation> operations = {create, RESERVE(reservedCpus)};
+
+  EXPECT_SOME_EQ(
+      Resources::parse("mem:512;disk(role):800").get() + volume1 +
+        reservedCpus,
+      original.apply(operations));
+
+  // A shared volume with multiple copies cannot be destroyed, which
+  // leaves both copies.
+  Resource volume3 = createDiskResource(
+      "200", "role", "3", "path3", None(), true);
+
+  total += volume3;
+  total += volume3;
+
+  original = total;
+
+  Offer::Operation destroy;
+  destroy.set_type(Offer::Operation::DESTROY);
+  destroy.mutable_destroy()->add_volumes()->CopyFrom(volume3);
+
+  EXPECT_ERROR(total.transform(destroy));
+  EXPECT_EQ(original, total);
+  EXPECT_EQ(2u, total.count(volume3));
+}
+
+
 TEST(ResourcesOperationTest, FlattenResources)
 {
   Resources unreservedCpus = Resources::parse("cpus:1").get();
@@ -3037,6 +3098,198 @@ TEST(ResourcesTest, Count)
 }
 
 
+// This test verifies that arithmetic and containment are unaffected
+// by the index that `Resources` builds once it holds many `Resource`
+// objects, including after the objects are modified in place.
+TEST(ResourcesTest, ManyResources)
+{
+  vector<Resource> reserved;
+  vector<Resource> volumes;
+
+  Resources total;
+
+  for (int i = 0; i < 50; i++) {
+    reserved.push_back(
+        Resources::parse("cpus", "1", "role" + stringify(i)).get());
+
+    volumes.push_back(createDiskResource(
+        "10", "role", "id" + stringify(i), "path" + stringify(i)));
+
+    total += reserved.back();
+    total += reserved.back();
+    total += volumes.back();
+  }
+
+  EXPECT_EQ(100u, total.size());
+  EXPECT_EQ(100, total.cpus().get());
+  EXPECT_EQ(Megabytes(500), total.disk().get());
+
+  for (int i = 0; i < 50; i++) {
+    EXPECT_TRUE(total.contains(reserved[i]));
+    EXPECT_TRUE(total.contains(volumes[i]));
+    EXPECT_EQ(1u, total.count(volumes[i]));
+  }
+
+  // Remove every other reservation and volume.
+  Resources remaining = total;
+
+  for (int i = 0; i < 50; i += 2) {
+    remaining -= reserved[i];
+    remaining -= reserved[i];
+    remaining -= volumes[i];
+  }
+
+  EXPECT_EQ(50u, remaining.size());
+  EXPECT_TRUE(total.contains(remaining));
+  EXPECT_FALSE(remaining.contains(total));
+
+  for (int i = 0; i < 50; i++) {
+    EXPECT_EQ(i % 2 == 1, remaining.contains(reserved[i]));
+    EXPECT_EQ(i % 2 == 1, remaining.contains(volumes[i]));
+  }
+
+  EXPECT_EQ(total, remaining + (total - remaining));
+
+  Resources allocated = remaining;
+  allocated.allocate("role");
+
+  Resource cpus = reserved[1];
+  cpus.mutable_allocation_info()->set_role("role");
+
+  EXPECT_TRUE(allocated.contains(cpus));
+  EXPECT_FALSE(allocated.contains(reserved[1]));
+
+  allocated -= cpus;
+  allocated -= cpus;
+
+  EXPECT_EQ(49u, allocated.size());
+  EXPECT_FALSE(allocated.contains(cpus));
+
+  allocated.unallocate();
+
+  EXPECT_EQ(remaining - reserved[1] - reserved[1], allocated);
+}
+
+
+// Copies of `Resources` share their underlying resources until they
+// are modified. This checks that modifying a copy, including one that
+// is indexed, never affects the original.
+TEST(ResourcesTest, CopyOnWrite)
+{
+  Resources original = Resources::parse("cpus:1;mem:10").get();
+  Resources copy = original;
+
+  copy += Resources::parse("cpus:2").get();
+  copy -= Resources::parse("mem:5").get();
+
+  EXPECT_EQ(Resources::parse("cpus:1;mem:10").get(), original);
+  EXPECT_EQ(Resources::parse("cpus:3;mem:5").get(), copy);
+
+  Resources reserved = Resources::parse("cpus(role):1;mem:10").get();
+  Resources filtered = reserved.reserved("role");
+
+  filtered += Resources::parse("cpus(role):1").get();
+  filtered.allocate("role");
+
+  EXPECT_EQ(Resources::parse("cpus(role):1;mem:10").get(), reserved);
+
+  Resources total;
+  for (int i = 0; i < 50; i++) {
+    total += Resources::parse("cpus", "1", "role" + stringify(i)).get();
+  }
+
+  Resources modified = total;
+  modified -= Resources::parse("cpus", "1", "role0").get();
+  modified += Resources::parse("cpus", "1", "role1").get();
+  modified += Resources::parse("cpus", "1", "role50").get();
+
+  EXPECT_EQ(50u, total.size());
+  EXPECT_EQ(50, total.cpus().get());
+  EXPECT_TRUE(total.contains(Resources::parse("cpus", "1", "role0").get()));
+  EXPECT_FALSE(total.contains(Resources::parse("cpus", "2", "role1").get()));
+  EXPECT_FALSE(total.contains(Resources::parse("cpus", "1", "role50").get()));
+
+  EXPECT_EQ(50u, modified.size());
+  EXPECT_EQ(51, modified.cpus().get());
+  EXPECT_TRUE(modified.contains(Resources::parse("cpus", "2", "role1").get()));
+}
+
+
+TEST(ResourcesTest, ScalarQuantities)
+{
+  Resources resources = Resources::parse(
+      "cpus:1;cpus(role):2;mem:10;disk(role):20;ports:[1-10]").get();
+
+  Resource volume = createDiskResource("5", "role", "id", "path");
+  resources += volume;
+
+  map<string, Value::Scalar> expected;
+  expected["cpus"].set_value(3);
+  expected["mem"].set_value(10);
+  expected["disk"].set_value(25);
+
+  EXPECT_EQ(expected, resources.scalarQuantities());
+  EXPECT_EQ(3, resources.cpus().get());
+
+  // Modifications of a copy must not affect the quantities of the
+  // original, and must be reflected in subsequent calls.
+  Resources copy = resources;
+  copy -= volume;
+  copy += Resources::parse("gpus:1").get();
+
+  expected["gpus"].set_value(1);
+  expected["disk"].set_value(20);
+
+  EXPECT_EQ(expected, copy.scalarQuantities());
+  EXPECT_EQ(Megabytes(25), resources.disk().get());
+  EXPECT_EQ(Megabytes(20), copy.disk().get());
+  EXPECT_EQ(1, copy.gpus().get());
+  EXPECT_NONE(resources.gpus());
+
+  EXPECT_EQ(
+      Resources::parse("cpus:1;cpus(role):2;mem:10;disk(role):25").get(),
+      resources.createStrippedScalarQuantity());
+
+  resources -= Resources::parse("cpus(role):2").get();
+
+  EXPECT_EQ(1, resources.cpus().get());
+  EXPECT_EQ(
+      Resources::parse("cpus:1;mem:10;disk(role):25").get(),
+      resources.createStrippedScalarQuantity());
+
+  // Allocating does not change the quantities.
+  resources.allocate("role");
+
+  EXPECT_EQ(1, resources.cpus().get());
+  EXPECT_EQ(
+      Resources::parse("cpus:1;mem:10;disk(role):25").get(),
+      resources.createStrippedScalarQuantity());
+
+  resources.unallocate();
+
+  // Reserving in place moves the quantity to the role.
+  Resources reserved = Resources::parse("cpus:1").get().pushReservation(
+      createDynamicReservationInfo("role", "principal"));
+
+  ASSERT_SOME(resources.transform(RESERVE(reserved)));
+
+  EXPECT_EQ(1, resources.cpus().get());
+  EXPECT_EQ(
+      Resources::parse("cpus(role):1;mem:10;disk(role):25").get(),
+      resources.createStrippedScalarQuantity());
+
+  // Subtracting all of a resource removes its quantity.
+  resources -= reserved;
+
+  expected.clear();
+  expected["mem"].set_value(10);
+  expected["disk"].set_value(25);
+
+  EXPECT_EQ(expected, resources.scalarQuantities());
+  EXPECT_NONE(resources.cpus());
+}
+
+
 TEST(ResourcesTest, Evolve)
 {
   string resourcesString = "cpus(role1):2;mem(role1):10;cpus:4;mem:20";
@@ -3726,6 +3979,285 @@ TEST_P(Resources_Contains_BENCHMARK_Test, Contains)
 }
 
 
+class Resources_ManyResources_BENCHMARK_Test
+  : public ::testing::Test,
+    public ::testing::WithParamInterface<size_t> {};
+
+
+// The benchmark is parameterized by the number of reservations and
+// persistent volumes, as on an agent with many of them.
+INSTANTIATE_TEST_CASE_P(
+    ResourceCount,
+    Resources_ManyResources_BENCHMARK_Test,
+    ::testing::Values(10U, 100U, 1000U, 10000U));
+
+
+TEST_P(Resources_ManyResources_BENCHMARK_Test, Arithmetic)
+{
+  const size_t count = GetParam();
+
+  vector<Resource> resources;
+  resources.reserve(2 * count);
+
+  for (size_t i = 0; i < count; i++) {
+    resources.push_back(
+        Resources::parse("cpus", "1", "role" + stringify(i)).get());
+
+    resources.push_back(createDiskResource(
+        "10", "role", "id" + stringify(i), "path" + stringify(i)));
+  }
+
+  Resources total;
+  Stopwatch watch;
+
+  watch.start();
+  foreach (const Resource& resource, resources) {
+    total += resource;
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to add " << resources.size()
+       << " reservations and persistent volumes one by one" << endl;
+
+  watch.start();
+  foreach (const Resource& resource, resources) {
+    ASSERT_TRUE(total.contains(resource));
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to check whether they are"
+       << " contained one by one" << endl;
+
+  watch.start();
+  ASSERT_TRUE(total.contains(total));
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to check whether they are"
+       << " contained at once" << endl;
+
+  watch.start();
+  foreach (const Resource& resource, resources) {
+    total -= resource;
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to subtract them one by one"
+       << endl;
+
+  ASSERT_TRUE(total.empty()) << total;
+}
+
+
+TEST_P(Resources_ManyResources_BENCHMARK_Test, Filters)
+{
+  const size_t count = GetParam();
+  const size_t totalOperations = 100;
+
+  Resources total;
+
+  for (size_t i = 0; i < count; i++) {
+    total += Resources::parse("cpus", "1", "role" + stringify(i)).get();
+    total += createDiskResource(
+        "10", "role", "id" + stringify(i), "path" + stringify(i));
+  }
+
+  Stopwatch watch;
+
+  watch.start();
+  for (size_t i = 0; i < totalOperations; i++) {
+    Resources copy = total;
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to perform " << totalOperations
+       << " copies of " << total.size() << " resources" << endl;
+
+  watch.start();
+  for (size_t i = 0; i < totalOperations; i++) {
+    total.nonRevocable();
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to perform " << totalOperations
+       << " 'r.nonRevocable()' operations on " << total.size()
+       << " resources" << endl;
+
+  watch.start();
+  for (size_t i = 0; i < totalOperations; i++) {
+    total.reserved("role");
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to perform " << totalOperations
+       << " 'r.reserved(role)' operations on " << total.size()
+       << " resources" << endl;
+
+  watch.start();
+  for (size_t i = 0; i < totalOperations; i++) {
+    Resources allocated = total;
+    allocated.allocate("role");
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to perform " << totalOperations
+       << " 'r.allocate(role)' operations on copies of " << total.size()
+       << " resources" << endl;
+}
+
+
+TEST_P(Resources_ManyResources_BENCHMARK_Test, Quantities)
+{
+  const size_t count = GetParam();
+  const size_t totalOperations = 1000;
+
+  Resources total;
+
+  for (size_t i = 0; i < count; i++) {
+    total += Resources::parse("cpus", "1", "role" + stringify(i)).get();
+    total += createDiskResource(
+        "10", "role", "id" + stringify(i), "path" + stringify(i));
+  }
+
+  total += Resources::parse("mem:1024").get();
+
+  Stopwatch watch;
+
+  watch.start();
+  for (size_t i = 0; i < totalOperations; i++) {
+    total.cpus();
+    total.mem();
+    total.disk();
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to perform " << totalOperations
+       << " 'r.cpus()', 'r.mem()' and 'r.disk()' operations on "
+       << total.size() << " resources" << endl;
+
+  watch.start();
+  for (size_t i = 0; i < totalOperations; i++) {
+    total.createStrippedScalarQuantity();
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to perform " << totalOperations
+       << " 'r.createStrippedScalarQuantity()' operations on "
+       << total.size() << " resources" << endl;
+}
+
+
+TEST_P(Resources_ManyResources_BENCHMARK_Test, Operations)
+{
+  const size_t count = GetParam();
+
+  Resources total = Resources::parse(
+      "cpus:1;mem:512;disk(role):" + stringify(count * 10)).get();
+
+  vector<Offer::Operation> operations;
+
+  for (size_t i = 0; i < count; i++) {
+    Offer::Operation create;
+    create.set_type(Offer::Operation::CREATE);
+    create.mutable_create()->add_volumes()->CopyFrom(createDiskResource(
+        "10", "role", "id" + stringify(i), "path" + stringify(i)));
+
+    operations.push_back(create);
+  }
+
+  Stopwatch watch;
+
+  watch.start();
+  Resources applied = total;
+  foreach (const Offer::Operation& operation, operations) {
+    applied = applied.apply(operation).get();
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to apply " << count
+       << " CREATE operations one at a time" << endl;
+
+  watch.start();
+  Resources transformed = total;
+  foreach (const Offer::Operation& operation, operations) {
+    ASSERT_SOME(transformed.transform(operation));
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to transform " << count
+       << " CREATE operations in place" << endl;
+
+  EXPECT_EQ(applied, transformed);
+}
+
+
+class Resources_Ranges_BENCHMARK_Test
+  : public ::testing::Test,
+    public ::testing::WithParamInterface<size_t> {};
+
+
+// The ranges benchmark is parameterized by the number of disjoint
+// ranges that the ports of an agent are fragmented into.
+INSTANTIATE_TEST_CASE_P(
+    RangeCount,
+    Resources_Ranges_BENCHMARK_Test,
+    ::testing::Values(100U, 1000U, 10000U));
+
+
+// This benchmark takes single ports from and returns them to the
+// fragmented ports of an agent, as when launching and completing
+// tasks that each use a port.
+TEST_P(Resources_Ranges_BENCHMARK_Test, Ports)
+{
+  const size_t rangeCount = GetParam();
+
+  Try<::mesos::Value::Ranges> ranges =
+    fragment(createRange(1, 64000), rangeCount);
+
+  ASSERT_SOME(ranges);
+
+  const Resources available = createPorts(ranges.get());
+
+  vector<Resources> ports;
+  ports.reserve(rangeCount);
+
+  foreach (const Value::Range& range, ranges->range()) {
+    ::mesos::Value::Ranges port;
+    port.add_range()->CopyFrom(createRange(range.begin(), range.begin()));
+
+    ports.push_back(createPorts(port));
+  }
+
+  Resources total = available;
+  Stopwatch watch;
+
+  watch.start();
+  foreach (const Resources& port, ports) {
+    ASSERT_TRUE(total.contains(port));
+    total -= port;
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to take " << ports.size()
+       << " ports one by one from " << rangeCount << " ranges" << endl;
+
+  watch.start();
+  foreach (const Resources& port, ports) {
+    total += port;
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to return " << ports.size()
+       << " ports one by one to " << rangeCount << " ranges" << endl;
+
+  watch.start();
+  ASSERT_EQ(available, total);
+  watch.stop();
+
+  cout << "Took " << watch.elapsed() << " to compare " << rangeCount
+       << " ranges" << endl;
+}
+
+
 class Resources_Parse_BENCHMARK_Test
   : public MesosTest,
     public ::testing::WithParamInterface<size_t> {};
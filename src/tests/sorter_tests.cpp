@@ -15,6 +15,7 @@
 // limitations under the License.
 
 #include <iostream>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -33,6 +34,7 @@ using mesos::internal::master::allocator::DRFSorter;
 
 using std::cout;
 using std::endl;
+using std::set;
 using std::string;
 using std::vector;
 
@@ -1037,6 +1039,65 @@ TEST(SorterTest, UpdateAllocationNestedClient)
 }
 
 
+// This test checks that the sorter maintains the sum of the scalar
+// quantities allocated to all of its clients.
+TEST(SorterTest, AggregateAllocationScalarQuantities)
+{
+  DRFSorter sorter;
+
+  SlaveID slaveId;
+  slaveId.set_value("agentId");
+
+  sorter.add("a");
+  sorter.add("a/x");
+  sorter.add("b/y");
+  sorter.activate("a");
+  sorter.activate("a/x");
+  sorter.activate("b/y");
+
+  sorter.add(slaveId, Resources::parse("cpus:10;mem:10;disk:10").get());
+
+  EXPECT_EQ(Resources(), sorter.allocationScalarQuantities());
+
+  sorter.allocated("a", slaveId, Resources::parse("cpus:1;mem:1").get());
+  sorter.allocated("a/x", slaveId, Resources::parse("cpus:2;mem:2").get());
+  sorter.allocated(
+      "b/y", slaveId, Resources::parse("cpus:3;mem:3;disk:10").get());
+
+  EXPECT_EQ(
+      Resources::parse("cpus:6;mem:6;disk:10").get(),
+      sorter.allocationScalarQuantities());
+
+  // Creating a persistent volume does not change the quantities.
+  Resource volume = Resources::parse("disk", "5", "*").get();
+  volume.mutable_disk()->mutable_persistence()->set_id("ID");
+  volume.mutable_disk()->mutable_volume()->set_container_path("data");
+
+  Resources oldAllocation = sorter.allocation("b/y", slaveId);
+  Try<Resources> newAllocation = oldAllocation.apply(CREATE(volume));
+  ASSERT_SOME(newAllocation);
+
+  sorter.update("b/y", slaveId, oldAllocation, newAllocation.get());
+
+  EXPECT_EQ(
+      Resources::parse("cpus:6;mem:6;disk:10").get(),
+      sorter.allocationScalarQuantities());
+
+  sorter.unallocated("a/x", slaveId, Resources::parse("cpus:1;mem:1").get());
+
+  EXPECT_EQ(
+      Resources::parse("cpus:5;mem:5;disk:10").get(),
+      sorter.allocationScalarQuantities());
+
+  // Removing a client removes its remaining allocation.
+  sorter.remove("b/y");
+
+  EXPECT_EQ(
+      Resources::parse("cpus:2;mem:2").get(),
+      sorter.allocationScalarQuantities());
+}
+
+
 // This test checks that the sorter correctly reports allocation
 // information about inactive clients.
 TEST(SorterTest, AllocationForInactiveClient)
@@ -1231,6 +1292,43 @@ TEST(SorterTest, MultipleSlavesUpdateTotal)
 }
 
 
+// Tests that the dominant share of a client only considers the
+// resources in the total that are not excluded from fair sharing.
+TEST(SorterTest, DominantShare)
+{
+  DRFSorter sorter;
+  sorter.initialize(set<string>({"gpus"}));
+
+  SlaveID slaveId;
+  slaveId.set_value("agentId");
+
+  sorter.add("a");
+  sorter.add("b");
+  sorter.add("c");
+  sorter.activate("a");
+  sorter.activate("b");
+  sorter.activate("c");
+
+  sorter.add(slaveId, Resources::parse("cpus:10;mem:100;gpus:1").get());
+
+  // Dominant share of "a" is 0.1 (cpus), as gpus are excluded.
+  sorter.allocated("a", slaveId, Resources::parse("cpus:1;gpus:1").get());
+
+  // Dominant share of "b" is 0.2 (mem).
+  sorter.allocated("b", slaveId, Resources::parse("mem:20").get());
+
+  // Dominant share of "c" is 0.05 (cpus), as "foo" is not in the total.
+  sorter.allocated("c", slaveId, Resources::parse("cpus:0.5;foo:5").get());
+
+  EXPECT_EQ(vector<string>({"c", "a", "b"}), sorter.sort());
+
+  // Dominant share of "c" is now 0.5 (mem).
+  sorter.allocated("c", slaveId, Resources::parse("mem:50").get());
+
+  EXPECT_EQ(vector<string>({"a", "b", "c"}), sorter.sort());
+}
+
+
 // This test verifies that revocable resources are properly accounted
 // for in the DRF sorter.
 TEST(SorterTest, RevocableResources)
@@ -33,14 +33,17 @@
 #include <mesos/state/storage.hpp>
 #include <mesos/state/zookeeper.hpp>
 
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gtest.hpp>
 #include <process/protobuf.hpp>
 #include <process/pid.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/gtest.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/try.hpp>
 
 #include <stout/tests/utils.hpp>
@@ -53,6 +56,8 @@
 
 #include "messages/state.hpp"
 
+#include "state/delta.hpp"
+
 #ifdef MESOS_HAS_JAVA
 #include "tests/zookeeper.hpp"
 #endif
@@ -61,6 +66,8 @@ using namespace mesos::internal::log;
 
 using namespace process;
 
+using std::cout;
+using std::endl;
 using std::list;
 using std::set;
 using std::string;
@@ -70,6 +77,7 @@ using mesos::log::Log;
 
 using mesos::state::Storage;
 using mesos::state::LevelDBStorage;
+using mesos::state::LogStorage;
 #ifdef MESOS_HAS_JAVA
 using mesos::state::ZooKeeperStorage;
 #endif
@@ -77,6 +85,9 @@ using mesos::state::ZooKeeperStorage;
 using mesos::state::protobuf::State;
 using mesos::state::protobuf::Variable;
 
+using testing::WithParamInterface;
+
+using mesos::internal::state::Delta;
 using mesos::internal::state::Operation;
 
 namespace mesos {
@@ -691,6 +702,322 @@ TEST_F(LogStateTest, Diff)
 }
 
 
+TEST_F(LogStateTest, Delta)
+{
+  // Replace the storage with one that writes binary deltas.
+  delete state;
+  delete storage;
+
+  storage = new LogStorage(log, 1024, LogStorage::DELTA);
+  state = new State(storage);
+
+  Future<Variable<Slaves>> future1 = state->fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  Variable<Slaves> variable = future1.get();
+
+  Slaves slaves = variable.get();
+  ASSERT_TRUE(slaves.slaves().empty());
+
+  for (size_t i = 0; i < 1024; i++) {
+    Slave* slave = slaves.add_slaves();
+    slave->mutable_info()->set_hostname("localhost" + stringify(i));
+  }
+
+  variable = variable.mutate(slaves);
+
+  Future<Option<Variable<Slaves>>> future2 = state->store(variable);
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  variable = future2->get();
+
+  slaves.mutable_slaves(512)->mutable_info()->set_hostname("localhost");
+
+  Slave* slave = slaves.add_slaves();
+  slave->mutable_info()->set_hostname("localhost1024");
+
+  variable = variable.mutate(slaves);
+
+  future2 = state->store(variable);
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  // See the comment in the 'Diff' test above.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  Log::Reader reader(log);
+
+  Future<Log::Position> beginning = reader.beginning();
+  Future<Log::Position> ending = reader.ending();
+
+  AWAIT_READY(beginning);
+  AWAIT_READY(ending);
+
+  Future<list<Log::Entry>> entries = reader.read(beginning.get(), ending.get());
+
+  AWAIT_READY(entries);
+
+  // Convert each Log::Entry to an Operation.
+  vector<Operation> operations;
+
+  foreach (const Log::Entry& entry, entries.get()) {
+    // Parse the Operation from the Log::Entry.
+    Operation operation;
+
+    google::protobuf::io::ArrayInputStream stream(
+        entry.data.data(),
+        entry.data.size());
+
+    ASSERT_TRUE(operation.ParseFromZeroCopyStream(&stream));
+
+    operations.push_back(operation);
+  }
+
+  ASSERT_EQ(2u, operations.size());
+  EXPECT_EQ(Operation::SNAPSHOT, operations[0].type());
+  EXPECT_EQ(Operation::DIFF, operations[1].type());
+  EXPECT_TRUE(operations[1].diff().has_delta());
+
+  // Now recover the entry from the log, which applies the delta.
+  delete state;
+  delete storage;
+
+  storage = new LogStorage(log, 1024, LogStorage::DELTA);
+  state = new State(storage);
+
+  future1 = state->fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  EXPECT_EQ(slaves.SerializeAsString(),
+            future1->get().SerializeAsString());
+}
+
+
+TEST(DeltaTest, DiffAndPatch)
+{
+  string from;
+  for (size_t i = 0; i < 1000; i++) {
+    from += stringify(i) + ",";
+  }
+
+  vector<string> values = {
+    "",
+    "value",
+    from,
+    from + "suffix",
+    "prefix" + from,
+    from.substr(0, 1000) + "infix" + from.substr(1000),
+    from.substr(0, 1000) + from.substr(2000),
+    from.substr(2000) + from.substr(0, 2000),
+    string(from.rbegin(), from.rend())
+  };
+
+  foreach (const string& to, values) {
+    Delta delta = state::delta::diff(from, to);
+    EXPECT_SOME_EQ(to, state::delta::patch(from, delta));
+  }
+
+  // A small change results in a small delta.
+  const string to = from.substr(0, 1000) + "infix" + from.substr(1000);
+
+  Delta delta = state::delta::diff(from, to);
+
+  EXPECT_GT(64, delta.ByteSize());
+
+  // A copy beyond the end of the value can not be applied.
+  Delta::Instruction* instruction = delta.add_instructions();
+  instruction->set_offset(from.size());
+  instruction->set_length(1);
+
+  EXPECT_ERROR(state::delta::patch(from, delta));
+}
+
+
+class LogState_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<
+        std::tr1::tuple<size_t, LogStorage::DiffFormat>> {};
+
+
+// The benchmark is parameterized by the number of agents in the
+// stored registry and the format of the diffs.
+INSTANTIATE_TEST_CASE_P(
+    SlaveCountAndDiffFormat,
+    LogState_BENCHMARK_Test,
+    ::testing::Combine(
+      ::testing::Values(1000U, 10000U, 50000U),
+      ::testing::Values(LogStorage::SVN, LogStorage::DELTA)));
+
+
+// Measures the latency of storing a registry in which a single agent
+// changed, which is what the registrar does for most operations.
+TEST_P(LogState_BENCHMARK_Test, Set)
+{
+  const size_t slaveCount = std::tr1::get<0>(GetParam());
+  const LogStorage::DiffFormat format = std::tr1::get<1>(GetParam());
+
+  // For initializing the replicas.
+  tool::Initialize initializer;
+
+  const string path1 = os::getcwd() + "/.log1";
+  const string path2 = os::getcwd() + "/.log2";
+
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  Replica replica2(path2);
+
+  set<UPID> pids;
+  pids.insert(replica2.pid());
+
+  Log log(2, path1, pids);
+  LogStorage storage(&log, 1024, format);
+  State state(&storage);
+
+  Future<Variable<Slaves>> fetch = state.fetch<Slaves>("slaves");
+  AWAIT_READY(fetch);
+
+  Variable<Slaves> variable = fetch.get();
+
+  Slaves slaves;
+  for (size_t i = 0; i < slaveCount; i++) {
+    SlaveInfo* info = slaves.add_slaves()->mutable_info();
+    info->set_hostname("localhost" + stringify(i));
+    info->set_port(5051);
+    info->mutable_id()->set_value(
+        "201310101658-2280333834-5050-48574-S" + stringify(i));
+  }
+
+  variable = variable.mutate(slaves);
+
+  Future<Option<Variable<Slaves>>> store = state.store(variable);
+  AWAIT_READY_FOR(store, Minutes(1));
+  ASSERT_SOME(store.get());
+
+  variable = store->get();
+
+  const size_t updates = 100;
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < updates; i++) {
+    slaves.mutable_slaves(i * slaveCount / updates)->mutable_info()
+      ->set_hostname("updated" + stringify(i));
+
+    variable = variable.mutate(slaves);
+
+    store = state.store(variable);
+    AWAIT_READY_FOR(store, Minutes(1));
+    ASSERT_SOME(store.get());
+
+    variable = store->get();
+  }
+
+  cout << "Stored " << updates << " updates of " << slaveCount << " agents ("
+       << Bytes(slaves.ByteSize()) << ") using "
+       << (format == LogStorage::SVN ? "SVN diffs" : "deltas") << " in "
+       << watch.elapsed() << endl;
+}
+
+
+class LogStorageConcurrency_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<size_t> {};
+
+
+// The benchmark is parameterized by the number of stores that are
+// outstanding at a time.
+INSTANTIATE_TEST_CASE_P(
+    Concurrency,
+    LogStorageConcurrency_BENCHMARK_Test,
+    ::testing::Values(1U, 8U, 64U));
+
+
+// Measures the throughput of concurrent stores of distinct entries,
+// for comparison with the appends of `LogAppend_BENCHMARK_Test`.
+TEST_P(LogStorageConcurrency_BENCHMARK_Test, ConcurrentStores)
+{
+  const size_t concurrency = GetParam();
+  const size_t stores = 256;
+
+  // For initializing the replicas.
+  tool::Initialize initializer;
+
+  const string path1 = os::getcwd() + "/.log1";
+  const string path2 = os::getcwd() + "/.log2";
+  const string path3 = os::getcwd() + "/.log3";
+
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  initializer.flags.path = path3;
+  ASSERT_SOME(initializer.execute());
+
+  Replica replica2(path2);
+  Replica replica3(path3);
+
+  set<UPID> pids;
+  pids.insert(replica2.pid());
+  pids.insert(replica3.pid());
+
+  Log log(2, path1, pids);
+  LogStorage storage(&log);
+  State state(&storage);
+
+  vector<Variable<Slaves>> variables;
+  for (size_t i = 0; i < concurrency; i++) {
+    Future<Variable<Slaves>> fetch =
+      state.fetch<Slaves>("slaves" + stringify(i));
+
+    AWAIT_READY(fetch);
+    variables.push_back(fetch.get());
+  }
+
+  Slaves slaves;
+  SlaveInfo* info = slaves.add_slaves()->mutable_info();
+  info->set_port(5051);
+  info->mutable_id()->set_value("201310101658-2280333834-5050-48574-S0");
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t stored = 0; stored < stores; stored += concurrency) {
+    info->set_hostname("localhost" + stringify(stored));
+
+    list<Future<Option<Variable<Slaves>>>> storing;
+    foreach (const Variable<Slaves>& variable, variables) {
+      storing.push_back(state.store(variable.mutate(slaves)));
+    }
+
+    Future<list<Option<Variable<Slaves>>>> results = collect(storing);
+    AWAIT_READY_FOR(results, Minutes(1));
+
+    variables.clear();
+    foreach (const Option<Variable<Slaves>>& variable, results.get()) {
+      ASSERT_SOME(variable);
+      variables.push_back(variable.get());
+    }
+  }
+
+  watch.stop();
+
+  cout << "Stored " << stores << " entries with " << concurrency
+       << " outstanding at a time in " << watch.elapsed() << " ("
+       << stores / watch.elapsed().secs() << " stores per second)"
+       << endl;
+}
+
+
 #ifdef MESOS_HAS_JAVA
 class ZooKeeperStateTest : public tests::ZooKeeperTest
 {
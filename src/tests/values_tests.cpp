@@ -17,11 +17,14 @@
 #include <stdint.h>
 
 #include <sstream>
+#include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 #include <mesos/values.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/interval.hpp>
 #include <stout/try.hpp>
@@ -32,6 +35,9 @@
 
 using namespace mesos::internal::values;
 
+using std::pair;
+using std::vector;
+
 namespace mesos {
   extern void coalesce(Value::Ranges* ranges);
   extern void coalesce(Value::Ranges* ranges, const Value::Range& range);
@@ -42,6 +48,24 @@ namespace mesos {
 namespace internal {
 namespace tests {
 
+// Returns the given ranges as they are, whereas `parse()` coalesces
+// them, so that the operators can be tested on ranges that are not
+// sorted, overlap or are adjacent.
+static Value::Ranges createRanges(
+    const vector<pair<uint64_t, uint64_t>>& ranges)
+{
+  Value::Ranges result;
+
+  foreach (const auto& range, ranges) {
+    Value::Range* _range = result.add_range();
+    _range->set_begin(range.first);
+    _range->set_end(range.second);
+  }
+
+  return result;
+}
+
+
 TEST(ValuesTest, ValidInput)
 {
   // Test parsing scalar type.
@@ -477,6 +501,127 @@ TEST(ValuesTest, RangesSubtraction)
   EXPECT_EQ(parse("[3-8]")->ranges(), ranges1 - ranges2);
 }
 
+
+// Test comparing ranges that are not coalesced.
+TEST(ValuesTest, RangesEquality)
+{
+  // Adjacent.
+  EXPECT_TRUE(createRanges({{1, 2}, {3, 4}}) == parse("[1-4]")->ranges());
+  EXPECT_TRUE(createRanges({{3, 4}, {1, 2}}) == parse("[1-4]")->ranges());
+
+  // Overlapping.
+  EXPECT_TRUE(createRanges({{1, 3}, {2, 4}}) == parse("[1-4]")->ranges());
+  EXPECT_TRUE(createRanges({{2, 4}, {1, 3}}) == createRanges({{1, 4}}));
+
+  // Contained.
+  EXPECT_TRUE(createRanges({{1, 10}, {3, 4}}) == parse("[1-10]")->ranges());
+  EXPECT_TRUE(createRanges({{3, 4}, {1, 10}, {3, 4}}) ==
+              createRanges({{1, 10}}));
+
+  // Disjoint.
+  EXPECT_TRUE(createRanges({{4, 5}, {1, 2}}) == parse("[1-2, 4-5]")->ranges());
+  EXPECT_FALSE(createRanges({{1, 2}, {4, 5}}) == parse("[1-5]")->ranges());
+  EXPECT_FALSE(createRanges({{1, 2}, {4, 5}}) == parse("[1-2]")->ranges());
+  EXPECT_FALSE(createRanges({{1, 2}, {4, 5}}) == parse("[1-2, 5-6]")->ranges());
+
+  EXPECT_TRUE(Value::Ranges() == createRanges({}));
+  EXPECT_FALSE(Value::Ranges() == createRanges({{1, 1}}));
+}
+
+
+// Test whether ranges contain ranges that are not coalesced.
+TEST(ValuesTest, RangesContainment)
+{
+  const Value::Ranges ranges = parse("[1-5, 10-15]")->ranges();
+
+  // Adjacent.
+  EXPECT_TRUE(createRanges({{2, 3}, {4, 5}}) <= ranges);
+  EXPECT_FALSE(createRanges({{4, 5}, {6, 7}}) <= ranges);
+  EXPECT_TRUE(ranges <= createRanges({{1, 9}, {10, 15}}));
+
+  // Overlapping.
+  EXPECT_TRUE(createRanges({{1, 4}, {3, 5}}) <= ranges);
+  EXPECT_FALSE(createRanges({{3, 6}}) <= ranges);
+  EXPECT_FALSE(createRanges({{9, 12}}) <= ranges);
+  EXPECT_FALSE(createRanges({{12, 16}}) <= ranges);
+
+  // Contained.
+  EXPECT_TRUE(createRanges({{11, 12}, {2, 2}, {14, 15}}) <= ranges);
+  EXPECT_TRUE(ranges <= ranges);
+  EXPECT_TRUE(ranges <= createRanges({{0, 20}, {3, 4}}));
+
+  // Disjoint.
+  EXPECT_FALSE(createRanges({{6, 9}}) <= ranges);
+  EXPECT_FALSE(createRanges({{0, 0}}) <= ranges);
+  EXPECT_FALSE(createRanges({{16, 20}}) <= ranges);
+  EXPECT_FALSE(createRanges({{1, 5}, {7, 7}, {10, 15}}) <= ranges);
+
+  EXPECT_TRUE(Value::Ranges() <= ranges);
+  EXPECT_FALSE(ranges <= Value::Ranges());
+}
+
+
+// Test adding and subtracting ranges that consist of several ranges,
+// which are not necessarily coalesced.
+TEST(ValuesTest, RangesArithmetic)
+{
+  // Adjacent.
+  Value::Ranges ranges1 = createRanges({{5, 6}, {1, 2}});
+  Value::Ranges ranges2 = createRanges({{3, 4}, {7, 8}});
+
+  EXPECT_EQ(1, (ranges1 + ranges2).range_size());
+  EXPECT_EQ(parse("[1-8]")->ranges(), ranges1 + ranges2);
+  EXPECT_EQ(parse("[1-2, 5-6]")->ranges(), ranges1 - ranges2);
+
+  // Overlapping.
+  ranges1 = createRanges({{1, 5}, {4, 8}, {10, 12}});
+  ranges2 = createRanges({{7, 11}, {3, 3}});
+
+  EXPECT_EQ(parse("[1-12]")->ranges(), ranges1 + ranges2);
+  EXPECT_EQ(parse("[1-2, 4-6, 12-12]")->ranges(), ranges1 - ranges2);
+
+  // A range that overlaps with several ranges.
+  ranges1 = parse("[1-5, 7-10]")->ranges();
+  ranges2 = parse("[4-8]")->ranges();
+
+  EXPECT_EQ(parse("[1-10]")->ranges(), ranges1 + ranges2);
+  EXPECT_EQ(parse("[1-3, 9-10]")->ranges(), ranges1 - ranges2);
+
+  ranges1 = parse("[1-3, 5-7, 9-11]")->ranges();
+  ranges2 = parse("[2-2, 6-10]")->ranges();
+
+  EXPECT_EQ(parse("[1-3, 5-11]")->ranges(), ranges1 + ranges2);
+  EXPECT_EQ(parse("[1-1, 3-3, 5-5, 11-11]")->ranges(), ranges1 - ranges2);
+
+  // Contained.
+  ranges1 = parse("[1-10, 20-30]")->ranges();
+  ranges2 = createRanges({{25, 26}, {2, 3}, {2, 2}});
+
+  EXPECT_EQ(ranges1, ranges1 + ranges2);
+  EXPECT_EQ(parse("[1-1, 4-10, 20-24, 27-30]")->ranges(), ranges1 - ranges2);
+  EXPECT_EQ(Value::Ranges(), ranges2 - ranges1);
+
+  // Disjoint.
+  ranges1 = parse("[1-2, 10-12]")->ranges();
+  ranges2 = createRanges({{20, 21}, {5, 6}});
+
+  EXPECT_EQ(4, (ranges1 + ranges2).range_size());
+  EXPECT_EQ(parse("[1-2, 5-6, 10-12, 20-21]")->ranges(), ranges1 + ranges2);
+  EXPECT_EQ(ranges1, ranges1 - ranges2);
+
+  // The compound assignments give the same results.
+  Value::Ranges ranges = createRanges({{4, 8}, {1, 5}});
+  ranges += createRanges({{10, 10}, {9, 9}});
+
+  EXPECT_EQ(1, ranges.range_size());
+  EXPECT_EQ(parse("[1-10]")->ranges(), ranges);
+
+  ranges -= createRanges({{5, 5}, {3, 3}});
+
+  EXPECT_EQ(3, ranges.range_size());
+  EXPECT_EQ(parse("[1-2, 4-4, 6-10]")->ranges(), ranges);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {